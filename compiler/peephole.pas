@@ -0,0 +1,331 @@
+{ TuxPascal peephole optimizer }
+{ Reads the compiler's assembly on stdin And writes it To stdout, }
+{ rewriting redundant instruction sequences In a small window: }
+{   str x0, [sp, #-16]! ... ldr xN, [sp], #16  ->  mov xN, x0 }
+{   stur xA, [m] ; ldur xC, [m]                ->  stur xA, [m] ; mov xC, xA }
+{   b Ln ; Ln:                                 ->  Ln: }
+{ Used by tpc -O; the compiler itself writes its output directly. }
+
+Program Peephole;
+
+Const
+  WINDOW = 8;          { Lines held back before they are written }
+  MAX_GAP = 6;         { Instructions allowed between a push And its pop }
+
+Var
+  win: Array[0..7] Of String;
+  count: Integer;
+  s, t, u: String;     { Scratch lines; string value params are Not used }
+  dreg, sreg: String;  { Operands For MakeMov }
+  ch: Char;
+  c, i: Integer;
+
+  { Patterns, set once. A literal Or Copy In an expression takes a fresh }
+  { string temporary, And those are never reused }
+  pat_indent, pat_push, pat_pop, pat_pop_tail, pat_mov_imm: String;
+  pat_stur, pat_ldur, pat_str, pat_ldr, pat_b: String;
+  pat_mov, pat_fmov, pat_comma, pat_addr: String;
+  pat_sp, pat_x0, pat_w0: String;
+
+Procedure InitPatterns;
+Begin
+  pat_indent := '    ';
+  pat_push := '    str x0, [sp, #-16]!';
+  pat_pop := '    ldr x';
+  pat_pop_tail := ', [sp], #16';
+  pat_mov_imm := '    mov x0, #';
+  pat_stur := '    stur ';
+  pat_ldur := '    ldur ';
+  pat_str := '    str ';
+  pat_ldr := '    ldr ';
+  pat_b := '    b ';
+  pat_mov := '    mov ';
+  pat_fmov := '    fmov ';
+  pat_comma := ', ';
+  pat_addr := ', [';
+  pat_sp := 'sp';
+  pat_x0 := 'x0';
+  pat_w0 := 'w0'
+End;
+
+{ ----- Building lines ----- }
+
+Procedure AppendChar(c: Char);
+Var
+  n: Integer;
+Begin
+  n := Length(t) + 1;
+  t[n] := c;
+  t[0] := Chr(n)
+End;
+
+{ t := t + u }
+Procedure AppendU;
+Var
+  j: Integer;
+Begin
+  For j := 1 To Length(u) Do
+    AppendChar(u[j])
+End;
+
+{ t := s[first..last] }
+Procedure SliceS(first, last: Integer);
+Var
+  j: Integer;
+Begin
+  t[0] := Chr(0);
+  For j := first To last Do
+    AppendChar(s[j])
+End;
+
+{ t := 'mov dreg, sreg', Or fmov For floating point registers }
+Procedure MakeMov(fp: Integer);
+Begin
+  If fp = 1 Then
+    t := pat_fmov
+  Else
+    t := pat_mov;
+  u := dreg;
+  AppendU;
+  u := pat_comma;
+  AppendU;
+  u := sreg;
+  AppendU
+End;
+
+{ ----- Line classification ----- }
+
+{ 1 If s is an instruction: indented And Not a directive Or label }
+Function IsInsn: Integer;
+Begin
+  IsInsn := 0;
+  If Length(s) > 5 Then
+    If (Pos(pat_indent, s) = 1) And (s[5] <> '.') And (s[Length(s)] <> ':') Then
+      IsInsn := 1
+End;
+
+{ 1 If s transfers control Or may clobber registers behind our back }
+Function IsBranch: Integer;
+Begin
+  IsBranch := 0;
+  If s[5] = 'b' Then
+    IsBranch := 1
+  Else If ((s[5] = 'c') Or (s[5] = 't')) And (s[6] = 'b') Then
+    IsBranch := 1
+  Else If (s[5] = 'r') And (s[6] = 'e') And (s[7] = 't') Then
+    IsBranch := 1
+  Else If (s[5] = 's') And (s[6] = 'v') And (s[7] = 'c') Then
+    IsBranch := 1
+End;
+
+{ 1 If s is a plain instruction that never names sp Or x0 }
+Function Transparent: Integer;
+Begin
+  Transparent := 0;
+  If IsInsn = 1 Then
+    If IsBranch = 0 Then
+      If (Pos(pat_sp, s) = 0) And (Pos(pat_x0, s) = 0) And (Pos(pat_w0, s) = 0) Then
+        Transparent := 1
+End;
+
+{ Register number of 'ldr xN, [sp], #16' In s, Or -1 If s is Not a pop }
+Function PopReg: Integer;
+Var
+  p: Integer;
+Begin
+  PopReg := -1;
+  If (Length(s) > 20) And (Pos(pat_pop, s) = 1) Then
+    If Pos(pat_pop_tail, s) = Length(s) - 10 Then
+    Begin
+      p := Pos(pat_comma, s);
+      If p = 11 Then
+        PopReg := Ord(s[10]) - 48
+      Else If p = 12 Then
+        PopReg := (Ord(s[10]) - 48) * 10 + Ord(s[11]) - 48
+    End
+End;
+
+{ ----- Window ----- }
+
+Procedure DeleteLine(k: Integer);
+Var
+  j: Integer;
+Begin
+  For j := k To count - 2 Do
+    win[j] := win[j + 1];
+  count := count - 1
+End;
+
+{ push x0 ... pop xN: the value never left x0, so copy it instead }
+Procedure FoldPushPop;
+Var
+  r, k, p: Integer;
+  wreg: String;
+Begin
+  s := win[count - 1];
+  r := PopReg;
+  If r >= 0 Then
+  Begin
+    SliceS(9, Pos(pat_comma, s) - 1);
+    dreg := t;
+    wreg := t;
+    wreg[1] := 'w';
+    p := -1;
+    k := count - 2;
+    While (k >= 0) And (k >= count - 2 - MAX_GAP) And (p = -1) Do
+    Begin
+      s := win[k];
+      If s = pat_push Then
+        p := k
+      Else If Transparent = 1 Then
+      Begin
+        { The popped register must survive the gap too }
+        If (r = 0) Or ((Pos(dreg, s) = 0) And (Pos(wreg, s) = 0)) Then
+          k := k - 1
+        Else
+          k := -1
+      End
+      Else
+        k := -1
+    End;
+    If p >= 0 Then
+    Begin
+      If r <> 0 Then
+      Begin
+        sreg := pat_x0;
+        { A constant pushed straight away can be loaded directly }
+        If p > 0 Then
+        Begin
+          s := win[p - 1];
+          If Pos(pat_mov_imm, s) = 1 Then
+          Begin
+            SliceS(13, Length(s));
+            sreg := t
+          End
+        End;
+        MakeMov(0)
+      End;
+      DeleteLine(count - 1);
+      DeleteLine(p);
+      If r <> 0 Then
+      Begin
+        win[count] := t;
+        count := count + 1
+      End
+    End
+  End
+End;
+
+{ str/stur followed by a load of the same slot: reuse the stored register }
+Procedure FoldStoreLoad;
+Var
+  ps, pt, first: Integer;
+  load: String;
+Begin
+  s := win[count - 2];
+  load := win[count - 1];
+  first := 0;
+  If (Pos(pat_stur, s) = 1) And (Pos(pat_ldur, load) = 1) Then
+    first := 10
+  Else If (Pos(pat_str, s) = 1) And (Pos(pat_ldr, load) = 1) Then
+    first := 9;
+  If first > 0 Then
+  Begin
+    ps := Pos(pat_addr, s);
+    pt := Pos(pat_addr, load);
+    { Same address text, And no writeback To the base register }
+    If (ps > 0) And (pt > 0) And (s[Length(s)] = ']') And
+       (Length(s) - ps = Length(load) - pt) Then
+    Begin
+      SliceS(ps, Length(s));
+      u := t;
+      s := load;
+      SliceS(pt, Length(s));
+      If t = u Then
+      Begin
+        SliceS(first, pt - 1);
+        dreg := t;
+        s := win[count - 2];
+        SliceS(first, ps - 1);
+        sreg := t;
+        { A w Or s load also clears the upper half, so keep it As a mov }
+        If sreg[1] = dreg[1] Then
+        Begin
+          If (sreg = dreg) And ((sreg[1] = 'x') Or (sreg[1] = 'd')) Then
+            DeleteLine(count - 1)
+          Else If (sreg[1] = 'x') Or (sreg[1] = 'w') Then
+          Begin
+            MakeMov(0);
+            win[count - 1] := t
+          End
+          Else If (sreg[1] = 'd') Or (sreg[1] = 's') Then
+          Begin
+            MakeMov(1);
+            win[count - 1] := t
+          End
+        End
+      End
+    End
+  End
+End;
+
+{ A branch To the label that immediately follows it }
+Procedure FoldBranchNext;
+Begin
+  s := win[count - 2];
+  u := win[count - 1];
+  If (Pos(pat_b, s) = 1) And (Length(u) = Length(s) - 5) Then
+    If u[Length(u)] = ':' Then
+    Begin
+      SliceS(7, Length(s));
+      AppendChar(':');
+      If t = u Then
+        DeleteLine(count - 2)
+    End
+End;
+
+Procedure Optimize;
+Begin
+  If count >= 2 Then
+  Begin
+    s := win[count - 1];
+    If IsInsn = 1 Then
+    Begin
+      FoldPushPop;
+      If count >= 2 Then
+        FoldStoreLoad
+    End
+    Else
+      FoldBranchNext
+  End
+End;
+
+Begin
+  InitPatterns;
+  count := 0;
+  c := ReadChar;
+  While c <> -1 Do
+  Begin
+    { The compiler's lines are short, well inside a String }
+    t[0] := Chr(0);
+    While (c <> 10) And (c <> -1) Do
+    Begin
+      ch := Chr(c);
+      If Length(t) < 255 Then
+        AppendChar(ch);
+      c := ReadChar
+    End;
+    If c = 10 Then
+      c := ReadChar;
+    If count = WINDOW Then
+    Begin
+      WriteLn(win[0]);
+      DeleteLine(0)
+    End;
+    win[count] := t;
+    count := count + 1;
+    Optimize
+  End;
+  For i := 0 To count - 1 Do
+    WriteLn(win[i])
+End.
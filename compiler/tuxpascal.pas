@@ -9,6 +9,7 @@ Const
   MAX_SYMBOLS = 100;
   MAX_STRINGS = 64;
   MAX_NAME = 32;
+  OPND_REGS = 5;  { operand stack slots kept In x11-x15 / d16-d20 }
 
   { Token types }
   TOK_EOF = 0;
@@ -88,6 +89,7 @@ Const
   TOK_IMPLEMENTATION = 146; { Implementation keyword }
   TOK_USES = 147;    { Uses keyword }
   TOK_EXTERNAL = 148; { External keyword for C library linking }
+  TOK_ANSISTRING_TYPE = 149; { AnsiString - reference-counted heap String }
 
   { Symbol kinds }
   SYM_VAR = 0;
@@ -112,6 +114,7 @@ Const
   TYPE_ENUM = 11;     { enumerated Type }
   TYPE_SUBRANGE = 12; { subrange Type }
   TYPE_SET = 13;      { Set Type }
+  TYPE_ANSISTRING = 14; { pointer To a counted heap String, Nil when empty }
 
 Var
   { Source input }
@@ -124,19 +127,21 @@ Var
   tok_int: Integer;
   tok_str: Array[0..255] Of Integer;  { String as Array Of chars }
   tok_len: Integer;
+  lit_buf: Array[0..255] Of Integer;  { Write/WriteLn literal bytes Not yet emitted }
+  lit_len: Integer;
 
   { Symbol table - flattened 2D Array: sym_name[idx * 32 + char_pos] }
-  sym_name: Array[0..15999] Of Integer;  { 500 symbols * 32 chars each }
-  sym_kind: Array[0..499] Of Integer;
-  sym_type: Array[0..499] Of Integer;
-  sym_level: Array[0..499] Of Integer;
-  sym_offset: Array[0..499] Of Integer;
-  sym_const_val: Array[0..499] Of Integer;
-  sym_label: Array[0..499] Of Integer;
-  sym_is_var_param: Array[0..499] Of Integer;  { 1 If Var parameter (pass by ref) }
-  sym_var_param_flags: Array[0..499] Of Integer;  { bitmap: bit i = 1 If param i is Var (For proc/func) }
-  sym_unit_idx: Array[0..499] Of Integer;  { Unit index For imported symbols, -1 For local }
-  sym_is_external: Array[0..499] Of Integer;  { 1 if external C function }
+  sym_name: Array[0..31999] Of Integer;  { 1000 symbols * 32 chars each }
+  sym_kind: Array[0..999] Of Integer;
+  sym_type: Array[0..999] Of Integer;
+  sym_level: Array[0..999] Of Integer;
+  sym_offset: Array[0..999] Of Integer;
+  sym_const_val: Array[0..999] Of Integer;
+  sym_label: Array[0..999] Of Integer;
+  sym_is_var_param: Array[0..999] Of Integer;  { 1 If Var parameter (pass by ref) }
+  sym_var_param_flags: Array[0..999] Of Integer;  { bitmap: bit i = 1 If param i is Var (For proc/func) }
+  sym_unit_idx: Array[0..999] Of Integer;  { Unit index For imported symbols, -1 For local }
+  sym_is_external: Array[0..999] Of Integer;  { 1 if external C function }
   sym_count: Integer;
 
   { Record field table }
@@ -148,9 +153,9 @@ Var
   field_count: Integer;                    { total fields defined }
 
   { Pointer metadata For multi-level pointers And pointer-To-Array }
-  ptr_depth: Array[0..499] Of Integer;        { pointer indirection depth (1=^T, 2=^^T) }
-  ptr_ultimate_type: Array[0..499] Of Integer; { ultimate base Type after all derefs }
-  ptr_ultimate_rec: Array[0..499] Of Integer;  { If ultimate base is Record, the Type index }
+  ptr_depth: Array[0..999] Of Integer;        { pointer indirection depth (1=^T, 2=^^T) }
+  ptr_ultimate_type: Array[0..999] Of Integer; { ultimate base Type after all derefs }
+  ptr_ultimate_rec: Array[0..999] Of Integer;  { If ultimate base is Record, the Type index }
   ptr_arr_lo: Array[0..99] Of Integer;     { low bound For pointer-To-Array }
   ptr_arr_hi: Array[0..99] Of Integer;     { high bound For pointer-To-Array }
   ptr_arr_elem: Array[0..99] Of Integer;   { element Type For pointer-To-Array }
@@ -175,15 +180,53 @@ Var
 
   { Runtime labels }
   rt_print_int: Integer;
+  rt_fmt_int: Integer;        { x0=value, x1=buffer End -> x1=text, x2=Length }
   rt_newline: Integer;
   rt_readchar: Integer;
   rt_print_char: Integer;
   rt_write_char_fd: Integer;  { Write single Char To file: x0=fd, x1=Char }
+  rt_flush_output: Integer;   { Write out stdout And spare descriptor buffers }
+  rt_flush_all: Integer;      { Write out every descriptor's buffer }
+  rt_flush_desc: Integer;     { x0=descriptor -> Write out its buffer }
+  rt_write_buf: Integer;      { append x2 bytes at x1 To output buffer }
+  rt_out_switch: Integer;     { make [x28] the descriptor For x20 }
+  rt_fill_input: Integer;     { refill input buffer For fd x19, x0=bytes available }
+  rt_io_find: Integer;        { x0=fd -> its descriptor Or 0 }
+  rt_io_desc: Integer;        { x0=fd -> descriptor, taking over the spare }
+  rt_io_open: Integer;        { x0=fd -> give it its own buffer }
+  rt_io_close: Integer;       { x0=fd -> Write out And release its buffer }
+  rt_io_sync: Integer;        { x0=fd -> Write out, x0=bytes Read ahead }
+  rt_io_drop: Integer;        { x0=fd -> Write out And discard Read-ahead }
+  rt_io_seek: Integer;        { x0=fd, x1=byte position }
+  rt_io_pos: Integer;         { x0=fd -> x0=byte position }
+  rt_io_size: Integer;        { x0=fd -> x0=file size In bytes }
+  rt_io_unmap: Integer;       { x0=fd -> release its MapFile mapping }
+  rt_map_file: Integer;       { x0=fd, x1=sync -> x0=mapping Or 0 }
+  rt_block_read: Integer;     { x0=fd, x1=dest, x2=bytes -> x0=bytes Read }
+  rt_block_write: Integer;    { x0=fd, x1=src, x2=bytes -> x0=bytes written }
+  rt_file_read: Integer;      { typed file elements into slots, x0=count }
+  rt_file_write: Integer;     { typed file elements from slots, x0=count }
+  rt_read_fd: Integer;        { x0=fd -> one Char Or -1 (readfd) }
+  rt_eof: Integer;            { x0=fd -> 1 If at End Of input }
   rt_read_int: Integer;
   rt_skip_line: Integer;
   rt_print_string: Integer;
-  rt_print_real: Integer;
+  rt_print_real: Integer;     { d0=x, x0=width, x1=decimals (<0 = shortest) }
+  rt_print_int_w: Integer;    { x0=value, x1=field width }
+  rt_write_spaces: Integer;   { x0=count }
+  rt_real_scale: Integer;     { d0 * 10^x0 }
+  rt_real_digits: Integer;    { d0 -> x0=17 digits, x1=exponent }
+  rt_real_shortest: Integer;  { d0 -> x0=digits, x1=exponent, x2=count }
+  rt_real_fixed: Integer;     { d0, x0=decimals, x1=buffer End -> x1=text, x2=Length }
+  rt_pow10_dbl: Integer;      { Table 1e0..1e22 }
+  rt_pow10_int: Integer;      { Table 10^0..10^18 }
   rt_read_real: Integer;
+  rt_scan_digits: Integer;    { x0=ptr, x1=End, x2=acc -> x0, x2, x3=count }
+  rt_parse_int: Integer;      { x0=ptr, x1=End -> x0=after, x2=value, x3=digits }
+  rt_parse_real: Integer;     { x0=ptr, x1=End -> x0=after, d0=value, x3=digits }
+  rt_real_exact: Integer;     { big Integer rounding check For rt_parse_real }
+  rt_num_cut: Integer;        { x4=1 If a buffered number may continue }
+  rt_fill_more: Integer;      { x3=desc -> x0=bytes appended To the buffer }
   rt_read_string: Integer;
 
   { Float literal parsing }
@@ -197,6 +240,15 @@ Var
   { Pointer base Type tracking For arithmetic }
   ptr_base_type: Integer;
 
+  { Operand stack: left operands waiting For their right side }
+  opnd_depth: Integer;
+  opnd_real: Array[0..4] Of Integer;  { 1 If register slot k holds a Real }
+
+  { Constant folding: expr_const = 1 when the expression just parsed is }
+  { the constant expr_const_val And no code For it has been emitted yet }
+  expr_const: Integer;
+  expr_const_val: Integer;
+
   { Output file descriptor - x20 is used To store it }
   out_fd: Integer;
 
@@ -216,6 +268,17 @@ Var
 
   { Runtime labels For heap }
   rt_heap_init: Integer;
+  rt_heap_grow: Integer;       { map another heap chunk }
+  rt_arena_grow: Integer;      { map another Mark/Release segment }
+  rt_mark: Integer;            { Mark(p): start Or note arena position }
+  rt_release: Integer;         { Release(p): free arena back To p }
+  heap_min_size: Integer;      { first heap chunk, from dollar-M }
+  heap_max_size: Integer;      { heap growth limit, 0 = none }
+  heap_stats: Integer;         { 1 = count heap use, report at Exit }
+  heap_stats_out: Integer;     { 1 once rt_heap_stats has been emitted }
+  runtime_out: Integer;        { 1 once the runtime is out; heap directives are too late }
+  rt_heap_avail: Integer;      { x0 = free bytes, x1 = largest block }
+  rt_heap_stats: Integer;      { Print heap statistics To stderr }
 
   { Runtime labels For String operations }
   rt_str_copy: Integer;
@@ -223,14 +286,33 @@ Var
   rt_str_concat: Integer;
   rt_str_cmp: Integer;  { lexicographic compare: returns -1, 0, Or 1 }
   rt_str_pos: Integer;  { find substring: returns position Or 0 }
+  rt_str_posex: Integer;  { find substring from a start position }
   rt_str_delete: Integer;  { delete chars from String In place }
   rt_str_insert: Integer;  { insert String into another }
   rt_int_to_str: Integer;  { convert Integer To String }
   rt_str_to_int: Integer;  { convert String To Integer With error code }
+  rt_str_to_real: Integer;  { convert String To Real With error code }
   rt_str_ltrim: Integer;  { trim leading whitespace }
   rt_str_rtrim: Integer;  { trim trailing whitespace }
   rt_str_trim: Integer;   { trim both leading And trailing whitespace }
 
+  { Runtime labels For AnsiString }
+  rt_ansi_new: Integer;        { x0=Length -> x0=temp record }
+  rt_ansi_addref: Integer;     { x0=record Or Nil gains a reference }
+  rt_ansi_release: Integer;    { x0=record Or Nil loses one, freed at 0 }
+  rt_ansi_unref: Integer;      { Function result loses its reference, kept }
+  rt_ansi_drop: Integer;       { x1=record freed If a temp, x0 kept }
+  rt_ansi_assign: Integer;     { x0=value, x1=variable address }
+  rt_ansi_unique: Integer;     { x0=variable address -> x0=unshared record }
+  rt_ansi_from_short: Integer; { x0=String addr -> x0=record, x1 kept }
+  rt_ansi_from_char: Integer;  { x0=Char -> x0=record, x1 kept }
+  rt_ansi_to_short: Integer;   { x0=record -> x0=temp String }
+  rt_ansi_concat: Integer;     { x0=left, x1=right -> x0=record }
+  rt_ansi_cmp: Integer;        { x0, x1 -> -1, 0 Or 1 }
+  rt_ansi_posex: Integer;      { x0=substr, x1=String, x2=start -> position }
+  rt_ansi_copy: Integer;       { x0=record, x1=index, x2=count -> x0=record }
+  rt_print_ansi: Integer;      { Write x0=record }
+
   { Runtime labels For screen/terminal control }
   rt_clrscr: Integer;     { clear screen And home cursor }
   rt_gotoxy: Integer;     { move cursor To x,y position }
@@ -264,7 +346,8 @@ Var
   { Register usage:
     x25 = argc (saved at Program start)
     x26 = argv (saved at Program start)
-    x27 = random seed }
+    x27 = random seed
+    x28 = I/O state block (output buffer, see EmitFileOpenInit) }
 
   { Saved terminal settings For restore }
   saved_termios: Array[0..79] Of Integer;  { 80 bytes For termios struct }
@@ -297,17 +380,18 @@ Var
 
   { Multi-dimensional array metadata }
   { arr_dims[sym_idx] = number of dimensions (1 for 1D, 2 for 2D, etc.) }
-  arr_dims: Array[0..499] Of Integer;
+  arr_dims: Array[0..999] Of Integer;
   { arr_info stores bounds for multi-dim arrays: 8 integers per symbol }
   { Layout: [lo1, size1, lo2, size2, lo3, size3, lo4, size4] }
   { For 2D array[0..3, 0..5]: lo1=0, size1=6, lo2=0, size2=6 }
   { Access arr_info[sym_idx * 8 + dim * 2] for lo, +1 for size }
-  arr_info: Array[0..3999] Of Integer;      { 500 symbols * 8 ints each }
+  arr_info: Array[0..7999] Of Integer;      { 1000 symbols * 8 ints each }
 
   { File variable structure (at runtime, 272 bytes per file Var):
     offset 0: fd (8 bytes) - file descriptor, -1 If Not open
     offset 8: mode (8 bytes) - 0=closed, 1=Read, 2=Write, 3=append
-    offset 16: filename (256 bytes) - null-terminated String }
+    offset 16: filename (256 bytes) - null-terminated String
+    The file's I/O buffer is found through the fd, see rt_io_find }
 
   { Include file support - using individual variables since bootstrap doesn't support Array subscripts With eof }
   include_file0, include_file1, include_file2, include_file3: Text;
@@ -424,13 +508,15 @@ Begin
   Else If code = 20 Then
     Write('Duplicate identifier')
   Else If code = 21 Then
-    Write('Too many symbols (max 500)')
+    Write('Too many symbols (max 1000)')
   Else If code = 22 Then
     Write('Too many record fields (max 200)')
   Else If code = 23 Then
     Write('Too many types (max 100)')
   Else If code = 24 Then
     Write('Too many units (max 16)')
+  Else If code = 25 Then
+    Write('Heap directive must come before the declarations')
   Else
   Begin
     Write('Unknown error (code ');
@@ -745,6 +831,71 @@ Begin
     PushIncludeFile(0, i)
 End;
 
+Function DirectiveNumber: Integer;
+Var
+  n: Integer;
+Begin
+  { Read the next number Of a directive, -1 If there is none }
+  While (ch = 32) Or (ch = 9) Or (ch = 44) Do
+    NextChar;
+  n := -1;
+  While IsDigit(ch) = 1 Do
+  Begin
+    If n < 0 Then
+      n := 0;
+    n := n * 10 + ch - 48;
+    NextChar
+  End;
+  DirectiveNumber := n
+End;
+
+Procedure ParseMemDirective;
+Var
+  n: Integer;
+Begin
+  { dollar-M stacksize, heapmin, heapmax. The OS sets the stack size; }
+  { heapmin is the first heap chunk And heapmax caps heap growth }
+  n := DirectiveNumber;
+  n := DirectiveNumber;
+  If n > 0 Then
+    heap_min_size := n;
+  n := DirectiveNumber;
+  If n >= 0 Then
+    heap_max_size := n;
+  While (ch <> 125) And (ch <> -1) Do
+    NextChar;
+  If ch = 125 Then
+    NextChar
+End;
+
+Function DirectiveSwitch: Integer;
+Var
+  r: Integer;
+Begin
+  { Read the ON/OFF (Or +/-) value Of a switch directive And skip To }
+  { its End. Returns 1 For on, 0 For off, -1 For anything Else }
+  While (ch = 32) Or (ch = 9) Do
+    NextChar;
+  r := -1;
+  If ch = 43 Then
+    r := 1
+  Else If ch = 45 Then
+    r := 0
+  Else If ToLower(ch) = 111 Then  { 'o' }
+  Begin
+    NextChar;
+    If ToLower(ch) = 110 Then  { 'n' }
+      r := 1
+    Else If ToLower(ch) = 102 Then  { 'f' }
+      r := 0
+  End;
+  While (ch <> 125) And (ch <> -1) Do
+    NextChar;
+  If ch = 125 Then
+    NextChar;
+  DirectiveSwitch := r
+End;
+
 Procedure SkipWhitespace;
 Var
   directive_char: Integer;
@@ -837,6 +988,50 @@ Begin
           SkipWhitespace
         End
       End
+      Else If directive_char = 104 Then  { 'h' }
+      Begin
+        { Read the directive name }
+        tok_len := 0;
+        While (IsAlpha(ch) = 1) And (tok_len < 255) Do
+        Begin
+          tok_str[tok_len] := ToLower(ch);
+          tok_len := tok_len + 1;
+          NextChar
+        End;
+        { heapstats = 104,101,97,112,115,116,97,116,115 }
+        If (tok_len = 9) And (tok_str[0] = 104) And (tok_str[1] = 101) And
+           (tok_str[2] = 97) And (tok_str[3] = 112) And (tok_str[4] = 115) And
+           (tok_str[5] = 116) And (tok_str[6] = 97) And (tok_str[7] = 116) And
+           (tok_str[8] = 115) Then
+        Begin
+          If runtime_out = 1 Then
+            Error(25);
+          If DirectiveSwitch = 1 Then
+            heap_stats := 1
+          Else
+            heap_stats := 0
+        End
+        Else
+        Begin
+          While (ch <> 125) And (ch <> -1) Do NextChar;
+          If ch = 125 Then NextChar
+        End;
+        SkipWhitespace
+      End
+      Else If directive_char = 109 Then  { 'm' }
+      Begin
+        NextChar;
+        If runtime_out = 1 Then
+          Error(25);
+        If (ch = 32) Or (ch = 9) Then
+          ParseMemDirective
+        Else
+        Begin
+          While (ch <> 125) And (ch <> -1) Do NextChar;
+          If ch = 125 Then NextChar
+        End;
+        SkipWhitespace
+      End
       Else
       Begin
         { Unknown directive, skip as comment }
@@ -1196,6 +1391,14 @@ Begin
             If (ToLower(tok_str[6]) = 97) And (ToLower(tok_str[7]) = 108) Then { al }
               tok_type := TOK_EXTERNAL
     End;
+    { AnsiString = 97,110,115,105,115,116,114,105,110,103 }
+    If tok_len = 10 Then
+      If (ToLower(tok_str[0]) = 97) And (ToLower(tok_str[1]) = 110) Then { an }
+        If (ToLower(tok_str[2]) = 115) And (ToLower(tok_str[3]) = 105) Then { si }
+          If (ToLower(tok_str[4]) = 115) And (ToLower(tok_str[5]) = 116) Then { st }
+            If (ToLower(tok_str[6]) = 114) And (ToLower(tok_str[7]) = 105) Then { ri }
+              If (ToLower(tok_str[8]) = 110) And (ToLower(tok_str[9]) = 103) Then { ng }
+                tok_type := TOK_ANSISTRING_TYPE;
     { Implementation = 105,109,112,108,101,109,101,110,116,97,116,105,111,110 }
     If tok_len = 14 Then
       If (ToLower(tok_str[0]) = 105) And (ToLower(tok_str[1]) = 109) Then { im }
@@ -1387,7 +1590,7 @@ End;
 
 Function SymAdd(kind, typ, level, offset: Integer): Integer;
 Begin
-  If sym_count >= 500 Then
+  If sym_count >= 1000 Then
     Error(21);  { Too many symbols }
   CopyTokenToSym(sym_count);
   sym_kind[sym_count] := kind;
@@ -1529,11 +1732,12 @@ Begin
     WriteLn('    ldur x9, [x9, #-8]')
 End;
 
-Procedure EmitMovX0(val: Integer);
+Procedure EmitMovReg(r, val: Integer);
 Var
-  lo, hi: Integer;
+  shift: Integer;
   neg: Integer;
 Begin
+  { x<r> := val, one movk per further non-zero 16-bit chunk }
   neg := 0;
   If val < 0 Then
   Begin
@@ -1542,17 +1746,33 @@ Begin
   End;
   If val > 65535 Then
   Begin
-    lo := val Mod 65536;
-    hi := val Div 65536;
-    Write('    movz x0, #'); WriteLn(lo);
-    Write('    movk x0, #'); Write(hi); WriteLn(', lsl #16')
+    Write('    movz x'); Write(r); Write(', #'); WriteLn(val Mod 65536);
+    val := val Div 65536;
+    shift := 16;
+    While val > 0 Do
+    Begin
+      If val Mod 65536 <> 0 Then
+      Begin
+        Write('    movk x'); Write(r); Write(', #'); Write(val Mod 65536);
+        Write(', lsl #'); WriteLn(shift)
+      End;
+      val := val Div 65536;
+      shift := shift + 16
+    End
   End
   Else
   Begin
-    Write('    mov x0, #'); WriteLn(val)
+    Write('    mov x'); Write(r); Write(', #'); WriteLn(val)
   End;
   If neg = 1 Then
-    WriteLn('    neg x0, x0')
+  Begin
+    Write('    neg x'); Write(r); Write(', x'); WriteLn(r)
+  End
+End;
+
+Procedure EmitMovX0(val: Integer);
+Begin
+  EmitMovReg(0, val)
 End;
 
 Procedure EmitMovX16(val: Integer);
@@ -1644,6 +1864,187 @@ Begin
   WriteLn('    str x1, [sp, #-16]!')
 End;
 
+{ ----- Operand Stack ----- }
+{ The left operand Of a binary operator waits In a register While the }
+{ right one is evaluated: slot k is x(11+k), Or d(16+k) For a Real. }
+{ Slots past OPND_REGS go To the machine stack. Calls clobber the }
+{ registers, so EmitBL saves the live slots around each call. }
+
+Procedure EmitPushOperandX(r: Integer);
+Begin
+  { Push x<r> onto the operand stack }
+  If opnd_depth < OPND_REGS Then
+  Begin
+    Write('    mov x'); Write(opnd_depth + 11); Write(', x'); WriteLn(r);
+    opnd_real[opnd_depth] := 0
+  End
+  Else
+  Begin
+    Write('    str x'); Write(r); WriteLn(', [sp, #-16]!')
+  End;
+  opnd_depth := opnd_depth + 1
+End;
+
+Procedure EmitPushOperand;
+Begin
+  EmitPushOperandX(0)
+End;
+
+Procedure EmitPushConstOperand(val: Integer);
+Begin
+  { Push a constant left operand whose code was never emitted; the right }
+  { operand is already In x0 }
+  If opnd_depth < OPND_REGS Then
+  Begin
+    EmitMovReg(opnd_depth + 11, val);
+    opnd_real[opnd_depth] := 0
+  End
+  Else
+  Begin
+    EmitMovReg(1, val);
+    WriteLn('    str x1, [sp, #-16]!')
+  End;
+  opnd_depth := opnd_depth + 1
+End;
+
+Procedure EmitPushOperandD0;
+Begin
+  If opnd_depth < OPND_REGS Then
+  Begin
+    Write('    fmov d'); Write(opnd_depth + 16); WriteLn(', d0');
+    opnd_real[opnd_depth] := 1
+  End
+  Else
+    WriteLn('    str d0, [sp, #-16]!');
+  opnd_depth := opnd_depth + 1
+End;
+
+Function EmitPopOperand(r: Integer): Integer;
+Begin
+  { Pop the top slot And Return the x register holding it; a spilled }
+  { slot is loaded into x<r> }
+  opnd_depth := opnd_depth - 1;
+  If opnd_depth < OPND_REGS Then
+    EmitPopOperand := opnd_depth + 11
+  Else
+  Begin
+    Write('    ldr x'); Write(r); WriteLn(', [sp], #16');
+    EmitPopOperand := r
+  End
+End;
+
+Function EmitPopOperandD(r: Integer): Integer;
+Begin
+  opnd_depth := opnd_depth - 1;
+  If opnd_depth < OPND_REGS Then
+    EmitPopOperandD := opnd_depth + 16
+  Else
+  Begin
+    Write('    ldr d'); Write(r); WriteLn(', [sp], #16');
+    EmitPopOperandD := r
+  End
+End;
+
+Procedure EmitPopOperandTo(r: Integer);
+Var
+  src: Integer;
+Begin
+  { Pop the top slot into x<r> }
+  src := EmitPopOperand(r);
+  If src <> r Then
+  Begin
+    Write('    mov x'); Write(r); Write(', x'); WriteLn(src)
+  End
+End;
+
+Procedure EmitPopOperandToD(r: Integer);
+Var
+  src: Integer;
+Begin
+  src := EmitPopOperandD(r);
+  If src <> r Then
+  Begin
+    Write('    fmov d'); Write(r); Write(', d'); WriteLn(src)
+  End
+End;
+
+Procedure WriteOperandReg(k: Integer);
+Begin
+  { Name Of the register behind slot k }
+  If opnd_real[k] = 1 Then
+  Begin
+    Write('d'); Write(k + 16)
+  End
+  Else
+  Begin
+    Write('x'); Write(k + 11)
+  End
+End;
+
+Procedure EmitOperandSlots(load: Integer);
+Var
+  k, n, pair: Integer;
+Begin
+  { Store (load = 0) Or reload (load = 1) the live register slots at }
+  { [sp, #8k], pairing neighbours Of the same kind }
+  n := opnd_depth;
+  If n > OPND_REGS Then
+    n := OPND_REGS;
+  k := 0;
+  While k < n Do
+  Begin
+    pair := 0;
+    If k + 1 < n Then
+      If opnd_real[k] = opnd_real[k + 1] Then
+        pair := 1;
+    If load = 1 Then
+      Write('    ld')
+    Else
+      Write('    st');
+    If pair = 1 Then
+      Write('p ')
+    Else
+      Write('r ');
+    WriteOperandReg(k);
+    If pair = 1 Then
+    Begin
+      Write(', ');
+      WriteOperandReg(k + 1)
+    End;
+    Write(', [sp, #'); Write(k * 8); WriteLn(']');
+    k := k + 1 + pair
+  End
+End;
+
+Procedure EmitSaveOperands;
+Var
+  n: Integer;
+Begin
+  { Save live register slots before a call }
+  n := opnd_depth;
+  If n > OPND_REGS Then
+    n := OPND_REGS;
+  If n > 0 Then
+  Begin
+    Write('    sub sp, sp, #'); WriteLn(((n + 1) Div 2) * 16);
+    EmitOperandSlots(0)
+  End
+End;
+
+Procedure EmitRestoreOperands;
+Var
+  n: Integer;
+Begin
+  n := opnd_depth;
+  If n > OPND_REGS Then
+    n := OPND_REGS;
+  If n > 0 Then
+  Begin
+    EmitOperandSlots(1);
+    Write('    add sp, sp, #'); WriteLn(((n + 1) Div 2) * 16)
+  End
+End;
+
 Procedure EmitAdd;
 Begin
   WriteLn('    add x0, x1, x0')
@@ -1686,7 +2087,55 @@ End;
 
 Procedure EmitBL(lbl: Integer);
 Begin
-  Write('    bl L'); WriteLn(lbl)
+  EmitSaveOperands;
+  Write('    bl L'); WriteLn(lbl);
+  EmitRestoreOperands
+End;
+
+Procedure EmitLitFlush;
+Var
+  lbl, i: Integer;
+Begin
+  { Emit the collected Write literal: the bytes go To the read-only }
+  { __const section And one rt_write_buf call writes them all }
+  If lit_len = 1 Then
+  Begin
+    EmitMovX0(lit_buf[0]);
+    EmitBL(rt_print_char)
+  End
+  Else If lit_len > 1 Then
+  Begin
+    lbl := NewLabel;
+    WriteLn('.section __TEXT,__const');
+    EmitLabel(lbl);
+    i := 0;
+    While i < lit_len Do
+    Begin
+      If i Mod 16 = 0 Then
+        Write('    .byte ')
+      Else
+        Write(',');
+      Write(lit_buf[i]);
+      If (i Mod 16 = 15) Or (i = lit_len - 1) Then
+        WriteLn;
+      i := i + 1
+    End;
+    WriteLn('.text');
+    Write('    adrp x1, L'); Write(lbl); WriteLn('@PAGE');
+    Write('    add x1, x1, L'); Write(lbl); WriteLn('@PAGEOFF');
+    Write('    mov x2, #'); WriteLn(lit_len);
+    EmitBL(rt_write_buf)
+  End;
+  lit_len := 0
+End;
+
+Procedure EmitLitChar(c: Integer);
+Begin
+  { Queue one byte Of Write literal output }
+  If lit_len > 255 Then
+    EmitLitFlush;
+  lit_buf[lit_len] := c;
+  lit_len := lit_len + 1
 End;
 
 Procedure EmitBLExternal(sym_idx: Integer);
@@ -1694,6 +2143,7 @@ Var
   i, base: Integer;
 Begin
   { Emit: bl _symbolname (for external C functions) }
+  EmitSaveOperands;
   Write('    bl _');
   base := sym_idx * 32;
   i := 0;
@@ -1702,7 +2152,8 @@ Begin
     WriteChar(sym_name[base + i]);
     i := i + 1
   End;
-  WriteLn
+  WriteLn;
+  EmitRestoreOperands
 End;
 
 Procedure EmitCmpX0X1;
@@ -1921,69 +2372,352 @@ Begin
   WriteLn('    msub x0, x0, x2, x1')
 End;
 
-Procedure EmitMovX2X0;
+Procedure EmitIntOp(op, r: Integer);
 Begin
-  WriteLn('    mov x2, x0')
+  { x0 := x<r> op x0 For +, -, *, Div And Mod }
+  If op = TOK_MOD Then
+  Begin
+    Write('    sdiv x2, x'); Write(r); WriteLn(', x0');
+    Write('    msub x0, x2, x0, x'); WriteLn(r)
+  End
+  Else
+  Begin
+    If op = TOK_PLUS Then
+      Write('    add')
+    Else If op = TOK_MINUS Then
+      Write('    sub')
+    Else If op = TOK_STAR Then
+      Write('    mul')
+    Else
+      Write('    sdiv');
+    Write(' x0, x'); Write(r); WriteLn(', x0')
+  End
 End;
 
-Procedure EmitAndX0X1;
+Procedure EmitCmpReg(r: Integer);
 Begin
-  WriteLn('    And x0, x1, x0')
+  Write('    cmp x'); Write(r); WriteLn(', x0')
 End;
 
-Procedure EmitOrrX0X1;
-Begin
-  WriteLn('    orr x0, x1, x0')
-End;
+{ ----- Immediate Operands ----- }
 
-Procedure EmitAndImm(val: Integer);
+Function ArithImmFits(val: Integer): Integer;
 Begin
-  Write('    And x0, x0, #'); WriteLn(val)
+  { 1 If add, sub, cmp Or cmn can encode |val|: 12 bits, optionally lsl #12 }
+  If val < 0 Then
+    val := 0 - val;
+  ArithImmFits := 0;
+  If val >= 0 Then
+  Begin
+    If val <= 4095 Then
+      ArithImmFits := 1
+    Else If (val Mod 4096 = 0) And (val <= 16773120) Then
+      ArithImmFits := 1
+  End
 End;
 
-Procedure EmitEorX0(val: Integer);
+Procedure EmitArithImm(val: Integer);
 Begin
-  Write('    eor x0, x0, #'); WriteLn(val)
+  { The immediate operand For a non-negative val that ArithImmFits }
+  If val > 4095 Then
+  Begin
+    Write('#'); Write(val Div 4096); WriteLn(', lsl #12')
+  End
+  Else
+  Begin
+    Write('#'); WriteLn(val)
+  End
 End;
 
-{ ----- Floating Point Emitters ----- }
-
-Procedure EmitPushD0;
+Procedure EmitAddImm(dest, r, val: Integer);
 Begin
-  WriteLn('    str d0, [sp, #-16]!')
+  { x<dest> := x<r> + val, As a sub For negative val }
+  If val = 0 Then
+  Begin
+    If dest <> r Then
+    Begin
+      Write('    mov x'); Write(dest); Write(', x'); WriteLn(r)
+    End
+  End
+  Else
+  Begin
+    If val < 0 Then
+    Begin
+      Write('    sub x');
+      val := 0 - val
+    End
+    Else
+      Write('    add x');
+    Write(dest); Write(', x'); Write(r); Write(', ');
+    EmitArithImm(val)
+  End
 End;
 
-Procedure EmitPopD0;
+Procedure EmitCmpImm(r, val: Integer);
 Begin
-  WriteLn('    ldr d0, [sp], #16')
+  { Compare x<r> With val, As a cmn For negative val }
+  If val < 0 Then
+  Begin
+    Write('    cmn x');
+    val := 0 - val
+  End
+  Else
+    Write('    cmp x');
+  Write(r); Write(', ');
+  EmitArithImm(val)
 End;
 
-Procedure EmitPopD1;
+Procedure EmitAddX0Const(val: Integer);
 Begin
-  WriteLn('    ldr d1, [sp], #16')
+  { x0 := x0 + val; a val too wide For an immediate goes through x1 }
+  If ArithImmFits(val) = 1 Then
+    EmitAddImm(0, 0, val)
+  Else
+  Begin
+    EmitMovReg(1, val);
+    WriteLn('    add x0, x0, x1')
+  End
 End;
 
-Procedure EmitFAdd;
-Begin
-  WriteLn('    fadd d0, d1, d0')
-End;
+{ ----- Strength Reduction ----- }
 
-Procedure EmitFSub;
+Function Log2Exact(a: Integer): Integer;
+Var
+  k: Integer;
 Begin
-  WriteLn('    fsub d0, d1, d0')
+  { k If a = 2^k (a > 0), Else -1 }
+  k := 0;
+  While (a > 1) And (a Mod 2 = 0) Do
+  Begin
+    a := a Div 2;
+    k := k + 1
+  End;
+  If a = 1 Then
+    Log2Exact := k
+  Else
+    Log2Exact := -1
 End;
 
-Procedure EmitFMul;
+Function DivMagic(a, l: Integer): Integer;
+Var
+  i, r, q: Integer;
 Begin
-  WriteLn('    fmul d0, d1, d0')
+  { Low 64 bits Of 1 + floor(2^(63+l) / a), by long division; With }
+  { 2^(l-1) < a < 2^l this is the signed division multiplier from }
+  { Granlund And Montgomery. r stays below a, q wraps }
+  r := 1;
+  q := 0;
+  For i := 1 To 63 + l Do
+  Begin
+    r := r + r;
+    q := q + q;
+    If r >= a Then
+    Begin
+      r := r - a;
+      q := q + 1
+    End
+  End;
+  DivMagic := q + 1
 End;
 
-Procedure EmitFDiv;
+Procedure EmitMulConst(r, c: Integer);
+Var
+  a, neg: Integer;
 Begin
-  WriteLn('    fdiv d0, d1, d0')
+  { x0 := x<r> * c, using shifts And adds when |c| is 2^k Or 2^k +/- 1 }
+  a := c;
+  If a < 0 Then
+    a := 0 - a;
+  neg := 0;
+  If a = 0 Then
+    WriteLn('    mov x0, #0')
+  Else If a = 1 Then
+  Begin
+    If c < 0 Then
+    Begin
+      Write('    neg x0, x'); WriteLn(r)
+    End
+    Else If r <> 0 Then
+    Begin
+      Write('    mov x0, x'); WriteLn(r)
+    End
+  End
+  Else If Log2Exact(a) > 0 Then
+  Begin
+    Write('    lsl x0, x'); Write(r); Write(', #'); WriteLn(Log2Exact(a));
+    neg := 1
+  End
+  Else If Log2Exact(a - 1) > 0 Then
+  Begin
+    { x * (2^k + 1) = x + (x << k) }
+    Write('    add x0, x'); Write(r); Write(', x'); Write(r);
+    Write(', lsl #'); WriteLn(Log2Exact(a - 1));
+    neg := 1
+  End
+  Else If Log2Exact(a + 1) > 0 Then
+  Begin
+    { x * (2^k - 1) = (x << k) - x }
+    Write('    lsl x2, x'); Write(r); Write(', #'); WriteLn(Log2Exact(a + 1));
+    Write('    sub x0, x2, x'); WriteLn(r);
+    neg := 1
+  End
+  Else
+  Begin
+    EmitMovReg(2, c);
+    Write('    mul x0, x'); Write(r); WriteLn(', x2')
+  End;
+  If (neg = 1) And (c < 0) Then
+    WriteLn('    neg x0, x0')
 End;
 
-Procedure EmitFNeg;
+Procedure EmitSDivConst(dest, r, a: Integer);
+Var
+  k, l: Integer;
+Begin
+  { x<dest> := x<r> Div a For 2 <= a < 2^62, rounding toward zero; }
+  { uses x2 }
+  k := Log2Exact(a);
+  If k > 0 Then
+  Begin
+    { Add a - 1 To negative dividends, Then shift }
+    Write('    asr x2, x'); Write(r); WriteLn(', #63');
+    Write('    add x2, x'); Write(r); Write(', x2, lsr #'); WriteLn(64 - k);
+    Write('    asr x'); Write(dest); Write(', x2, #'); WriteLn(k)
+  End
+  Else
+  Begin
+    { Multiply by the magic number, keep the high half And add one }
+    { For negative dividends }
+    l := 0;
+    k := 1;
+    While k < a Do
+    Begin
+      k := k + k;
+      l := l + 1
+    End;
+    EmitMovReg(2, DivMagic(a, l));
+    Write('    smulh x2, x'); Write(r); WriteLn(', x2');
+    Write('    add x2, x2, x'); WriteLn(r);
+    Write('    asr x2, x2, #'); WriteLn(l - 1);
+    Write('    sub x'); Write(dest); Write(', x2, x'); Write(r); WriteLn(', asr #63')
+  End
+End;
+
+Procedure EmitDivConst(r, c: Integer);
+Var
+  a: Integer;
+Begin
+  { x0 := x<r> Div c }
+  a := c;
+  If a < 0 Then
+    a := 0 - a;
+  If (a < 2) Or (a >= 4611686018427387904) Then
+  Begin
+    { 0, 1, -1 And huge divisors: plain sdiv }
+    EmitMovReg(2, c);
+    Write('    sdiv x0, x'); Write(r); WriteLn(', x2')
+  End
+  Else
+  Begin
+    EmitSDivConst(0, r, a);
+    If c < 0 Then
+      WriteLn('    neg x0, x0')
+  End
+End;
+
+Procedure EmitModConst(r, c: Integer);
+Var
+  a, k: Integer;
+Begin
+  { x0 := x<r> Mod c; the sign follows the dividend, so only |c| matters }
+  a := c;
+  If a < 0 Then
+    a := 0 - a;
+  If (a < 2) Or (a >= 4611686018427387904) Then
+  Begin
+    EmitMovReg(2, c);
+    Write('    sdiv x3, x'); Write(r); WriteLn(', x2');
+    Write('    msub x0, x3, x2, x'); WriteLn(r)
+  End
+  Else
+  Begin
+    EmitSDivConst(2, r, a);
+    k := Log2Exact(a);
+    If k > 0 Then
+    Begin
+      Write('    sub x0, x'); Write(r); Write(', x2, lsl #'); WriteLn(k)
+    End
+    Else
+    Begin
+      EmitMovReg(3, a);
+      Write('    msub x0, x2, x3, x'); WriteLn(r)
+    End
+  End
+End;
+
+Procedure EmitMovX2X0;
+Begin
+  WriteLn('    mov x2, x0')
+End;
+
+Procedure EmitAndX0X1;
+Begin
+  WriteLn('    And x0, x1, x0')
+End;
+
+Procedure EmitOrrX0X1;
+Begin
+  WriteLn('    orr x0, x1, x0')
+End;
+
+Procedure EmitAndImm(val: Integer);
+Begin
+  Write('    And x0, x0, #'); WriteLn(val)
+End;
+
+Procedure EmitEorX0(val: Integer);
+Begin
+  Write('    eor x0, x0, #'); WriteLn(val)
+End;
+
+{ ----- Floating Point Emitters ----- }
+
+Procedure EmitPushD0;
+Begin
+  WriteLn('    str d0, [sp, #-16]!')
+End;
+
+Procedure EmitPopD0;
+Begin
+  WriteLn('    ldr d0, [sp], #16')
+End;
+
+Procedure EmitPopD1;
+Begin
+  WriteLn('    ldr d1, [sp], #16')
+End;
+
+Procedure EmitFAdd;
+Begin
+  WriteLn('    fadd d0, d1, d0')
+End;
+
+Procedure EmitFSub;
+Begin
+  WriteLn('    fsub d0, d1, d0')
+End;
+
+Procedure EmitFMul;
+Begin
+  WriteLn('    fmul d0, d1, d0')
+End;
+
+Procedure EmitFDiv;
+Begin
+  WriteLn('    fdiv d0, d1, d0')
+End;
+
+Procedure EmitFNeg;
 Begin
   WriteLn('    fneg d0, d0')
 End;
@@ -1993,6 +2727,25 @@ Begin
   WriteLn('    fcmp d1, d0')
 End;
 
+Procedure EmitFloatOp(op, r: Integer);
+Begin
+  { d0 := d<r> op d0; Div And / both divide }
+  If op = TOK_PLUS Then
+    Write('    fadd')
+  Else If op = TOK_MINUS Then
+    Write('    fsub')
+  Else If op = TOK_STAR Then
+    Write('    fmul')
+  Else
+    Write('    fdiv');
+  Write(' d0, d'); Write(r); WriteLn(', d0')
+End;
+
+Procedure EmitFCmpReg(r: Integer);
+Begin
+  Write('    fcmp d'); Write(r); WriteLn(', d0')
+End;
+
 Procedure EmitScvtfD0X0;
 Begin
   WriteLn('    scvtf d0, x0')
@@ -2110,11 +2863,13 @@ End;
 
 Procedure EmitBLUnitProc(unit_idx, sym_idx: Integer);
 Begin
+  EmitSaveOperands;
   Write('    bl _');
   WriteLoadedUnitName(unit_idx);
   Write('_');
   WriteSymName(sym_idx);
-  WriteLn
+  WriteLn;
+  EmitRestoreOperands
 End;
 
 Procedure EmitGloblUnitInit;
@@ -2140,133 +2895,95 @@ End;
 
 { ----- Print Runtime ----- }
 
-Procedure EmitPrintIntRuntime;
+Procedure EmitFmtIntRuntime;
 Var
-  loop_lbl, done_lbl, neg_lbl, print_lbl: Integer;
+  table_lbl, loop_lbl, tail_lbl, one_lbl, sign_lbl, done_lbl, i, lo_digit: Integer;
 Begin
-  { Runtime routine To print Integer In x0 }
-  EmitLabel(rt_print_int);
-  EmitStp;
-  EmitMovFP;
-  EmitSubSP(48);
-  { Save value }
-  EmitSturX0(-24);
-
-  { Handle negative }
-  neg_lbl := NewLabel;
-  done_lbl := NewLabel;
-  WriteLn('    cmp x0, #0');
-
-  Write('    b.ge L'); WriteLn(neg_lbl);
-
-  { Print minus sign }
-  EmitMovX0(1);
-  EmitSturX0(-32);
-  EmitMovX0(45);  { '-' }
-  EmitSturX0(-8);
-  EmitMovX16(33554436); { 0x2000004 }
-  EmitMovX0X20;
-  WriteLn('    sub x1, x29, #8');
-  WriteLn('    mov x2, #1');
-  EmitSvc;
-
-  { Negate }
-  EmitLdurX0(-24);
-  EmitNeg;
-  EmitSturX0(-24);
-
-  EmitLabel(neg_lbl);
-
-  { Convert To String (digits In reverse) }
-  EmitMovX0(0);
-  EmitSturX0(-40);  { digit count }
-
-  loop_lbl := NewLabel;
-  print_lbl := NewLabel;
-
-  EmitLabel(loop_lbl);
-  EmitLdurX0(-24);
-  EmitBranchLabelZ(print_lbl);
-
-  { val % 10 }
-  EmitLdurX0(-24);
-  EmitPushX0;
-  EmitMovX0(10);
-  EmitPopX1;
-  EmitSDiv;
-  EmitMovX2X0;
-  EmitLdurX0(-24);
-  EmitPushX0;
-  EmitMovX0(10);
-  EmitPopX1;
-  EmitMsub;
-
-  { Store digit }
-  WriteLn('    add x0, x0, #48');
-
-  WriteLn('    ldur x1, [x29, #-40]');
-
-  WriteLn('    sub x2, x29, #48');
-
-  WriteLn('    strb w0, [x2, x1]');
-
-  { digit count++ }
-  WriteLn('    add x1, x1, #1');
-
-  WriteLn('    stur x1, [x29, #-40]');
-
-  { val /= 10 }
-  EmitLdurX0(-24);
-  EmitPushX0;
-  EmitMovX0(10);
-  EmitPopX1;
-  EmitSDiv;
-  EmitSturX0(-24);
-
-  EmitBranchLabel(loop_lbl);
-
-  EmitLabel(print_lbl);
-
-  { Handle zero }
-  EmitLdurX0(-40);
-  EmitBranchLabelNZ(done_lbl);
-  EmitMovX0(48);  { '0' }
-  EmitSturX0(-48);
-  EmitMovX0(1);
-  EmitSturX0(-40);
-
-  EmitLabel(done_lbl);
-
-  { Print digits In reverse order }
+  { Format Integer - x0 = value, x1 = End Of a scratch area (>= 20 bytes) }
+  { Digits are written backwards from x1, two at a time from a table, }
+  { using a multiply by the reciprocal Of 100 instead Of a divide }
+  { Returns x1 = first Char, x2 = Length. Leaf, clobbers x0-x7, x16 }
+  table_lbl := NewLabel;
   loop_lbl := NewLabel;
+  tail_lbl := NewLabel;
+  one_lbl := NewLabel;
+  sign_lbl := NewLabel;
   done_lbl := NewLabel;
-  EmitLabel(loop_lbl);
-  EmitLdurX0(-40);
-  EmitBranchLabelZ(done_lbl);
 
-  { digit count-- }
-  WriteLn('    sub x0, x0, #1');
-  EmitSturX0(-40);
-
-  { Load digit }
-  WriteLn('    sub x1, x29, #48');
-
-  WriteLn('    ldrb w0, [x1, x0]');
-
-  { Print Char }
-  EmitSturX0(-8);
-  EmitMovX16(33554436);
-  EmitMovX0X20;
-  WriteLn('    sub x1, x29, #8');
-  WriteLn('    mov x2, #1');
-  EmitSvc;
+  { '00' '01' .. '99' }
+  WriteLn('.section __TEXT,__const');
+  EmitLabel(table_lbl);
+  For i := 0 To 9 Do
+  Begin
+    Write('    .ascii "');
+    For lo_digit := 0 To 9 Do
+    Begin
+      Write(i); Write(lo_digit)
+    End;
+    WriteLn('"')
+  End;
+  WriteLn('.text');
 
+  EmitLabel(rt_fmt_int);
+  WriteLn('    mov x16, x1');
+  { x3 = magnitude; unsigned, so the most negative value works too }
+  WriteLn('    cmp x0, #0');
+  WriteLn('    cneg x3, x0, lt');
+  Write('    adrp x6, L'); Write(table_lbl); WriteLn('@PAGE');
+  Write('    add x6, x6, L'); Write(table_lbl); WriteLn('@PAGEOFF');
+  WriteLn('    mov x5, #100');
+  { x7 = 0x28F5C28F5C28F5C3: n / 100 = umulh(n >> 2, x7) >> 2 }
+  WriteLn('    movz x7, #0xF5C3');
+  WriteLn('    movk x7, #0x5C28, lsl #16');
+  WriteLn('    movk x7, #0xC28F, lsl #32');
+  WriteLn('    movk x7, #0x28F5, lsl #48');
+
+  { Two digits per step while n >= 100 }
+  EmitLabel(loop_lbl);
+  WriteLn('    cmp x3, #100');
+  Write('    b.lo L'); WriteLn(tail_lbl);
+  WriteLn('    lsr x4, x3, #2');
+  WriteLn('    umulh x4, x4, x7');
+  WriteLn('    lsr x4, x4, #2');
+  WriteLn('    msub x2, x4, x5, x3');
+  WriteLn('    ldrh w2, [x6, x2, lsl #1]');
+  WriteLn('    strh w2, [x1, #-2]!');
+  WriteLn('    mov x3, x4');
   EmitBranchLabel(loop_lbl);
 
-  { Exit label }
+  { Last one Or two digits }
+  EmitLabel(tail_lbl);
+  WriteLn('    cmp x3, #10');
+  Write('    b.lo L'); WriteLn(one_lbl);
+  WriteLn('    ldrh w2, [x6, x3, lsl #1]');
+  WriteLn('    strh w2, [x1, #-2]!');
+  EmitBranchLabel(sign_lbl);
+  EmitLabel(one_lbl);
+  WriteLn('    add w2, w3, #48');
+  WriteLn('    strb w2, [x1, #-1]!');
+
+  EmitLabel(sign_lbl);
+  WriteLn('    cmp x0, #0');
+  Write('    b.ge L'); WriteLn(done_lbl);
+  WriteLn('    mov w2, #45');
+  WriteLn('    strb w2, [x1, #-1]!');
   EmitLabel(done_lbl);
+  WriteLn('    sub x2, x16, x1');
+  EmitRet
+End;
 
-  EmitAddSP(48);
+Procedure EmitPrintIntRuntime;
+Begin
+  { Runtime routine To print Integer In x0 }
+  { Formats into the frame, Then one rt_write_buf call }
+  EmitLabel(rt_print_int);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(32);
+  WriteLn('    mov x1, x29');
+  EmitBL(rt_fmt_int);
+  EmitBL(rt_write_buf);
+  EmitAddSP(32);
   EmitLdp;
   EmitRet
 End;
@@ -2277,623 +2994,3381 @@ Begin
   EmitLabel(rt_newline);
   EmitStp;
   EmitMovFP;
-  EmitSubSP(16);
   EmitMovX0(10);
-  EmitSturX0(-9);
-  EmitMovX16(33554436);  { 0x2000004 = Write }
-  EmitMovX0X20;
-  WriteLn('    sub x1, x29, #9');
-  WriteLn('    mov x2, #1');
-  EmitSvc;
-  EmitAddSP(16);
+  EmitBL(rt_print_char);
   EmitLdp;
   EmitRet
 End;
 
-Procedure EmitReadcharRuntime;
+{ ----- Buffered I/O Runtime ----- }
+
+{ Every fd In use has a 64-byte descriptor: }
+{   [d]      fd }
+{   [d, #8]  next unread index   [d, #16] bytes valid (Read-ahead) }
+{   [d, #24] buffer address      [d, #32] buffer size }
+{   [d, #40] next free byte      [d, #48] End Of buffer (pending Write) }
+{   [d, #56] 1 If mapped by rt_io_open (unmapped at Close) }
+{ A descriptor holds either Read-ahead Or pending output, never both. }
+{ stdin And stdout have descriptors In the I/O state block, files opened }
+{ by Reset/Rewrite get their own, And any other fd shares one spare. }
+{ Descriptors mapped by rt_io_open (128 bytes, buffer after them) also }
+{ track the fd's position so FilePos And FileSize need no lseek, And }
+{ hold the file's MapFile mapping: }
+{   [d, #64] kernel file offset   [d, #72] file size (-1 = Not known yet) }
+{   [d, #80] mapping address      [d, #88] mapping Length }
+{   [d, #96] 1 If the mapping is synced To disk before it is unmapped }
+
+Procedure EmitIoAdvance(d, n, t1, t2: Integer);
+Var
+  skip_lbl: Integer;
 Begin
-  { ReadChar routine - Read one Char, return In x0 (-1 For EOF) }
-  { Uses x19 as input file descriptor (0=stdin, Or opened file) }
-  EmitLabel(rt_readchar);
-  EmitStp;
-  EmitMovFP;
-  EmitSubSP(16);
-  WriteLn('    mov x0, x19');
-  WriteLn('    mov x1, sp');
-  WriteLn('    mov x2, #1');
-  EmitMovX16(33554435);  { 0x2000003 = Read }
-  EmitSvc;
-  { Check If Read returned >= 1 }
-  WriteLn('    cmp x0, #1');
-  Write('    b.ge L'); WriteLn(label_count);
-  EmitMovX0(-1);  { EOF }
-  EmitBranchLabel(label_count + 1);
-  EmitLabel(label_count);
-  label_count := label_count + 1;
-  WriteLn('    ldrb w0, [sp]');
-  EmitLabel(label_count);
-  label_count := label_count + 1;
-  EmitAddSP(16);
-  EmitLdp;
-  EmitRet
+  { After a Read Or Write Of xn bytes through descriptor xd: advance an }
+  { owned descriptor's file offset And grow its known size. Uses xt1, xt2 }
+  skip_lbl := NewLabel;
+  Write('    ldr x'); Write(t1); Write(', [x'); Write(d); WriteLn(', #56]');
+  Write('    cbz x'); Write(t1); Write(', L'); WriteLn(skip_lbl);
+  Write('    ldp x'); Write(t1); Write(', x'); Write(t2); Write(', [x'); Write(d); WriteLn(', #64]');
+  Write('    add x'); Write(t1); Write(', x'); Write(t1); Write(', x'); WriteLn(n);
+  Write('    cmp x'); Write(t1); Write(', x'); WriteLn(t2);
+  Write('    csel x'); Write(t2); Write(', x'); Write(t1); Write(', x'); Write(t2); WriteLn(', hi');
+  Write('    stp x'); Write(t1); Write(', x'); Write(t2); Write(', [x'); Write(d); WriteLn(', #64]');
+  EmitLabel(skip_lbl)
 End;
 
-Procedure EmitPrintCharRuntime;
+Procedure EmitInputPeek(eof_lbl: Integer);
+Var
+  retry_lbl, fill_lbl, have_lbl: Integer;
 Begin
-  { Print Char routine - print Char In x0 }
-  EmitLabel(rt_print_char);
-  EmitStp;
-  EmitMovFP;
-  EmitSubSP(16);
-  WriteLn('    strb w0, [sp]');
-  EmitMovX16(33554436);  { 0x2000004 = Write }
-  EmitMovX0X20;
-  WriteLn('    mov x1, sp');
-  WriteLn('    mov x2, #1');
-  EmitSvc;
-  EmitAddSP(16);
-  EmitLdp;
-  EmitRet
+  { Inline peek at the next input byte For fd x19 }
+  { Result: x0 = byte, x1 = its index, x3 = input descriptor; branches To }
+  { eof_lbl at End Of input. Consume the byte With EmitInputConsume }
+  retry_lbl := NewLabel;
+  fill_lbl := NewLabel;
+  have_lbl := NewLabel;
+  EmitLabel(retry_lbl);
+  WriteLn('    ldr x3, [x28, #8]');
+  WriteLn('    ldr x1, [x3]');
+  WriteLn('    cmp x1, x19');
+  Write('    b.ne L'); WriteLn(fill_lbl);
+  WriteLn('    ldp x1, x2, [x3, #8]');
+  WriteLn('    cmp x1, x2');
+  Write('    b.lt L'); WriteLn(have_lbl);
+  EmitLabel(fill_lbl);
+  EmitBL(rt_fill_input);
+  Write('    cbz x0, L'); WriteLn(eof_lbl);
+  EmitBranchLabel(retry_lbl);
+  EmitLabel(have_lbl);
+  WriteLn('    ldr x2, [x3, #24]');
+  WriteLn('    ldrb w0, [x2, x1]')
 End;
 
-Procedure EmitWriteCharFdRuntime;
+Procedure EmitInputConsume;
 Begin
-  { Write Char To fd routine - x0=fd, x1=Char }
-  EmitLabel(rt_write_char_fd);
-  EmitStp;
-  EmitMovFP;
-  EmitSubSP(16);
-  { Store Char on stack }
-  WriteLn('    strb w1, [sp]');
-  { x0 already has fd, Set up rest Of syscall }
-  EmitMovX16(33554436);  { 0x2000004 = Write }
-  WriteLn('    mov x1, sp');
-  WriteLn('    mov x2, #1');
-  EmitSvc;
-  EmitAddSP(16);
-  EmitLdp;
-  EmitRet
+  { Advance past the byte returned by EmitInputPeek }
+  WriteLn('    add x1, x1, #1');
+  WriteLn('    str x1, [x3, #8]')
 End;
 
-Procedure EmitPrintStringRuntime;
+Procedure EmitFlushDescRuntime;
 Var
   loop_lbl, done_lbl: Integer;
 Begin
-  { Print String routine - x0 = address Of pascal String (Length byte + chars) }
+  { Flush descriptor - x0 = descriptor, Write its pending bytes To its fd }
+  { Loops on short writes; a Write error discards the rest }
+  { Clobbers x0-x3 }
   loop_lbl := NewLabel;
   done_lbl := NewLabel;
-  EmitLabel(rt_print_string);
+  EmitLabel(rt_flush_desc);
   EmitStp;
   EmitMovFP;
   EmitSubSP(32);
-  { Save base address To [x29, #-8] }
   WriteLn('    stur x0, [x29, #-8]');
-  { Load Length from [x0] into x1 And save To [x29, #-16] }
-  WriteLn('    ldrb w1, [x0]');
+  WriteLn('    ldr x1, [x0, #24]');
+  WriteLn('    ldr x2, [x0, #40]');
+  WriteLn('    subs x2, x2, x1');
+  Write('    b.le L'); WriteLn(done_lbl);
+  EmitLabel(loop_lbl);
+  { [x29-16] = next byte To Write, [x29-24] = bytes left }
   WriteLn('    stur x1, [x29, #-16]');
-  { Initialize index To 0 at [x29, #-24] }
-  WriteLn('    mov x2, #0');
   WriteLn('    stur x2, [x29, #-24]');
-  { Loop label }
-  EmitLabel(loop_lbl);
-  { Load index And Length, compare }
-  WriteLn('    ldur x2, [x29, #-24]');
+  WriteLn('    ldur x3, [x29, #-8]');
+  WriteLn('    ldr x0, [x3]');
+  EmitMovX16(33554436);  { 0x2000004 = Write }
+  EmitSvc;
+  Write('    b.cs L'); WriteLn(done_lbl);
+  WriteLn('    ldur x3, [x29, #-8]');
+  EmitIoAdvance(3, 0, 1, 2);
   WriteLn('    ldur x1, [x29, #-16]');
-  WriteLn('    cmp x2, x1');
-  { b.ge done_lbl }
-  Write('    b.ge L'); WriteLn(done_lbl);
-  { Load Char at [base + index + 1] }
-  WriteLn('    ldur x0, [x29, #-8]');
-  WriteLn('    add x0, x0, x2');
-  WriteLn('    add x0, x0, #1');
-  WriteLn('    ldrb w0, [x0]');
-  { Call print_char }
-  EmitBL(rt_print_char);
-  { Increment index }
   WriteLn('    ldur x2, [x29, #-24]');
-  WriteLn('    add x2, x2, #1');
-  WriteLn('    stur x2, [x29, #-24]');
-  { Branch back To loop }
-  EmitBranchLabel(loop_lbl);
-  { Done label }
+  WriteLn('    add x1, x1, x0');
+  WriteLn('    subs x2, x2, x0');
+  Write('    b.gt L'); WriteLn(loop_lbl);
   EmitLabel(done_lbl);
+  WriteLn('    ldur x3, [x29, #-8]');
+  WriteLn('    ldr x1, [x3, #24]');
+  WriteLn('    str x1, [x3, #40]');
   EmitAddSP(32);
   EmitLdp;
   EmitRet
 End;
 
-Procedure EmitReadIntRuntime;
+Procedure EmitFlushOutputRuntime;
+Begin
+  { Flush output - Write out what belongs on the terminal: stdout And the }
+  { spare descriptor (stderr And raw fds). Clobbers x0-x3 }
+  EmitLabel(rt_flush_output);
+  EmitStp;
+  EmitMovFP;
+  WriteLn('    add x0, x28, #128');
+  EmitBL(rt_flush_desc);
+  WriteLn('    add x0, x28, #192');
+  EmitBL(rt_flush_desc);
+  EmitLdp;
+  EmitRet
+End;
+
+Procedure EmitFlushAllRuntime;
 Var
-  skip_ws_lbl, read_digit_lbl, done_lbl, neg_lbl, not_neg_lbl, skip_neg_lbl: Integer;
+  loop_lbl, next_lbl: Integer;
 Begin
-  { Read Integer routine - reads from x19 (input fd), returns In x0 }
-  { Skips whitespace, handles optional minus sign, reads digits }
-  EmitLabel(rt_read_int);
+  { Flush all - Write out every descriptor's pending output (program End) }
+  { Clobbers x0-x3 }
+  loop_lbl := NewLabel;
+  next_lbl := NewLabel;
+  EmitLabel(rt_flush_all);
   EmitStp;
   EmitMovFP;
-  EmitSubSP(48);
+  EmitSubSP(16);
+  WriteLn('    add x0, x28, #192');
+  EmitBL(rt_flush_desc);
+  { [x29-8] = fd table index }
+  WriteLn('    stur xzr, [x29, #-8]');
+  EmitLabel(loop_lbl);
+  WriteLn('    ldur x1, [x29, #-8]');
+  WriteLn('    add x0, x28, #256');
+  WriteLn('    ldr x0, [x0, x1, lsl #3]');
+  Write('    cbz x0, L'); WriteLn(next_lbl);
+  EmitBL(rt_flush_desc);
+  EmitLabel(next_lbl);
+  WriteLn('    ldur x1, [x29, #-8]');
+  WriteLn('    add x1, x1, #1');
+  WriteLn('    stur x1, [x29, #-8]');
+  WriteLn('    cmp x1, #256');
+  Write('    b.lt L'); WriteLn(loop_lbl);
+  EmitAddSP(16);
+  EmitLdp;
+  EmitRet
+End;
 
-  { x21 = accumulated value, x22 = negative flag }
-  WriteLn('    mov x21, #0');
-  WriteLn('    mov x22, #0');
+Procedure EmitIoFindRuntime;
+Var
+  spare_lbl: Integer;
+Begin
+  { I/O find - x0 = fd, returns x0 = its descriptor Or 0 If it has none }
+  { Clobbers x1-x2 }
+  spare_lbl := NewLabel;
+  EmitLabel(rt_io_find);
+  WriteLn('    cmp x0, #256');
+  Write('    b.hs L'); WriteLn(spare_lbl);
+  WriteLn('    add x1, x28, #256');
+  WriteLn('    ldr x1, [x1, x0, lsl #3]');
+  Write('    cbz x1, L'); WriteLn(spare_lbl);
+  WriteLn('    mov x0, x1');
+  EmitRet;
+  EmitLabel(spare_lbl);
+  WriteLn('    add x1, x28, #192');
+  WriteLn('    ldr x2, [x1]');
+  WriteLn('    cmp x2, x0');
+  WriteLn('    csel x0, x1, xzr, eq');
+  EmitRet
+End;
 
-  { Skip whitespace loop }
-  skip_ws_lbl := NewLabel;
-  EmitLabel(skip_ws_lbl);
-  { Read one Char }
-  WriteLn('    mov x0, x19');
-  WriteLn('    mov x1, sp');
-  WriteLn('    mov x2, #1');
-  EmitMovX16(33554435);  { 0x2000003 = Read }
-  EmitSvc;
-  { Check If Read failed }
-  WriteLn('    cmp x0, #1');
+Procedure EmitIoDescRuntime;
+Var
+  done_lbl, no_back_lbl: Integer;
+Begin
+  { I/O descriptor - x0 = fd, returns x0 = descriptor To buffer it In }
+  { An fd without its own descriptor takes over the spare one: pending }
+  { output is written And Read-ahead handed back (lseek) To the old fd }
+  { Clobbers x0-x3 }
   done_lbl := NewLabel;
-  Write('    b.lt L'); WriteLn(done_lbl);
-  { Load Char into x23 }
-  WriteLn('    ldrb w23, [sp]');
-  { Check If space (32), tab (9), newline (10), Or carriage return (13) }
-  WriteLn('    cmp x23, #32');
-  Write('    b.eq L'); WriteLn(skip_ws_lbl);
-  WriteLn('    cmp x23, #9');
-  Write('    b.eq L'); WriteLn(skip_ws_lbl);
-  WriteLn('    cmp x23, #10');
-  Write('    b.eq L'); WriteLn(skip_ws_lbl);
-  WriteLn('    cmp x23, #13');
-  Write('    b.eq L'); WriteLn(skip_ws_lbl);
-
-  { Check For minus sign (45) }
-  neg_lbl := NewLabel;
-  not_neg_lbl := NewLabel;
-  WriteLn('    cmp x23, #45');
-  Write('    b.ne L'); WriteLn(not_neg_lbl);
-  { Set negative flag }
-  WriteLn('    mov x22, #1');
-  EmitBranchLabel(neg_lbl);
-  EmitLabel(not_neg_lbl);
-  { Not a minus, so it should be a digit - process it }
-  WriteLn('    sub x23, x23, #48');
-  { Check If valid digit (0-9) }
-  WriteLn('    cmp x23, #9');
-  Write('    b.hi L'); WriteLn(done_lbl);
-  { Add To accumulated value: x21 = x21 * 10 + x23 }
-  WriteLn('    mov x24, #10');
-  WriteLn('    mul x21, x21, x24');
-  WriteLn('    add x21, x21, x23');
-
-  { Read digit loop }
-  EmitLabel(neg_lbl);
-  read_digit_lbl := NewLabel;
-  EmitLabel(read_digit_lbl);
-  { Read one Char }
-  WriteLn('    mov x0, x19');
-  WriteLn('    mov x1, sp');
+  no_back_lbl := NewLabel;
+  EmitLabel(rt_io_desc);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(16);
+  WriteLn('    stur x0, [x29, #-8]');
+  EmitBL(rt_io_find);
+  Write('    cbnz x0, L'); WriteLn(done_lbl);
+  WriteLn('    add x0, x28, #192');
+  EmitBL(rt_flush_desc);
+  WriteLn('    add x3, x28, #192');
+  WriteLn('    ldp x1, x2, [x3, #8]');
+  WriteLn('    subs x1, x1, x2');
+  Write('    b.ge L'); WriteLn(no_back_lbl);
+  WriteLn('    ldr x0, [x3]');
   WriteLn('    mov x2, #1');
-  EmitMovX16(33554435);  { 0x2000003 = Read }
+  WriteLn('    movz x16, #0xC7');
+  WriteLn('    movk x16, #0x200, lsl #16');
   EmitSvc;
-  { Check If Read failed }
-  WriteLn('    cmp x0, #1');
-  Write('    b.lt L'); WriteLn(done_lbl);
-  { Load Char into x23 }
-  WriteLn('    ldrb w23, [sp]');
-  { Save original Char To x18 For pushback }
-  WriteLn('    mov x18, x23');
-  { Convert To digit }
-  WriteLn('    sub x23, x23, #48');
-  { Check If valid digit (0-9) }
-  WriteLn('    cmp x23, #9');
-  Write('    b.hi L'); WriteLn(done_lbl);
-  { Add To accumulated value: x21 = x21 * 10 + x23 }
-  WriteLn('    mov x24, #10');
-  WriteLn('    mul x21, x21, x24');
-  WriteLn('    add x21, x21, x23');
-  EmitBranchLabel(read_digit_lbl);
-
-  { Done - apply negative If needed }
+  EmitLabel(no_back_lbl);
+  WriteLn('    add x0, x28, #192');
+  WriteLn('    ldur x1, [x29, #-8]');
+  WriteLn('    str x1, [x0]');
+  WriteLn('    stp xzr, xzr, [x0, #8]');
   EmitLabel(done_lbl);
-  skip_neg_lbl := NewLabel;
-  Write('    cbz x22, L'); WriteLn(skip_neg_lbl);
-  WriteLn('    neg x21, x21');
-  EmitLabel(skip_neg_lbl);
-  { Move result To x0 }
-  WriteLn('    mov x0, x21');
-  EmitAddSP(48);
+  EmitAddSP(16);
   EmitLdp;
   EmitRet
 End;
 
-Procedure EmitSkipLineRuntime;
+Procedure EmitIoOpenRuntime;
 Var
-  loop_lbl, done_lbl, check_pb_lbl: Integer;
+  done_lbl: Integer;
 Begin
-  { Skip To End Of line routine - reads chars Until newline Or EOF }
-  { Uses x18 as pushback character from read_int (-1 means none) }
-  EmitLabel(rt_skip_line);
+  { I/O open - x0 = fd just opened by Reset/Rewrite; give it a descriptor }
+  { And a 64KB buffer. Without one (fd >= 256, mmap failed) the fd simply }
+  { uses the spare descriptor. Preserves x0, clobbers x1-x5 }
+  done_lbl := NewLabel;
+  EmitLabel(rt_io_open);
   EmitStp;
   EmitMovFP;
   EmitSubSP(16);
-
-  loop_lbl := NewLabel;
-  done_lbl := NewLabel;
-  check_pb_lbl := NewLabel;
-
-  { First check If pushback character is available }
-  WriteLn('    cmp x18, #0');
-  Write('    b.lt L'); WriteLn(loop_lbl);
-  { Check If pushback is newline }
-  WriteLn('    cmp x18, #10');
-  { Clear pushback }
-  WriteLn('    mov x18, #-1');
-  Write('    b.eq L'); WriteLn(done_lbl);
-
-  EmitLabel(loop_lbl);
-  { Read one Char }
-  WriteLn('    mov x0, x19');
-  WriteLn('    mov x1, sp');
-  WriteLn('    mov x2, #1');
-  EmitMovX16(33554435);  { 0x2000003 = Read }
+  WriteLn('    stur x0, [x29, #-8]');
+  WriteLn('    cmp x0, #256');
+  Write('    b.hs L'); WriteLn(done_lbl);
+  WriteLn('    mov x0, #0');
+  WriteLn('    mov x1, #65536');
+  WriteLn('    mov x2, #3');
+  WriteLn('    mov x3, #4098');
+  WriteLn('    movn x4, #0');
+  WriteLn('    mov x5, #0');
+  WriteLn('    movz x16, #0xC5');
+  WriteLn('    movk x16, #0x200, lsl #16');
   EmitSvc;
-  { Check If Read failed }
-  WriteLn('    cmp x0, #1');
-  Write('    b.lt L'); WriteLn(done_lbl);
-  { Load Char }
-  WriteLn('    ldrb w0, [sp]');
-  { Check If newline (10) }
-  WriteLn('    cmp x0, #10');
-  Write('    b.ne L'); WriteLn(loop_lbl);
-
+  Write('    b.cs L'); WriteLn(done_lbl);
+  { Descriptor at the start, buffer after it; the rest is zero already }
+  WriteLn('    ldur x1, [x29, #-8]');
+  WriteLn('    str x1, [x0]');
+  WriteLn('    add x2, x0, #128');
+  WriteLn('    str x2, [x0, #24]');
+  WriteLn('    str x2, [x0, #40]');
+  WriteLn('    mov x3, #65408');
+  WriteLn('    str x3, [x0, #32]');
+  WriteLn('    add x2, x2, x3');
+  WriteLn('    str x2, [x0, #48]');
+  WriteLn('    mov x2, #1');
+  WriteLn('    str x2, [x0, #56]');
+  { Offset 0, size Not known until FileSize asks }
+  WriteLn('    movn x2, #0');
+  WriteLn('    str x2, [x0, #72]');
+  WriteLn('    add x2, x28, #256');
+  WriteLn('    str x0, [x2, x1, lsl #3]');
+  { The spare descriptor may still think it owns this fd number }
+  WriteLn('    add x2, x28, #192');
+  WriteLn('    ldr x3, [x2]');
+  WriteLn('    cmp x3, x1');
+  Write('    b.ne L'); WriteLn(done_lbl);
+  WriteLn('    movn x3, #0');
+  WriteLn('    str x3, [x2]');
+  WriteLn('    stp xzr, xzr, [x2, #8]');
   EmitLabel(done_lbl);
+  WriteLn('    ldur x0, [x29, #-8]');
   EmitAddSP(16);
   EmitLdp;
   EmitRet
 End;
 
-Procedure EmitPrintRealRuntime;
+Procedure EmitIoCloseRuntime;
 Var
-  neg_lbl, skip_neg_lbl, print_frac_lbl, frac_loop_lbl: Integer;
+  done_lbl, out_lbl, in_lbl: Integer;
 Begin
-  { Print Real In d0 - format: Integer.fraction (6 decimal places) }
-  EmitLabel(rt_print_real);
+  { I/O close - x0 = fd about To be closed: Write its pending output, drop }
+  { its Read-ahead And release its descriptor. Preserves x0 }
+  done_lbl := NewLabel;
+  out_lbl := NewLabel;
+  in_lbl := NewLabel;
+  EmitLabel(rt_io_close);
   EmitStp;
   EmitMovFP;
-  EmitSubSP(64);
-
-  { Save original value To [x29, #-16] as double }
-  WriteLn('    stur d0, [x29, #-16]');
-
-  { Check For negative }
-  neg_lbl := NewLabel;
-  skip_neg_lbl := NewLabel;
-  { fcmp d0, #0.0 }
-  WriteLn('    fcmp d0, #0.0');
-  { b.ge skip_neg }
-  Write('    b.ge L'); WriteLn(neg_lbl);
-
-  { Print '-' And negate }
-  EmitMovX0(45);  { '-' }
-  EmitBL(rt_print_char);
-  { fneg d0, d0 }
-  WriteLn('    ldur d0, [x29, #-16]');
-  EmitFNeg;
-  WriteLn('    stur d0, [x29, #-16]');
-
-  EmitLabel(neg_lbl);
-
-  { Load value And get Integer part }
-  WriteLn('    ldur d0, [x29, #-16]');
-
-  { fcvtzs x0, d0 - truncate To Integer }
-  EmitFcvtzsX0D0;
-
-  { Save Integer part To [x29, #-24] }
-  WriteLn('    stur x0, [x29, #-24]');
-
-  { Print Integer part }
-  EmitBL(rt_print_int);
-
-  { Print '.' }
-  EmitMovX0(46);  { '.' }
-  EmitBL(rt_print_char);
-
-  { Calculate fractional part: (original - int_part) * 1000000 }
-  WriteLn('    ldur d0, [x29, #-16]');
-
-  { Load Integer part And convert To float }
-  WriteLn('    ldur x0, [x29, #-24]');
-
-  { scvtf d1, x0 }
-  WriteLn('    scvtf d1, x0');
-
-  { fsub d0, d0, d1 - fractional part (d0 = original - int_part) }
-  { EmitFSub does d0=d1-d0, so emit inline For d0=d0-d1 }
-  WriteLn('    fsub d0, d0, d1');
-
-  { Multiply by 1000000 }
-  EmitMovX0(1000000);
-  EmitScvtfD0X0;  { d0 = 1000000.0 }
-  EmitPushD0;
-  WriteLn('    ldur d0, [x29, #-16]');
-  WriteLn('    ldur x0, [x29, #-24]');
-  WriteLn('    scvtf d1, x0');
-  { fsub d0, d0, d1 - d0 = frac part (original - int_part) }
-  { EmitFSub does d0=d1-d0, so emit inline For d0=d0-d1 }
-  WriteLn('    fsub d0, d0, d1');
-  EmitPopD1;  { d1 = 1000000.0 }
-  EmitFMul;  { d0 = frac * 1000000 }
-
-  { Convert To Integer }
-  EmitFcvtzsX0D0;
-
-  { Save fractional digits To [x29, #-32] }
-  WriteLn('    stur x0, [x29, #-32]');
-
-  { Print fractional part With leading zeros (6 digits) }
-  { Count digits needed }
-  frac_loop_lbl := NewLabel;
-  print_frac_lbl := NewLabel;
-
-  { Print leading zeros: If frac < 100000, print '0', etc }
-  WriteLn('    ldur x0, [x29, #-32]');
-
-  { x1 = 100000 - use movz since 100000 > 65535 }
-  { movz x1, #34464; movk x1, #1, lsl #16 }
-  WriteLn('    movz x1, #34464');
-  WriteLn('    movk x1, #1, lsl #16');
-
-  EmitLabel(frac_loop_lbl);
-  { cmp x1, #10 }
-  WriteLn('    cmp x1, #10');
-  { b.lt print_frac }
-  Write('    b.lt L'); WriteLn(print_frac_lbl);
-  { cmp x0, x1 }
+  EmitSubSP(16);
+  WriteLn('    stur x0, [x29, #-8]');
+  EmitBL(rt_io_find);
+  Write('    cbz x0, L'); WriteLn(done_lbl);
+  WriteLn('    stur x0, [x29, #-16]');
+  EmitBL(rt_flush_desc);
+  WriteLn('    ldur x0, [x29, #-16]');
+  WriteLn('    stp xzr, xzr, [x0, #8]');
+  { The spare descriptor just forgets the fd }
+  WriteLn('    add x1, x28, #192');
   WriteLn('    cmp x0, x1');
-  { b.ge print_frac }
-  Write('    b.ge L'); WriteLn(print_frac_lbl);
-  { Print '0' }
-  EmitPushX0;
-  EmitPushX1;
-  EmitMovX0(48);
-  EmitBL(rt_print_char);
-  EmitPopX1;
-  EmitPopX0;
-  { x1 = x1 / 10 }
-  WriteLn('    mov x2, #10');
-  WriteLn('    udiv x1, x1, x2');
-  EmitBranchLabel(frac_loop_lbl);
-
-  EmitLabel(print_frac_lbl);
-  { Load And print the fractional value }
-  WriteLn('    ldur x0, [x29, #-32]');
-  { Only print If non-zero }
-  EmitBranchLabelZ(label_count);
-  EmitBL(rt_print_int);
-  EmitLabel(label_count);
-  label_count := label_count + 1;
-
-  EmitAddSP(64);
+  Write('    b.ne L'); WriteLn(out_lbl);
+  WriteLn('    movn x1, #0');
+  WriteLn('    str x1, [x0]');
+  EmitBranchLabel(done_lbl);
+  EmitLabel(out_lbl);
+  { stdin And stdout keep theirs }
+  WriteLn('    ldr x1, [x0, #56]');
+  Write('    cbz x1, L'); WriteLn(done_lbl);
+  WriteLn('    ldur x0, [x29, #-8]');
+  EmitBL(rt_io_unmap);
+  WriteLn('    ldur x0, [x29, #-16]');
+  WriteLn('    ldur x1, [x29, #-8]');
+  WriteLn('    add x2, x28, #256');
+  WriteLn('    str xzr, [x2, x1, lsl #3]');
+  { Current input/output fall back To stdin/stdout's descriptors }
+  WriteLn('    ldr x1, [x28]');
+  WriteLn('    cmp x1, x0');
+  Write('    b.ne L'); WriteLn(in_lbl);
+  WriteLn('    add x1, x28, #128');
+  WriteLn('    str x1, [x28]');
+  EmitLabel(in_lbl);
+  WriteLn('    ldr x1, [x28, #8]');
+  WriteLn('    cmp x1, x0');
+  out_lbl := NewLabel;
+  Write('    b.ne L'); WriteLn(out_lbl);
+  WriteLn('    add x1, x28, #64');
+  WriteLn('    str x1, [x28, #8]');
+  EmitLabel(out_lbl);
+  WriteLn('    mov x1, #65536');
+  EmitMovX16(33554505);  { 0x2000049 = munmap }
+  EmitSvc;
+  EmitLabel(done_lbl);
+  WriteLn('    ldur x0, [x29, #-8]');
+  EmitAddSP(16);
   EmitLdp;
   EmitRet
 End;
 
-Procedure EmitReadRealRuntime;
+Procedure EmitIoSyncRuntime;
 Var
-  skip_ws_lbl, read_int_lbl, read_frac_lbl, done_lbl, neg_lbl, not_neg_lbl, skip_neg_lbl: Integer;
+  done_lbl: Integer;
 Begin
-  { Read Real from input, return In d0 }
-  EmitLabel(rt_read_real);
+  { I/O sync - x0 = fd; Write its pending output And return x0 = bytes }
+  { Read ahead from it that the program has Not consumed yet }
+  { (Flush(f), Eof, FilePos, FileSize). Clobbers x0-x3 }
+  done_lbl := NewLabel;
+  EmitLabel(rt_io_sync);
   EmitStp;
   EmitMovFP;
-  EmitSubSP(64);
-
-  { x21 = Integer part, x22 = fractional part (scaled), x23 = neg flag, x24 = frac scale }
-  WriteLn('    mov x21, #0');
-  WriteLn('    mov x22, #0');
-  WriteLn('    mov x23, #0');
-  WriteLn('    mov x24, #1');
-
-  { Skip whitespace }
-  skip_ws_lbl := NewLabel;
-  EmitLabel(skip_ws_lbl);
-  WriteLn('    mov x0, x19');
-  WriteLn('    mov x1, sp');
-  WriteLn('    mov x2, #1');
-  EmitMovX16(33554435);  { 0x2000003 = Read }
-  EmitSvc;
-  done_lbl := NewLabel;
-  WriteLn('    cmp x0, #1');
-  Write('    b.lt L'); WriteLn(done_lbl);
-  { Load Char }
-  WriteLn('    ldrb w25, [sp]');
-  { Check whitespace }
-  WriteLn('    cmp x25, #32');
-  Write('    b.eq L'); WriteLn(skip_ws_lbl);
-  WriteLn('    cmp x25, #9');
-  Write('    b.eq L'); WriteLn(skip_ws_lbl);
-  WriteLn('    cmp x25, #10');
-  Write('    b.eq L'); WriteLn(skip_ws_lbl);
-  WriteLn('    cmp x25, #13');
-  Write('    b.eq L'); WriteLn(skip_ws_lbl);
-
-  { Check For minus }
-  neg_lbl := NewLabel;
-  not_neg_lbl := NewLabel;
-  WriteLn('    cmp x25, #45');
-  Write('    b.ne L'); WriteLn(not_neg_lbl);
-  WriteLn('    mov x23, #1');
-  EmitBranchLabel(neg_lbl);
-  EmitLabel(not_neg_lbl);
-
-  { First Char is a digit - process it }
-  WriteLn('    sub x25, x25, #48');
-  WriteLn('    cmp x25, #9');
-  Write('    b.hi L'); WriteLn(done_lbl);
-  { x21 = x21 * 10 + x25 }
-  WriteLn('    mov x26, #10');
-  WriteLn('    mul x21, x21, x26');
-  WriteLn('    add x21, x21, x25');
-
-  { Read Integer part loop }
-  EmitLabel(neg_lbl);
-  read_int_lbl := NewLabel;
-  read_frac_lbl := NewLabel;
-  EmitLabel(read_int_lbl);
-  WriteLn('    mov x0, x19');
-  WriteLn('    mov x1, sp');
-  WriteLn('    mov x2, #1');
-  EmitMovX16(33554435);  { 0x2000003 = Read }
-  EmitSvc;
-  WriteLn('    cmp x0, #1');
-  Write('    b.lt L'); WriteLn(done_lbl);
-  WriteLn('    ldrb w25, [sp]');
-
-  { Check For '.' }
-  WriteLn('    cmp x25, #46');
-  Write('    b.eq L'); WriteLn(read_frac_lbl);
-
-  { Check If digit }
-  WriteLn('    sub x25, x25, #48');
-  WriteLn('    cmp x25, #9');
-  Write('    b.hi L'); WriteLn(done_lbl);
-  { x21 = x21 * 10 + x25 }
-  WriteLn('    mov x26, #10');
-  WriteLn('    mul x21, x21, x26');
-  WriteLn('    add x21, x21, x25');
-  EmitBranchLabel(read_int_lbl);
-
-  { Read fractional part }
-  EmitLabel(read_frac_lbl);
-  skip_neg_lbl := NewLabel;
-  EmitLabel(skip_neg_lbl);
-  WriteLn('    mov x0, x19');
-  WriteLn('    mov x1, sp');
-  WriteLn('    mov x2, #1');
-  EmitMovX16(33554435);  { 0x2000003 = Read }
-  EmitSvc;
-  WriteLn('    cmp x0, #1');
-  Write('    b.lt L'); WriteLn(done_lbl);
-  WriteLn('    ldrb w25, [sp]');
-
-  { Check If digit }
-  WriteLn('    sub x25, x25, #48');
-  WriteLn('    cmp x25, #9');
-  Write('    b.hi L'); WriteLn(done_lbl);
-  { x22 = x22 * 10 + x25, x24 = x24 * 10 }
-  WriteLn('    mov x26, #10');
-  WriteLn('    mul x22, x22, x26');
-  WriteLn('    add x22, x22, x25');
-  WriteLn('    mul x24, x24, x26');
-  EmitBranchLabel(skip_neg_lbl);
-
-  { Done - combine Integer And fractional parts }
+  EmitSubSP(16);
+  EmitBL(rt_io_find);
+  Write('    cbz x0, L'); WriteLn(done_lbl);
+  WriteLn('    stur x0, [x29, #-8]');
+  EmitBL(rt_flush_desc);
+  WriteLn('    ldur x3, [x29, #-8]');
+  WriteLn('    ldp x1, x2, [x3, #8]');
+  WriteLn('    sub x0, x2, x1');
   EmitLabel(done_lbl);
-  { d0 = x21 (Integer part) }
-  WriteLn('    scvtf d0, x21');
-  { d1 = x22 (fractional part) }
-  WriteLn('    scvtf d1, x22');
-  { d2 = x24 (scale) }
-  WriteLn('    scvtf d2, x24');
-  { d1 = d1 / d2 }
-  WriteLn('    fdiv d1, d1, d2');
-  { d0 = d0 + d1 }
-  EmitFAdd;
-
-  { Apply negative If needed }
-  skip_neg_lbl := NewLabel;
-  Write('    cbz x23, L'); WriteLn(skip_neg_lbl);
-  EmitFNeg;
-  EmitLabel(skip_neg_lbl);
-
-  EmitAddSP(64);
+  EmitAddSP(16);
   EmitLdp;
   EmitRet
 End;
 
-Procedure EmitReadStringRuntime;
+Procedure EmitIoDropRuntime;
 Var
-  loop_lbl, done_lbl, store_len_lbl: Integer;
+  done_lbl: Integer;
 Begin
-  { Read String from input (x19), String buffer address passed In x0 }
-  { String format: byte 0 = Length, bytes 1-255 = characters }
-  { Reads Until newline Or max 255 chars }
-  EmitLabel(rt_read_string);
+  { I/O drop - x0 = fd about To be repositioned (Seek): Write its pending }
+  { output And discard its Read-ahead. Preserves x0 }
+  done_lbl := NewLabel;
+  EmitLabel(rt_io_drop);
   EmitStp;
   EmitMovFP;
-  EmitSubSP(32);
-
-  { Save String buffer address In x21 }
-  WriteLn('    mov x21, x0');
-
-  { x22 = character count (starts at 0) }
-  WriteLn('    mov x22, #0');
-
-  { Read loop }
-  loop_lbl := NewLabel;
-  done_lbl := NewLabel;
-  EmitLabel(loop_lbl);
-
-  { Check If count >= 255 }
-  WriteLn('    cmp x22, #255');
-  Write('    b.ge L'); WriteLn(done_lbl);
-
-  { Read one character: Read(x19, sp, 1) }
-  WriteLn('    mov x0, x19');
-  WriteLn('    mov x1, sp');
-  WriteLn('    mov x2, #1');
-  EmitMovX16(33554435);  { 0x2000003 = Read syscall }
-  EmitSvc;
-
-  { Check If Read failed Or EOF (x0 < 1) }
-  WriteLn('    cmp x0, #1');
-  Write('    b.lt L'); WriteLn(done_lbl);
-
-  { Load character into x23 }
-  WriteLn('    ldrb w23, [sp]');
-
-  { Check If newline (10) Or carriage return (13) }
-  WriteLn('    cmp x23, #10');
-  Write('    b.eq L'); WriteLn(done_lbl);
-  WriteLn('    cmp x23, #13');
-  Write('    b.eq L'); WriteLn(done_lbl);
-
-  { Store character at buffer[count+1] }
-  { x24 = x21 + x22 + 1 }
-  WriteLn('    add x24, x21, x22');
-  WriteLn('    add x24, x24, #1');
-  WriteLn('    strb w23, [x24]');
-
-  { Increment count }
-  WriteLn('    add x22, x22, #1');
-
-  { Loop back }
-  Write('    b L'); WriteLn(loop_lbl);
-
-  { Done - store Length at buffer[0] }
+  EmitSubSP(16);
+  WriteLn('    stur x0, [x29, #-8]');
+  EmitBL(rt_io_find);
+  Write('    cbz x0, L'); WriteLn(done_lbl);
+  WriteLn('    stur x0, [x29, #-16]');
+  EmitBL(rt_flush_desc);
+  WriteLn('    ldur x0, [x29, #-16]');
+  WriteLn('    stp xzr, xzr, [x0, #8]');
   EmitLabel(done_lbl);
-  WriteLn('    strb w22, [x21]');
-
-  EmitAddSP(32);
+  WriteLn('    ldur x0, [x29, #-8]');
+  EmitAddSP(16);
   EmitLdp;
   EmitRet
 End;
 
-Procedure EmitFileOpenInit;
+Procedure EmitIoSeekRuntime;
 Var
-  skip_input_lbl, skip_output_lbl: Integer;
+  far_lbl, done_lbl: Integer;
 Begin
-  { Initialize x19 (input fd) And x20 (output fd) from command line }
-  { On entry: x0 = argc, x1 = argv }
-  { Usage: tpcv2 input.pas output.s }
-  skip_input_lbl := NewLabel;
+  { I/O seek - x0 = fd, x1 = byte position. A target inside an owned }
+  { descriptor's Read-ahead only moves its Read index; otherwise pending }
+  { output is written, Read-ahead dropped And the fd repositioned }
+  { Clobbers x0-x3 }
+  far_lbl := NewLabel;
+  done_lbl := NewLabel;
+  EmitLabel(rt_io_seek);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(16);
+  WriteLn('    stur x0, [x29, #-8]');
+  WriteLn('    stur x1, [x29, #-16]');
+  EmitBL(rt_io_find);
+  Write('    cbz x0, L'); WriteLn(far_lbl);
+  WriteLn('    ldr x1, [x0, #56]');
+  Write('    cbz x1, L'); WriteLn(far_lbl);
+  WriteLn('    ldr x1, [x0, #40]');
+  WriteLn('    ldr x2, [x0, #24]');
+  WriteLn('    cmp x1, x2');
+  Write('    b.ne L'); WriteLn(far_lbl);
+  { The buffer holds file bytes fpos - rlen .. fpos }
+  WriteLn('    ldr x2, [x0, #16]');
+  WriteLn('    ldr x3, [x0, #64]');
+  WriteLn('    sub x3, x3, x2');
+  WriteLn('    ldur x1, [x29, #-16]');
+  WriteLn('    subs x1, x1, x3');
+  Write('    b.lt L'); WriteLn(far_lbl);
+  WriteLn('    cmp x1, x2');
+  Write('    b.gt L'); WriteLn(far_lbl);
+  WriteLn('    str x1, [x0, #8]');
+  EmitBranchLabel(done_lbl);
+  EmitLabel(far_lbl);
+  WriteLn('    ldur x0, [x29, #-8]');
+  EmitBL(rt_io_drop);
+  WriteLn('    ldur x1, [x29, #-16]');
+  WriteLn('    mov x2, #0');
+  WriteLn('    movz x16, #0xC7');
+  WriteLn('    movk x16, #0x200, lsl #16');
+  EmitSvc;
+  Write('    b.cs L'); WriteLn(done_lbl);
+  WriteLn('    mov x3, x0');
+  WriteLn('    ldur x0, [x29, #-8]');
+  EmitBL(rt_io_find);
+  Write('    cbz x0, L'); WriteLn(done_lbl);
+  WriteLn('    ldr x1, [x0, #56]');
+  Write('    cbz x1, L'); WriteLn(done_lbl);
+  WriteLn('    str x3, [x0, #64]');
+  EmitLabel(done_lbl);
+  EmitAddSP(16);
+  EmitLdp;
+  EmitRet
+End;
+
+Procedure EmitIoPosRuntime;
+Var
+  slow_lbl, done_lbl: Integer;
+Begin
+  { I/O position - x0 = fd, returns x0 = the program's byte position: }
+  { the kernel offset less unread Read-ahead plus pending output. Owned }
+  { descriptors know their offset, others ask lseek. Clobbers x0-x3 }
+  slow_lbl := NewLabel;
+  done_lbl := NewLabel;
+  EmitLabel(rt_io_pos);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(16);
+  WriteLn('    stur x0, [x29, #-8]');
+  EmitBL(rt_io_find);
+  Write('    cbz x0, L'); WriteLn(slow_lbl);
+  WriteLn('    ldr x1, [x0, #56]');
+  Write('    cbz x1, L'); WriteLn(slow_lbl);
+  WriteLn('    ldr x1, [x0, #64]');
+  WriteLn('    ldp x2, x3, [x0, #8]');
+  WriteLn('    sub x2, x3, x2');
+  WriteLn('    sub x1, x1, x2');
+  WriteLn('    ldr x2, [x0, #40]');
+  WriteLn('    ldr x3, [x0, #24]');
+  WriteLn('    sub x2, x2, x3');
+  WriteLn('    add x0, x1, x2');
+  EmitBranchLabel(done_lbl);
+  EmitLabel(slow_lbl);
+  { Write out pending output; x0 = bytes Read ahead }
+  WriteLn('    ldur x0, [x29, #-8]');
+  EmitBL(rt_io_sync);
+  WriteLn('    stur x0, [x29, #-16]');
+  { lseek(fd, 0, SEEK_CUR=1) }
+  WriteLn('    ldur x0, [x29, #-8]');
+  WriteLn('    mov x1, #0');
+  WriteLn('    mov x2, #1');
+  WriteLn('    movz x16, #0xC7');
+  WriteLn('    movk x16, #0x200, lsl #16');
+  EmitSvc;
+  WriteLn('    ldur x1, [x29, #-16]');
+  WriteLn('    sub x0, x0, x1');
+  EmitLabel(done_lbl);
+  EmitAddSP(16);
+  EmitLdp;
+  EmitRet
+End;
+
+Procedure EmitIoSizeRuntime;
+Var
+  slow_lbl, known_lbl, max_lbl, done_lbl: Integer;
+Begin
+  { I/O size - x0 = fd, returns x0 = file size In bytes. An owned }
+  { descriptor asks the kernel once And Then keeps the size up To date }
+  { As it reads And writes; pending output counts toward it }
+  { Clobbers x0-x3 }
+  slow_lbl := NewLabel;
+  known_lbl := NewLabel;
+  max_lbl := NewLabel;
+  done_lbl := NewLabel;
+  EmitLabel(rt_io_size);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(32);
+  WriteLn('    stur x0, [x29, #-8]');
+  EmitBL(rt_io_find);
+  Write('    cbz x0, L'); WriteLn(slow_lbl);
+  WriteLn('    ldr x1, [x0, #56]');
+  Write('    cbz x1, L'); WriteLn(slow_lbl);
+  WriteLn('    stur x0, [x29, #-16]');
+  WriteLn('    ldr x1, [x0, #72]');
+  WriteLn('    cmn x1, #1');
+  Write('    b.ne L'); WriteLn(known_lbl);
+  { lseek(fd, 0, SEEK_END=2), Then back To the kernel offset }
+  WriteLn('    ldr x0, [x0]');
+  WriteLn('    mov x1, #0');
+  WriteLn('    mov x2, #2');
+  WriteLn('    movz x16, #0xC7');
+  WriteLn('    movk x16, #0x200, lsl #16');
+  EmitSvc;
+  WriteLn('    mov x1, #0');
+  WriteLn('    ldur x3, [x29, #-16]');
+  Write('    b.cs L'); WriteLn(max_lbl);
+  WriteLn('    str x0, [x3, #72]');
+  WriteLn('    ldr x0, [x3]');
+  WriteLn('    ldr x1, [x3, #64]');
+  WriteLn('    mov x2, #0');
+  WriteLn('    movz x16, #0xC7');
+  WriteLn('    movk x16, #0x200, lsl #16');
+  EmitSvc;
+  EmitLabel(known_lbl);
+  WriteLn('    ldur x3, [x29, #-16]');
+  WriteLn('    ldr x1, [x3, #72]');
+  EmitLabel(max_lbl);
+  { Size is at least the offset plus pending output }
+  WriteLn('    ldr x0, [x3, #64]');
+  WriteLn('    ldr x2, [x3, #40]');
+  WriteLn('    add x0, x0, x2');
+  WriteLn('    ldr x2, [x3, #24]');
+  WriteLn('    sub x0, x0, x2');
+  WriteLn('    cmp x0, x1');
+  WriteLn('    csel x0, x0, x1, hi');
+  EmitBranchLabel(done_lbl);
+  EmitLabel(slow_lbl);
+  { Pending output counts toward the size }
+  WriteLn('    ldur x0, [x29, #-8]');
+  EmitBL(rt_io_sync);
+  { lseek(fd, 0, SEEK_CUR=1) To get current position (To restore later) }
+  WriteLn('    ldur x0, [x29, #-8]');
+  WriteLn('    mov x1, #0');
+  WriteLn('    mov x2, #1');
+  WriteLn('    movz x16, #0xC7');
+  WriteLn('    movk x16, #0x200, lsl #16');
+  EmitSvc;
+  WriteLn('    stur x0, [x29, #-16]');
+  { lseek(fd, 0, SEEK_END=2) To get file size }
+  WriteLn('    ldur x0, [x29, #-8]');
+  WriteLn('    mov x1, #0');
+  WriteLn('    mov x2, #2');
+  WriteLn('    movz x16, #0xC7');
+  WriteLn('    movk x16, #0x200, lsl #16');
+  EmitSvc;
+  WriteLn('    stur x0, [x29, #-24]');
+  { Restore file position: lseek(fd, current_pos, SEEK_SET=0) }
+  WriteLn('    ldur x0, [x29, #-8]');
+  WriteLn('    ldur x1, [x29, #-16]');
+  WriteLn('    mov x2, #0');
+  WriteLn('    movz x16, #0xC7');
+  WriteLn('    movk x16, #0x200, lsl #16');
+  EmitSvc;
+  WriteLn('    ldur x0, [x29, #-24]');
+  EmitLabel(done_lbl);
+  EmitAddSP(32);
+  EmitLdp;
+  EmitRet
+End;
+
+Procedure EmitIoUnmapRuntime;
+Var
+  unmap_lbl, done_lbl: Integer;
+Begin
+  { I/O unmap - x0 = fd: release the mapping made by MapFile, syncing it }
+  { To disk first If asked. Clobbers x0-x3 }
+  unmap_lbl := NewLabel;
+  done_lbl := NewLabel;
+  EmitLabel(rt_io_unmap);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(16);
+  EmitBL(rt_io_find);
+  Write('    cbz x0, L'); WriteLn(done_lbl);
+  WriteLn('    ldr x1, [x0, #56]');
+  Write('    cbz x1, L'); WriteLn(done_lbl);
+  WriteLn('    ldr x1, [x0, #80]');
+  Write('    cbz x1, L'); WriteLn(done_lbl);
+  WriteLn('    stur x0, [x29, #-8]');
+  WriteLn('    ldr x2, [x0, #96]');
+  Write('    cbz x2, L'); WriteLn(unmap_lbl);
+  { msync(addr, len, MS_SYNC=0x10) }
+  WriteLn('    ldr x1, [x0, #88]');
+  WriteLn('    ldr x0, [x0, #80]');
+  WriteLn('    mov x2, #16');
+  EmitMovX16(33554497);  { 0x2000041 = msync }
+  EmitSvc;
+  EmitLabel(unmap_lbl);
+  WriteLn('    ldur x3, [x29, #-8]');
+  WriteLn('    ldr x0, [x3, #80]');
+  WriteLn('    ldr x1, [x3, #88]');
+  EmitMovX16(33554505);  { 0x2000049 = munmap }
+  EmitSvc;
+  WriteLn('    ldur x3, [x29, #-8]');
+  WriteLn('    stp xzr, xzr, [x3, #80]');
+  WriteLn('    str xzr, [x3, #96]');
+  EmitLabel(done_lbl);
+  EmitAddSP(16);
+  EmitLdp;
+  EmitRet
+End;
+
+Procedure EmitMapFileRuntime;
+Var
+  mapped_lbl, fail_lbl, done_lbl: Integer;
+Begin
+  { Map file - x0 = fd, x1 = 1 To sync the mapping when it is released; }
+  { returns x0 = address Of the whole file mapped shared, Or 0 (empty }
+  { file, no descriptor Of its own, mmap failed). Pending output is }
+  { written first. Read-write If the fd allows it, otherwise Read-only }
+  { Clobbers x0-x5 }
+  mapped_lbl := NewLabel;
+  fail_lbl := NewLabel;
+  done_lbl := NewLabel;
+  EmitLabel(rt_map_file);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(32);
+  { [x29-8] = fd, [x29-16] = sync flag, [x29-24] = descriptor, }
+  { [x29-32] = Length }
+  WriteLn('    stur x0, [x29, #-8]');
+  WriteLn('    stur x1, [x29, #-16]');
+  EmitBL(rt_io_unmap);
+  WriteLn('    ldur x0, [x29, #-8]');
+  EmitBL(rt_io_find);
+  Write('    cbz x0, L'); WriteLn(fail_lbl);
+  WriteLn('    ldr x1, [x0, #56]');
+  Write('    cbz x1, L'); WriteLn(fail_lbl);
+  WriteLn('    stur x0, [x29, #-24]');
+  EmitBL(rt_flush_desc);
+  WriteLn('    ldur x0, [x29, #-8]');
+  EmitBL(rt_io_size);
+  WriteLn('    cmp x0, #0');
+  Write('    b.le L'); WriteLn(fail_lbl);
+  WriteLn('    stur x0, [x29, #-32]');
+  { mmap(0, len, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0) }
+  WriteLn('    mov x1, x0');
+  WriteLn('    mov x0, #0');
+  WriteLn('    mov x2, #3');
+  WriteLn('    mov x3, #1');
+  WriteLn('    ldur x4, [x29, #-8]');
+  WriteLn('    mov x5, #0');
+  WriteLn('    movz x16, #0xC5');
+  WriteLn('    movk x16, #0x200, lsl #16');
+  EmitSvc;
+  Write('    b.cc L'); WriteLn(mapped_lbl);
+  { Retry With PROT_READ For a file opened Read-only }
+  WriteLn('    mov x0, #0');
+  WriteLn('    ldur x1, [x29, #-32]');
+  WriteLn('    mov x2, #1');
+  WriteLn('    mov x3, #1');
+  WriteLn('    ldur x4, [x29, #-8]');
+  WriteLn('    mov x5, #0');
+  WriteLn('    movz x16, #0xC5');
+  WriteLn('    movk x16, #0x200, lsl #16');
+  EmitSvc;
+  Write('    b.cs L'); WriteLn(fail_lbl);
+  EmitLabel(mapped_lbl);
+  WriteLn('    ldur x3, [x29, #-24]');
+  WriteLn('    ldur x1, [x29, #-32]');
+  WriteLn('    stp x0, x1, [x3, #80]');
+  WriteLn('    ldur x1, [x29, #-16]');
+  WriteLn('    str x1, [x3, #96]');
+  EmitBranchLabel(done_lbl);
+  EmitLabel(fail_lbl);
+  EmitMovX0(0);
+  EmitLabel(done_lbl);
+  EmitAddSP(32);
+  EmitLdp;
+  EmitRet
+End;
+
+Procedure EmitFillInputRuntime;
+Var
+  same_lbl, err_lbl, done_lbl: Integer;
+Begin
+  { Fill input buffer - make sure the input descriptor holds unread bytes }
+  { For fd x19, switching descriptors If x19 has changed }
+  { Returns x0 = bytes available (0 at EOF Or error). Clobbers x0-x3 }
+  same_lbl := NewLabel;
+  err_lbl := NewLabel;
+  done_lbl := NewLabel;
+  EmitLabel(rt_fill_input);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(16);
+  WriteLn('    ldr x3, [x28, #8]');
+  WriteLn('    ldr x0, [x3]');
+  WriteLn('    cmp x0, x19');
+  Write('    b.eq L'); WriteLn(same_lbl);
+  WriteLn('    mov x0, x19');
+  EmitBL(rt_io_desc);
+  WriteLn('    str x0, [x28, #8]');
+  WriteLn('    mov x3, x0');
+  EmitLabel(same_lbl);
+  WriteLn('    ldp x1, x2, [x3, #8]');
+  WriteLn('    subs x0, x2, x1');
+  Write('    b.gt L'); WriteLn(done_lbl);
+  { Buffer empty: Write out anything pending On this fd And the terminal }
+  { (prompts) before we block, Then Read }
+  WriteLn('    stur x3, [x29, #-8]');
+  WriteLn('    mov x0, x3');
+  EmitBL(rt_flush_desc);
+  EmitBL(rt_flush_output);
+  WriteLn('    ldur x3, [x29, #-8]');
+  WriteLn('    ldr x0, [x3]');
+  WriteLn('    ldr x1, [x3, #24]');
+  WriteLn('    ldr x2, [x3, #32]');
+  EmitMovX16(33554435);  { 0x2000003 = Read }
+  EmitSvc;
+  Write('    b.cs L'); WriteLn(err_lbl);
+  WriteLn('    ldur x3, [x29, #-8]');
+  WriteLn('    stp xzr, x0, [x3, #8]');
+  EmitIoAdvance(3, 0, 1, 2);
+  EmitBranchLabel(done_lbl);
+  EmitLabel(err_lbl);
+  WriteLn('    ldur x3, [x29, #-8]');
+  WriteLn('    stp xzr, xzr, [x3, #8]');
+  EmitMovX0(0);
+  EmitLabel(done_lbl);
+  EmitAddSP(16);
+  EmitLdp;
+  EmitRet
+End;
+
+Procedure EmitBlockReadRuntime;
+Var
+  loop_lbl, fill_lbl, small_lbl, done_lbl: Integer;
+Begin
+  { Block Read - x0 = fd, x1 = destination, x2 = bytes; returns x0 = }
+  { bytes Read (less at End Of file). Takes what the buffer holds, Then }
+  { reads a remainder Of a buffer Or more straight into the destination }
+  { And a smaller one through the buffer. Clobbers x0-x7 }
+  loop_lbl := NewLabel;
+  fill_lbl := NewLabel;
+  small_lbl := NewLabel;
+  done_lbl := NewLabel;
+  EmitLabel(rt_block_read);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(32);
+  { [x29-8] = descriptor, [x29-16] = destination, [x29-24] = bytes left, }
+  { [x29-32] = bytes Read }
+  WriteLn('    stur x1, [x29, #-16]');
+  WriteLn('    stur x2, [x29, #-24]');
+  WriteLn('    stur xzr, [x29, #-32]');
+  EmitBL(rt_io_desc);
+  WriteLn('    stur x0, [x29, #-8]');
+  EmitBL(rt_flush_desc);
+  EmitLabel(loop_lbl);
+  WriteLn('    ldur x3, [x29, #-8]');
+  WriteLn('    ldur x2, [x29, #-24]');
+  Write('    cbz x2, L'); WriteLn(done_lbl);
+  WriteLn('    ldp x4, x5, [x3, #8]');
+  WriteLn('    subs x5, x5, x4');
+  Write('    b.le L'); WriteLn(fill_lbl);
+  { Copy min(buffered, left) bytes out Of the buffer }
+  WriteLn('    cmp x5, x2');
+  WriteLn('    csel x2, x5, x2, lo');
+  WriteLn('    add x5, x4, x2');
+  WriteLn('    str x5, [x3, #8]');
+  WriteLn('    ldr x0, [x3, #24]');
+  WriteLn('    add x0, x0, x4');
+  WriteLn('    ldur x1, [x29, #-16]');
+  WriteLn('    add x5, x1, x2');
+  WriteLn('    stur x5, [x29, #-16]');
+  WriteLn('    ldur x5, [x29, #-24]');
+  WriteLn('    sub x5, x5, x2');
+  WriteLn('    stur x5, [x29, #-24]');
+  WriteLn('    ldur x5, [x29, #-32]');
+  WriteLn('    add x5, x5, x2');
+  WriteLn('    stur x5, [x29, #-32]');
+  EmitBL(rt_move);
+  EmitBranchLabel(loop_lbl);
+  EmitLabel(fill_lbl);
+  EmitBL(rt_flush_output);
+  WriteLn('    ldur x3, [x29, #-8]');
+  WriteLn('    ldr x0, [x3]');
+  WriteLn('    ldur x2, [x29, #-24]');
+  WriteLn('    ldr x4, [x3, #32]');
+  WriteLn('    cmp x2, x4');
+  Write('    b.lo L'); WriteLn(small_lbl);
+  WriteLn('    ldur x1, [x29, #-16]');
+  EmitMovX16(33554435);  { 0x2000003 = Read }
+  EmitSvc;
+  Write('    b.cs L'); WriteLn(done_lbl);
+  Write('    cbz x0, L'); WriteLn(done_lbl);
+  WriteLn('    ldur x3, [x29, #-8]');
+  EmitIoAdvance(3, 0, 1, 2);
+  WriteLn('    ldur x1, [x29, #-16]');
+  WriteLn('    add x1, x1, x0');
+  WriteLn('    stur x1, [x29, #-16]');
+  WriteLn('    ldur x1, [x29, #-24]');
+  WriteLn('    sub x1, x1, x0');
+  WriteLn('    stur x1, [x29, #-24]');
+  WriteLn('    ldur x1, [x29, #-32]');
+  WriteLn('    add x1, x1, x0');
+  WriteLn('    stur x1, [x29, #-32]');
+  EmitBranchLabel(loop_lbl);
+  EmitLabel(small_lbl);
+  WriteLn('    ldr x1, [x3, #24]');
+  WriteLn('    mov x2, x4');
+  EmitMovX16(33554435);  { 0x2000003 = Read }
+  EmitSvc;
+  Write('    b.cs L'); WriteLn(done_lbl);
+  Write('    cbz x0, L'); WriteLn(done_lbl);
+  WriteLn('    ldur x3, [x29, #-8]');
+  WriteLn('    stp xzr, x0, [x3, #8]');
+  EmitIoAdvance(3, 0, 1, 2);
+  EmitBranchLabel(loop_lbl);
+  EmitLabel(done_lbl);
+  WriteLn('    ldur x0, [x29, #-32]');
+  EmitAddSP(32);
+  EmitLdp;
+  EmitRet
+End;
+
+Procedure EmitBlockWriteRuntime;
+Var
+  kept_lbl, loop_lbl, flush_lbl, direct_lbl, done_lbl: Integer;
+Begin
+  { Block Write - x0 = fd, x1 = source, x2 = bytes; returns x0 = bytes }
+  { written. Unread Read-ahead is handed back first so the data lands at }
+  { the program's position. Blocks smaller than the buffer collect In }
+  { it, larger ones are written directly. Clobbers x0-x7 }
+  kept_lbl := NewLabel;
+  loop_lbl := NewLabel;
+  flush_lbl := NewLabel;
+  direct_lbl := NewLabel;
+  done_lbl := NewLabel;
+  EmitLabel(rt_block_write);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(32);
+  { [x29-8] = descriptor, [x29-16] = source, [x29-24] = bytes left, }
+  { [x29-32] = bytes asked For }
+  WriteLn('    stur x1, [x29, #-16]');
+  WriteLn('    stur x2, [x29, #-24]');
+  WriteLn('    stur x2, [x29, #-32]');
+  EmitBL(rt_io_desc);
+  WriteLn('    stur x0, [x29, #-8]');
+  WriteLn('    mov x3, x0');
+  WriteLn('    ldp x1, x2, [x3, #8]');
+  WriteLn('    subs x1, x1, x2');
+  Write('    b.ge L'); WriteLn(loop_lbl);
+  { lseek(fd, -(unread), SEEK_CUR=1) }
+  WriteLn('    ldr x0, [x3]');
+  WriteLn('    mov x2, #1');
+  WriteLn('    movz x16, #0xC7');
+  WriteLn('    movk x16, #0x200, lsl #16');
+  EmitSvc;
+  WriteLn('    ldur x3, [x29, #-8]');
+  Write('    b.cs L'); WriteLn(kept_lbl);
+  WriteLn('    ldr x1, [x3, #56]');
+  Write('    cbz x1, L'); WriteLn(kept_lbl);
+  WriteLn('    str x0, [x3, #64]');
+  EmitLabel(kept_lbl);
+  WriteLn('    stp xzr, xzr, [x3, #8]');
+  EmitLabel(loop_lbl);
+  WriteLn('    ldur x3, [x29, #-8]');
+  WriteLn('    ldur x2, [x29, #-24]');
+  Write('    cbz x2, L'); WriteLn(done_lbl);
+  WriteLn('    ldr x4, [x3, #32]');
+  WriteLn('    cmp x2, x4');
+  Write('    b.hs L'); WriteLn(direct_lbl);
+  WriteLn('    ldr x1, [x3, #40]');
+  WriteLn('    ldr x4, [x3, #48]');
+  WriteLn('    subs x4, x4, x1');
+  Write('    b.eq L'); WriteLn(flush_lbl);
+  { Copy min(room, left) bytes into the buffer }
+  WriteLn('    cmp x4, x2');
+  WriteLn('    csel x2, x4, x2, lo');
+  WriteLn('    add x4, x1, x2');
+  WriteLn('    str x4, [x3, #40]');
+  WriteLn('    ldur x0, [x29, #-16]');
+  WriteLn('    add x4, x0, x2');
+  WriteLn('    stur x4, [x29, #-16]');
+  WriteLn('    ldur x4, [x29, #-24]');
+  WriteLn('    sub x4, x4, x2');
+  WriteLn('    stur x4, [x29, #-24]');
+  EmitBL(rt_move);
+  EmitBranchLabel(loop_lbl);
+  EmitLabel(flush_lbl);
+  WriteLn('    mov x0, x3');
+  EmitBL(rt_flush_desc);
+  EmitBranchLabel(loop_lbl);
+  EmitLabel(direct_lbl);
+  WriteLn('    mov x0, x3');
+  EmitBL(rt_flush_desc);
+  WriteLn('    ldur x3, [x29, #-8]');
+  WriteLn('    ldr x0, [x3]');
+  WriteLn('    ldur x1, [x29, #-16]');
+  WriteLn('    ldur x2, [x29, #-24]');
+  EmitMovX16(33554436);  { 0x2000004 = Write }
+  EmitSvc;
+  Write('    b.cs L'); WriteLn(done_lbl);
+  Write('    cbz x0, L'); WriteLn(done_lbl);
+  WriteLn('    ldur x3, [x29, #-8]');
+  EmitIoAdvance(3, 0, 1, 2);
+  WriteLn('    ldur x1, [x29, #-16]');
+  WriteLn('    add x1, x1, x0');
+  WriteLn('    stur x1, [x29, #-16]');
+  WriteLn('    ldur x1, [x29, #-24]');
+  WriteLn('    sub x1, x1, x0');
+  WriteLn('    stur x1, [x29, #-24]');
+  EmitBranchLabel(loop_lbl);
+  EmitLabel(done_lbl);
+  WriteLn('    ldur x0, [x29, #-32]');
+  WriteLn('    ldur x1, [x29, #-24]');
+  WriteLn('    sub x0, x0, x1');
+  EmitAddSP(32);
+  EmitLdp;
+  EmitRet
+End;
+
+Procedure EmitFileReadRuntime;
+Var
+  each_lbl, loop_lbl, pad_lbl, next_lbl, done_lbl: Integer;
+Begin
+  { File Read - x0 = fd, x1 = first slot, x2 = element size, x3 = count, }
+  { x4 = step To the next slot, x5 = slot size; returns x0 = whole }
+  { elements Read. Packed slots take one block Read, others are filled }
+  { one element at a time And zero-padded. Clobbers x0-x7 }
+  each_lbl := NewLabel;
+  loop_lbl := NewLabel;
+  pad_lbl := NewLabel;
+  next_lbl := NewLabel;
+  done_lbl := NewLabel;
+  EmitLabel(rt_file_read);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(64);
+  WriteLn('    cmp x3, #0');
+  WriteLn('    csel x3, x3, xzr, gt');
+  WriteLn('    stp x0, x1, [x29, #-16]');
+  WriteLn('    stp x2, x3, [x29, #-32]');
+  WriteLn('    stp x4, x5, [x29, #-48]');
+  WriteLn('    stur xzr, [x29, #-56]');
+  WriteLn('    cmp x4, x2');
+  Write('    b.ne L'); WriteLn(each_lbl);
+  WriteLn('    cmp x5, x2');
+  Write('    b.ne L'); WriteLn(each_lbl);
+  WriteLn('    mul x2, x2, x3');
+  EmitBL(rt_block_read);
+  WriteLn('    ldur x2, [x29, #-32]');
+  WriteLn('    udiv x0, x0, x2');
+  WriteLn('    stur x0, [x29, #-56]');
+  EmitBranchLabel(done_lbl);
+  EmitLabel(each_lbl);
+  EmitLabel(loop_lbl);
+  WriteLn('    ldur x3, [x29, #-24]');
+  Write('    cbz x3, L'); WriteLn(done_lbl);
+  WriteLn('    ldp x0, x1, [x29, #-16]');
+  WriteLn('    ldur x2, [x29, #-32]');
+  EmitBL(rt_block_read);
+  WriteLn('    ldp x2, x3, [x29, #-32]');
+  WriteLn('    cmp x0, x2');
+  Write('    b.lo L'); WriteLn(done_lbl);
+  { Clear the rest Of the slot }
+  WriteLn('    ldur x1, [x29, #-8]');
+  WriteLn('    ldur x5, [x29, #-40]');
+  WriteLn('    add x4, x1, x2');
+  WriteLn('    add x5, x1, x5');
+  EmitLabel(pad_lbl);
+  WriteLn('    cmp x4, x5');
+  Write('    b.hs L'); WriteLn(next_lbl);
+  WriteLn('    strb wzr, [x4], #1');
+  EmitBranchLabel(pad_lbl);
+  EmitLabel(next_lbl);
+  WriteLn('    ldur x4, [x29, #-48]');
+  WriteLn('    add x1, x1, x4');
+  WriteLn('    stur x1, [x29, #-8]');
+  WriteLn('    sub x3, x3, #1');
+  WriteLn('    stur x3, [x29, #-24]');
+  WriteLn('    ldur x0, [x29, #-56]');
+  WriteLn('    add x0, x0, #1');
+  WriteLn('    stur x0, [x29, #-56]');
+  EmitBranchLabel(loop_lbl);
+  EmitLabel(done_lbl);
+  WriteLn('    ldur x0, [x29, #-56]');
+  EmitAddSP(64);
+  EmitLdp;
+  EmitRet
+End;
+
+Procedure EmitFileWriteRuntime;
+Var
+  loop_lbl, done_lbl: Integer;
+Begin
+  { File Write - x0 = fd, x1 = first slot, x2 = element size, x3 = count, }
+  { x4 = step To the next slot; returns x0 = whole elements written }
+  { Packed slots take one block Write. Clobbers x0-x7 }
+  loop_lbl := NewLabel;
+  done_lbl := NewLabel;
+  EmitLabel(rt_file_write);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(48);
+  WriteLn('    cmp x3, #0');
+  WriteLn('    csel x3, x3, xzr, gt');
+  WriteLn('    stp x0, x1, [x29, #-16]');
+  WriteLn('    stp x2, x3, [x29, #-32]');
+  WriteLn('    stur x4, [x29, #-40]');
+  WriteLn('    stur xzr, [x29, #-48]');
+  WriteLn('    cmp x4, x2');
+  Write('    b.ne L'); WriteLn(loop_lbl);
+  WriteLn('    mul x2, x2, x3');
+  EmitBL(rt_block_write);
+  WriteLn('    ldur x2, [x29, #-32]');
+  WriteLn('    udiv x0, x0, x2');
+  WriteLn('    stur x0, [x29, #-48]');
+  EmitBranchLabel(done_lbl);
+  EmitLabel(loop_lbl);
+  WriteLn('    ldur x3, [x29, #-24]');
+  Write('    cbz x3, L'); WriteLn(done_lbl);
+  WriteLn('    ldp x0, x1, [x29, #-16]');
+  WriteLn('    ldur x2, [x29, #-32]');
+  EmitBL(rt_block_write);
+  WriteLn('    ldp x2, x3, [x29, #-32]');
+  WriteLn('    cmp x0, x2');
+  Write('    b.lo L'); WriteLn(done_lbl);
+  WriteLn('    ldur x1, [x29, #-8]');
+  WriteLn('    ldur x4, [x29, #-40]');
+  WriteLn('    add x1, x1, x4');
+  WriteLn('    stur x1, [x29, #-8]');
+  WriteLn('    sub x3, x3, #1');
+  WriteLn('    stur x3, [x29, #-24]');
+  WriteLn('    ldur x0, [x29, #-48]');
+  WriteLn('    add x0, x0, #1');
+  WriteLn('    stur x0, [x29, #-48]');
+  EmitBranchLabel(loop_lbl);
+  EmitLabel(done_lbl);
+  WriteLn('    ldur x0, [x29, #-48]');
+  EmitAddSP(48);
+  EmitLdp;
+  EmitRet
+End;
+
+Procedure EmitReadFdRuntime;
+Begin
+  { Read fd routine - x0 = fd, returns one Char Or -1 For EOF }
+  { Reads through fd's buffer With x19 temporarily pointed at fd }
+  EmitLabel(rt_read_fd);
+  EmitStp;
+  EmitMovFP;
+  WriteLn('    str x19, [sp, #-16]!');
+  WriteLn('    mov x19, x0');
+  EmitBL(rt_readchar);
+  WriteLn('    ldr x19, [sp], #16');
+  EmitLdp;
+  EmitRet
+End;
+
+Procedure EmitReadcharRuntime;
+Var
+  eof_lbl, done_lbl: Integer;
+Begin
+  { ReadChar routine - Read one Char, return In x0 (-1 For EOF) }
+  { Uses x19 as input file descriptor (0=stdin, Or opened file) }
+  eof_lbl := NewLabel;
+  done_lbl := NewLabel;
+  EmitLabel(rt_readchar);
+  EmitStp;
+  EmitMovFP;
+  EmitInputPeek(eof_lbl);
+  EmitInputConsume;
+  EmitBranchLabel(done_lbl);
+  EmitLabel(eof_lbl);
+  EmitMovX0(-1);  { EOF }
+  EmitLabel(done_lbl);
+  EmitLdp;
+  EmitRet
+End;
+
+Procedure EmitEofRuntime;
+Var
+  eof_lbl, done_lbl: Integer;
+Begin
+  { Eof routine - x0 = fd, returns x0 = 1 If no more input can be Read }
+  { Peeks through fd's buffer, so only an empty buffer costs a syscall }
+  { Clobbers x0-x3 }
+  eof_lbl := NewLabel;
+  done_lbl := NewLabel;
+  EmitLabel(rt_eof);
+  EmitStp;
+  EmitMovFP;
+  WriteLn('    str x19, [sp, #-16]!');
+  WriteLn('    mov x19, x0');
+  EmitInputPeek(eof_lbl);
+  EmitMovX0(0);
+  EmitBranchLabel(done_lbl);
+  EmitLabel(eof_lbl);
+  EmitMovX0(1);
+  EmitLabel(done_lbl);
+  WriteLn('    ldr x19, [sp], #16');
+  EmitLdp;
+  EmitRet
+End;
+
+Procedure EmitOutSwitchRuntime;
+Var
+  keep_lbl: Integer;
+Begin
+  { Output switch - make [x28] the descriptor For x20 }
+  { Terminal output (fd 0-2) is written out when we move away from it, so }
+  { stdout And stderr stay In order. Preserves x0, returns x2 = descriptor }
+  { Clobbers x1-x3 }
+  keep_lbl := NewLabel;
+  EmitLabel(rt_out_switch);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(16);
+  WriteLn('    stur x0, [x29, #-8]');
+  WriteLn('    ldr x0, [x28]');
+  WriteLn('    ldr x1, [x0]');
+  WriteLn('    cmp x1, #2');
+  Write('    b.hi L'); WriteLn(keep_lbl);
+  EmitBL(rt_flush_desc);
+  EmitLabel(keep_lbl);
+  WriteLn('    mov x0, x20');
+  EmitBL(rt_io_desc);
+  WriteLn('    str x0, [x28]');
+  WriteLn('    mov x2, x0');
+  WriteLn('    ldur x0, [x29, #-8]');
+  EmitAddSP(16);
+  EmitLdp;
+  EmitRet
+End;
+
+Procedure EmitPrintCharRuntime;
+Var
+  put_lbl, switch_lbl, full_lbl: Integer;
+Begin
+  { Print Char routine - append Char In x0 To the buffer Of fd x20 }
+  { Clobbers x0-x2 }
+  put_lbl := NewLabel;
+  switch_lbl := NewLabel;
+  full_lbl := NewLabel;
+  EmitLabel(rt_print_char);
+  WriteLn('    ldr x2, [x28]');
+  WriteLn('    ldr x1, [x2]');
+  WriteLn('    cmp x1, x20');
+  Write('    b.ne L'); WriteLn(switch_lbl);
+  EmitLabel(put_lbl);
+  WriteLn('    ldr x1, [x2, #40]');
+  WriteLn('    strb w0, [x1], #1');
+  WriteLn('    str x1, [x2, #40]');
+  WriteLn('    ldr x0, [x2, #48]');
+  WriteLn('    cmp x1, x0');
+  Write('    b.hs L'); WriteLn(full_lbl);
+  EmitRet;
+  { x20 changed since the last Write }
+  EmitLabel(switch_lbl);
+  EmitStp;
+  WriteLn('    str x3, [sp, #-16]!');
+  EmitBL(rt_out_switch);
+  WriteLn('    ldr x3, [sp], #16');
+  EmitLdp;
+  EmitBranchLabel(put_lbl);
+  { Buffer full }
+  EmitLabel(full_lbl);
+  EmitStp;
+  WriteLn('    str x3, [sp, #-16]!');
+  WriteLn('    mov x0, x2');
+  EmitBL(rt_flush_desc);
+  WriteLn('    ldr x3, [sp], #16');
+  EmitLdp;
+  EmitRet
+End;
+
+Procedure EmitWriteCharFdRuntime;
+Begin
+  { Write Char To fd routine - x0=fd, x1=Char }
+  { Goes through fd's buffer With x20 temporarily pointed at fd }
+  EmitLabel(rt_write_char_fd);
+  EmitStp;
+  EmitMovFP;
+  WriteLn('    str x20, [sp, #-16]!');
+  WriteLn('    mov x20, x0');
+  WriteLn('    mov x0, x1');
+  EmitBL(rt_print_char);
+  WriteLn('    ldr x20, [sp], #16');
+  EmitLdp;
+  EmitRet
+End;
+
+Procedure EmitWriteBufRuntime;
+Var
+  chunk_lbl, copy_lbl, copied_lbl, done_lbl: Integer;
+Begin
+  { Write buffer routine - append x2 bytes at x1 To the buffer Of fd x20 }
+  { Used For escape sequences And other multi-byte writes }
+  { Clobbers x0-x3 }
+  chunk_lbl := NewLabel;
+  copy_lbl := NewLabel;
+  copied_lbl := NewLabel;
+  done_lbl := NewLabel;
+  EmitLabel(rt_write_buf);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(16);
+  { [x29-8] = source, [x29-16] = bytes left }
+  WriteLn('    stur x1, [x29, #-8]');
+  WriteLn('    stur x2, [x29, #-16]');
+  WriteLn('    ldr x0, [x28]');
+  WriteLn('    ldr x0, [x0]');
+  WriteLn('    cmp x0, x20');
+  Write('    b.eq L'); WriteLn(chunk_lbl);
+  EmitBL(rt_out_switch);
+
+  { Copy as much as fits, flush when full, repeat }
+  EmitLabel(chunk_lbl);
+  WriteLn('    ldur x2, [x29, #-16]');
+  Write('    cbz x2, L'); WriteLn(done_lbl);
+  { x1 = room left, capped at bytes left; x0 = destination }
+  WriteLn('    ldr x3, [x28]');
+  WriteLn('    ldr x0, [x3, #40]');
+  WriteLn('    ldr x1, [x3, #48]');
+  WriteLn('    sub x1, x1, x0');
+  WriteLn('    cmp x1, x2');
+  WriteLn('    csel x1, x1, x2, lt');
+  WriteLn('    sub x2, x2, x1');
+  WriteLn('    stur x2, [x29, #-16]');
+  WriteLn('    ldur x2, [x29, #-8]');
+  EmitLabel(copy_lbl);
+  Write('    cbz x1, L'); WriteLn(copied_lbl);
+  WriteLn('    ldrb w3, [x2], #1');
+  WriteLn('    strb w3, [x0], #1');
+  WriteLn('    sub x1, x1, #1');
+  EmitBranchLabel(copy_lbl);
+  EmitLabel(copied_lbl);
+  WriteLn('    stur x2, [x29, #-8]');
+  WriteLn('    ldr x3, [x28]');
+  WriteLn('    str x0, [x3, #40]');
+  WriteLn('    ldr x1, [x3, #48]');
+  WriteLn('    cmp x0, x1');
+  Write('    b.lo L'); WriteLn(chunk_lbl);
+  WriteLn('    mov x0, x3');
+  EmitBL(rt_flush_desc);
+  EmitBranchLabel(chunk_lbl);
+
+  EmitLabel(done_lbl);
+  EmitAddSP(16);
+  EmitLdp;
+  EmitRet
+End;
+
+Procedure EmitPrintStringRuntime;
+Begin
+  { Print String routine - x0 = address Of pascal String (Length byte + chars) }
+  { The characters go To rt_write_buf In one call. Clobbers x0-x3 }
+  EmitLabel(rt_print_string);
+  WriteLn('    add x1, x0, #1');
+  WriteLn('    ldrb w2, [x0]');
+  EmitBranchLabel(rt_write_buf)
+End;
+
+Procedure EmitPow10Addr(reg: Integer; tbl: Integer);
+Begin
+  { x<reg> = address Of a powers-of-ten table }
+  Write('    adrp x'); Write(reg); Write(', L'); Write(tbl); WriteLn('@PAGE');
+  Write('    add x'); Write(reg); Write(', x'); Write(reg); Write(', L'); Write(tbl); WriteLn('@PAGEOFF')
+End;
+
+Procedure EmitSwarCombine;
+Begin
+  { x4 holds 8 digit values (0..9), first digit In the low byte; }
+  { combine them pairwise into the 8-digit number. Clobbers x5-x6 }
+  WriteLn('    mov x5, #10');
+  WriteLn('    lsr x6, x4, #8');
+  WriteLn('    madd x4, x4, x5, x6');
+  WriteLn('    and x4, x4, #0x00FF00FF00FF00FF');
+  WriteLn('    mov x5, #100');
+  WriteLn('    lsr x6, x4, #16');
+  WriteLn('    madd x4, x4, x5, x6');
+  WriteLn('    and x4, x4, #0x0000FFFF0000FFFF');
+  WriteLn('    mov x5, #10000');
+  WriteLn('    lsr x6, x4, #32');
+  WriteLn('    madd x4, x4, x5, x6');
+  WriteLn('    mov w4, w4')
+End;
+
+Procedure EmitScanDigitsRuntime;
+Var
+  word_lbl, part_lbl, byte_lbl, done_lbl: Integer;
+Begin
+  { Scan digits - x0 = first byte, x1 = End (exclusive), x2 = value so far }
+  { Returns x0 = first non-digit, x2 = x2 * 10^n + digits, x3 = n }
+  { Takes 8 bytes per step While they fit before x1: a word Of digits is }
+  { converted With three multiply-adds, a partial word With a shift. }
+  { Overflow wraps. Leaf, clobbers x4-x7, x16-x17 }
+  word_lbl := NewLabel;
+  part_lbl := NewLabel;
+  byte_lbl := NewLabel;
+  done_lbl := NewLabel;
+  EmitLabel(rt_scan_digits);
+  WriteLn('    mov x3, #0');
+  WriteLn('    mov x16, #0x3030303030303030');
+  WriteLn('    mov x17, #0x0606060606060606');
+  EmitLabel(word_lbl);
+  WriteLn('    sub x4, x1, x0');
+  WriteLn('    cmp x4, #8');
+  Write('    b.lt L'); WriteLn(byte_lbl);
+  WriteLn('    ldr x4, [x0]');
+  { A byte is a digit iff its high nibble is 3 both before And after }
+  { adding 6; x6 gets a nonzero byte For every non-digit }
+  WriteLn('    and x6, x4, #0xF0F0F0F0F0F0F0F0');
+  WriteLn('    eor x6, x6, x16');
+  WriteLn('    add x5, x4, x17');
+  WriteLn('    and x5, x5, #0xF0F0F0F0F0F0F0F0');
+  WriteLn('    eor x5, x5, x16');
+  WriteLn('    orr x6, x6, x5');
+  Write('    cbnz x6, L'); WriteLn(part_lbl);
+  WriteLn('    sub x4, x4, x16');
+  EmitSwarCombine;
+  WriteLn('    movz x5, #0xE100');
+  WriteLn('    movk x5, #0x5F5, lsl #16');
+  WriteLn('    madd x2, x2, x5, x4');
+  WriteLn('    add x0, x0, #8');
+  WriteLn('    add x3, x3, #8');
+  EmitBranchLabel(word_lbl);
+
+  { n = digits before the first non-digit; shift them To the top so the }
+  { vacated low bytes act as leading zeros }
+  EmitLabel(part_lbl);
+  WriteLn('    rbit x6, x6');
+  WriteLn('    clz x6, x6');
+  WriteLn('    lsr x7, x6, #3');
+  Write('    cbz x7, L'); WriteLn(done_lbl);
+  WriteLn('    sub x4, x4, x16');
+  WriteLn('    mov x5, #64');
+  WriteLn('    sub x5, x5, x7, lsl #3');
+  WriteLn('    lsl x4, x4, x5');
+  EmitSwarCombine;
+  EmitPow10Addr(5, rt_pow10_int);
+  WriteLn('    ldr x5, [x5, x7, lsl #3]');
+  WriteLn('    madd x2, x2, x5, x4');
+  WriteLn('    add x0, x0, x7');
+  WriteLn('    add x3, x3, x7');
+  EmitRet;
+
+  { Fewer than 8 bytes left }
+  EmitLabel(byte_lbl);
+  WriteLn('    cmp x0, x1');
+  Write('    b.hs L'); WriteLn(done_lbl);
+  WriteLn('    ldrb w4, [x0]');
+  WriteLn('    sub w4, w4, #48');
+  WriteLn('    cmp w4, #9');
+  Write('    b.hi L'); WriteLn(done_lbl);
+  WriteLn('    mov x5, #10');
+  WriteLn('    madd x2, x2, x5, x4');
+  WriteLn('    add x0, x0, #1');
+  WriteLn('    add x3, x3, #1');
+  EmitBranchLabel(byte_lbl);
+  EmitLabel(done_lbl);
+  EmitRet
+End;
+
+Procedure EmitParseIntRuntime;
+Var
+  digits_lbl, pos_lbl, none_lbl, done_lbl: Integer;
+Begin
+  { Parse Integer - x0 = first byte, x1 = End. Optional sign, Then digits }
+  { Returns x0 = byte after the number, x2 = value, x3 = digit count; }
+  { With no digits x0 is unchanged And x2 = 0. Clobbers x4-x7, x16-x17 }
+  digits_lbl := NewLabel;
+  pos_lbl := NewLabel;
+  none_lbl := NewLabel;
+  done_lbl := NewLabel;
+  EmitLabel(rt_parse_int);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(16);
+  { [x29-8] = start, [x29-16] = 1 If negative }
+  WriteLn('    stur x0, [x29, #-8]');
+  WriteLn('    stur xzr, [x29, #-16]');
+  WriteLn('    cmp x0, x1');
+  Write('    b.hs L'); WriteLn(digits_lbl);
+  WriteLn('    ldrb w2, [x0]');
+  WriteLn('    cmp w2, #43');
+  Write('    b.eq L'); WriteLn(pos_lbl);
+  WriteLn('    cmp w2, #45');
+  Write('    b.ne L'); WriteLn(digits_lbl);
+  WriteLn('    mov x2, #1');
+  WriteLn('    stur x2, [x29, #-16]');
+  EmitLabel(pos_lbl);
+  WriteLn('    add x0, x0, #1');
+  EmitLabel(digits_lbl);
+  WriteLn('    mov x2, #0');
+  EmitBL(rt_scan_digits);
+  Write('    cbz x3, L'); WriteLn(none_lbl);
+  WriteLn('    ldur x4, [x29, #-16]');
+  Write('    cbz x4, L'); WriteLn(done_lbl);
+  WriteLn('    neg x2, x2');
+  EmitBranchLabel(done_lbl);
+  EmitLabel(none_lbl);
+  WriteLn('    ldur x0, [x29, #-8]');
+  EmitLabel(done_lbl);
+  EmitAddSP(16);
+  EmitLdp;
+  EmitRet
+End;
+
+Procedure EmitRealExactRuntime;
+Var
+  mul_lbl, mloop_lbl, mtail_lbl, mdone_lbl: Integer;
+  shl_lbl, sloop_lbl, slow0_lbl, sstore_lbl, szero_lbl, szloop_lbl, sfin_lbl, sret_lbl: Integer;
+  pow5_lbl, p27_lbl, prest_lbl, pmul_lbl, pret_lbl: Integer;
+  main_lbl, rloop_lbl, rdig_lbl, rend_lbl, rnosign_lbl, rnext_lbl, rfull_lbl, rsticky_lbl, rflush_lbl: Integer;
+  cmp_lbl, sub_lbl, qneg_lbl, tneg_lbl, copy_lbl, cloop_lbl, gt_lbl, lt_lbl, cret_lbl: Integer;
+  up_lbl, raise_lbl, tryd_lbl, down_lbl, lower_lbl, out_lbl: Integer;
+Begin
+  { Exact Real rounding - x0 = number text, x1 = End, x2 = e And x3 = }
+  { significant digit count As found by rt_parse_real, d0 = b, a }
+  { non-negative double within a few units Of the correct result. The }
+  { decimal value Is rebuilt As a big Integer D * 10^q And compared With }
+  { the midpoint M * 2^F between b And the next double, moving b up Or }
+  { down Until it Is bracketed; equal rounds To even. At most 800 }
+  { digits are kept, later nonzero digits become a final 1. Numbers }
+  { are little-endian 64-bit limbs after a limb count, 80 limbs each }
+  mul_lbl := NewLabel;
+  mloop_lbl := NewLabel;
+  mtail_lbl := NewLabel;
+  mdone_lbl := NewLabel;
+  shl_lbl := NewLabel;
+  sloop_lbl := NewLabel;
+  slow0_lbl := NewLabel;
+  sstore_lbl := NewLabel;
+  szero_lbl := NewLabel;
+  szloop_lbl := NewLabel;
+  sfin_lbl := NewLabel;
+  sret_lbl := NewLabel;
+  pow5_lbl := NewLabel;
+  p27_lbl := NewLabel;
+  prest_lbl := NewLabel;
+  pmul_lbl := NewLabel;
+  pret_lbl := NewLabel;
+  main_lbl := NewLabel;
+  rloop_lbl := NewLabel;
+  rdig_lbl := NewLabel;
+  rend_lbl := NewLabel;
+  rnosign_lbl := NewLabel;
+  rnext_lbl := NewLabel;
+  rfull_lbl := NewLabel;
+  rsticky_lbl := NewLabel;
+  rflush_lbl := NewLabel;
+  cmp_lbl := NewLabel;
+  sub_lbl := NewLabel;
+  qneg_lbl := NewLabel;
+  tneg_lbl := NewLabel;
+  copy_lbl := NewLabel;
+  cloop_lbl := NewLabel;
+  gt_lbl := NewLabel;
+  lt_lbl := NewLabel;
+  cret_lbl := NewLabel;
+  up_lbl := NewLabel;
+  raise_lbl := NewLabel;
+  tryd_lbl := NewLabel;
+  down_lbl := NewLabel;
+  lower_lbl := NewLabel;
+  out_lbl := NewLabel;
+  EmitLabel(rt_real_exact);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(2016);
+  { [sp] = D, [sp+656] = work copy Of D, [sp+1312] = midpoint, }
+  { [x29-8] = e Then q, [x29-16] = bits Of b, [x29-24] = significant }
+  { digits Then F, [x29-32] = 1 once b moved up, [x29-40] = Return }
+  WriteLn('    fmov x4, d0');
+  WriteLn('    stur x4, [x29, #-16]');
+  WriteLn('    stur x2, [x29, #-8]');
+  WriteLn('    stur x3, [x29, #-24]');
+  EmitBranchLabel(main_lbl);
+
+  { Local: limbs at x0 times x1 plus x2. Clobbers x2-x7 }
+  EmitLabel(mul_lbl);
+  WriteLn('    ldr x3, [x0]');
+  WriteLn('    add x4, x0, #8');
+  WriteLn('    mov x5, #0');
+  EmitLabel(mloop_lbl);
+  WriteLn('    cmp x5, x3');
+  Write('    b.hs L'); WriteLn(mtail_lbl);
+  WriteLn('    ldr x6, [x4, x5, lsl #3]');
+  WriteLn('    mul x7, x6, x1');
+  WriteLn('    umulh x6, x6, x1');
+  WriteLn('    adds x7, x7, x2');
+  WriteLn('    adc x2, x6, xzr');
+  WriteLn('    str x7, [x4, x5, lsl #3]');
+  WriteLn('    add x5, x5, #1');
+  EmitBranchLabel(mloop_lbl);
+  EmitLabel(mtail_lbl);
+  Write('    cbz x2, L'); WriteLn(mdone_lbl);
+  WriteLn('    str x2, [x4, x3, lsl #3]');
+  WriteLn('    add x3, x3, #1');
+  WriteLn('    str x3, [x0]');
+  EmitLabel(mdone_lbl);
+  EmitRet;
+
+  { Local: limbs at x0 shifted left by x1 bits. Clobbers x1-x8, x10-x12 }
+  EmitLabel(shl_lbl);
+  WriteLn('    ldr x3, [x0]');
+  Write('    cbz x3, L'); WriteLn(sret_lbl);
+  WriteLn('    lsr x4, x1, #6');
+  WriteLn('    and x5, x1, #63');
+  WriteLn('    mov x8, #63');
+  WriteLn('    sub x8, x8, x5');
+  WriteLn('    add x6, x0, #8');
+  WriteLn('    sub x2, x3, #1');
+  { Bits pushed out Of the top limb; two shifts so that s = 0 gives 0 }
+  WriteLn('    ldr x7, [x6, x2, lsl #3]');
+  WriteLn('    lsr x7, x7, #1');
+  WriteLn('    lsr x7, x7, x8');
+  EmitLabel(sloop_lbl);
+  WriteLn('    ldr x10, [x6, x2, lsl #3]');
+  WriteLn('    lsl x10, x10, x5');
+  WriteLn('    mov x11, #0');
+  Write('    cbz x2, L'); WriteLn(slow0_lbl);
+  WriteLn('    sub x12, x2, #1');
+  WriteLn('    ldr x11, [x6, x12, lsl #3]');
+  WriteLn('    lsr x11, x11, #1');
+  WriteLn('    lsr x11, x11, x8');
+  EmitLabel(slow0_lbl);
+  WriteLn('    orr x10, x10, x11');
+  WriteLn('    add x12, x2, x4');
+  WriteLn('    str x10, [x6, x12, lsl #3]');
+  Write('    cbz x2, L'); WriteLn(szero_lbl);
+  WriteLn('    sub x2, x2, #1');
+  EmitBranchLabel(sloop_lbl);
+  EmitLabel(szero_lbl);
+  EmitLabel(szloop_lbl);
+  WriteLn('    cmp x2, x4');
+  Write('    b.hs L'); WriteLn(sfin_lbl);
+  WriteLn('    str xzr, [x6, x2, lsl #3]');
+  WriteLn('    add x2, x2, #1');
+  EmitBranchLabel(szloop_lbl);
+  EmitLabel(sfin_lbl);
+  WriteLn('    add x3, x3, x4');
+  Write('    cbz x7, L'); WriteLn(sstore_lbl);
+  WriteLn('    str x7, [x6, x3, lsl #3]');
+  WriteLn('    add x3, x3, #1');
+  EmitLabel(sstore_lbl);
+  WriteLn('    str x3, [x0]');
+  EmitLabel(sret_lbl);
+  EmitRet;
+
+  { Local: limbs at x0 times 5^x1. Clobbers x1-x7, x12-x15 }
+  EmitLabel(pow5_lbl);
+  WriteLn('    mov x15, x30');
+  WriteLn('    mov x12, x1');
+  WriteLn('    mov x13, x0');
+  EmitLabel(p27_lbl);
+  WriteLn('    cmp x12, #27');
+  Write('    b.lo L'); WriteLn(prest_lbl);
+  { 5^27 = 0x6765C793FA10079D }
+  WriteLn('    movz x1, #0x079D');
+  WriteLn('    movk x1, #0xFA10, lsl #16');
+  WriteLn('    movk x1, #0xC793, lsl #32');
+  WriteLn('    movk x1, #0x6765, lsl #48');
+  WriteLn('    mov x2, #0');
+  WriteLn('    mov x0, x13');
+  EmitBL(mul_lbl);
+  WriteLn('    sub x12, x12, #27');
+  EmitBranchLabel(p27_lbl);
+  EmitLabel(prest_lbl);
+  WriteLn('    mov x1, #1');
+  WriteLn('    mov x14, #5');
+  EmitLabel(pmul_lbl);
+  Write('    cbz x12, L'); WriteLn(pret_lbl);
+  WriteLn('    mul x1, x1, x14');
+  WriteLn('    sub x12, x12, #1');
+  EmitBranchLabel(pmul_lbl);
+  EmitLabel(pret_lbl);
+  WriteLn('    mov x2, #0');
+  WriteLn('    mov x0, x13');
+  EmitBL(mul_lbl);
+  WriteLn('    mov x30, x15');
+  EmitRet;
+
+  { D from the digits: x10 = text, x11 = End, x12 = digits kept, }
+  { x13 = pending chunk, x14 = its length, x15 = bit 0 seen '.', }
+  { bit 1 first significant digit seen, x16 = dropped nonzero digit }
+  EmitLabel(main_lbl);
+  WriteLn('    str xzr, [sp]');
+  WriteLn('    mov x10, x0');
+  WriteLn('    mov x11, x1');
+  WriteLn('    mov x12, #0');
+  WriteLn('    mov x13, #0');
+  WriteLn('    mov x14, #0');
+  WriteLn('    mov x15, #0');
+  WriteLn('    mov x16, #0');
+  WriteLn('    ldrb w4, [x10]');
+  WriteLn('    cmp w4, #43');
+  Write('    b.eq L'); WriteLn(rnosign_lbl);
+  WriteLn('    cmp w4, #45');
+  Write('    b.ne L'); WriteLn(rloop_lbl);
+  EmitLabel(rnosign_lbl);
+  WriteLn('    add x10, x10, #1');
+  EmitLabel(rloop_lbl);
+  WriteLn('    cmp x10, x11');
+  Write('    b.hs L'); WriteLn(rend_lbl);
+  WriteLn('    ldrb w4, [x10]');
+  WriteLn('    cmp w4, #46');
+  Write('    b.ne L'); WriteLn(rdig_lbl);
+  Write('    tbnz x15, #0, L'); WriteLn(rend_lbl);
+  WriteLn('    orr x15, x15, #1');
+  WriteLn('    add x10, x10, #1');
+  EmitBranchLabel(rloop_lbl);
+  EmitLabel(rdig_lbl);
+  WriteLn('    sub w4, w4, #48');
+  WriteLn('    cmp w4, #9');
+  Write('    b.hi L'); WriteLn(rend_lbl);
+  WriteLn('    add x10, x10, #1');
+  Write('    tbnz x15, #1, L'); WriteLn(rnext_lbl);
+  Write('    cbz w4, L'); WriteLn(rloop_lbl);
+  WriteLn('    orr x15, x15, #2');
+  EmitLabel(rnext_lbl);
+  WriteLn('    cmp x12, #800');
+  Write('    b.lo L'); WriteLn(rfull_lbl);
+  WriteLn('    orr x16, x16, x4');
+  EmitBranchLabel(rloop_lbl);
+  EmitLabel(rfull_lbl);
+  WriteLn('    mov x5, #10');
+  WriteLn('    madd x13, x13, x5, x4');
+  WriteLn('    add x14, x14, #1');
+  WriteLn('    add x12, x12, #1');
+  WriteLn('    cmp x14, #18');
+  Write('    b.lo L'); WriteLn(rloop_lbl);
+  EmitPow10Addr(1, rt_pow10_int);
+  WriteLn('    ldr x1, [x1, #144]');
+  WriteLn('    mov x2, x13');
+  WriteLn('    mov x0, sp');
+  EmitBL(mul_lbl);
+  WriteLn('    mov x13, #0');
+  WriteLn('    mov x14, #0');
+  EmitBranchLabel(rloop_lbl);
+  EmitLabel(rend_lbl);
+  Write('    cbz x16, L'); WriteLn(rsticky_lbl);
+  WriteLn('    mov x5, #10');
+  WriteLn('    madd x13, x13, x5, xzr');
+  WriteLn('    add x13, x13, #1');
+  WriteLn('    add x14, x14, #1');
+  WriteLn('    add x12, x12, #1');
+  EmitLabel(rsticky_lbl);
+  Write('    cbz x14, L'); WriteLn(rflush_lbl);
+  EmitPow10Addr(1, rt_pow10_int);
+  WriteLn('    ldr x1, [x1, x14, lsl #3]');
+  WriteLn('    mov x2, x13');
+  WriteLn('    mov x0, sp');
+  EmitBL(mul_lbl);
+  EmitLabel(rflush_lbl);
+
+  { q = e - (kept - significant) }
+  WriteLn('    ldur x2, [x29, #-8]');
+  WriteLn('    ldur x3, [x29, #-24]');
+  WriteLn('    sub x2, x2, x12');
+  WriteLn('    add x2, x2, x3');
+  WriteLn('    stur x2, [x29, #-8]');
+
+  WriteLn('    stur xzr, [x29, #-32]');
+
+  { Move b up While the value Is above its upper midpoint }
+  EmitLabel(up_lbl);
+  WriteLn('    ldur x4, [x29, #-16]');
+  WriteLn('    movz x5, #0x7FF0, lsl #48');
+  WriteLn('    cmp x4, x5');
+  Write('    b.hs L'); WriteLn(out_lbl);
+  EmitBL(cmp_lbl);
+  WriteLn('    ldur x4, [x29, #-16]');
+  WriteLn('    cmp x0, #0');
+  Write('    b.gt L'); WriteLn(raise_lbl);
+  Write('    b.lt L'); WriteLn(tryd_lbl);
+  Write('    tbz x4, #0, L'); WriteLn(out_lbl);
+  EmitLabel(raise_lbl);
+  WriteLn('    add x4, x4, #1');
+  WriteLn('    stur x4, [x29, #-16]');
+  WriteLn('    mov x5, #1');
+  WriteLn('    stur x5, [x29, #-32]');
+  EmitBranchLabel(up_lbl);
+
+  { Else move it down While the value Is below its lower midpoint }
+  EmitLabel(tryd_lbl);
+  WriteLn('    ldur x5, [x29, #-32]');
+  Write('    cbnz x5, L'); WriteLn(out_lbl);
+  EmitLabel(down_lbl);
+  WriteLn('    ldur x4, [x29, #-16]');
+  Write('    cbz x4, L'); WriteLn(out_lbl);
+  WriteLn('    sub x4, x4, #1');
+  EmitBL(cmp_lbl);
+  WriteLn('    ldur x4, [x29, #-16]');
+  WriteLn('    cmp x0, #0');
+  Write('    b.gt L'); WriteLn(out_lbl);
+  Write('    b.lt L'); WriteLn(lower_lbl);
+  Write('    tbz x4, #0, L'); WriteLn(out_lbl);
+  EmitLabel(lower_lbl);
+  WriteLn('    sub x4, x4, #1');
+  WriteLn('    stur x4, [x29, #-16]');
+  EmitBranchLabel(down_lbl);
+
+  EmitLabel(out_lbl);
+  WriteLn('    ldur x4, [x29, #-16]');
+  WriteLn('    fmov d0, x4');
+  EmitAddSP(2016);
+  EmitLdp;
+  EmitRet;
+
+  { Local: x4 = bits Of a double c; x0 = sign Of D * 10^q minus the }
+  { midpoint (2m + 1) * 2^(E-1) between c And the next double }
+  EmitLabel(cmp_lbl);
+  WriteLn('    stur x30, [x29, #-40]');
+  WriteLn('    and x5, x4, #0xFFFFFFFFFFFFF');
+  WriteLn('    lsr x6, x4, #52');
+  WriteLn('    mov x7, #-1074');
+  Write('    cbz x6, L'); WriteLn(sub_lbl);
+  WriteLn('    orr x5, x5, #0x10000000000000');
+  WriteLn('    mov x7, #1075');
+  WriteLn('    sub x7, x6, x7');
+  EmitLabel(sub_lbl);
+  WriteLn('    lsl x5, x5, #1');
+  WriteLn('    add x5, x5, #1');
+  WriteLn('    sub x7, x7, #1');
+  WriteLn('    stur x7, [x29, #-24]');
+  WriteLn('    add x0, sp, #1312');
+  WriteLn('    mov x1, #1');
+  WriteLn('    stp x1, x5, [x0]');
+  WriteLn('    ldr x2, [sp]');
+  WriteLn('    add x3, sp, #656');
+  EmitLabel(copy_lbl);
+  WriteLn('    ldr x1, [sp, x2, lsl #3]');
+  WriteLn('    str x1, [x3, x2, lsl #3]');
+  WriteLn('    sub x2, x2, #1');
+  Write('    tbz x2, #63, L'); WriteLn(copy_lbl);
+
+  { Powers Of 5 go To whichever side has them, Then powers Of 2 }
+  WriteLn('    add x0, sp, #656');
+  WriteLn('    ldur x1, [x29, #-8]');
+  Write('    tbz x1, #63, L'); WriteLn(qneg_lbl);
+  WriteLn('    add x0, sp, #1312');
+  WriteLn('    neg x1, x1');
+  EmitLabel(qneg_lbl);
+  EmitBL(pow5_lbl);
+  WriteLn('    ldur x1, [x29, #-8]');
+  WriteLn('    ldur x2, [x29, #-24]');
+  WriteLn('    subs x1, x1, x2');
+  WriteLn('    add x0, sp, #656');
+  Write('    b.ge L'); WriteLn(tneg_lbl);
+  WriteLn('    add x0, sp, #1312');
+  WriteLn('    neg x1, x1');
+  EmitLabel(tneg_lbl);
+  EmitBL(shl_lbl);
+
+  { Longer wins, Then from the top limb down }
+  WriteLn('    ldr x2, [sp, #656]');
+  WriteLn('    ldr x3, [sp, #1312]');
+  WriteLn('    cmp x2, x3');
+  Write('    b.hi L'); WriteLn(gt_lbl);
+  Write('    b.lo L'); WriteLn(lt_lbl);
+  WriteLn('    add x4, sp, #664');
+  WriteLn('    add x5, sp, #1320');
+  WriteLn('    mov x0, #0');
+  EmitLabel(cloop_lbl);
+  Write('    cbz x2, L'); WriteLn(cret_lbl);
+  WriteLn('    sub x2, x2, #1');
+  WriteLn('    ldr x6, [x4, x2, lsl #3]');
+  WriteLn('    ldr x7, [x5, x2, lsl #3]');
+  WriteLn('    cmp x6, x7');
+  Write('    b.hi L'); WriteLn(gt_lbl);
+  Write('    b.lo L'); WriteLn(lt_lbl);
+  EmitBranchLabel(cloop_lbl);
+  EmitLabel(gt_lbl);
+  WriteLn('    mov x0, #1');
+  EmitBranchLabel(cret_lbl);
+  EmitLabel(lt_lbl);
+  WriteLn('    mov x0, #-1');
+  EmitLabel(cret_lbl);
+  WriteLn('    ldur x30, [x29, #-40]');
+  EmitRet
+End;
+
+Procedure EmitParseRealRuntime;
+Var
+  z1_lbl, int_lbl, skip1_lbl, frac_lbl, z2_lbl, fdig_lbl, skip2_lbl: Integer;
+  exp_lbl, esign_lbl, edig_lbl, eloop_lbl, eclamp_lbl, eend_lbl: Integer;
+  conv_lbl, slow_lbl, div_lbl, zero_lbl, sign_lbl, done_lbl, none_lbl: Integer;
+  near_lbl, exact_lbl: Integer;
+  skip1_end_lbl, skip2_end_lbl, epos_lbl: Integer;
+Begin
+  { Parse Real - x0 = first byte, x1 = End. Accepts [sign] digits [. digits] }
+  { [e [sign] digits] And returns x0 = byte after it, d0 = value, x3 = }
+  { mantissa digit count (0: no number, x0 unchanged, d0 = 0) }
+  { Up To 19 significant digits are kept In an Integer w With the value }
+  { w * 10^e. If w < 2^53 And |e| <= 22 one exact multiply Or divide }
+  { gives the correctly rounded result; otherwise rt_real_scale does it }
+  { In double-double, With rt_real_exact For the rare close calls. }
+  { Clobbers x0-x7, x10-x17, d0-d7 }
+  z1_lbl := NewLabel;
+  int_lbl := NewLabel;
+  skip1_lbl := NewLabel;
+  skip1_end_lbl := NewLabel;
+  frac_lbl := NewLabel;
+  z2_lbl := NewLabel;
+  fdig_lbl := NewLabel;
+  skip2_lbl := NewLabel;
+  skip2_end_lbl := NewLabel;
+  exp_lbl := NewLabel;
+  esign_lbl := NewLabel;
+  epos_lbl := NewLabel;
+  edig_lbl := NewLabel;
+  eloop_lbl := NewLabel;
+  eclamp_lbl := NewLabel;
+  eend_lbl := NewLabel;
+  conv_lbl := NewLabel;
+  slow_lbl := NewLabel;
+  div_lbl := NewLabel;
+  zero_lbl := NewLabel;
+  sign_lbl := NewLabel;
+  done_lbl := NewLabel;
+  none_lbl := NewLabel;
+  near_lbl := NewLabel;
+  exact_lbl := NewLabel;
+  EmitLabel(rt_parse_real);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(80);
+  { [x29-8] = start, [x29-16] = 1 If negative, [x29-24] = End, }
+  { [x29-32] = w, [x29-40] = e, [x29-48] = significant digits, }
+  { [x29-56] = 1 If nonzero digits were dropped, [x29-64] = all digits, }
+  { [x29-72] = End Of the number }
+  WriteLn('    stur x0, [x29, #-8]');
+  WriteLn('    stur xzr, [x29, #-16]');
+  WriteLn('    stur x1, [x29, #-24]');
+  WriteLn('    stp xzr, xzr, [x29, #-40]');
+  WriteLn('    stp xzr, xzr, [x29, #-56]');
+  WriteLn('    stur xzr, [x29, #-64]');
+  WriteLn('    cmp x0, x1');
+  Write('    b.hs L'); WriteLn(z1_lbl);
+  WriteLn('    ldrb w2, [x0]');
+  WriteLn('    cmp w2, #43');
+  Write('    b.eq L'); WriteLn(int_lbl);
+  WriteLn('    cmp w2, #45');
+  Write('    b.ne L'); WriteLn(z1_lbl);
+  WriteLn('    mov x2, #1');
+  WriteLn('    stur x2, [x29, #-16]');
+  EmitLabel(int_lbl);
+  WriteLn('    add x0, x0, #1');
+
+  { Leading zeros carry no significance }
+  EmitLabel(z1_lbl);
+  WriteLn('    mov x6, #0');
+  EmitLabel(skip1_lbl);
+  WriteLn('    cmp x0, x1');
+  Write('    b.hs L'); WriteLn(skip1_end_lbl);
+  WriteLn('    ldrb w2, [x0]');
+  WriteLn('    cmp w2, #48');
+  Write('    b.ne L'); WriteLn(skip1_end_lbl);
+  WriteLn('    add x0, x0, #1');
+  WriteLn('    add x6, x6, #1');
+  EmitBranchLabel(skip1_lbl);
+  EmitLabel(skip1_end_lbl);
+  WriteLn('    stur x6, [x29, #-64]');
+  { Integer digits, at most 19 into w }
+  WriteLn('    add x1, x0, #19');
+  WriteLn('    ldur x2, [x29, #-24]');
+  WriteLn('    cmp x1, x2');
+  WriteLn('    csel x1, x1, x2, lo');
+  WriteLn('    mov x2, #0');
+  EmitBL(rt_scan_digits);
+  WriteLn('    stur x2, [x29, #-32]');
+  WriteLn('    stur x3, [x29, #-48]');
+  WriteLn('    ldur x6, [x29, #-64]');
+  WriteLn('    add x6, x6, x3');
+  { Further Integer digits only scale w: e += 1 each }
+  WriteLn('    ldur x1, [x29, #-24]');
+  WriteLn('    mov x5, #0');
+  WriteLn('    ldur x7, [x29, #-56]');
+  EmitLabel(z2_lbl);
+  WriteLn('    cmp x0, x1');
+  Write('    b.hs L'); WriteLn(frac_lbl);
+  WriteLn('    ldrb w2, [x0]');
+  WriteLn('    sub w2, w2, #48');
+  WriteLn('    cmp w2, #9');
+  Write('    b.hi L'); WriteLn(frac_lbl);
+  WriteLn('    orr x7, x7, x2');
+  WriteLn('    add x0, x0, #1');
+  WriteLn('    add x5, x5, #1');
+  WriteLn('    add x6, x6, #1');
+  EmitBranchLabel(z2_lbl);
+
+  { Fraction: '.' counts only When a digit follows }
+  EmitLabel(frac_lbl);
+  WriteLn('    stur x5, [x29, #-40]');
+  WriteLn('    stur x7, [x29, #-56]');
+  WriteLn('    stur x6, [x29, #-64]');
+  WriteLn('    add x2, x0, #1');
+  WriteLn('    cmp x2, x1');
+  Write('    b.hs L'); WriteLn(exp_lbl);
+  WriteLn('    ldrb w2, [x0]');
+  WriteLn('    cmp w2, #46');
+  Write('    b.ne L'); WriteLn(exp_lbl);
+  WriteLn('    ldrb w2, [x0, #1]');
+  WriteLn('    sub w2, w2, #48');
+  WriteLn('    cmp w2, #9');
+  Write('    b.hi L'); WriteLn(exp_lbl);
+  WriteLn('    add x0, x0, #1');
+  { Without significant digits yet, fraction zeros only move e }
+  WriteLn('    ldur x3, [x29, #-48]');
+  WriteLn('    ldur x5, [x29, #-40]');
+  Write('    cbnz x3, L'); WriteLn(fdig_lbl);
+  EmitLabel(skip2_lbl);
+  WriteLn('    cmp x0, x1');
+  Write('    b.hs L'); WriteLn(fdig_lbl);
+  WriteLn('    ldrb w2, [x0]');
+  WriteLn('    cmp w2, #48');
+  Write('    b.ne L'); WriteLn(fdig_lbl);
+  WriteLn('    add x0, x0, #1');
+  WriteLn('    sub x5, x5, #1');
+  WriteLn('    add x6, x6, #1');
+  EmitBranchLabel(skip2_lbl);
+  { Fraction digits into w While it has room: e -= 1 each }
+  EmitLabel(fdig_lbl);
+  WriteLn('    stur x5, [x29, #-40]');
+  WriteLn('    stur x6, [x29, #-64]');
+  WriteLn('    mov x2, #19');
+  WriteLn('    sub x2, x2, x3');
+  WriteLn('    add x1, x0, x2');
+  WriteLn('    ldur x2, [x29, #-24]');
+  WriteLn('    cmp x1, x2');
+  WriteLn('    csel x1, x1, x2, lo');
+  WriteLn('    ldur x2, [x29, #-32]');
+  EmitBL(rt_scan_digits);
+  WriteLn('    stur x2, [x29, #-32]');
+  WriteLn('    ldur x4, [x29, #-48]');
+  WriteLn('    add x4, x4, x3');
+  WriteLn('    stur x4, [x29, #-48]');
+  WriteLn('    ldur x5, [x29, #-40]');
+  WriteLn('    sub x5, x5, x3');
+  WriteLn('    stur x5, [x29, #-40]');
+  WriteLn('    ldur x6, [x29, #-64]');
+  WriteLn('    add x6, x6, x3');
+  { Remaining fraction digits only matter If nonzero }
+  WriteLn('    ldur x1, [x29, #-24]');
+  WriteLn('    ldur x7, [x29, #-56]');
+  EmitLabel(skip2_end_lbl);
+  WriteLn('    cmp x0, x1');
+  Write('    b.hs L'); WriteLn(eend_lbl);
+  WriteLn('    ldrb w2, [x0]');
+  WriteLn('    sub w2, w2, #48');
+  WriteLn('    cmp w2, #9');
+  Write('    b.hi L'); WriteLn(eend_lbl);
+  WriteLn('    orr x7, x7, x2');
+  WriteLn('    add x0, x0, #1');
+  WriteLn('    add x6, x6, #1');
+  EmitBranchLabel(skip2_end_lbl);
+  EmitLabel(eend_lbl);
+  WriteLn('    stur x7, [x29, #-56]');
+  WriteLn('    stur x6, [x29, #-64]');
+
+  { Exponent: e Or E, optional sign, at least one digit }
+  EmitLabel(exp_lbl);
+  WriteLn('    ldur x6, [x29, #-64]');
+  Write('    cbz x6, L'); WriteLn(none_lbl);
+  WriteLn('    mov x4, x0');
+  WriteLn('    cmp x4, x1');
+  Write('    b.hs L'); WriteLn(conv_lbl);
+  WriteLn('    ldrb w2, [x4], #1');
+  WriteLn('    orr w2, w2, #32');
+  WriteLn('    cmp w2, #101');
+  Write('    b.ne L'); WriteLn(conv_lbl);
+  WriteLn('    mov x6, #0');
+  WriteLn('    cmp x4, x1');
+  Write('    b.hs L'); WriteLn(conv_lbl);
+  WriteLn('    ldrb w2, [x4]');
+  WriteLn('    cmp w2, #43');
+  Write('    b.eq L'); WriteLn(epos_lbl);
+  WriteLn('    cmp w2, #45');
+  Write('    b.ne L'); WriteLn(esign_lbl);
+  WriteLn('    mov x6, #1');
+  EmitLabel(epos_lbl);
+  WriteLn('    add x4, x4, #1');
+  EmitLabel(esign_lbl);
+  { x5 = exponent, capped so a long run Of digits cannot overflow it }
+  WriteLn('    mov x5, #0');
+  WriteLn('    mov x3, #0');
+  WriteLn('    mov x7, #10');
+  EmitLabel(eloop_lbl);
+  WriteLn('    cmp x4, x1');
+  Write('    b.hs L'); WriteLn(edig_lbl);
+  WriteLn('    ldrb w2, [x4]');
+  WriteLn('    sub w2, w2, #48');
+  WriteLn('    cmp w2, #9');
+  Write('    b.hi L'); WriteLn(edig_lbl);
+  WriteLn('    add x4, x4, #1');
+  WriteLn('    add x3, x3, #1');
+  WriteLn('    mov x17, #10000');
+  WriteLn('    cmp x5, x17');
+  Write('    b.ge L'); WriteLn(eloop_lbl);
+  WriteLn('    madd x5, x5, x7, x2');
+  EmitBranchLabel(eloop_lbl);
+  EmitLabel(edig_lbl);
+  Write('    cbz x3, L'); WriteLn(conv_lbl);
+  WriteLn('    mov x0, x4');
+  WriteLn('    cmp x6, #0');
+  WriteLn('    cneg x5, x5, ne');
+  WriteLn('    ldur x2, [x29, #-40]');
+  WriteLn('    add x2, x2, x5');
+  WriteLn('    stur x2, [x29, #-40]');
+
+  { Convert w * 10^e }
+  EmitLabel(conv_lbl);
+  WriteLn('    ldur x2, [x29, #-32]');
+  WriteLn('    ldur x4, [x29, #-40]');
+  WriteLn('    ldur x7, [x29, #-56]');
+  WriteLn('    fmov d0, xzr');
+  Write('    cbz x2, L'); WriteLn(sign_lbl);
+  Write('    cbnz x7, L'); WriteLn(slow_lbl);
+  WriteLn('    lsr x5, x2, #53');
+  Write('    cbnz x5, L'); WriteLn(slow_lbl);
+  WriteLn('    cmp x4, #22');
+  Write('    b.gt L'); WriteLn(slow_lbl);
+  WriteLn('    cmn x4, #22');
+  Write('    b.lt L'); WriteLn(slow_lbl);
+  WriteLn('    scvtf d0, x2');
+  EmitPow10Addr(5, rt_pow10_dbl);
+  Write('    tbnz x4, #63, L'); WriteLn(div_lbl);
+  WriteLn('    ldr d1, [x5, x4, lsl #3]');
+  WriteLn('    fmul d0, d0, d1');
+  EmitBranchLabel(sign_lbl);
+  EmitLabel(div_lbl);
+  WriteLn('    neg x4, x4');
+  WriteLn('    ldr d1, [x5, x4, lsl #3]');
+  WriteLn('    fdiv d0, d0, d1');
+  EmitBranchLabel(sign_lbl);
+
+  { Far exponents: w >= 1, so beyond 10^310 it is Inf And below }
+  { 10^-345 it is 0 }
+  EmitLabel(slow_lbl);
+  WriteLn('    cmp x4, #310');
+  Write('    b.le L'); WriteLn(eclamp_lbl);
+  WriteLn('    movz x5, #0x7FF0, lsl #48');
+  WriteLn('    fmov d0, x5');
+  EmitBranchLabel(sign_lbl);
+  EmitLabel(eclamp_lbl);
+  WriteLn('    cmn x4, #345');
+  Write('    b.lt L'); WriteLn(sign_lbl);
+  { d0 + d3 = w exactly }
+  WriteLn('    ucvtf d0, x2');
+  WriteLn('    fcvtzu x5, d0');
+  WriteLn('    sub x5, x2, x5');
+  WriteLn('    scvtf d3, x5');
+  WriteLn('    stur x0, [x29, #-72]');
+  WriteLn('    mov x0, x4');
+  EmitBL(rt_real_scale);
+  { The value lies between L = h + l - u And U = h + l + u (+ 10^e If }
+  { digits were dropped), u covering the double-double error. When L }
+  { And U round alike that Is the answer, Else rt_real_exact decides }
+  WriteLn('    fabs d1, d0');
+  WriteLn('    movz x5, #0x39F0, lsl #48');
+  WriteLn('    fmov d2, x5');
+  WriteLn('    fmul d2, d1, d2');
+  WriteLn('    mov x5, #4');
+  WriteLn('    fmov d6, x5');
+  WriteLn('    fadd d2, d2, d6');
+  WriteLn('    fsub d4, d3, d2');
+  WriteLn('    fadd d4, d0, d4');
+  WriteLn('    fadd d5, d3, d2');
+  WriteLn('    ldur x7, [x29, #-56]');
+  Write('    cbz x7, L'); WriteLn(zero_lbl);
+  WriteLn('    movz x5, #0x3C40, lsl #48');
+  WriteLn('    fmov d6, x5');
+  WriteLn('    fmul d6, d1, d6');
+  WriteLn('    fadd d5, d5, d6');
+  EmitLabel(zero_lbl);
+  WriteLn('    fadd d5, d0, d5');
+  WriteLn('    fmov d2, xzr');
+  WriteLn('    fcmp d4, #0.0');
+  WriteLn('    fcsel d4, d2, d4, mi');
+  WriteLn('    fcmp d4, d5');
+  Write('    b.eq L'); WriteLn(near_lbl);
+  { Overflow In the scaling: test against the largest double }
+  WriteLn('    fcmp d4, d4');
+  Write('    b.vc L'); WriteLn(exact_lbl);
+  WriteLn('    movn x5, #0x8010, lsl #48');
+  WriteLn('    fmov d4, x5');
+  EmitLabel(exact_lbl);
+  WriteLn('    fmov d0, d4');
+  WriteLn('    ldur x0, [x29, #-8]');
+  WriteLn('    ldur x1, [x29, #-72]');
+  WriteLn('    ldur x2, [x29, #-40]');
+  WriteLn('    ldur x3, [x29, #-48]');
+  EmitBL(rt_real_exact);
+  WriteLn('    fmov d4, d0');
+  EmitLabel(near_lbl);
+  WriteLn('    fmov d0, d4');
+  WriteLn('    ldur x0, [x29, #-72]');
+
+  EmitLabel(sign_lbl);
+  WriteLn('    ldur x2, [x29, #-16]');
+  Write('    cbz x2, L'); WriteLn(done_lbl);
+  WriteLn('    fneg d0, d0');
+  EmitBranchLabel(done_lbl);
+  EmitLabel(none_lbl);
+  WriteLn('    ldur x0, [x29, #-8]');
+  WriteLn('    fmov d0, xzr');
+  EmitLabel(done_lbl);
+  WriteLn('    ldur x3, [x29, #-64]');
+  EmitAddSP(80);
+  EmitLdp;
+  EmitRet
+End;
+
+Procedure EmitNumCutRuntime;
+Var
+  yes_lbl, no_lbl, two_lbl: Integer;
+Begin
+  { Number cut - x0 = where a parse stopped, x1 = End Of the buffered }
+  { bytes. x4 = 1 If the number may go On In bytes Not Read yet: nothing }
+  { is left, Or only a '.', 'e', sign Or 'e' And sign. Leaf, clobbers x4-x6 }
+  yes_lbl := NewLabel;
+  no_lbl := NewLabel;
+  two_lbl := NewLabel;
+  EmitLabel(rt_num_cut);
+  WriteLn('    sub x5, x1, x0');
+  Write('    cbz x5, L'); WriteLn(yes_lbl);
+  WriteLn('    ldrb w6, [x0]');
+  WriteLn('    cmp x5, #2');
+  Write('    b.eq L'); WriteLn(two_lbl);
+  Write('    b.hi L'); WriteLn(no_lbl);
+  WriteLn('    cmp w6, #46');
+  Write('    b.eq L'); WriteLn(yes_lbl);
+  WriteLn('    cmp w6, #43');
+  Write('    b.eq L'); WriteLn(yes_lbl);
+  WriteLn('    cmp w6, #45');
+  Write('    b.eq L'); WriteLn(yes_lbl);
+  WriteLn('    orr w6, w6, #32');
+  WriteLn('    cmp w6, #101');
+  Write('    b.eq L'); WriteLn(yes_lbl);
+  EmitBranchLabel(no_lbl);
+  EmitLabel(two_lbl);
+  WriteLn('    orr w6, w6, #32');
+  WriteLn('    cmp w6, #101');
+  Write('    b.ne L'); WriteLn(no_lbl);
+  WriteLn('    ldrb w6, [x0, #1]');
+  WriteLn('    cmp w6, #43');
+  Write('    b.eq L'); WriteLn(yes_lbl);
+  WriteLn('    cmp w6, #45');
+  Write('    b.eq L'); WriteLn(yes_lbl);
+  EmitLabel(no_lbl);
+  WriteLn('    mov x4, #0');
+  EmitRet;
+  EmitLabel(yes_lbl);
+  WriteLn('    mov x4, #1');
+  EmitRet
+End;
+
+Procedure EmitFillMoreRuntime;
+Var
+  copy_lbl, read_lbl, none_lbl, done_lbl: Integer;
+Begin
+  { Fill more - x3 = input descriptor With unread bytes. Moves them To }
+  { the start Of the buffer And reads more after them, so a token that }
+  { straddles a refill can be parsed In one piece }
+  { Returns x0 = bytes added (0 at EOF, error Or full buffer) }
+  { Clobbers x0-x7 }
+  copy_lbl := NewLabel;
+  read_lbl := NewLabel;
+  none_lbl := NewLabel;
+  done_lbl := NewLabel;
+  EmitLabel(rt_fill_more);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(16);
+  WriteLn('    stur x3, [x29, #-8]');
+  WriteLn('    ldp x4, x5, [x3, #8]');
+  WriteLn('    ldr x6, [x3, #24]');
+  WriteLn('    sub x5, x5, x4');
+  WriteLn('    stp xzr, x5, [x3, #8]');
+  WriteLn('    add x4, x6, x4');
+  WriteLn('    mov x7, x6');
+  WriteLn('    add x2, x6, x5');
+  EmitLabel(copy_lbl);
+  WriteLn('    cmp x7, x2');
+  Write('    b.hs L'); WriteLn(read_lbl);
+  WriteLn('    ldrb w0, [x4], #1');
+  WriteLn('    strb w0, [x7], #1');
+  EmitBranchLabel(copy_lbl);
+  EmitLabel(read_lbl);
+  WriteLn('    ldr x2, [x3, #32]');
+  WriteLn('    subs x2, x2, x5');
+  Write('    b.eq L'); WriteLn(none_lbl);
+  EmitBL(rt_flush_output);
+  WriteLn('    ldur x3, [x29, #-8]');
+  WriteLn('    ldr x0, [x3]');
+  WriteLn('    ldr x1, [x3, #24]');
+  WriteLn('    ldr x5, [x3, #16]');
+  WriteLn('    add x1, x1, x5');
+  WriteLn('    ldr x2, [x3, #32]');
+  WriteLn('    sub x2, x2, x5');
+  EmitMovX16(33554435);  { 0x2000003 = Read }
+  EmitSvc;
+  Write('    b.cs L'); WriteLn(none_lbl);
+  WriteLn('    ldur x3, [x29, #-8]');
+  WriteLn('    ldr x5, [x3, #16]');
+  WriteLn('    add x5, x5, x0');
+  WriteLn('    str x5, [x3, #16]');
+  EmitIoAdvance(3, 0, 1, 2);
+  EmitBranchLabel(done_lbl);
+  EmitLabel(none_lbl);
+  EmitMovX0(0);
+  EmitLabel(done_lbl);
+  WriteLn('    ldur x3, [x29, #-8]');
+  EmitAddSP(16);
+  EmitLdp;
+  EmitRet
+End;
+
+Procedure EmitReadNumber(parse_rt: Integer);
+Var
+  skip_ws_lbl, ws_lbl, parse_lbl, finish_lbl, some_lbl, eof_lbl, done_lbl: Integer;
+Begin
+  { Body Of rt_read_int / rt_read_real: skip whitespace, Then run the }
+  { parse_rt core (x0 = first byte, x1 = End) straight On the buffered }
+  { input. If the number may go On past the buffered bytes, pull In more }
+  { (rt_fill_more) And parse again. The byte that ends the number stays }
+  { In the buffer; If there is no number one byte is skipped }
+  skip_ws_lbl := NewLabel;
+  ws_lbl := NewLabel;
+  parse_lbl := NewLabel;
+  finish_lbl := NewLabel;
+  some_lbl := NewLabel;
+  eof_lbl := NewLabel;
+  done_lbl := NewLabel;
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(16);
+  { [x29-8] = 1 once no more input can be added }
+  WriteLn('    stur xzr, [x29, #-8]');
+  EmitLabel(skip_ws_lbl);
+  EmitInputPeek(eof_lbl);
+  { Space (32), tab (9), newline (10) Or carriage return (13) }
+  WriteLn('    cmp x0, #32');
+  Write('    b.eq L'); WriteLn(ws_lbl);
+  WriteLn('    sub x2, x0, #9');
+  WriteLn('    cmp x2, #1');
+  Write('    b.ls L'); WriteLn(ws_lbl);
+  WriteLn('    cmp x0, #13');
+  Write('    b.ne L'); WriteLn(parse_lbl);
+  EmitLabel(ws_lbl);
+  EmitInputConsume;
+  EmitBranchLabel(skip_ws_lbl);
+
+  EmitLabel(parse_lbl);
+  WriteLn('    ldr x2, [x3, #24]');
+  WriteLn('    add x0, x2, x1');
+  WriteLn('    ldr x1, [x3, #16]');
+  WriteLn('    add x1, x2, x1');
+  EmitBL(parse_rt);
+  WriteLn('    ldur x4, [x29, #-8]');
+  Write('    cbnz x4, L'); WriteLn(finish_lbl);
+  { The parse may have used x1, so find the End again }
+  WriteLn('    ldr x4, [x28, #8]');
+  WriteLn('    ldr x5, [x4, #24]');
+  WriteLn('    ldr x1, [x4, #16]');
+  WriteLn('    add x1, x5, x1');
+  EmitBL(rt_num_cut);
+  Write('    cbz x4, L'); WriteLn(finish_lbl);
+  WriteLn('    ldr x3, [x28, #8]');
+  EmitBL(rt_fill_more);
+  WriteLn('    cmp x0, #0');
+  WriteLn('    cset x0, eq');
+  WriteLn('    stur x0, [x29, #-8]');
+  EmitInputPeek(eof_lbl);
+  EmitBranchLabel(parse_lbl);
+
+  { Leave the input just after the number }
+  EmitLabel(finish_lbl);
+  WriteLn('    ldr x4, [x28, #8]');
+  WriteLn('    ldr x5, [x4, #24]');
+  WriteLn('    sub x1, x0, x5');
+  Write('    cbnz x3, L'); WriteLn(some_lbl);
+  WriteLn('    add x1, x1, #1');
+  EmitLabel(some_lbl);
+  WriteLn('    str x1, [x4, #8]');
+  WriteLn('    mov x0, x2');
+  EmitBranchLabel(done_lbl);
+  EmitLabel(eof_lbl);
+  WriteLn('    mov x0, #0');
+  WriteLn('    fmov d0, xzr');
+  EmitLabel(done_lbl);
+  EmitAddSP(16);
+  EmitLdp;
+  EmitRet
+End;
+
+Procedure EmitReadIntRuntime;
+Begin
+  { Read Integer routine - reads from x19 (input fd), returns In x0 }
+  { Skips whitespace, Then an optional sign And digits (rt_parse_int) }
+  EmitLabel(rt_read_int);
+  EmitReadNumber(rt_parse_int)
+End;
+
+Procedure EmitReadRealRuntime;
+Begin
+  { Read Real from input, return In d0 }
+  { Skips whitespace, Then [sign] digits [. digits] [e [sign] digits] }
+  EmitLabel(rt_read_real);
+  EmitReadNumber(rt_parse_real)
+End;
+
+Procedure EmitSkipLineRuntime;
+Var
+  loop_lbl, done_lbl: Integer;
+Begin
+  { Skip To End Of line routine - consumes chars Up To And including newline }
+  EmitLabel(rt_skip_line);
+  EmitStp;
+  EmitMovFP;
+
+  loop_lbl := NewLabel;
+  done_lbl := NewLabel;
+
+  EmitLabel(loop_lbl);
+  EmitInputPeek(done_lbl);
+  EmitInputConsume;
+  { Check If newline (10) }
+  WriteLn('    cmp x0, #10');
+  Write('    b.ne L'); WriteLn(loop_lbl);
+
+  EmitLabel(done_lbl);
+  EmitLdp;
+  EmitRet
+End;
+
+Procedure EmitRealTablesRuntime;
+Var
+  i, p: Integer;
+Begin
+  { Powers Of ten For Real formatting, In the read-only __const section: }
+  { rt_pow10_dbl = 1e0 .. 1e22 (all exact doubles), rt_pow10_int = 10^0 .. 10^18 }
+  WriteLn('.section __TEXT,__const');
+  WriteLn('.p2align 3');
+  EmitLabel(rt_pow10_dbl);
+  For i := 0 To 22 Do
+  Begin
+    Write('    .double 1e'); WriteLn(i)
+  End;
+  EmitLabel(rt_pow10_int);
+  p := 1;
+  For i := 0 To 18 Do
+  Begin
+    Write('    .quad '); WriteLn(p);
+    p := p * 10
+  End;
+  WriteLn('.text')
+End;
+
+Procedure EmitRealScaleRuntime;
+Var
+  step_lbl, last_div_lbl, up_lbl, down_lbl, mul_lbl, div_lbl: Integer;
+Begin
+  { Real scale - (d0 + d3) * 10^x0 In double-double, result In d0 + d3 }
+  { Steps by exact powers Of ten (at most 1e22); each step keeps its }
+  { rounding error In d3, so the result is good To about 100 bits }
+  { Leaf, clobbers x0-x1, d0-d3, d5 }
+  step_lbl := NewLabel;
+  last_div_lbl := NewLabel;
+  up_lbl := NewLabel;
+  down_lbl := NewLabel;
+  mul_lbl := NewLabel;
+  div_lbl := NewLabel;
+  EmitLabel(rt_real_scale);
+  EmitPow10Addr(1, rt_pow10_dbl);
+  EmitLabel(step_lbl);
+  WriteLn('    cmp x0, #22');
+  Write('    b.gt L'); WriteLn(up_lbl);
+  WriteLn('    cmn x0, #22');
+  Write('    b.lt L'); WriteLn(down_lbl);
+  { Last step: 10^|x0| }
+  Write('    tbnz x0, #63, L'); WriteLn(last_div_lbl);
+  WriteLn('    ldr d1, [x1, x0, lsl #3]');
+  WriteLn('    mov x0, #0');
+  EmitBranchLabel(mul_lbl);
+  EmitLabel(last_div_lbl);
+  WriteLn('    neg x0, x0');
+  WriteLn('    ldr d1, [x1, x0, lsl #3]');
+  WriteLn('    mov x0, #0');
+  EmitBranchLabel(div_lbl);
+  EmitLabel(up_lbl);
+  WriteLn('    ldr d1, [x1, #176]');
+  WriteLn('    sub x0, x0, #22');
+  EmitBranchLabel(mul_lbl);
+  EmitLabel(down_lbl);
+  WriteLn('    ldr d1, [x1, #176]');
+  WriteLn('    add x0, x0, #22');
+  EmitBranchLabel(div_lbl);
+
+  { (d0 + d3) * d1: d5 = d0 * d1 - round(d0 * d1) exactly, plus d3 * d1 }
+  EmitLabel(mul_lbl);
+  WriteLn('    fmul d2, d0, d1');
+  WriteLn('    fnmsub d5, d0, d1, d2');
+  WriteLn('    fmadd d5, d3, d1, d5');
+  WriteLn('    fmov d0, d2');
+  WriteLn('    fmov d3, d5');
+  Write('    cbnz x0, L'); WriteLn(step_lbl);
+  EmitRet;
+  { (d0 + d3) / d1: the remainder d0 - q * d1 is exact }
+  EmitLabel(div_lbl);
+  WriteLn('    fdiv d2, d0, d1');
+  WriteLn('    fmsub d5, d2, d1, d0');
+  WriteLn('    fadd d5, d5, d3');
+  WriteLn('    fdiv d5, d5, d1');
+  WriteLn('    fmov d0, d2');
+  WriteLn('    fmov d3, d5');
+  Write('    cbnz x0, L'); WriteLn(step_lbl);
+  EmitRet
+End;
+
+Procedure EmitRealDigitsRuntime;
+Var
+  retry_lbl, inc_lbl, dec_lbl, even_lbl: Integer;
+Begin
+  { Real digits - d0 = x > 0 (finite). Returns x0 = D With exactly 17 }
+  { digits And x1 = q, so that x ~ D * 10^q, D correctly rounded; d0 = }
+  { x * 10^-q - D, the part rounded away }
+  { Clobbers x0-x7, d0-d7 }
+  retry_lbl := NewLabel;
+  inc_lbl := NewLabel;
+  dec_lbl := NewLabel;
+  even_lbl := NewLabel;
+  EmitLabel(rt_real_digits);
+  EmitStp;
+  EmitMovFP;
+  WriteLn('    fmov d7, d0');
+  { Estimate the decimal exponent: E = floor(e2 * log10(2)) }
+  WriteLn('    fmov x2, d0');
+  WriteLn('    lsr x2, x2, #52');
+  WriteLn('    sub x2, x2, #1023');
+  WriteLn('    mov x3, #13377');
+  WriteLn('    movk x3, #1, lsl #16');
+  WriteLn('    mul x2, x2, x3');
+  WriteLn('    asr x2, x2, #18');
+  { x6 = k = 16 - E: scale by 10^k To get 17 digits }
+  WriteLn('    mov x3, #16');
+  WriteLn('    sub x6, x3, x2');
+
+  EmitLabel(retry_lbl);
+  WriteLn('    fmov d0, d7');
+  WriteLn('    fmov d3, xzr');
+  WriteLn('    mov x0, x6');
+  EmitBL(rt_real_scale);
+  { D = round(d0 + d3) }
+  WriteLn('    fcvtzs x0, d0');
+  WriteLn('    fcvtas x5, d3');
+  WriteLn('    add x0, x0, x5');
+  WriteLn('    scvtf d1, x5');
+  WriteLn('    fsub d0, d3, d1');
+  { An exact tie rounds To even }
+  WriteLn('    fabs d2, d0');
+  WriteLn('    fmov d1, #0.5');
+  WriteLn('    fcmp d2, d1');
+  Write('    b.ne L'); WriteLn(even_lbl);
+  Write('    tbz x0, #0, L'); WriteLn(even_lbl);
+  WriteLn('    fneg d0, d0');
+  WriteLn('    fcmp d0, #0.0');
+  WriteLn('    mov x1, #1');
+  WriteLn('    cneg x1, x1, pl');
+  WriteLn('    add x0, x0, x1');
+  EmitLabel(even_lbl);
+
+  { The estimate may be one off: retry until 10^16 <= D < 10^17 }
+  EmitPow10Addr(2, rt_pow10_int);
+  WriteLn('    ldr x3, [x2, #128]');
+  WriteLn('    cmp x0, x3');
+  Write('    b.lo L'); WriteLn(inc_lbl);
+  WriteLn('    ldr x3, [x2, #136]');
+  WriteLn('    cmp x0, x3');
+  Write('    b.hs L'); WriteLn(dec_lbl);
+  WriteLn('    neg x1, x6');
+  EmitLdp;
+  EmitRet;
+  EmitLabel(inc_lbl);
+  WriteLn('    add x6, x6, #1');
+  EmitBranchLabel(retry_lbl);
+  EmitLabel(dec_lbl);
+  WriteLn('    sub x6, x6, #1');
+  EmitBranchLabel(retry_lbl)
+End;
+
+Procedure EmitRealShortestRuntime;
+Var
+  loop_lbl, hit_lbl, found_lbl, strip_lbl, count_lbl: Integer;
+  digit_lbl, done_lbl, order_lbl, swap_lbl, no_alt_lbl, alt_lbl: Integer;
+  try_lbl, next_lbl, unit_lbl: Integer;
+Begin
+  { Real shortest - d0 = x > 0 (finite). Returns the fewest digits that }
+  { Read back as exactly x: x0 = D (no trailing zeros), x1 = q, x2 = digit }
+  { count. Each candidate is converted back (rt_real_scale) And compared; }
+  { If p digits Read back, so do p + 1, so the count is binary searched }
+  { Clobbers x0-x7, d0-d7 }
+  loop_lbl := NewLabel;
+  hit_lbl := NewLabel;
+  found_lbl := NewLabel;
+  strip_lbl := NewLabel;
+  count_lbl := NewLabel;
+  digit_lbl := NewLabel;
+  done_lbl := NewLabel;
+  order_lbl := NewLabel;
+  swap_lbl := NewLabel;
+  no_alt_lbl := NewLabel;
+  alt_lbl := NewLabel;
+  try_lbl := NewLabel;
+  next_lbl := NewLabel;
+  unit_lbl := NewLabel;
+  EmitLabel(rt_real_shortest);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(112);
+  { [x29-8] = x (scaled), [x29-16] = D17, [x29-24] = q17, [x29-32] = lo, }
+  { [x29-48] = candidate And its exponent, [x29-56] = second candidate, }
+  { [x29-64] = what D17 rounded away, [x29-80] = hi, [x29-88] = p, }
+  { [x29-104] = best candidate so far }
+  WriteLn('    stur d0, [x29, #-8]');
+  EmitBL(rt_real_digits);
+  WriteLn('    stur x0, [x29, #-16]');
+  WriteLn('    stur x1, [x29, #-24]');
+  WriteLn('    stur d0, [x29, #-64]');
+  { For small normal x the check runs on x * 2^64, so the error terms }
+  { Of the scaling stay representable; [x29-72] = 1 Or 2^64 }
+  WriteLn('    ldur d0, [x29, #-8]');
+  WriteLn('    fmov x0, d0');
+  WriteLn('    movz x1, #0x3FF0, lsl #48');
+  WriteLn('    lsr x0, x0, #52');
+  WriteLn('    sub x0, x0, #1');
+  WriteLn('    cmp x0, #63');
+  Write('    b.hs L'); WriteLn(unit_lbl);
+  WriteLn('    movz x1, #0x43F0, lsl #48');
+  EmitLabel(unit_lbl);
+  WriteLn('    fmov d1, x1');
+  WriteLn('    fmul d0, d0, d1');
+  WriteLn('    stur d0, [x29, #-8]');
+  WriteLn('    stur d1, [x29, #-72]');
+  { 17 digits always identify x: search p In lo .. hi = 1 .. 17 }
+  WriteLn('    mov x2, #1');
+  WriteLn('    stur x2, [x29, #-32]');
+  WriteLn('    mov x2, #17');
+  WriteLn('    stur x2, [x29, #-80]');
+  WriteLn('    ldur x0, [x29, #-16]');
+  WriteLn('    ldur x1, [x29, #-24]');
+  WriteLn('    stp x0, x1, [x29, #-104]');
+
+  { Try p = (lo + hi) / 2 digits: Dp = D17 rounded To p digits }
+  EmitLabel(loop_lbl);
+  WriteLn('    ldur x2, [x29, #-32]');
+  WriteLn('    ldur x3, [x29, #-80]');
+  WriteLn('    cmp x2, x3');
+  Write('    b.ge L'); WriteLn(found_lbl);
+  WriteLn('    add x2, x2, x3');
+  WriteLn('    lsr x2, x2, #1');
+  WriteLn('    stur x2, [x29, #-88]');
+  WriteLn('    mov x3, #17');
+  WriteLn('    sub x3, x3, x2');
+  EmitPow10Addr(4, rt_pow10_int);
+  WriteLn('    ldr x5, [x4, x3, lsl #3]');
+  WriteLn('    lsr x6, x5, #1');
+  { x7 = D17 truncated, x4 = one above, x2 = the dropped part }
+  WriteLn('    ldur x0, [x29, #-16]');
+  WriteLn('    udiv x7, x0, x5');
+  WriteLn('    msub x2, x7, x5, x0');
+  WriteLn('    add x4, x7, #1');
+  { Try the nearer one first: on a tie In D17 the part it rounded away }
+  { decides, On an exact tie the even one }
+  WriteLn('    cmp x2, x6');
+  Write('    b.lo L'); WriteLn(order_lbl);
+  Write('    b.hi L'); WriteLn(swap_lbl);
+  WriteLn('    ldur d0, [x29, #-64]');
+  WriteLn('    fcmp d0, #0.0');
+  Write('    b.gt L'); WriteLn(swap_lbl);
+  Write('    b.mi L'); WriteLn(order_lbl);
+  Write('    tbz x7, #0, L'); WriteLn(order_lbl);
+  EmitLabel(swap_lbl);
+  WriteLn('    mov x0, x7');
+  WriteLn('    mov x7, x4');
+  WriteLn('    mov x4, x0');
+  EmitLabel(order_lbl);
+  { D17 is itself rounded: near the halfway point try the other too }
+  WriteLn('    sub x0, x2, x6');
+  WriteLn('    cmp x0, #1');
+  Write('    b.gt L'); WriteLn(no_alt_lbl);
+  WriteLn('    cmn x0, #1');
+  Write('    b.ge L'); WriteLn(alt_lbl);
+  EmitLabel(no_alt_lbl);
+  WriteLn('    movn x4, #0');
+  EmitLabel(alt_lbl);
+  WriteLn('    stur x4, [x29, #-56]');
+  WriteLn('    mov x0, x7');
+  WriteLn('    ldur x1, [x29, #-24]');
+  WriteLn('    add x1, x1, x3');
+  EmitLabel(try_lbl);
+  WriteLn('    stp x0, x1, [x29, #-48]');
+  { Does Dp * 10^qp convert back To x? Dp = d0 + d3 exactly }
+  WriteLn('    scvtf d0, x0');
+  WriteLn('    fcvtzs x6, d0');
+  WriteLn('    sub x6, x0, x6');
+  WriteLn('    scvtf d3, x6');
+  WriteLn('    ldur d1, [x29, #-72]');
+  WriteLn('    fmul d0, d0, d1');
+  WriteLn('    fmul d3, d3, d1');
+  WriteLn('    mov x0, x1');
+  EmitBL(rt_real_scale);
+  WriteLn('    fadd d0, d0, d3');
+  WriteLn('    ldur d1, [x29, #-8]');
+  WriteLn('    fcmp d0, d1');
+  Write('    b.eq L'); WriteLn(hit_lbl);
+  WriteLn('    ldur x0, [x29, #-56]');
+  Write('    tbnz x0, #63, L'); WriteLn(next_lbl);
+  WriteLn('    movn x2, #0');
+  WriteLn('    stur x2, [x29, #-56]');
+  WriteLn('    ldur x1, [x29, #-40]');
+  EmitBranchLabel(try_lbl);
+  { Too few digits: lo = p + 1 }
+  EmitLabel(next_lbl);
+  WriteLn('    ldur x2, [x29, #-88]');
+  WriteLn('    add x2, x2, #1');
+  WriteLn('    stur x2, [x29, #-32]');
+  EmitBranchLabel(loop_lbl);
+  { Reads back: keep it, hi = p }
+  EmitLabel(hit_lbl);
+  WriteLn('    ldp x0, x1, [x29, #-48]');
+  WriteLn('    stp x0, x1, [x29, #-104]');
+  WriteLn('    ldur x2, [x29, #-88]');
+  WriteLn('    stur x2, [x29, #-80]');
+  EmitBranchLabel(loop_lbl);
+
+  { Drop trailing zeros }
+  EmitLabel(found_lbl);
+  WriteLn('    ldp x0, x1, [x29, #-104]');
+  WriteLn('    mov x5, #10');
+  EmitLabel(strip_lbl);
+  WriteLn('    udiv x3, x0, x5');
+  WriteLn('    msub x4, x3, x5, x0');
+  Write('    cbnz x4, L'); WriteLn(count_lbl);
+  WriteLn('    mov x0, x3');
+  WriteLn('    add x1, x1, #1');
+  EmitBranchLabel(strip_lbl);
+
+  { x2 = number Of digits In D }
+  EmitLabel(count_lbl);
+  EmitPow10Addr(4, rt_pow10_int);
+  WriteLn('    mov x2, #1');
+  EmitLabel(digit_lbl);
+  WriteLn('    ldr x3, [x4, x2, lsl #3]');
+  WriteLn('    cmp x0, x3');
+  Write('    b.lo L'); WriteLn(done_lbl);
+  WriteLn('    add x2, x2, #1');
+  EmitBranchLabel(digit_lbl);
+  EmitLabel(done_lbl);
+  EmitAddSP(112);
+  EmitLdp;
+  EmitRet
+End;
+
+Procedure EmitRealFixedRuntime;
+Var
+  sub_lbl, p5_lbl, pw_lbl, ml_lbl, mt_lbl, p5_done_lbl: Integer;
+  right_lbl, sl_lbl, sl0_lbl, sz_lbl, sfin_lbl, stop_lbl: Integer;
+  carry_lbl, cdone_lbl, sr_lbl, sr0_lbl, trim_lbl, zero_lbl: Integer;
+  div_lbl, dl_lbl, dr_lbl, keep_lbl, de_lbl, strip_lbl, zl_lbl, fin_lbl: Integer;
+Begin
+  { Real fixed - d0 = x >= 0 (finite), x0 = d (0 To 40), x1 = End Of a }
+  { 400-byte buffer. Writes the digits Of N = x * 10^d rounded half up, }
+  { from the exact binary value, backwards from x1 }
+  { Returns x1 = first digit, x2 = count. x = m * 2^e, so N comes from }
+  { the big Integer m * 5^d shifted by e + d; it stays below 2^1157 }
+  { Leaf, clobbers x0-x8, x10-x15 }
+  sub_lbl := NewLabel;
+  p5_lbl := NewLabel;
+  pw_lbl := NewLabel;
+  ml_lbl := NewLabel;
+  mt_lbl := NewLabel;
+  p5_done_lbl := NewLabel;
+  right_lbl := NewLabel;
+  sl_lbl := NewLabel;
+  sl0_lbl := NewLabel;
+  sz_lbl := NewLabel;
+  sfin_lbl := NewLabel;
+  stop_lbl := NewLabel;
+  carry_lbl := NewLabel;
+  cdone_lbl := NewLabel;
+  sr_lbl := NewLabel;
+  sr0_lbl := NewLabel;
+  trim_lbl := NewLabel;
+  zero_lbl := NewLabel;
+  div_lbl := NewLabel;
+  dl_lbl := NewLabel;
+  dr_lbl := NewLabel;
+  keep_lbl := NewLabel;
+  de_lbl := NewLabel;
+  strip_lbl := NewLabel;
+  zl_lbl := NewLabel;
+  fin_lbl := NewLabel;
+  EmitLabel(rt_real_fixed);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(208);
+  { [sp] = limb count, little-endian 64-bit limbs from [sp, #8] }
+  WriteLn('    mov x10, x1');
+  WriteLn('    fmov x4, d0');
+  WriteLn('    and x5, x4, #0xFFFFFFFFFFFFF');
+  WriteLn('    lsr x6, x4, #52');
+  WriteLn('    mov x7, #-1074');
+  Write('    cbz x6, L'); WriteLn(sub_lbl);
+  WriteLn('    orr x5, x5, #0x10000000000000');
+  WriteLn('    mov x7, #1075');
+  WriteLn('    sub x7, x6, x7');
+  EmitLabel(sub_lbl);
+  WriteLn('    mov x2, #1');
+  WriteLn('    stp x2, x5, [sp]');
+  { x13 = s = e + d, x12 = powers Of 5 still To multiply in }
+  WriteLn('    add x13, x7, x0');
+  WriteLn('    mov x12, x0');
+
+  { Times 5^d, at most 5^27 per pass }
+  EmitLabel(p5_lbl);
+  Write('    cbz x12, L'); WriteLn(p5_done_lbl);
+  WriteLn('    mov x14, #27');
+  WriteLn('    cmp x12, x14');
+  WriteLn('    csel x14, x12, x14, lo');
+  WriteLn('    sub x12, x12, x14');
+  WriteLn('    mov x1, #1');
+  WriteLn('    mov x15, #5');
+  EmitLabel(pw_lbl);
+  WriteLn('    mul x1, x1, x15');
+  WriteLn('    subs x14, x14, #1');
+  Write('    b.ne L'); WriteLn(pw_lbl);
+  WriteLn('    ldr x3, [sp]');
+  WriteLn('    add x4, sp, #8');
+  WriteLn('    mov x5, #0');
+  WriteLn('    mov x2, #0');
+  EmitLabel(ml_lbl);
+  WriteLn('    cmp x5, x3');
+  Write('    b.hs L'); WriteLn(mt_lbl);
+  WriteLn('    ldr x6, [x4, x5, lsl #3]');
+  WriteLn('    mul x7, x6, x1');
+  WriteLn('    umulh x6, x6, x1');
+  WriteLn('    adds x7, x7, x2');
+  WriteLn('    adc x2, x6, xzr');
+  WriteLn('    str x7, [x4, x5, lsl #3]');
+  WriteLn('    add x5, x5, #1');
+  EmitBranchLabel(ml_lbl);
+  EmitLabel(mt_lbl);
+  Write('    cbz x2, L'); WriteLn(p5_lbl);
+  WriteLn('    str x2, [x4, x3, lsl #3]');
+  WriteLn('    add x3, x3, #1');
+  WriteLn('    str x3, [sp]');
+  EmitBranchLabel(p5_lbl);
+  EmitLabel(p5_done_lbl);
+  WriteLn('    ldr x3, [sp]');
+  WriteLn('    add x4, sp, #8');
+  Write('    tbnz x13, #63, L'); WriteLn(right_lbl);
+
+  { s >= 0: shift left by s, x14 = whole limbs, x15 = bits; two shifts }
+  { right so that 0 bits gives 0 }
+  WriteLn('    lsr x14, x13, #6');
+  WriteLn('    and x15, x13, #63');
+  WriteLn('    mov x8, #63');
+  WriteLn('    sub x8, x8, x15');
+  WriteLn('    sub x2, x3, #1');
+  WriteLn('    ldr x7, [x4, x2, lsl #3]');
+  WriteLn('    lsr x7, x7, #1');
+  WriteLn('    lsr x7, x7, x8');
+  EmitLabel(sl_lbl);
+  WriteLn('    ldr x5, [x4, x2, lsl #3]');
+  WriteLn('    lsl x5, x5, x15');
+  WriteLn('    mov x6, #0');
+  Write('    cbz x2, L'); WriteLn(sl0_lbl);
+  WriteLn('    sub x6, x2, #1');
+  WriteLn('    ldr x6, [x4, x6, lsl #3]');
+  WriteLn('    lsr x6, x6, #1');
+  WriteLn('    lsr x6, x6, x8');
+  EmitLabel(sl0_lbl);
+  WriteLn('    orr x5, x5, x6');
+  WriteLn('    add x6, x2, x14');
+  WriteLn('    str x5, [x4, x6, lsl #3]');
+  Write('    cbz x2, L'); WriteLn(sz_lbl);
+  WriteLn('    sub x2, x2, #1');
+  EmitBranchLabel(sl_lbl);
+  EmitLabel(sz_lbl);
+  WriteLn('    cmp x2, x14');
+  Write('    b.hs L'); WriteLn(sfin_lbl);
+  WriteLn('    str xzr, [x4, x2, lsl #3]');
+  WriteLn('    add x2, x2, #1');
+  EmitBranchLabel(sz_lbl);
+  EmitLabel(sfin_lbl);
+  WriteLn('    add x3, x3, x14');
+  Write('    cbz x7, L'); WriteLn(stop_lbl);
+  WriteLn('    str x7, [x4, x3, lsl #3]');
+  WriteLn('    add x3, x3, #1');
+  EmitLabel(stop_lbl);
+  WriteLn('    str x3, [sp]');
+  EmitBranchLabel(div_lbl);
+
+  { s < 0: N = (B + 2^(t-1)) >> t With t = -s. When the half bit lies }
+  { above every limb, B + 2^(t-1) < 2^t And N = 0 }
+  EmitLabel(right_lbl);
+  WriteLn('    neg x13, x13');
+  WriteLn('    sub x0, x13, #1');
+  WriteLn('    lsr x5, x0, #6');
+  WriteLn('    cmp x5, x3');
+  Write('    b.hs L'); WriteLn(zero_lbl);
+  WriteLn('    str xzr, [x4, x3, lsl #3]');
+  WriteLn('    mov x1, #1');
+  WriteLn('    lsl x1, x1, x0');
+  EmitLabel(carry_lbl);
+  WriteLn('    ldr x6, [x4, x5, lsl #3]');
+  WriteLn('    adds x6, x6, x1');
+  WriteLn('    str x6, [x4, x5, lsl #3]');
+  Write('    b.cc L'); WriteLn(cdone_lbl);
+  WriteLn('    mov x1, #1');
+  WriteLn('    add x5, x5, #1');
+  EmitBranchLabel(carry_lbl);
+  EmitLabel(cdone_lbl);
+  WriteLn('    cmp x5, x3');
+  WriteLn('    cinc x3, x3, eq');
+  WriteLn('    str xzr, [x4, x3, lsl #3]');
+  { x14 = whole limbs, x15 = bits; the limb above is shifted In two }
+  { steps so that 0 bits gives 0 }
+  WriteLn('    lsr x14, x13, #6');
+  WriteLn('    and x15, x13, #63');
+  WriteLn('    mov x8, #63');
+  WriteLn('    sub x8, x8, x15');
+  WriteLn('    cmp x14, x3');
+  Write('    b.hs L'); WriteLn(zero_lbl);
+  WriteLn('    sub x3, x3, x14');
+  WriteLn('    mov x2, #0');
+  EmitLabel(sr_lbl);
+  WriteLn('    cmp x2, x3');
+  Write('    b.hs L'); WriteLn(trim_lbl);
+  WriteLn('    add x6, x2, x14');
+  WriteLn('    ldr x5, [x4, x6, lsl #3]');
+  WriteLn('    lsr x5, x5, x15');
+  WriteLn('    add x6, x6, #1');
+  WriteLn('    ldr x6, [x4, x6, lsl #3]');
+  WriteLn('    lsl x6, x6, #1');
+  WriteLn('    lsl x6, x6, x8');
+  WriteLn('    orr x5, x5, x6');
+  WriteLn('    str x5, [x4, x2, lsl #3]');
+  WriteLn('    add x2, x2, #1');
+  EmitBranchLabel(sr_lbl);
+  { Drop zero limbs from the top }
+  EmitLabel(trim_lbl);
+  Write('    cbz x3, L'); WriteLn(zero_lbl);
+  WriteLn('    sub x2, x3, #1');
+  WriteLn('    ldr x5, [x4, x2, lsl #3]');
+  Write('    cbnz x5, L'); WriteLn(sr0_lbl);
+  WriteLn('    mov x3, x2');
+  EmitBranchLabel(trim_lbl);
+  EmitLabel(zero_lbl);
+  WriteLn('    mov x3, #0');
+  EmitLabel(sr0_lbl);
+  WriteLn('    str x3, [sp]');
+
+  { Nine digits per division by 10^9, done on 32-bit halves so that }
+  { each dividend fits In 64 bits }
+  EmitLabel(div_lbl);
+  WriteLn('    mov x11, x10');
+  WriteLn('    movz x15, #0xCA00');
+  WriteLn('    movk x15, #0x3B9A, lsl #16');
+  WriteLn('    mov x12, #10');
+  EmitLabel(dl_lbl);
+  WriteLn('    ldr x3, [sp]');
+  Write('    cbz x3, L'); WriteLn(strip_lbl);
+  WriteLn('    mov x2, #0');
+  WriteLn('    mov x5, x3');
+  EmitLabel(dr_lbl);
+  WriteLn('    sub x5, x5, #1');
+  WriteLn('    ldr x6, [x4, x5, lsl #3]');
+  WriteLn('    lsr x7, x6, #32');
+  WriteLn('    orr x2, x7, x2, lsl #32');
+  WriteLn('    udiv x8, x2, x15');
+  WriteLn('    msub x2, x8, x15, x2');
+  WriteLn('    and x7, x6, #0xFFFFFFFF');
+  WriteLn('    orr x2, x7, x2, lsl #32');
+  WriteLn('    udiv x6, x2, x15');
+  WriteLn('    msub x2, x6, x15, x2');
+  WriteLn('    orr x6, x6, x8, lsl #32');
+  WriteLn('    str x6, [x4, x5, lsl #3]');
+  Write('    cbnz x5, L'); WriteLn(dr_lbl);
+  { Dividing by 10^9 can empty the top limb }
+  WriteLn('    sub x5, x3, #1');
+  WriteLn('    ldr x6, [x4, x5, lsl #3]');
+  Write('    cbnz x6, L'); WriteLn(keep_lbl);
+  WriteLn('    str x5, [sp]');
+  EmitLabel(keep_lbl);
+  WriteLn('    mov x5, #9');
+  EmitLabel(de_lbl);
+  WriteLn('    udiv x6, x2, x12');
+  WriteLn('    msub x7, x6, x12, x2');
+  WriteLn('    add w7, w7, #48');
+  WriteLn('    strb w7, [x11, #-1]!');
+  WriteLn('    mov x2, x6');
+  WriteLn('    subs x5, x5, #1');
+  Write('    b.ne L'); WriteLn(de_lbl);
+  EmitBranchLabel(dl_lbl);
+
+  { Leading zeros go, but N = 0 still prints one digit }
+  EmitLabel(strip_lbl);
+  WriteLn('    cmp x11, x10');
+  Write('    b.ne L'); WriteLn(zl_lbl);
+  WriteLn('    mov w7, #48');
+  WriteLn('    strb w7, [x11, #-1]!');
+  EmitLabel(zl_lbl);
+  WriteLn('    sub x2, x10, #1');
+  WriteLn('    cmp x11, x2');
+  Write('    b.hs L'); WriteLn(fin_lbl);
+  WriteLn('    ldrb w7, [x11]');
+  WriteLn('    cmp w7, #48');
+  Write('    b.ne L'); WriteLn(fin_lbl);
+  WriteLn('    add x11, x11, #1');
+  EmitBranchLabel(zl_lbl);
+  EmitLabel(fin_lbl);
+  WriteLn('    mov x1, x11');
+  WriteLn('    sub x2, x10, x11');
+  EmitAddSP(208);
+  EmitLdp;
+  EmitRet
+End;
+
+Procedure EmitPutChar(c: Integer);
+Begin
+  { Store one Char at the rt_print_real cursor x7 }
+  Write('    mov w2, #'); WriteLn(c);
+  WriteLn('    strb w2, [x7], #1')
+End;
+
+Procedure EmitPrintRealRuntime;
+Var
+  copy_lbl, copy_store_lbl: Integer;
+  nan_lbl, inf_lbl, pos_lbl, fixed_lbl, zero_lbl, sci_lbl: Integer;
+  int_lbl, frac_lbl, frac_pad_lbl, out_lbl, copy_done_lbl: Integer;
+  mid_lbl, small_lbl, sci_one_lbl, exp_pos_lbl, exp_lbl, exp2_lbl: Integer;
+  dec_ok_lbl: Integer;
+Begin
+  { Print Real In d0 }
+  { x0 = field width (0 = none), x1 = decimals: x1 < 0 prints the shortest }
+  { digits that Read back as the same value (fixed notation For 1e-5 <= }
+  { |x| < 1e16, otherwise d.dddE+nn); x1 >= 0 prints fixed With x1 decimals, }
+  { rounded half up from the exact value }
+  { The text is built In the frame And written With one rt_write_buf }
+  copy_lbl := NewLabel;
+  copy_store_lbl := NewLabel;
+  nan_lbl := NewLabel;
+  inf_lbl := NewLabel;
+  pos_lbl := NewLabel;
+  fixed_lbl := NewLabel;
+  zero_lbl := NewLabel;
+  sci_lbl := NewLabel;
+  int_lbl := NewLabel;
+  frac_lbl := NewLabel;
+  frac_pad_lbl := NewLabel;
+  out_lbl := NewLabel;
+  copy_done_lbl := NewLabel;
+  mid_lbl := NewLabel;
+  small_lbl := NewLabel;
+  sci_one_lbl := NewLabel;
+  exp_pos_lbl := NewLabel;
+  exp_lbl := NewLabel;
+  exp2_lbl := NewLabel;
+  dec_ok_lbl := NewLabel;
+
+  EmitLabel(rt_print_real);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(880);
+  { [x29-8] = width, [x29-16] = decimals, [x29-24] = x, [x29-32] = cursor, }
+  { [x29-40] = D, [x29-48] = q; digits are formatted below x29-56, Or }
+  { For x:w:d below sp + 784; the text is built from sp (384 bytes) }
+  WriteLn('    stur x0, [x29, #-8]');
+  WriteLn('    stur x1, [x29, #-16]');
+  WriteLn('    mov x7, sp');
+
+  { NaN And infinities }
+  WriteLn('    fcmp d0, d0');
+  Write('    b.vs L'); WriteLn(nan_lbl);
+  WriteLn('    fcmp d0, #0.0');
+  Write('    b.ge L'); WriteLn(pos_lbl);
+  EmitPutChar(45);  { '-' }
+  WriteLn('    fneg d0, d0');
+  EmitLabel(pos_lbl);
+  WriteLn('    stur d0, [x29, #-24]');
+  WriteLn('    fmov x2, d0');
+  WriteLn('    lsr x2, x2, #52');
+  WriteLn('    cmp x2, #2047');
+  Write('    b.eq L'); WriteLn(inf_lbl);
+  WriteLn('    stur x7, [x29, #-32]');
+  WriteLn('    ldur x1, [x29, #-16]');
+  Write('    tbz x1, #63, L'); WriteLn(fixed_lbl);
+
+  { ----- Shortest round-trip ----- }
+  WriteLn('    fcmp d0, #0.0');
+  Write('    b.eq L'); WriteLn(zero_lbl);
+  EmitBL(rt_real_shortest);
+  WriteLn('    stur x1, [x29, #-48]');
+  WriteLn('    sub x1, x29, #56');
+  EmitBL(rt_fmt_int);
+  { x6 = digits, x5 = n, x4 = q, x3 = E = n - 1 + q }
+  WriteLn('    mov x6, x1');
+  WriteLn('    mov x5, x2');
+  WriteLn('    ldur x4, [x29, #-48]');
+  WriteLn('    add x3, x5, x4');
+  WriteLn('    sub x3, x3, #1');
+  WriteLn('    ldur x7, [x29, #-32]');
+  WriteLn('    cmn x3, #5');
+  Write('    b.lt L'); WriteLn(sci_lbl);
+  WriteLn('    cmp x3, #16');
+  Write('    b.ge L'); WriteLn(sci_lbl);
+  Write('    tbnz x4, #63, L'); WriteLn(mid_lbl);
+  { Integral: digits, q zeros, '.0' }
+  WriteLn('    mov x0, #0');
+  WriteLn('    add x1, x5, x4');
+  Write('    bl L'); WriteLn(copy_lbl);
+  EmitPutChar(46);
+  EmitPutChar(48);
+  EmitBranchLabel(out_lbl);
+  { d.ddd With the point inside the digits }
+  EmitLabel(mid_lbl);
+  Write('    tbnz x3, #63, L'); WriteLn(small_lbl);
+  WriteLn('    mov x0, #0');
+  WriteLn('    add x1, x3, #1');
+  WriteLn('    stur x1, [x29, #-40]');
+  Write('    bl L'); WriteLn(copy_lbl);
+  EmitPutChar(46);
+  WriteLn('    ldur x0, [x29, #-40]');
+  WriteLn('    mov x1, x5');
+  Write('    bl L'); WriteLn(copy_lbl);
+  EmitBranchLabel(out_lbl);
+  { 0.000ddd }
+  EmitLabel(small_lbl);
+  EmitPutChar(48);
+  EmitPutChar(46);
+  { -E-1 zeros: copy positions n .. n-E-1 (all past the digits) }
+  WriteLn('    mov x0, x5');
+  WriteLn('    sub x1, x5, x3');
+  WriteLn('    sub x1, x1, #1');
+  Write('    bl L'); WriteLn(copy_lbl);
+  WriteLn('    mov x0, #0');
+  WriteLn('    mov x1, x5');
+  Write('    bl L'); WriteLn(copy_lbl);
+  EmitBranchLabel(out_lbl);
+  { d.dddE+nn }
+  EmitLabel(sci_lbl);
+  WriteLn('    ldrb w2, [x6]');
+  WriteLn('    strb w2, [x7], #1');
+  EmitPutChar(46);
+  WriteLn('    cmp x5, #1');
+  Write('    b.eq L'); WriteLn(sci_one_lbl);
+  WriteLn('    mov x0, #1');
+  WriteLn('    mov x1, x5');
+  Write('    bl L'); WriteLn(copy_lbl);
+  Write('    b L'); WriteLn(exp_lbl);
+  EmitLabel(sci_one_lbl);
+  EmitPutChar(48);
+  EmitLabel(exp_lbl);
+  EmitPutChar(69);  { 'E' }
+  EmitPutChar(43);  { '+' }
+  Write('    tbz x3, #63, L'); WriteLn(exp_pos_lbl);
+  WriteLn('    mov w2, #45');
+  WriteLn('    sturb w2, [x7, #-1]');
+  WriteLn('    neg x3, x3');
+  EmitLabel(exp_pos_lbl);
+  { At least two exponent digits }
+  WriteLn('    mov x4, #10');
+  WriteLn('    cmp x3, #100');
+  Write('    b.lo L'); WriteLn(exp2_lbl);
+  WriteLn('    mov x0, #100');
+  WriteLn('    udiv x1, x3, x0');
+  WriteLn('    msub x3, x1, x0, x3');
+  WriteLn('    add w2, w1, #48');
+  WriteLn('    strb w2, [x7], #1');
+  EmitLabel(exp2_lbl);
+  WriteLn('    udiv x1, x3, x4');
+  WriteLn('    msub x3, x1, x4, x3');
+  WriteLn('    add w2, w1, #48');
+  WriteLn('    strb w2, [x7], #1');
+  WriteLn('    add w2, w3, #48');
+  WriteLn('    strb w2, [x7], #1');
+  EmitBranchLabel(out_lbl);
+
+  { Zero }
+  EmitLabel(zero_lbl);
+  EmitPutChar(48);
+  EmitPutChar(46);
+  EmitPutChar(48);
+  EmitBranchLabel(out_lbl);
+
+  { ----- Fixed, x1 decimals (at most 40) ----- }
+  { Digits Of the exact value times 10^decimals, so q = -decimals }
+  EmitLabel(fixed_lbl);
+  WriteLn('    cmp x1, #40');
+  Write('    b.le L'); WriteLn(dec_ok_lbl);
+  WriteLn('    mov x1, #40');
+  WriteLn('    stur x1, [x29, #-16]');
+  EmitLabel(dec_ok_lbl);
+  WriteLn('    neg x0, x1');
+  WriteLn('    stur x0, [x29, #-48]');
+  WriteLn('    mov x0, x1');
+  WriteLn('    add x1, sp, #784');
+  EmitBL(rt_real_fixed);
+  { x6 = digits, x5 = n, x4 = L = n + q + decimals, x3 = decimals }
+  WriteLn('    mov x6, x1');
+  WriteLn('    mov x5, x2');
+  WriteLn('    ldur x3, [x29, #-16]');
+  WriteLn('    ldur x4, [x29, #-48]');
+  WriteLn('    add x4, x4, x5');
+  WriteLn('    add x4, x4, x3');
+  WriteLn('    ldur x7, [x29, #-32]');
+  { Integer part: first L - decimals chars, Or '0' }
+  WriteLn('    subs x1, x4, x3');
+  Write('    b.gt L'); WriteLn(int_lbl);
+  EmitPutChar(48);
+  EmitBranchLabel(frac_lbl);
+  EmitLabel(int_lbl);
+  WriteLn('    mov x0, #0');
+  Write('    bl L'); WriteLn(copy_lbl);
+  EmitLabel(frac_lbl);
+  Write('    cbz x3, L'); WriteLn(out_lbl);
+  EmitPutChar(46);
+  { Fraction: pad With zeros when L < decimals, Then the last chars }
+  WriteLn('    subs x2, x3, x4');
+  Write('    b.le L'); WriteLn(frac_pad_lbl);
+  WriteLn('    mov x0, x5');
+  WriteLn('    add x1, x5, x2');
+  Write('    bl L'); WriteLn(copy_lbl);
+  WriteLn('    mov x3, x4');
+  EmitLabel(frac_pad_lbl);
+  WriteLn('    sub x0, x4, x3');
+  WriteLn('    mov x1, x4');
+  Write('    bl L'); WriteLn(copy_lbl);
+  EmitBranchLabel(out_lbl);
+
+  EmitLabel(nan_lbl);
+  EmitPutChar(78);
+  EmitPutChar(97);
+  EmitPutChar(78);
+  EmitBranchLabel(out_lbl);
+  EmitLabel(inf_lbl);
+  EmitPutChar(73);
+  EmitPutChar(110);
+  EmitPutChar(102);
+
+  { Pad To the field width, Then Write the text }
+  EmitLabel(out_lbl);
+  WriteLn('    mov x1, sp');
+  WriteLn('    sub x2, x7, x1');
+  WriteLn('    stur x2, [x29, #-40]');
+  WriteLn('    ldur x0, [x29, #-8]');
+  WriteLn('    sub x0, x0, x2');
+  EmitBL(rt_write_spaces);
+  WriteLn('    mov x1, sp');
+  WriteLn('    ldur x2, [x29, #-40]');
+  EmitBL(rt_write_buf);
+  EmitAddSP(880);
+  EmitLdp;
+  EmitRet;
+
+  { Copy positions x0 .. x1-1 Of the digit String (x6, x5 digits, }
+  { followed by zeros) To the cursor x7 }
+  EmitLabel(copy_lbl);
+  WriteLn('    cmp x0, x1');
+  Write('    b.ge L'); WriteLn(copy_done_lbl);
+  WriteLn('    mov w2, #48');
+  WriteLn('    cmp x0, x5');
+  Write('    b.ge L'); WriteLn(copy_store_lbl);
+  WriteLn('    ldrb w2, [x6, x0]');
+  EmitLabel(copy_store_lbl);
+  WriteLn('    strb w2, [x7], #1');
+  WriteLn('    add x0, x0, #1');
+  EmitBranchLabel(copy_lbl);
+  EmitLabel(copy_done_lbl);
+  EmitRet
+End;
+
+Procedure EmitWriteSpacesRuntime;
+Var
+  loop_lbl, done_lbl: Integer;
+Begin
+  { Write spaces - x0 = count (nothing If <= 0). Used For field widths }
+  { Clobbers x0-x3 }
+  loop_lbl := NewLabel;
+  done_lbl := NewLabel;
+  EmitLabel(rt_write_spaces);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(16);
+  EmitLabel(loop_lbl);
+  WriteLn('    cmp x0, #0');
+  Write('    b.le L'); WriteLn(done_lbl);
+  WriteLn('    sub x0, x0, #1');
+  WriteLn('    stur x0, [x29, #-8]');
+  EmitMovX0(32);
+  EmitBL(rt_print_char);
+  WriteLn('    ldur x0, [x29, #-8]');
+  EmitBranchLabel(loop_lbl);
+  EmitLabel(done_lbl);
+  EmitAddSP(16);
+  EmitLdp;
+  EmitRet
+End;
+
+Procedure EmitPrintIntWidthRuntime;
+Begin
+  { Print Integer x0 right-aligned In a field Of x1 characters }
+  EmitLabel(rt_print_int_w);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(48);
+  WriteLn('    stur x1, [x29, #-8]');
+  WriteLn('    sub x1, x29, #8');
+  EmitBL(rt_fmt_int);
+  WriteLn('    stp x1, x2, [x29, #-48]');
+  WriteLn('    ldur x0, [x29, #-8]');
+  WriteLn('    sub x0, x0, x2');
+  EmitBL(rt_write_spaces);
+  WriteLn('    ldp x1, x2, [x29, #-48]');
+  EmitBL(rt_write_buf);
+  EmitAddSP(48);
+  EmitLdp;
+  EmitRet
+End;
+
+Procedure EmitReadStringRuntime;
+Var
+  loop_lbl, done_lbl, cr_lbl: Integer;
+Begin
+  { Read String from input (x19), String buffer address passed In x0 }
+  { String format: byte 0 = Length, bytes 1-255 = characters }
+  { Reads Until newline (LF, CR Or CR LF, consumed) Or max 255 chars }
+  EmitLabel(rt_read_string);
+  EmitStp;
+  EmitMovFP;
+
+  { x10 = String buffer address, x11 = character count }
+  WriteLn('    mov x10, x0');
+  WriteLn('    mov x11, #0');
+
+  { Read loop }
+  loop_lbl := NewLabel;
+  done_lbl := NewLabel;
+  cr_lbl := NewLabel;
+  EmitLabel(loop_lbl);
+
+  { Check If count >= 255 }
+  WriteLn('    cmp x11, #255');
+  Write('    b.ge L'); WriteLn(done_lbl);
+
+  EmitInputPeek(done_lbl);
+  EmitInputConsume;
+
+  { Check If newline (10) Or carriage return (13) }
+  WriteLn('    cmp x0, #10');
+  Write('    b.eq L'); WriteLn(done_lbl);
+  WriteLn('    cmp x0, #13');
+  Write('    b.eq L'); WriteLn(cr_lbl);
+
+  { Store character at buffer[count+1], count := count + 1 }
+  WriteLn('    add x11, x11, #1');
+  WriteLn('    strb w0, [x10, x11]');
+  EmitBranchLabel(loop_lbl);
+
+  { CR: also swallow a following LF }
+  EmitLabel(cr_lbl);
+  EmitInputPeek(done_lbl);
+  WriteLn('    cmp x0, #10');
+  Write('    b.ne L'); WriteLn(done_lbl);
+  EmitInputConsume;
+
+  { Done - store Length at buffer[0] }
+  EmitLabel(done_lbl);
+  WriteLn('    strb w11, [x10]');
+
+  EmitLdp;
+  EmitRet
+End;
+
+Procedure EmitIoDescInit(desc, fd, buf_pages, size: Integer);
+Begin
+  { Set up a built-in descriptor at x28 + desc whose buffer starts }
+  { buf_pages * 4096 bytes into the state block }
+  Write('    add x1, x28, #'); WriteLn(desc);
+  EmitMovX0(fd);
+  WriteLn('    str x0, [x1]');
+  Write('    add x0, x28, #'); Write(buf_pages); WriteLn(', lsl #12');
+  WriteLn('    str x0, [x1, #24]');
+  WriteLn('    str x0, [x1, #40]');
+  Write('    mov x2, #'); WriteLn(size);
+  WriteLn('    str x2, [x1, #32]');
+  WriteLn('    add x0, x0, x2');
+  WriteLn('    str x0, [x1, #48]')
+End;
+
+Procedure EmitFileOpenInit;
+Var
+  skip_input_lbl, skip_output_lbl: Integer;
+Begin
+  { Initialize x19 (input fd) And x20 (output fd) from command line }
+  { On entry: x0 = argc, x1 = argv }
+  { Usage: tpcv2 input.pas output.s }
+  skip_input_lbl := NewLabel;
   skip_output_lbl := NewLabel;
 
   { Save argc And argv To callee-saved registers }
   WriteLn('    mov x21, x0');
   WriteLn('    mov x22, x1');
 
-  { Default: x19 = 0 (stdin), x20 = 1 (stdout), x18 = -1 (no pushback) }
+  { Map the I/O state block, x28 points To it For the whole run: }
+  {   [x28]         current output descriptor }
+  {   [x28, #8]     current input descriptor }
+  {   [x28, #64]    stdin descriptor }
+  {   [x28, #128]   stdout descriptor }
+  {   [x28, #192]   spare descriptor, shared by fds without their own }
+  {   [x28, #256]   descriptor table indexed by fd (256 entries) }
+  {   [x28, #4096]  stdout buffer (16384 bytes) }
+  {   [x28, #20480] stdin buffer (65536 bytes) }
+  {   [x28, #86016] spare buffer (4096 bytes) }
+  WriteLn('    mov x0, #0');
+  WriteLn('    movz x1, #0x6000');
+  WriteLn('    movk x1, #1, lsl #16');
+  WriteLn('    mov x2, #3');
+  WriteLn('    mov x3, #4098');
+  WriteLn('    movn x4, #0');
+  WriteLn('    mov x5, #0');
+  WriteLn('    movz x16, #0xC5');
+  WriteLn('    movk x16, #0x200, lsl #16');
+  EmitSvc;
+  WriteLn('    mov x28, x0');
+  EmitIoDescInit(64, 0, 5, 65536);
+  EmitIoDescInit(128, 1, 1, 16384);
+  EmitIoDescInit(192, -1, 21, 4096);
+  WriteLn('    add x0, x28, #64');
+  WriteLn('    str x0, [x28, #8]');
+  WriteLn('    str x0, [x28, #256]');
+  WriteLn('    add x0, x28, #128');
+  WriteLn('    str x0, [x28]');
+  WriteLn('    str x0, [x28, #264]');
+
+  { Default: x19 = 0 (stdin), x20 = 1 (stdout) }
   WriteLn('    mov x19, #0');
   WriteLn('    mov x20, #1');
-  WriteLn('    mov x18, #-1');
 
   { If argc < 2, skip input file open }
   WriteLn('    cmp x21, #2');
@@ -2910,6 +6385,7 @@ Begin
 
   { Move input fd To x19 }
   WriteLn('    mov x19, x0');
+  EmitBL(rt_io_open);
 
   { If argc < 4, skip output file open (need: prog input.pas -o output.s) }
   WriteLn('    cmp x21, #4');
@@ -2939,63 +6415,223 @@ Begin
 
   { Move output fd To x20 }
   WriteLn('    mov x20, x0');
+  EmitBL(rt_io_open);
 
   EmitLabel(skip_output_lbl);
   EmitLabel(skip_input_lbl)
 End;
 
-Procedure EmitHeapInitRuntime;
+Procedure EmitMmapAnon;
 Begin
-  { Initialize heap using mmap syscall }
-  { Allocates 1MB Of memory For heap, stores base In x21 }
-  { Initializes free list head In x22 pointing To entire block }
-  EmitLabel(rt_heap_init);
-  EmitStp;
-  EmitMovFP;
-  EmitSubSP(16);
-
-  { mov x0, #0  - addr = NULL (let kernel choose) }
+  { mmap(NULL, x1, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0) }
+  { Returns the address In x0, carry Set If the kernel refused }
   WriteLn('    mov x0, #0');
-
-  { mov x1, #1048576  - Length = 1MB (0x100000) }
-  { Need movz + movk since 1048576 > 65535 }
-  WriteLn('    movz x1, #0');
-  WriteLn('    movk x1, #16, lsl #16');
-
-  { mov x2, #3  - PROT_READ | PROT_WRITE }
   WriteLn('    mov x2, #3');
-
-  { mov x3, #4098  - MAP_PRIVATE | MAP_ANON (0x1002) }
   WriteLn('    mov x3, #4098');
-
-  { mov x4, #-1  - fd = -1 }
   WriteLn('    movn x4, #0');
-
-  { mov x5, #0  - offset = 0 }
   WriteLn('    mov x5, #0');
-
-  { mmap syscall: 0x20000C5 }
   WriteLn('    movz x16, #0xC5');
   WriteLn('    movk x16, #0x200, lsl #16');
+  EmitSvc
+End;
 
-  EmitSvc;
+Procedure EmitHeapBin(dst, sz: Integer);
+Begin
+  { xdst = address Of the free list head For blocks Of xsz bytes: the }
+  { bin at [x22, #48 + size / 2] up To 528 bytes, Else the large list }
+  Write('    add x'); Write(dst); Write(', x22, x'); Write(sz); WriteLn(', lsr #1');
+  Write('    add x'); Write(dst); Write(', x'); Write(dst); WriteLn(', #48');
+  Write('    cmp x'); Write(sz); WriteLn(', #528');
+  Write('    csel x'); Write(dst); Write(', x'); Write(dst); WriteLn(', x22, ls')
+End;
+
+Procedure EmitHeapUnlink(b, t1, t2: Integer);
+Var
+  skip_lbl: Integer;
+Begin
+  { Take free block xb off its list. [xb, #16] is the next block, }
+  { [xb, #24] the address Of the field that points To xb. Uses xt1, xt2 }
+  skip_lbl := NewLabel;
+  Write('    ldp x'); Write(t1); Write(', x'); Write(t2); Write(', [x'); Write(b); WriteLn(', #16]');
+  Write('    str x'); Write(t1); Write(', [x'); Write(t2); WriteLn(']');
+  Write('    cbz x'); Write(t1); Write(', L'); WriteLn(skip_lbl);
+  Write('    str x'); Write(t2); Write(', [x'); Write(t1); WriteLn(', #24]');
+  EmitLabel(skip_lbl)
+End;
+
+Procedure EmitHeapInsert(b, head, t1, t2: Integer);
+Var
+  skip_lbl: Integer;
+Begin
+  { Push free block xb onto the list whose head is at [xhead]. Uses xt1, xt2 }
+  skip_lbl := NewLabel;
+  Write('    ldr x'); Write(t1); Write(', [x'); Write(head); WriteLn(']');
+  Write('    stp x'); Write(t1); Write(', x'); Write(head); Write(', [x'); Write(b); WriteLn(', #16]');
+  Write('    str x'); Write(b); Write(', [x'); Write(head); WriteLn(']');
+  Write('    cbz x'); Write(t1); Write(', L'); WriteLn(skip_lbl);
+  Write('    add x'); Write(t2); Write(', x'); Write(b); WriteLn(', #16');
+  Write('    str x'); Write(t2); Write(', [x'); Write(t1); WriteLn(', #24]');
+  EmitLabel(skip_lbl)
+End;
+
+Procedure EmitHeapChunk(base, len: Integer);
+Begin
+  { Turn xlen bytes at xbase into one free block followed by a fence, a }
+  { header that looks In use so no block ever merges past the End. }
+  { Leaves the block size In xlen; uses x2-x3 }
+  Write('    sub x'); Write(len); Write(', x'); Write(len); WriteLn(', #16');
+  Write('    orr x2, x'); Write(len); WriteLn(', #2');
+  Write('    str x2, [x'); Write(base); WriteLn(', #8]');
+  Write('    add x3, x'); Write(base); Write(', x'); WriteLn(len);
+  Write('    str x'); Write(len); WriteLn(', [x3]');
+  WriteLn('    mov x2, #1');
+  WriteLn('    str x2, [x3, #8]')
+End;
+
+Procedure EmitHeapCount(sz, off: Integer);
+Begin
+  { Heap statistics: add one To the counter at [x22, #off + n] For a }
+  { block Of n = xsz bytes. Blocks over 528 bytes all share the slot }
+  { For n = 544. Clobbers x11-x12 }
+  WriteLn('    mov x11, #544');
+  Write('    cmp x'); Write(sz); WriteLn(', x11');
+  Write('    csel x11, x'); Write(sz); WriteLn(', x11, lo');
+  WriteLn('    add x11, x11, x22');
+  Write('    ldr x12, [x11, #'); Write(off); WriteLn(']');
+  WriteLn('    add x12, x12, #1');
+  Write('    str x12, [x11, #'); Write(off); WriteLn(']')
+End;
+
+Procedure EmitHeapInitRuntime;
+Var
+  size, limit, ctl: Integer;
+Begin
+  { Initialize the heap. x21 bumps through its own region For String }
+  { temporaries. x22 points To the heap control block at the start Of }
+  { the first chunk: }
+  {   [x22]       large free list head }
+  {   [x22, #8]   Length Of the next chunk To map }
+  {   [x22, #16]  heap limit In bytes, 0 = none }
+  {   [x22, #24]  bytes mapped so far }
+  {   [x22, #32]  Mark/Release arena bump pointer, 0 when Not In use }
+  {   [x22, #40]  End Of the current arena segment }
+  {   [x22, #48]  current arena segment, 0 before the first Mark }
+  {   [x22, #64]  bins For free blocks Of 32 To 528 bytes, one per }
+  {               16 bytes, the bin For size n at [x22, #48 + n / 2] }
+  { With $HEAPSTATS the control block also holds: }
+  {   [x22, #512]  bytes In use   [x22, #520]  peak bytes In use }
+  {   [x22, #528]  arena blocks, freed together by Release }
+  {   [x22, #544]  allocations And frees For each block size, 16 }
+  {                bytes per size, the last For blocks over 528 bytes }
+  { The first free block follows the control block at [x22, #512], Or }
+  { at [x22, #1072] With statistics }
+  { Every block starts With a 16-byte header: }
+  {   [b]       size Of the block before, valid only If that one is free }
+  {   [b, #8]   size Of this block, bit 0 = In use, bit 1 = block before }
+  {             In use, bit 2 = arena block (freed by Release), bit 3 }
+  {             = block With its own mapping (munmapped by rt_free) }
+  { Free blocks are doubly linked: [b, #16] next, [b, #24] the address }
+  { Of the field that points To b }
+  size := ((heap_min_size + 65535) Div 65536) * 65536;
+  If size > 4294901760 Then
+    size := 4294901760;
+  ctl := 512;
+  If heap_stats = 1 Then
+    ctl := 1072;
+  limit := heap_max_size;
+  If (limit > 0) And (limit < size) Then
+    limit := size;
+  EmitLabel(rt_heap_init);
+  EmitStp;
+  EmitMovFP;
 
-  { mov x21, x0  - store heap base In x21 }
+  { 16MB For String temporaries, only touched pages cost memory }
+  WriteLn('    movz x1, #0x100, lsl #16');
+  EmitMmapAnon;
   WriteLn('    mov x21, x0');
 
-  { Initialize free list: x22 = x21 (free list head points To heap base) }
-  WriteLn('    mov x22, x21');
+  EmitMovX0(size);
+  WriteLn('    mov x1, x0');
+  EmitMmapAnon;
+  WriteLn('    mov x22, x0');
+  EmitMovX0(size);
+  WriteLn('    str x0, [x22, #24]');
+  { Each chunk after the first doubles the last one }
+  WriteLn('    lsl x0, x0, #1');
+  WriteLn('    str x0, [x22, #8]');
+  EmitMovX0(limit);
+  WriteLn('    str x0, [x22, #16]');
+  EmitMovX0(size - ctl);
+  WriteLn('    mov x1, x0');
+  Write('    add x0, x22, #'); WriteLn(ctl);
+  EmitHeapChunk(0, 1);
+  EmitHeapInsert(0, 22, 2, 3);
+
+  EmitLdp;
+  EmitRet
+End;
 
-  { Store block size (1MB) at [x21]: first free block header }
-  { movz x1, #0; movk x1, #16, lsl #16 = 1048576 }
-  WriteLn('    movz x1, #0');
-  WriteLn('    movk x1, #16, lsl #16');
-  { str x1, [x21] - store size }
-  WriteLn('    str x1, [x21]');
+Procedure EmitHeapGrowRuntime;
+Var
+  map_lbl, done_lbl, fail_lbl, keep_lbl: Integer;
+Begin
+  { Map another heap chunk And put it on the large free list }
+  { Input: x0 = block size that must fit }
+  { Output: x0 = the New chunk, Or 0 If the limit Or the kernel says no }
+  map_lbl := NewLabel;
+  done_lbl := NewLabel;
+  fail_lbl := NewLabel;
+  keep_lbl := NewLabel;
+  EmitLabel(rt_heap_grow);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(16);
 
-  { Store next=0 at [x21, #8]: no next free block }
-  WriteLn('    str xzr, [x21, #8]');
+  { Length = the next geometric step, Or the request plus the fence }
+  { rounded up To 64KB If that is larger }
+  WriteLn('    movz x1, #0x1, lsl #16');
+  WriteLn('    add x1, x1, #15');
+  WriteLn('    add x0, x0, x1');
+  WriteLn('    and x0, x0, #-65536');
+  WriteLn('    ldr x1, [x22, #8]');
+  WriteLn('    cmp x1, x0');
+  WriteLn('    csel x1, x1, x0, hs');
+
+  { Past the limit, fall back To the bare request before giving up }
+  WriteLn('    ldr x4, [x22, #16]');
+  Write('    cbz x4, L'); WriteLn(map_lbl);
+  WriteLn('    ldr x5, [x22, #24]');
+  WriteLn('    add x6, x5, x1');
+  WriteLn('    cmp x6, x4');
+  Write('    b.ls L'); WriteLn(map_lbl);
+  WriteLn('    mov x1, x0');
+  WriteLn('    add x6, x5, x1');
+  WriteLn('    cmp x6, x4');
+  Write('    b.hi L'); WriteLn(fail_lbl);
+
+  EmitLabel(map_lbl);
+  WriteLn('    stur x1, [x29, #-8]');
+  EmitMmapAnon;
+  Write('    b.cs L'); WriteLn(fail_lbl);
+  WriteLn('    ldur x1, [x29, #-8]');
+  WriteLn('    ldr x2, [x22, #24]');
+  WriteLn('    add x2, x2, x1');
+  WriteLn('    str x2, [x22, #24]');
+  EmitHeapChunk(0, 1);
+  EmitHeapInsert(0, 22, 2, 3);
+  { Double the next step Until it reaches 64MB }
+  WriteLn('    ldr x2, [x22, #8]');
+  WriteLn('    movz x3, #0x400, lsl #16');
+  WriteLn('    cmp x2, x3');
+  Write('    b.hs L'); WriteLn(keep_lbl);
+  WriteLn('    lsl x2, x2, #1');
+  WriteLn('    str x2, [x22, #8]');
+  EmitLabel(keep_lbl);
+  EmitBranchLabel(done_lbl);
 
+  EmitLabel(fail_lbl);
+  EmitMovX0(0);
+  EmitLabel(done_lbl);
   EmitAddSP(16);
   EmitLdp;
   EmitRet
@@ -3003,339 +6639,828 @@ End;
 
 Procedure EmitAllocRuntime;
 Var
-  loop_lbl, found_lbl, split_lbl, no_split_lbl, update_head_lbl, done_lbl, oom_lbl: Integer;
+  retry_lbl, loop_lbl, found_lbl, large_lbl, miss_lbl: Integer;
+  whole_lbl, done_lbl, grow_lbl, arena_lbl, arena_grow_lbl, oom_lbl: Integer;
+  direct_lbl: Integer;
 Begin
-  { Allocate memory from free list With block splitting }
+  { Allocate memory With segregated free lists }
   { Input: x0 = requested size }
   { Output: x0 = pointer To user data, Or 0 If OOM }
+  { Blocks Of up To 528 bytes (512 bytes Of data) come from the bin For }
+  { their exact size In O(1). Larger blocks are split off the first fit }
+  { In the large free list at [x22]. Blocks Of 128KB And up that no }
+  { free block fits get their own mapping. Between Mark And Release, }
+  { blocks are bumped off the arena instead }
+  retry_lbl := NewLabel;
   loop_lbl := NewLabel;
   found_lbl := NewLabel;
-  split_lbl := NewLabel;
-  no_split_lbl := NewLabel;
-  update_head_lbl := NewLabel;
+  large_lbl := NewLabel;
+  miss_lbl := NewLabel;
+  whole_lbl := NewLabel;
   done_lbl := NewLabel;
+  grow_lbl := NewLabel;
+  arena_lbl := NewLabel;
+  arena_grow_lbl := NewLabel;
   oom_lbl := NewLabel;
+  direct_lbl := NewLabel;
 
   EmitLabel(rt_alloc);
   EmitStp;
   EmitMovFP;
   EmitSubSP(16);
 
-  { Add 16 For header And align To 16 bytes: x0 = (x0 + 31) & ~15 }
+  { Add 16 For header And align To 16 bytes, at least 32 so a freed }
+  { block can hold its links: x3 = max((x0 + 31) & ~15, 32) }
   WriteLn('    add x0, x0, #31');
-  { And x0, x0, #-16 }
-  WriteLn('    And x0, x0, #-16');
-  { Save required size To x3 }
-  WriteLn('    mov x3, x0');
-
-  { x1 = prev (0 initially), x2 = curr (x22 = free list head) }
-  WriteLn('    mov x1, #0');
-  WriteLn('    mov x2, x22');
-
-  { Loop: walk free list looking For big enough block }
+  WriteLn('    and x3, x0, #-16');
+  WriteLn('    mov x4, #32');
+  WriteLn('    cmp x3, x4');
+  WriteLn('    csel x3, x3, x4, hs');
+  WriteLn('    ldr x0, [x22, #32]');
+  Write('    cbnz x0, L'); WriteLn(arena_lbl);
+
+  EmitLabel(retry_lbl);
+  WriteLn('    cmp x3, #528');
+  Write('    b.hi L'); WriteLn(large_lbl);
+
+  { Small: take the head Of the bin For this size }
+  WriteLn('    add x6, x22, x3, lsr #1');
+  WriteLn('    ldr x2, [x6, #48]');
+  Write('    cbnz x2, L'); WriteLn(found_lbl);
+
+  { Empty bin: any large block fits, split the head Of the large list }
+  EmitLabel(miss_lbl);
+  WriteLn('    ldr x2, [x22]');
+  Write('    cbnz x2, L'); WriteLn(found_lbl);
+  EmitBranchLabel(grow_lbl);
+
+  { Large: first fit }
+  EmitLabel(large_lbl);
+  WriteLn('    ldr x2, [x22]');
   EmitLabel(loop_lbl);
-  { cbz x2, oom - End Of list }
-  Write('    cbz x2, L'); WriteLn(oom_lbl);
-  { ldr x4, [x2] - x4 = block size }
-  WriteLn('    ldr x4, [x2]');
-  { cmp x4, x3 - compare block size To required }
+  Write('    cbz x2, L'); WriteLn(grow_lbl);
+  WriteLn('    ldr x4, [x2, #8]');
+  WriteLn('    and x4, x4, #-16');
   WriteLn('    cmp x4, x3');
-  { b.ge found }
-  Write('    b.ge L'); WriteLn(found_lbl);
-  { Not big enough - move To next }
-  { mov x1, x2 - prev = curr }
-  WriteLn('    mov x1, x2');
-  { ldr x2, [x2, #8] - curr = curr->next }
-  WriteLn('    ldr x2, [x2, #8]');
+  Write('    b.hs L'); WriteLn(found_lbl);
+  WriteLn('    ldr x2, [x2, #16]');
   EmitBranchLabel(loop_lbl);
 
-  { Found a big enough block - check If we can split it }
+  { Found free block x2: take it off its list, split If the rest can }
+  { hold a block }
   EmitLabel(found_lbl);
-  { x2 = block addr, x3 = required size, x4 = block size }
-  { ldr x5, [x2, #8] - x5 = found->next }
-  WriteLn('    ldr x5, [x2, #8]');
-  { Check If block can be split: x4 - x3 >= 32 }
-  { sub x6, x4, x3 - x6 = remainder size }
+  EmitHeapUnlink(2, 5, 7);
+  WriteLn('    ldr x4, [x2, #8]');
+  WriteLn('    and x4, x4, #-16');
   WriteLn('    sub x6, x4, x3');
-  { cmp x6, #32 }
   WriteLn('    cmp x6, #32');
-  { b.lt no_split - If remainder < 32, don't split }
-  Write('    b.lt L'); WriteLn(no_split_lbl);
-
-  { Split the block }
-  EmitLabel(split_lbl);
-  { x6 = remainder size, x7 = remainder block address = x2 + x3 }
-  { add x7, x2, x3 }
+  Write('    b.lo L'); WriteLn(whole_lbl);
+  { The front part is In use, the rest is a free block after it }
+  WriteLn('    orr x5, x3, #3');
+  WriteLn('    str x5, [x2, #8]');
   WriteLn('    add x7, x2, x3');
-  { str x6, [x7] - remainder->size = x6 }
-  WriteLn('    str x6, [x7]');
-  { str x5, [x7, #8] - remainder->next = found->next }
+  WriteLn('    orr x5, x6, #2');
   WriteLn('    str x5, [x7, #8]');
-  { str x3, [x2] - found->size = required size }
-  WriteLn('    str x3, [x2]');
-  { mov x5, x7 - use remainder as New "next" For unlinking }
-  WriteLn('    mov x5, x7');
-
-  { Unlink found block from free list (And link remainder In its place) }
-  EmitLabel(no_split_lbl);
-  { cbz x1, update_head - If prev==0, update head }
-  Write('    cbz x1, L'); WriteLn(update_head_lbl);
-  { str x5, [x1, #8] - prev->next = x5 (remainder Or found->next) }
-  WriteLn('    str x5, [x1, #8]');
+  WriteLn('    str x6, [x7, x6]');
+  EmitHeapBin(8, 6);
+  EmitHeapInsert(7, 8, 5, 9);
   EmitBranchLabel(done_lbl);
 
-  EmitLabel(update_head_lbl);
-  { mov x22, x5 - free list head = x5 (remainder Or found->next) }
-  WriteLn('    mov x22, x5');
+  { Too small To split: mark the block And the next one's prev bit }
+  EmitLabel(whole_lbl);
+  WriteLn('    ldr x5, [x2, #8]');
+  WriteLn('    orr x5, x5, #1');
+  WriteLn('    str x5, [x2, #8]');
+  WriteLn('    add x7, x2, x4');
+  WriteLn('    ldr x5, [x7, #8]');
+  WriteLn('    orr x5, x5, #2');
+  WriteLn('    str x5, [x7, #8]');
 
   EmitLabel(done_lbl);
-  { Mark as allocated: str xzr, [x2, #8] - next = 0 }
-  WriteLn('    str xzr, [x2, #8]');
-  { Return user pointer: add x0, x2, #16 }
+  If heap_stats = 1 Then
+  Begin
+    WriteLn('    ldr x9, [x2, #8]');
+    WriteLn('    and x9, x9, #-16');
+    EmitHeapCount(9, 512);
+    WriteLn('    add x12, x22, #512');
+    WriteLn('    ldp x10, x11, [x12]');
+    WriteLn('    add x10, x10, x9');
+    WriteLn('    cmp x10, x11');
+    WriteLn('    csel x11, x10, x11, hi');
+    WriteLn('    stp x10, x11, [x12]')
+  End;
   WriteLn('    add x0, x2, #16');
   EmitAddSP(16);
   EmitLdp;
   EmitRet;
 
+  { Nothing fits: map another chunk And try again }
+  EmitLabel(grow_lbl);
+  WriteLn('    cmp x3, #32, lsl #12');
+  Write('    b.hs L'); WriteLn(direct_lbl);
+  WriteLn('    stur x3, [x29, #-8]');
+  WriteLn('    mov x0, x3');
+  EmitBL(rt_heap_grow);
+  WriteLn('    ldur x3, [x29, #-8]');
+  Write('    cbnz x0, L'); WriteLn(retry_lbl);
+  EmitBranchLabel(oom_lbl);
+
+  { Big block: map it on its own, rounded To whole pages, And flag it }
+  { With bit 3 so rt_free hands it straight back To the kernel }
+  EmitLabel(direct_lbl);
+  WriteLn('    add x1, x3, #4095');
+  WriteLn('    and x1, x1, #-4096');
+  WriteLn('    ldr x4, [x22, #16]');
+  WriteLn('    ldr x5, [x22, #24]');
+  WriteLn('    add x5, x5, x1');
+  WriteLn('    cmp x5, x4');
+  WriteLn('    ccmp x4, #0, #4, hi');
+  Write('    b.ne L'); WriteLn(oom_lbl);
+  WriteLn('    stur x1, [x29, #-8]');
+  EmitMmapAnon;
+  Write('    b.cs L'); WriteLn(oom_lbl);
+  WriteLn('    ldur x1, [x29, #-8]');
+  WriteLn('    ldr x2, [x22, #24]');
+  WriteLn('    add x2, x2, x1');
+  WriteLn('    str x2, [x22, #24]');
+  WriteLn('    add x1, x1, #9');
+  WriteLn('    str x1, [x0, #8]');
+  WriteLn('    mov x2, x0');
+  EmitBranchLabel(done_lbl);
+
   { Out Of memory }
   EmitLabel(oom_lbl);
   EmitMovX0(0);
   EmitAddSP(16);
   EmitLdp;
-  EmitRet
+  EmitRet;
+
+  { Arena: bump x0 by the block size, the header marks it an arena block }
+  EmitLabel(arena_lbl);
+  WriteLn('    ldr x1, [x22, #40]');
+  WriteLn('    add x2, x0, x3');
+  WriteLn('    cmp x2, x1');
+  Write('    b.hi L'); WriteLn(arena_grow_lbl);
+  WriteLn('    str x2, [x22, #32]');
+  If heap_stats = 1 Then
+  Begin
+    { Counted apart: Release frees them without visiting each one }
+    WriteLn('    ldr x4, [x22, #528]');
+    WriteLn('    add x4, x4, #1');
+    WriteLn('    str x4, [x22, #528]')
+  End;
+  WriteLn('    add x4, x3, #5');
+  WriteLn('    str x4, [x0, #8]');
+  WriteLn('    add x0, x0, #16');
+  EmitAddSP(16);
+  EmitLdp;
+  EmitRet;
+
+  EmitLabel(arena_grow_lbl);
+  WriteLn('    stur x3, [x29, #-8]');
+  WriteLn('    mov x0, x3');
+  EmitBL(rt_arena_grow);
+  WriteLn('    ldur x3, [x29, #-8]');
+  Write('    cbz x0, L'); WriteLn(oom_lbl);
+  WriteLn('    ldr x0, [x22, #32]');
+  EmitBranchLabel(arena_lbl)
 End;
 
 Procedure EmitFreeRuntime;
+Var
+  prev_used_lbl, next_used_lbl, direct_lbl, done_lbl: Integer;
 Begin
-  { Free memory back To free list }
-  { Input: x0 = pointer To user data }
+  { Free memory: merge With free neighbours, Then push the result onto }
+  { the bin For its size Or the large free list }
+  { Input: x0 = pointer To user data (Nil And arena blocks are ignored, }
+  { blocks mapped on their own are unmapped) }
+  prev_used_lbl := NewLabel;
+  next_used_lbl := NewLabel;
+  direct_lbl := NewLabel;
+  done_lbl := NewLabel;
   EmitLabel(rt_free);
-  { Get block header: sub x0, x0, #16 }
+  Write('    cbz x0, L'); WriteLn(done_lbl);
   WriteLn('    sub x0, x0, #16');
-  { Link into free list: str x22, [x0, #8] - block->next = free_head }
-  WriteLn('    str x22, [x0, #8]');
-  { Update free list head: mov x22, x0 }
-  WriteLn('    mov x22, x0');
+  WriteLn('    ldr x1, [x0, #8]');
+  Write('    tbnz x1, #2, L'); WriteLn(done_lbl);
+  WriteLn('    and x2, x1, #-16');
+  If heap_stats = 1 Then
+  Begin
+    EmitHeapCount(2, 520);
+    WriteLn('    ldr x10, [x22, #512]');
+    WriteLn('    sub x10, x10, x2');
+    WriteLn('    str x10, [x22, #512]')
+  End;
+  Write('    tbnz x1, #3, L'); WriteLn(direct_lbl);
+  WriteLn('    add x3, x0, x2');
+  Write('    tbnz x1, #1, L'); WriteLn(prev_used_lbl);
+  { The block before is free: it absorbs this one }
+  WriteLn('    ldr x4, [x0]');
+  WriteLn('    sub x0, x0, x4');
+  WriteLn('    add x2, x2, x4');
+  EmitHeapUnlink(0, 5, 6);
+  EmitLabel(prev_used_lbl);
+  WriteLn('    ldr x4, [x3, #8]');
+  Write('    tbnz x4, #0, L'); WriteLn(next_used_lbl);
+  { The block after is free: absorb it }
+  WriteLn('    and x4, x4, #-16');
+  EmitHeapUnlink(3, 5, 6);
+  WriteLn('    add x2, x2, x4');
+  EmitLabel(next_used_lbl);
+  { Header, footer In the next block's first word, next block's prev bit }
+  WriteLn('    orr x1, x2, #2');
+  WriteLn('    str x1, [x0, #8]');
+  WriteLn('    add x3, x0, x2');
+  WriteLn('    str x2, [x3]');
+  WriteLn('    ldr x4, [x3, #8]');
+  WriteLn('    and x4, x4, #-3');
+  WriteLn('    str x4, [x3, #8]');
+  EmitHeapBin(5, 2);
+  EmitHeapInsert(0, 5, 6, 7);
+  EmitBranchLabel(done_lbl);
+
+  { A block With its own mapping: munmap(x0, size) }
+  EmitLabel(direct_lbl);
+  WriteLn('    ldr x3, [x22, #24]');
+  WriteLn('    sub x3, x3, x2');
+  WriteLn('    str x3, [x22, #24]');
+  WriteLn('    mov x1, x2');
+  EmitMovX16(33554505);  { 0x2000049 = munmap }
+  EmitSvc;
+  EmitLabel(done_lbl);
+  EmitRet
+End;
+
+Procedure EmitArenaGrowRuntime;
+Var
+  map_lbl, done_lbl, fail_lbl, first_lbl, size_lbl: Integer;
+Begin
+  { Map a New Mark/Release arena segment And bump from its start }
+  { Input: x0 = block size that must fit }
+  { Output: x0 = the segment, Or 0 If the limit Or the kernel says no }
+  { A segment starts With [s] = the segment before, [s, #8] = Length }
+  map_lbl := NewLabel;
+  done_lbl := NewLabel;
+  fail_lbl := NewLabel;
+  first_lbl := NewLabel;
+  size_lbl := NewLabel;
+  EmitLabel(rt_arena_grow);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(16);
+
+  { Length = twice the last segment (1MB For the first, 64MB at most), }
+  { Or the request plus the segment header rounded up To 64KB }
+  WriteLn('    movz x1, #0x1, lsl #16');
+  WriteLn('    add x1, x1, #15');
+  WriteLn('    add x0, x0, x1');
+  WriteLn('    and x0, x0, #-65536');
+  WriteLn('    ldr x1, [x22, #48]');
+  Write('    cbz x1, L'); WriteLn(first_lbl);
+  WriteLn('    ldr x1, [x1, #8]');
+  WriteLn('    lsl x1, x1, #1');
+  WriteLn('    movz x2, #0x400, lsl #16');
+  WriteLn('    cmp x1, x2');
+  WriteLn('    csel x1, x1, x2, ls');
+  EmitBranchLabel(size_lbl);
+  EmitLabel(first_lbl);
+  WriteLn('    movz x1, #0x10, lsl #16');
+  EmitLabel(size_lbl);
+  WriteLn('    cmp x1, x0');
+  WriteLn('    csel x1, x1, x0, hs');
+
+  { Stay within the heap limit }
+  WriteLn('    ldr x4, [x22, #16]');
+  Write('    cbz x4, L'); WriteLn(map_lbl);
+  WriteLn('    ldr x5, [x22, #24]');
+  WriteLn('    add x6, x5, x1');
+  WriteLn('    cmp x6, x4');
+  Write('    b.hi L'); WriteLn(fail_lbl);
+
+  EmitLabel(map_lbl);
+  WriteLn('    stur x1, [x29, #-8]');
+  EmitMmapAnon;
+  Write('    b.cs L'); WriteLn(fail_lbl);
+  WriteLn('    ldur x1, [x29, #-8]');
+  WriteLn('    ldr x2, [x22, #24]');
+  WriteLn('    add x2, x2, x1');
+  WriteLn('    str x2, [x22, #24]');
+  WriteLn('    ldr x2, [x22, #48]');
+  WriteLn('    stp x2, x1, [x0]');
+  WriteLn('    str x0, [x22, #48]');
+  WriteLn('    add x2, x0, #16');
+  WriteLn('    add x3, x0, x1');
+  WriteLn('    stp x2, x3, [x22, #32]');
+  EmitBranchLabel(done_lbl);
+
+  EmitLabel(fail_lbl);
+  EmitMovX0(0);
+  EmitLabel(done_lbl);
+  EmitAddSP(16);
+  EmitLdp;
+  EmitRet
+End;
+
+Procedure EmitMarkRuntime;
+Var
+  have_lbl, done_lbl: Integer;
+Begin
+  { Mark(p) - Output: x0 = the arena position To Release back To }
+  { The first Mark switches New And GetMem To bump allocation from the }
+  { arena, reusing the segment kept by the last full Release }
+  have_lbl := NewLabel;
+  done_lbl := NewLabel;
+  EmitLabel(rt_mark);
+  EmitStp;
+  EmitMovFP;
+  WriteLn('    ldr x0, [x22, #32]');
+  Write('    cbnz x0, L'); WriteLn(done_lbl);
+  WriteLn('    ldr x1, [x22, #48]');
+  Write('    cbnz x1, L'); WriteLn(have_lbl);
+  EmitBL(rt_arena_grow);
+  WriteLn('    ldr x0, [x22, #32]');
+  EmitBranchLabel(done_lbl);
+  EmitLabel(have_lbl);
+  WriteLn('    add x0, x1, #16');
+  WriteLn('    ldr x2, [x1, #8]');
+  WriteLn('    add x2, x1, x2');
+  WriteLn('    stp x0, x2, [x22, #32]');
+  EmitLabel(done_lbl);
+  EmitLdp;
+  EmitRet
+End;
+
+Procedure EmitReleaseRuntime;
+Var
+  loop_lbl, pop_lbl, first_lbl, done_lbl: Integer;
+Begin
+  { Release(p) - Input: x0 = position from Mark }
+  { Frees every arena block allocated since that Mark by moving the bump }
+  { pointer back, unmapping segments added after it. Releasing To the }
+  { start Of the first segment (Or To a position that is Not In the }
+  { arena) ends arena allocation; the first segment is kept For reuse }
+  loop_lbl := NewLabel;
+  pop_lbl := NewLabel;
+  first_lbl := NewLabel;
+  done_lbl := NewLabel;
+  EmitLabel(rt_release);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(16);
+  WriteLn('    stur x0, [x29, #-8]');
+  WriteLn('    ldr x1, [x22, #48]');
+  Write('    cbz x1, L'); WriteLn(done_lbl);
+
+  EmitLabel(loop_lbl);
+  { Is x0 inside segment x1? }
+  WriteLn('    add x2, x1, #16');
+  WriteLn('    ldr x3, [x1, #8]');
+  WriteLn('    add x3, x1, x3');
+  WriteLn('    cmp x0, x2');
+  Write('    b.lo L'); WriteLn(pop_lbl);
+  WriteLn('    cmp x0, x3');
+  Write('    b.hi L'); WriteLn(pop_lbl);
+  WriteLn('    stp x0, x3, [x22, #32]');
+  WriteLn('    cmp x0, x2');
+  Write('    b.ne L'); WriteLn(done_lbl);
+  WriteLn('    ldr x4, [x1]');
+  Write('    cbnz x4, L'); WriteLn(done_lbl);
+  WriteLn('    str xzr, [x22, #32]');
+  EmitBranchLabel(done_lbl);
+
+  { Not In this segment: unmap it And try the one before }
+  EmitLabel(pop_lbl);
+  WriteLn('    ldr x4, [x1]');
+  Write('    cbz x4, L'); WriteLn(first_lbl);
+  WriteLn('    str x4, [x22, #48]');
+  WriteLn('    ldr x5, [x1, #8]');
+  WriteLn('    ldr x2, [x22, #24]');
+  WriteLn('    sub x2, x2, x5');
+  WriteLn('    str x2, [x22, #24]');
+  WriteLn('    mov x0, x1');
+  WriteLn('    mov x1, x5');
+  EmitMovX16(33554505);  { 0x2000049 = munmap }
+  EmitSvc;
+  WriteLn('    ldur x0, [x29, #-8]');
+  WriteLn('    ldr x1, [x22, #48]');
+  EmitBranchLabel(loop_lbl);
+
+  { Not In the arena at all: empty it }
+  EmitLabel(first_lbl);
+  WriteLn('    ldr x3, [x1, #8]');
+  WriteLn('    add x3, x1, x3');
+  WriteLn('    stp xzr, x3, [x22, #32]');
+
+  EmitLabel(done_lbl);
+  EmitAddSP(16);
+  EmitLdp;
+  EmitRet
+End;
+
+Procedure EmitHeapAvailRuntime;
+Var
+  walk_lbl, blk_lbl, next_lbl, check_lbl: Integer;
+Begin
+  { Heap avail - walk every free list: x0 = usable bytes In all free }
+  { blocks, x1 = usable bytes In the largest one. Clobbers x2-x6 }
+  walk_lbl := NewLabel;
+  blk_lbl := NewLabel;
+  next_lbl := NewLabel;
+  check_lbl := NewLabel;
+  EmitLabel(rt_heap_avail);
+  WriteLn('    mov x0, #0');
+  WriteLn('    mov x1, #0');
+  { The large list at [x22] first, Then the bins at [x22, #64] }
+  WriteLn('    mov x2, x22');
+  WriteLn('    add x6, x22, #320');
+  EmitLabel(walk_lbl);
+  WriteLn('    ldr x4, [x2]');
+  EmitLabel(blk_lbl);
+  Write('    cbz x4, L'); WriteLn(next_lbl);
+  WriteLn('    ldr x5, [x4, #8]');
+  WriteLn('    and x5, x5, #-16');
+  WriteLn('    sub x5, x5, #16');
+  WriteLn('    add x0, x0, x5');
+  WriteLn('    cmp x5, x1');
+  WriteLn('    csel x1, x5, x1, hi');
+  WriteLn('    ldr x4, [x4, #16]');
+  EmitBranchLabel(blk_lbl);
+  EmitLabel(next_lbl);
+  WriteLn('    cmp x2, x22');
+  WriteLn('    add x2, x2, #8');
+  Write('    b.ne L'); WriteLn(check_lbl);
+  WriteLn('    add x2, x22, #64');
+  EmitLabel(check_lbl);
+  WriteLn('    cmp x2, x6');
+  Write('    b.lo L'); WriteLn(walk_lbl);
+  EmitRet
+End;
+
+Procedure EmitTextWrite(lbl, len: Integer);
+Begin
+  { Write the len bytes the caller just emitted at label lbl }
+  WriteLn('.text');
+  Write('    adrp x1, L'); Write(lbl); WriteLn('@PAGE');
+  Write('    add x1, x1, L'); Write(lbl); WriteLn('@PAGEOFF');
+  Write('    mov x2, #'); WriteLn(len);
+  EmitBL(rt_write_buf)
+End;
+
+Procedure EmitHeapStatsRuntime;
+Var
+  lbl, loop_lbl, next_lbl, small_lbl, size_lbl, arena_lbl: Integer;
+Begin
+  { Heap statistics - Print the counters kept With $HEAPSTATS To }
+  { stderr: bytes mapped, peak And final bytes In use, arena blocks If }
+  { any, Then allocations And frees For each block size. Called just }
+  { before the program exits }
+  arena_lbl := NewLabel;
+  loop_lbl := NewLabel;
+  next_lbl := NewLabel;
+  small_lbl := NewLabel;
+  size_lbl := NewLabel;
+  EmitLabel(rt_heap_stats);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(16);
+  WriteLn('    stur x20, [x29, #-8]');
+  WriteLn('    mov x20, #2');
+
+  lbl := NewLabel;
+  WriteLn('.section __TEXT,__const');
+  EmitLabel(lbl);
+  WriteLn('    .ascii "heap: "');
+  EmitTextWrite(lbl, 6);
+  WriteLn('    ldr x0, [x22, #24]');
+  EmitBL(rt_print_int);
+  lbl := NewLabel;
+  WriteLn('.section __TEXT,__const');
+  EmitLabel(lbl);
+  WriteLn('    .ascii " bytes mapped, peak in use "');
+  EmitTextWrite(lbl, 27);
+  WriteLn('    ldr x0, [x22, #520]');
+  EmitBL(rt_print_int);
+  lbl := NewLabel;
+  WriteLn('.section __TEXT,__const');
+  EmitLabel(lbl);
+  WriteLn('    .ascii ", in use at exit "');
+  EmitTextWrite(lbl, 17);
+  WriteLn('    ldr x0, [x22, #512]');
+  EmitBL(rt_print_int);
+  WriteLn('    ldr x0, [x22, #528]');
+  Write('    cbz x0, L'); WriteLn(arena_lbl);
+  lbl := NewLabel;
+  WriteLn('.section __TEXT,__const');
+  EmitLabel(lbl);
+  WriteLn('    .ascii ", arena blocks "');
+  EmitTextWrite(lbl, 15);
+  WriteLn('    ldr x0, [x22, #528]');
+  EmitBL(rt_print_int);
+  EmitLabel(arena_lbl);
+  lbl := NewLabel;
+  WriteLn('.section __TEXT,__const');
+  EmitLabel(lbl);
+  WriteLn('    .ascii "\n  size     allocs      frees\n"');
+  EmitTextWrite(lbl, 30);
+
+  { One line per block size With any allocations: [x29, #-16] = size }
+  WriteLn('    mov x0, #32');
+  WriteLn('    stur x0, [x29, #-16]');
+  EmitLabel(loop_lbl);
+  WriteLn('    add x1, x22, x0');
+  WriteLn('    ldr x1, [x1, #512]');
+  Write('    cbz x1, L'); WriteLn(next_lbl);
+  WriteLn('    cmp x0, #528');
+  Write('    b.ls L'); WriteLn(small_lbl);
+  lbl := NewLabel;
+  WriteLn('.section __TEXT,__const');
+  EmitLabel(lbl);
+  WriteLn('    .ascii "  >528"');
+  EmitTextWrite(lbl, 6);
+  EmitBranchLabel(size_lbl);
+  EmitLabel(small_lbl);
+  WriteLn('    mov x1, #6');
+  EmitBL(rt_print_int_w);
+  EmitLabel(size_lbl);
+  WriteLn('    ldur x0, [x29, #-16]');
+  WriteLn('    add x0, x22, x0');
+  WriteLn('    ldr x0, [x0, #512]');
+  WriteLn('    mov x1, #11');
+  EmitBL(rt_print_int_w);
+  WriteLn('    ldur x0, [x29, #-16]');
+  WriteLn('    add x0, x22, x0');
+  WriteLn('    ldr x0, [x0, #520]');
+  WriteLn('    mov x1, #11');
+  EmitBL(rt_print_int_w);
+  EmitBL(rt_newline);
+  EmitLabel(next_lbl);
+  WriteLn('    ldur x0, [x29, #-16]');
+  WriteLn('    add x0, x0, #16');
+  WriteLn('    stur x0, [x29, #-16]');
+  WriteLn('    cmp x0, #544');
+  Write('    b.ls L'); WriteLn(loop_lbl);
+
+  WriteLn('    ldur x20, [x29, #-8]');
+  EmitAddSP(16);
+  EmitLdp;
   EmitRet
 End;
 
 Procedure EmitFillCharRuntime;
 Var
-  loop_lbl, done_lbl: Integer;
+  loop_lbl, tail_lbl, b8_lbl, b4_lbl, b2_lbl, b1_lbl, done_lbl: Integer;
 Begin
   { FillChar: fill memory With a byte value }
   { Input: x0 = destination address, x1 = count, x2 = value (byte) }
+  { Stores 32 bytes per loop, Then 16, 8, 4, 2 And 1 For the rest }
   EmitLabel(rt_fillchar);
-  { Check If count <= 0, return immediately }
   loop_lbl := NewLabel;
+  tail_lbl := NewLabel;
+  b8_lbl := NewLabel;
+  b4_lbl := NewLabel;
+  b2_lbl := NewLabel;
+  b1_lbl := NewLabel;
   done_lbl := NewLabel;
+  { Check If count <= 0, return immediately }
   WriteLn('    cmp x1, #0');
   Write('    b.le L'); WriteLn(done_lbl);
-  { Loop: fill bytes }
+  { Copy the byte into all 8 bytes Of x2 }
+  WriteLn('    and x2, x2, #255');
+  WriteLn('    mov x3, #0x0101010101010101');
+  WriteLn('    mul x2, x2, x3');
+  WriteLn('    cmp x1, #32');
+  Write('    b.lo L'); WriteLn(tail_lbl);
   EmitLabel(loop_lbl);
-  { Store byte: strb w2, [x0], #1 - post-increment }
-  WriteLn('    strb w2, [x0], #1');
-  { Decrement count }
-  WriteLn('    sub x1, x1, #1');
-  { Loop If count > 0 }
-  WriteLn('    cmp x1, #0');
-  Write('    b.gt L'); WriteLn(loop_lbl);
+  WriteLn('    stp x2, x2, [x0, #16]');
+  WriteLn('    stp x2, x2, [x0], #32');
+  WriteLn('    sub x1, x1, #32');
+  WriteLn('    cmp x1, #32');
+  Write('    b.hs L'); WriteLn(loop_lbl);
+  { Under 32 bytes left: one store For each Set bit Of the count }
+  EmitLabel(tail_lbl);
+  Write('    tbz x1, #4, L'); WriteLn(b8_lbl);
+  WriteLn('    stp x2, x2, [x0], #16');
+  EmitLabel(b8_lbl);
+  Write('    tbz x1, #3, L'); WriteLn(b4_lbl);
+  WriteLn('    str x2, [x0], #8');
+  EmitLabel(b4_lbl);
+  Write('    tbz x1, #2, L'); WriteLn(b2_lbl);
+  WriteLn('    str w2, [x0], #4');
+  EmitLabel(b2_lbl);
+  Write('    tbz x1, #1, L'); WriteLn(b1_lbl);
+  WriteLn('    strh w2, [x0], #2');
+  EmitLabel(b1_lbl);
+  Write('    tbz x1, #0, L'); WriteLn(done_lbl);
+  WriteLn('    strb w2, [x0]');
   EmitLabel(done_lbl);
   EmitRet
 End;
 
+Procedure EmitMoveIndex(size, back: Integer);
+Begin
+  { Finish a post-increment Or, With back = 1, pre-decrement address }
+  If back = 1 Then
+  Begin
+    Write(', #-'); Write(size); WriteLn(']!')
+  End
+  Else
+  Begin
+    Write('], #'); WriteLn(size)
+  End
+End;
+
+Procedure EmitMoveTail(back: Integer);
+Var
+  skip_lbl, bit, size: Integer;
+Begin
+  { Move: copy the last x2 < 32 bytes, 16, 8, 4, 2 And 1 at a time For }
+  { each Set bit Of the count. With back = 1, x0 And x1 point just past }
+  { the bytes And step down. Clobbers x3-x4 }
+  bit := 4;
+  size := 16;
+  While size > 0 Do
+  Begin
+    skip_lbl := NewLabel;
+    Write('    tbz x2, #'); Write(bit); Write(', L'); WriteLn(skip_lbl);
+    If size = 16 Then
+      Write('    ldp x3, x4, [x0')
+    Else If size = 8 Then
+      Write('    ldr x3, [x0')
+    Else If size = 4 Then
+      Write('    ldr w3, [x0')
+    Else If size = 2 Then
+      Write('    ldrh w3, [x0')
+    Else
+      Write('    ldrb w3, [x0');
+    EmitMoveIndex(size, back);
+    If size = 16 Then
+      Write('    stp x3, x4, [x1')
+    Else If size = 8 Then
+      Write('    str x3, [x1')
+    Else If size = 4 Then
+      Write('    str w3, [x1')
+    Else If size = 2 Then
+      Write('    strh w3, [x1')
+    Else
+      Write('    strb w3, [x1');
+    EmitMoveIndex(size, back);
+    EmitLabel(skip_lbl);
+    bit := bit - 1;
+    size := size Div 2
+  End
+End;
+
 Procedure EmitMoveRuntime;
 Var
-  loop_lbl, done_lbl: Integer;
+  fwd_lbl, fwd_loop_lbl, fwd_tail_lbl, back_loop_lbl, back_tail_lbl: Integer;
+  done_lbl: Integer;
 Begin
   { Move: copy memory from source To destination }
   { Input: x0 = source address, x1 = destination address, x2 = count }
+  { Copies 32 bytes per loop With two register pairs. When the }
+  { destination starts inside the source it copies from the End down, }
+  { so overlapping moves work like memmove. Clobbers x0-x6 }
   EmitLabel(rt_move);
-  { Check If count <= 0, return immediately }
-  loop_lbl := NewLabel;
+  fwd_lbl := NewLabel;
+  fwd_loop_lbl := NewLabel;
+  fwd_tail_lbl := NewLabel;
+  back_loop_lbl := NewLabel;
+  back_tail_lbl := NewLabel;
   done_lbl := NewLabel;
+  { Check If count <= 0, return immediately }
   WriteLn('    cmp x2, #0');
-  Write('    b.le L'); WriteLn(done_lbl);
-  { Loop: copy bytes }
-  EmitLabel(loop_lbl);
-  { Load byte from source: ldrb w3, [x0], #1 - post-increment }
-  WriteLn('    ldrb w3, [x0], #1');
-  { Store byte To dest: strb w3, [x1], #1 - post-increment }
-  WriteLn('    strb w3, [x1], #1');
-  { Decrement count }
-  WriteLn('    sub x2, x2, #1');
-  { Loop If count > 0 }
-  WriteLn('    cmp x2, #0');
-  Write('    b.gt L'); WriteLn(loop_lbl);
+  Write('    b.le L'); WriteLn(done_lbl);
+  { dest - source, unsigned, below count means dest overlaps the tail }
+  WriteLn('    sub x3, x1, x0');
+  Write('    cbz x3, L'); WriteLn(done_lbl);
+  WriteLn('    cmp x3, x2');
+  Write('    b.hs L'); WriteLn(fwd_lbl);
+
+  { Backward: start past the End And step down }
+  WriteLn('    add x0, x0, x2');
+  WriteLn('    add x1, x1, x2');
+  WriteLn('    cmp x2, #32');
+  Write('    b.lo L'); WriteLn(back_tail_lbl);
+  EmitLabel(back_loop_lbl);
+  WriteLn('    ldp x5, x6, [x0, #-16]');
+  WriteLn('    ldp x3, x4, [x0, #-32]!');
+  WriteLn('    stp x5, x6, [x1, #-16]');
+  WriteLn('    stp x3, x4, [x1, #-32]!');
+  WriteLn('    sub x2, x2, #32');
+  WriteLn('    cmp x2, #32');
+  Write('    b.hs L'); WriteLn(back_loop_lbl);
+  EmitLabel(back_tail_lbl);
+  EmitMoveTail(1);
+  EmitRet;
+
+  { Forward }
+  EmitLabel(fwd_lbl);
+  WriteLn('    cmp x2, #32');
+  Write('    b.lo L'); WriteLn(fwd_tail_lbl);
+  EmitLabel(fwd_loop_lbl);
+  WriteLn('    ldp x5, x6, [x0, #16]');
+  WriteLn('    ldp x3, x4, [x0], #32');
+  WriteLn('    stp x5, x6, [x1, #16]');
+  WriteLn('    stp x3, x4, [x1], #32');
+  WriteLn('    sub x2, x2, #32');
+  WriteLn('    cmp x2, #32');
+  Write('    b.hs L'); WriteLn(fwd_loop_lbl);
+  EmitLabel(fwd_tail_lbl);
+  EmitMoveTail(0);
   EmitLabel(done_lbl);
   EmitRet
 End;
 
 Procedure EmitStrCopyRuntime;
-Var
-  loop_lbl, done_lbl: Integer;
 Begin
   { Copy String from x1 (source) To x0 (dest) }
   { Pascal strings: byte 0 = Length, bytes 1..Length = chars }
+  { The Length byte And the chars go through rt_move In one block, so }
+  { the copy runs a register pair at a time. Clobbers x0-x6 }
   EmitLabel(rt_str_copy);
-  EmitStp;
-  EmitMovFP;
-  EmitSubSP(32);
-
-  { Save dest And source addresses }
-  { stur x0, [x29, #-8] - dest }
-  WriteLn('    stur x0, [x29, #-8]');
-  { stur x1, [x29, #-16] - source }
-  WriteLn('    stur x1, [x29, #-16]');
-
-  { Load Length from source [x1] into x2 }
   WriteLn('    ldrb w2, [x1]');
-  { Store Length To dest [x0] }
-  WriteLn('    strb w2, [x0]');
-  { Save Length To [x29, #-24] }
-  WriteLn('    stur x2, [x29, #-24]');
-
-  { Initialize index To 0 }
-  EmitMovX0(0);
-  EmitSturX0(-32);
-
-  { Loop: copy bytes 1..Length }
-  loop_lbl := NewLabel;
-  done_lbl := NewLabel;
-  EmitLabel(loop_lbl);
-
-  { Load index }
-  EmitLdurX0(-32);
-  { Load Length }
-  WriteLn('    ldur x2, [x29, #-24]');
-  { cmp x0, x2 - If index >= Length, done }
-  WriteLn('    cmp x0, x2');
-  { b.ge done }
-  Write('    b.ge L'); WriteLn(done_lbl);
-
-  { x3 = index + 1 (offset into String) }
-  WriteLn('    add x3, x0, #1');
-
-  { Load source Char: ldrb w4, [x1, x3] where x1 = source }
-  WriteLn('    ldur x1, [x29, #-16]');
-  WriteLn('    ldrb w4, [x1, x3]');
-
-  { Store To dest Char: strb w4, [x5, x3] where x5 = dest }
-  WriteLn('    ldur x5, [x29, #-8]');
-  WriteLn('    strb w4, [x5, x3]');
-
-  { Increment index }
-  EmitLdurX0(-32);
-  WriteLn('    add x0, x0, #1');
-  EmitSturX0(-32);
-  EmitBranchLabel(loop_lbl);
-
-  EmitLabel(done_lbl);
-  EmitAddSP(32);
-  EmitLdp;
-  EmitRet
+  WriteLn('    add x2, x2, #1');
+  WriteLn('    mov x3, x0');
+  WriteLn('    mov x0, x1');
+  WriteLn('    mov x1, x3');
+  EmitBranchLabel(rt_move)
 End;
 
 Procedure EmitStrCompareRuntime;
 Var
-  loop_lbl, not_equal_lbl, done_lbl: Integer;
+  loop_lbl, word_lbl, byte_lbl, equal_lbl, not_equal_lbl: Integer;
 Begin
   { Compare strings at x0 And x1, return 1 If equal, 0 If Not equal In x0 }
+  { Equal lengths are checked first, Then the Length byte And chars are }
+  { compared 16 bytes at a time, one word And single bytes For the rest }
+  { Clobbers x1-x6 }
   EmitLabel(rt_str_compare);
-  EmitStp;
-  EmitMovFP;
-  EmitSubSP(32);
-
-  { Save addresses }
-  EmitSturX0(-8);  { String 1 }
-  { stur x1, [x29, #-16] }
-  WriteLn('    stur x1, [x29, #-16]');
+  loop_lbl := NewLabel;
+  word_lbl := NewLabel;
+  byte_lbl := NewLabel;
+  equal_lbl := NewLabel;
+  not_equal_lbl := NewLabel;
 
-  { Load lengths }
   WriteLn('    ldrb w2, [x0]');
   WriteLn('    ldrb w3, [x1]');
-
-  { Compare lengths first }
-  not_equal_lbl := NewLabel;
-  done_lbl := NewLabel;
   WriteLn('    cmp x2, x3');
-  { b.ne not_equal }
   Write('    b.ne L'); WriteLn(not_equal_lbl);
+  { x2 = bytes left, Length byte included }
+  WriteLn('    add x2, x2, #1');
 
-  { Save Length To [x29, #-24] }
-  WriteLn('    stur x2, [x29, #-24]');
-
-  { Initialize index To 0 }
-  EmitMovX0(0);
-  EmitSturX0(-32);
-
-  { Loop: compare each byte }
-  loop_lbl := NewLabel;
   EmitLabel(loop_lbl);
+  WriteLn('    cmp x2, #16');
+  Write('    b.lo L'); WriteLn(word_lbl);
+  WriteLn('    ldp x3, x4, [x0], #16');
+  WriteLn('    ldp x5, x6, [x1], #16');
+  WriteLn('    cmp x3, x5');
+  WriteLn('    ccmp x4, x6, #0, eq');
+  Write('    b.ne L'); WriteLn(not_equal_lbl);
+  WriteLn('    sub x2, x2, #16');
+  EmitBranchLabel(loop_lbl);
 
-  { Load index }
-  EmitLdurX0(-32);
-  { Load Length }
-  WriteLn('    ldur x2, [x29, #-24]');
-  { cmp x0, x2 - If index >= Length, all equal }
-  WriteLn('    cmp x0, x2');
-  { b.ge equal (return 1) }
-  Write('    b.ge L'); WriteLn(done_lbl);
-
-  { x3 = index + 1 }
-  WriteLn('    add x3, x0, #1');
-
-  { Load chars from both strings }
-  EmitLdurX0(-8);  { String 1 addr }
-  WriteLn('    ldrb w4, [x0, x3]');
-
-  WriteLn('    ldur x1, [x29, #-16]');
-  WriteLn('    ldrb w5, [x1, x3]');
-
-  { Compare chars }
-  WriteLn('    cmp x4, x5');
-  { b.ne not_equal }
+  EmitLabel(word_lbl);
+  Write('    tbz x2, #3, L'); WriteLn(byte_lbl);
+  WriteLn('    ldr x3, [x0], #8');
+  WriteLn('    ldr x5, [x1], #8');
+  WriteLn('    cmp x3, x5');
   Write('    b.ne L'); WriteLn(not_equal_lbl);
+  WriteLn('    sub x2, x2, #8');
 
-  { Increment index }
-  WriteLn('    ldur x0, [x29, #-32]');
-  WriteLn('    add x0, x0, #1');
-  EmitSturX0(-32);
-  EmitBranchLabel(loop_lbl);
+  EmitLabel(byte_lbl);
+  Write('    cbz x2, L'); WriteLn(equal_lbl);
+  WriteLn('    ldrb w3, [x0], #1');
+  WriteLn('    ldrb w5, [x1], #1');
+  WriteLn('    cmp x3, x5');
+  Write('    b.ne L'); WriteLn(not_equal_lbl);
+  WriteLn('    sub x2, x2, #1');
+  EmitBranchLabel(byte_lbl);
 
   { Equal - return 1 }
-  EmitLabel(done_lbl);
+  EmitLabel(equal_lbl);
   EmitMovX0(1);
-  EmitBranchLabel(label_count);
+  EmitRet;
 
   { Not equal - return 0 }
   EmitLabel(not_equal_lbl);
   EmitMovX0(0);
-
-  EmitLabel(label_count);
-  label_count := label_count + 1;
-  EmitAddSP(32);
-  EmitLdp;
   EmitRet
 End;
 
 Procedure EmitStrConcatRuntime;
-Var
-  loop1_lbl, loop2_lbl, done_lbl: Integer;
 Begin
   { Concatenate strings: x0 = dest, x1 = string1, x2 = string2 }
   { Result Length = len1 + len2 (capped at 255) }
+  { Both parts are copied With rt_move, so string2 is cut where the }
+  { result reaches 255 chars. Returns dest In x0 }
   EmitLabel(rt_str_concat);
   EmitStp;
   EmitMovFP;
-  EmitSubSP(48);
-
-  { Save addresses }
-  EmitSturX0(-8);   { dest }
-  { stur x1, [x29, #-16] - String 1 }
-  WriteLn('    stur x1, [x29, #-16]');
-  { stur x2, [x29, #-24] - String 2 }
-  WriteLn('    stur x2, [x29, #-24]');
+  EmitSubSP(32);
+  { [x29-8] = dest, [x29-16] = string2, [x29-24] = where string2 goes, }
+  { [x29-32] = chars taken from string2 }
+  EmitSturX0(-8);
+  WriteLn('    stur x2, [x29, #-16]');
 
   { Load lengths }
   WriteLn('    ldrb w3, [x1]');
@@ -3343,105 +7468,33 @@ Begin
 
   { Calculate total Length (capped at 255) }
   WriteLn('    add x5, x3, x4');
-  { cmp x5, #255 }
   WriteLn('    cmp x5, #255');
-  { csel x5, x5, x6, le - If x5 <= 255, keep it; Else use 255 }
   WriteLn('    mov x6, #255');
   WriteLn('    csel x5, x5, x6, le');
-
-  { Store total Length To dest }
-  EmitLdurX0(-8);  { dest }
   WriteLn('    strb w5, [x0]');
+  WriteLn('    sub x4, x5, x3');
+  WriteLn('    stur x4, [x29, #-32]');
+  WriteLn('    add x6, x0, x3');
+  WriteLn('    add x6, x6, #1');
+  WriteLn('    stur x6, [x29, #-24]');
 
-  { Save len1 To [x29, #-32] }
-  WriteLn('    stur x3, [x29, #-32]');
-
-  { Initialize index To 0 }
-  EmitMovX0(0);
-  EmitSturX0(-40);
-
-  { Loop 1: copy string1 chars }
-  loop1_lbl := NewLabel;
-  loop2_lbl := NewLabel;
-  done_lbl := NewLabel;
-  EmitLabel(loop1_lbl);
-
-  { Load index And len1 }
-  EmitLdurX0(-40);
-  WriteLn('    ldur x3, [x29, #-32]');
-  { cmp x0, x3 }
-  WriteLn('    cmp x0, x3');
-  { b.ge loop2 }
-  Write('    b.ge L'); WriteLn(loop2_lbl);
-
-  { x7 = index + 1 }
-  WriteLn('    add x7, x0, #1');
-
-  { Load source1 Char }
-  WriteLn('    ldur x1, [x29, #-16]');
-  WriteLn('    ldrb w8, [x1, x7]');
-
-  { Store To dest }
-  EmitLdurX0(-8);
-  WriteLn('    strb w8, [x0, x7]');
-
-  { Increment index }
-  EmitLdurX0(-40);
-  WriteLn('    add x0, x0, #1');
-  EmitSturX0(-40);
-  EmitBranchLabel(loop1_lbl);
-
-  { Loop 2: copy string2 chars }
-  EmitLabel(loop2_lbl);
-  { Reset index To 0 For string2 }
-  EmitMovX0(0);
-  EmitSturX0(-40);
-
-  { Load len2 into x4 }
-  WriteLn('    ldur x2, [x29, #-24]');
-  WriteLn('    ldrb w4, [x2]');
-  { Save len2 To [x29, #-48] }
-  WriteLn('    stur x4, [x29, #-48]');
-
-  { Loop 2 body label }
-  EmitLabel(label_count);
-  label_count := label_count + 1;
-
-  { Load index And len2 }
-  EmitLdurX0(-40);
-  WriteLn('    ldur x4, [x29, #-48]');
-  { cmp x0, x4 }
-  WriteLn('    cmp x0, x4');
-  { b.ge done }
-  Write('    b.ge L'); WriteLn(done_lbl);
-
-  { x7 = index + 1 (source offset) }
-  WriteLn('    add x7, x0, #1');
-
-  { Load source2 Char }
-  WriteLn('    ldur x2, [x29, #-24]');
-  WriteLn('    ldrb w8, [x2, x7]');
-
-  { Calculate dest offset: len1 + index + 1 }
-  EmitLdurX0(-40);  { index }
-  WriteLn('    ldur x3, [x29, #-32]');
-  WriteLn('    add x7, x0, x3');
-  WriteLn('    add x7, x7, #1');
-
-  { Store To dest }
-  EmitLdurX0(-8);
-  WriteLn('    strb w8, [x0, x7]');
+  { Copy string1 chars To dest[1..len1] }
+  WriteLn('    mov x2, x3');
+  WriteLn('    add x3, x0, #1');
+  WriteLn('    add x0, x1, #1');
+  WriteLn('    mov x1, x3');
+  EmitBL(rt_move);
 
-  { Increment index }
-  EmitLdurX0(-40);
+  { Copy string2 chars after them }
+  WriteLn('    ldur x0, [x29, #-16]');
   WriteLn('    add x0, x0, #1');
-  EmitSturX0(-40);
-  EmitBranchLabel(label_count - 1);
+  WriteLn('    ldur x1, [x29, #-24]');
+  WriteLn('    ldur x2, [x29, #-32]');
+  EmitBL(rt_move);
 
-  EmitLabel(done_lbl);
   { Return dest address In x0 }
   EmitLdurX0(-8);
-  EmitAddSP(48);
+  EmitAddSP(32);
   EmitLdp;
   EmitRet
 End;
@@ -3450,198 +7503,331 @@ Procedure EmitStrCmpRuntime;
 { Lexicographic String comparison - returns -1 If x0<x1, 0 If x0=x1, 1 If x0>x1 }
 { Input: x0 = string1 addr, x1 = string2 addr }
 { Output: x0 = -1/0/1 }
+{ Compares 8 chars at a time. A differing word is byte-reversed With }
+{ rev so its first char is the most significant, Then one unsigned }
+{ compare orders the strings. Clobbers x1-x7 }
+{ rt_ansi_cmp does the same For two AnsiStrings And drops them }
 Var
-  loop_lbl, done_lbl, less_lbl, greater_lbl, check_len_lbl: Integer;
+  loop_lbl, byte_lbl, word_diff_lbl, check_len_lbl, less_lbl, greater_lbl: Integer;
+  core_lbl, len1_lbl, len2_lbl: Integer;
 Begin
-  EmitLabel(rt_str_cmp);
-  EmitStp;
-  EmitMovFP;
-  EmitSubSP(32);
-  { stur x0, [x29, #-8]  - string1 }
-  EmitSturX0(-8);
-  { stur x1, [x29, #-16] - string2 }
-  WriteLn('    stur x1, [x29, #-16]');
-
   loop_lbl := NewLabel;
-  done_lbl := NewLabel;
+  byte_lbl := NewLabel;
+  word_diff_lbl := NewLabel;
+  check_len_lbl := NewLabel;
   less_lbl := NewLabel;
   greater_lbl := NewLabel;
-  check_len_lbl := NewLabel;
-
-  { index = 0 }
-  EmitMovX0(0);
-  EmitSturX0(-24);
-
-  EmitLabel(loop_lbl);
-
-  { Load lengths }
-  EmitLdurX0(-8);    { x0 = &s1 }
-  WriteLn('    ldrb w2, [x0]');
-
-  WriteLn('    ldur x1, [x29, #-16]');
-  WriteLn('    ldrb w3, [x1]');
-
-  { Load index }
-  EmitLdurX0(-24);   { x0 = index }
-
-  { If index >= min(len1, len2), check Length }
-  WriteLn('    cmp x0, x2');
-  Write('    b.ge L'); WriteLn(check_len_lbl);
-  WriteLn('    cmp x0, x3');
-  Write('    b.ge L'); WriteLn(check_len_lbl);
-
-  { Compare chars at index+1 }
-  { x4 = index + 1 }
-  WriteLn('    add x4, x0, #1');
-
-  { Load Char from s1 }
-  EmitLdurX0(-8);
-  WriteLn('    ldrb w5, [x0, x4]');
-
-  { Load Char from s2 }
-  WriteLn('    ldur x1, [x29, #-16]');
-  WriteLn('    ldrb w6, [x1, x4]');
-
-  { Compare chars }
-  WriteLn('    cmp x5, x6');
-  Write('    b.lt L'); WriteLn(less_lbl);
-  Write('    b.gt L'); WriteLn(greater_lbl);
-
-  { Chars equal, increment index }
-  EmitLdurX0(-24);
-  WriteLn('    add x0, x0, #1');
-  EmitSturX0(-24);
-  EmitBranchLabel(loop_lbl);
-
-  { Check lengths when all compared chars are equal }
-  EmitLabel(check_len_lbl);
-  EmitLdurX0(-8);
-  WriteLn('    ldrb w2, [x0]');
-  WriteLn('    ldur x1, [x29, #-16]');
-  WriteLn('    ldrb w3, [x1]');
-  WriteLn('    cmp x2, x3');
-  Write('    b.lt L'); WriteLn(less_lbl);
-  Write('    b.gt L'); WriteLn(greater_lbl);
-  { Equal }
-  EmitMovX0(0);
-  EmitBranchLabel(done_lbl);
-
-  EmitLabel(less_lbl);
-  EmitMovX0(0);
-  WriteLn('    sub x0, x0, #1');
-  EmitBranchLabel(done_lbl);
-
-  EmitLabel(greater_lbl);
-  EmitMovX0(1);
-
-  EmitLabel(done_lbl);
-  EmitAddSP(32);
-  EmitLdp;
-  EmitRet
-End;
+  core_lbl := NewLabel;
+  len1_lbl := NewLabel;
+  len2_lbl := NewLabel;
 
-Procedure EmitStrPosRuntime;
-{ Find substring position - returns position (1-based) Or 0 If Not found }
-{ Input: x0 = substring addr, x1 = String addr }
-{ Output: x0 = position (1-based) Or 0 }
-Var
-  outer_lbl, inner_lbl, done_lbl, found_lbl, not_found_lbl, next_pos_lbl: Integer;
-Begin
-  EmitLabel(rt_str_pos);
+  { AnsiStrings: x6/x7 = lengths, chars based one below p+16 }
+  EmitLabel(rt_ansi_cmp);
   EmitStp;
   EmitMovFP;
-  EmitSubSP(48);
-  { [x29-8] = substr, [x29-16] = String, [x29-24] = outer idx, [x29-32] = inner idx }
+  EmitSubSP(16);
   EmitSturX0(-8);
   WriteLn('    stur x1, [x29, #-16]');
-
-  outer_lbl := NewLabel;
-  inner_lbl := NewLabel;
-  done_lbl := NewLabel;
-  found_lbl := NewLabel;
-  not_found_lbl := NewLabel;
-  next_pos_lbl := NewLabel;
-
-  { If substr is empty, return 1 }
-  EmitLdurX0(-8);
-  WriteLn('    ldrb w2, [x0]');
-  Write('    cbz x2, L'); WriteLn(found_lbl);
-  { x2 = substr len }
-  WriteLn('    stur x2, [x29, #-40]');
-
-  { Load String Length }
+  WriteLn('    mov x6, #0');
+  Write('    cbz x0, L'); WriteLn(len1_lbl);
+  WriteLn('    ldr x6, [x0, #8]');
+  EmitLabel(len1_lbl);
+  WriteLn('    mov x7, #0');
+  Write('    cbz x1, L'); WriteLn(len2_lbl);
+  WriteLn('    ldr x7, [x1, #8]');
+  EmitLabel(len2_lbl);
+  WriteLn('    add x0, x0, #15');
+  WriteLn('    add x1, x1, #15');
+  EmitBL(core_lbl);
+  WriteLn('    ldur x1, [x29, #-8]');
+  EmitBL(rt_ansi_drop);
   WriteLn('    ldur x1, [x29, #-16]');
-  WriteLn('    ldrb w3, [x1]');
-  { x3 = String len }
+  EmitBL(rt_ansi_drop);
+  EmitAddSP(16);
+  EmitLdp;
+  EmitRet;
 
-  { outer_idx = 0 (will be 1-based position - 1) }
-  EmitMovX0(0);
-  EmitSturX0(-24);
+  EmitLabel(rt_str_cmp);
+  WriteLn('    ldrb w6, [x0]');
+  WriteLn('    ldrb w7, [x1]');
+  EmitLabel(core_lbl);
+  { x2 = chars To compare = min(len1, len2), x3 = offset Of the next }
+  WriteLn('    cmp x6, x7');
+  WriteLn('    csel x2, x6, x7, lo');
+  WriteLn('    mov x3, #1');
 
-  EmitLabel(outer_lbl);
-  { Check If outer_idx + substr_len > string_len }
-  EmitLdurX0(-24);  { outer_idx }
-  WriteLn('    ldur x2, [x29, #-40]');
-  WriteLn('    add x4, x0, x2');
-  { x4 = outer_idx + substr_len }
-  WriteLn('    ldur x1, [x29, #-16]');
-  WriteLn('    ldrb w3, [x1]');
-  WriteLn('    cmp x4, x3');
-  Write('    b.gt L'); WriteLn(not_found_lbl);
+  EmitLabel(loop_lbl);
+  WriteLn('    cmp x2, #8');
+  Write('    b.lo L'); WriteLn(byte_lbl);
+  WriteLn('    ldr x4, [x0, x3]');
+  WriteLn('    ldr x5, [x1, x3]');
+  WriteLn('    cmp x4, x5');
+  Write('    b.ne L'); WriteLn(word_diff_lbl);
+  WriteLn('    add x3, x3, #8');
+  WriteLn('    sub x2, x2, #8');
+  EmitBranchLabel(loop_lbl);
 
-  { inner_idx = 0 }
-  EmitMovX0(0);
-  EmitSturX0(-32);
+  EmitLabel(word_diff_lbl);
+  WriteLn('    rev x4, x4');
+  WriteLn('    rev x5, x5');
+  WriteLn('    cmp x4, x5');
+  Write('    b.lo L'); WriteLn(less_lbl);
+  EmitBranchLabel(greater_lbl);
 
-  EmitLabel(inner_lbl);
-  { If inner_idx >= substr_len, found! }
-  EmitLdurX0(-32);
-  WriteLn('    ldur x2, [x29, #-40]');
-  WriteLn('    cmp x0, x2');
-  Write('    b.ge L'); WriteLn(found_lbl);
+  { Fewer than 8 chars left }
+  EmitLabel(byte_lbl);
+  Write('    cbz x2, L'); WriteLn(check_len_lbl);
+  WriteLn('    ldrb w4, [x0, x3]');
+  WriteLn('    ldrb w5, [x1, x3]');
+  WriteLn('    cmp x4, x5');
+  Write('    b.lo L'); WriteLn(less_lbl);
+  Write('    b.hi L'); WriteLn(greater_lbl);
+  WriteLn('    add x3, x3, #1');
+  WriteLn('    sub x2, x2, #1');
+  EmitBranchLabel(byte_lbl);
+
+  { Check lengths when all compared chars are equal }
+  EmitLabel(check_len_lbl);
+  WriteLn('    cmp x6, x7');
+  Write('    b.lo L'); WriteLn(less_lbl);
+  Write('    b.hi L'); WriteLn(greater_lbl);
+  { Equal }
+  EmitMovX0(0);
+  EmitRet;
 
-  { Compare substr[inner_idx+1] With String[outer_idx+inner_idx+1] }
-  EmitLdurX0(-8);  { substr addr }
-  WriteLn('    ldur x4, [x29, #-32]');
-  WriteLn('    add x4, x4, #1');
-  WriteLn('    ldrb w5, [x0, x4]');
-  { x5 = substr[inner_idx+1] }
+  EmitLabel(less_lbl);
+  WriteLn('    mov x0, #-1');
+  EmitRet;
 
-  WriteLn('    ldur x1, [x29, #-16]');
-  EmitLdurX0(-24);  { outer_idx }
-  WriteLn('    ldur x4, [x29, #-32]');
-  WriteLn('    add x4, x0, x4');
-  WriteLn('    add x4, x4, #1');
-  WriteLn('    ldrb w6, [x1, x4]');
-  { x6 = String[outer_idx+inner_idx+1] }
+  EmitLabel(greater_lbl);
+  EmitMovX0(1);
+  EmitRet
+End;
 
-  WriteLn('    cmp x5, x6');
-  Write('    b.ne L'); WriteLn(next_pos_lbl);
+Procedure EmitPosVerify(found_lbl, fail_lbl: Integer);
+Var
+  word_lbl, byte_lbl: Integer;
+Begin
+  { Pos: does the substring at x0 occur In the String at x1 at position }
+  { x2? x3 = substring Length. Compares 8 bytes at a time, Then single }
+  { bytes, And branches To found_lbl Or fail_lbl. Clobbers x10-x14 }
+  word_lbl := NewLabel;
+  byte_lbl := NewLabel;
+  WriteLn('    mov x12, x3');
+  WriteLn('    add x13, x0, #1');
+  WriteLn('    add x14, x1, x2');
+  EmitLabel(word_lbl);
+  WriteLn('    cmp x12, #8');
+  Write('    b.lo L'); WriteLn(byte_lbl);
+  WriteLn('    ldr x10, [x13], #8');
+  WriteLn('    ldr x11, [x14], #8');
+  WriteLn('    cmp x10, x11');
+  Write('    b.ne L'); WriteLn(fail_lbl);
+  WriteLn('    sub x12, x12, #8');
+  EmitBranchLabel(word_lbl);
+  EmitLabel(byte_lbl);
+  Write('    cbz x12, L'); WriteLn(found_lbl);
+  WriteLn('    ldrb w10, [x13], #1');
+  WriteLn('    ldrb w11, [x14], #1');
+  WriteLn('    cmp x10, x11');
+  Write('    b.ne L'); WriteLn(fail_lbl);
+  WriteLn('    sub x12, x12, #1');
+  EmitBranchLabel(byte_lbl)
+End;
 
-  { Chars match, increment inner_idx }
-  EmitLdurX0(-32);
-  WriteLn('    add x0, x0, #1');
-  EmitSturX0(-32);
-  EmitBranchLabel(inner_lbl);
+Procedure EmitStrPosRuntime;
+{ Find substring position - returns position (1-based) Or 0 If Not found }
+{ Input: x0 = substring addr, x1 = String addr, And For rt_str_posex }
+{ x2 = position To start searching at }
+{ Output: x0 = position (1-based) Or 0 }
+{ Substrings Of up To 8 chars: scan 8 bytes at a time For the first }
+{ char With the SWAR zero-byte test, Then verify each candidate. Longer }
+{ substrings use Horspool With a 256-byte shift table on the stack. }
+{ rt_ansi_posex takes two AnsiStrings, searches the same way And drops }
+{ them }
+Var
+  empty_lbl, scan_lbl, bytes_lbl, hit_lbl, verify_lbl, next_lbl: Integer;
+  found_lbl: Integer;
+  not_found_lbl, horspool_lbl, fill_lbl, table_lbl, table_done_lbl: Integer;
+  search_lbl, shift_lbl, reload_lbl, h_found_lbl, h_done_lbl: Integer;
+  core_lbl, len1_lbl, len2_lbl: Integer;
+Begin
+  core_lbl := NewLabel;
+  len1_lbl := NewLabel;
+  len2_lbl := NewLabel;
+  empty_lbl := NewLabel;
+  scan_lbl := NewLabel;
+  bytes_lbl := NewLabel;
+  hit_lbl := NewLabel;
+  verify_lbl := NewLabel;
+  next_lbl := NewLabel;
+  found_lbl := NewLabel;
+  not_found_lbl := NewLabel;
+  horspool_lbl := NewLabel;
+  fill_lbl := NewLabel;
+  table_lbl := NewLabel;
+  table_done_lbl := NewLabel;
+  search_lbl := NewLabel;
+  shift_lbl := NewLabel;
+  reload_lbl := NewLabel;
+  h_found_lbl := NewLabel;
+  h_done_lbl := NewLabel;
+
+  { AnsiStrings: x3/x4 = lengths, chars based one below p+16 }
+  EmitLabel(rt_ansi_posex);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(16);
+  EmitSturX0(-8);
+  WriteLn('    stur x1, [x29, #-16]');
+  WriteLn('    mov x3, #0');
+  Write('    cbz x0, L'); WriteLn(len1_lbl);
+  WriteLn('    ldr x3, [x0, #8]');
+  EmitLabel(len1_lbl);
+  WriteLn('    mov x4, #0');
+  Write('    cbz x1, L'); WriteLn(len2_lbl);
+  WriteLn('    ldr x4, [x1, #8]');
+  EmitLabel(len2_lbl);
+  WriteLn('    add x0, x0, #15');
+  WriteLn('    add x1, x1, #15');
+  EmitBL(core_lbl);
+  WriteLn('    ldur x1, [x29, #-8]');
+  EmitBL(rt_ansi_drop);
+  WriteLn('    ldur x1, [x29, #-16]');
+  EmitBL(rt_ansi_drop);
+  EmitAddSP(16);
+  EmitLdp;
+  EmitRet;
 
-  EmitLabel(next_pos_lbl);
-  { Chars don't match, try next outer position }
-  EmitLdurX0(-24);
-  WriteLn('    add x0, x0, #1');
-  EmitSturX0(-24);
-  EmitBranchLabel(outer_lbl);
+  { Pos searches from position 1 }
+  EmitLabel(rt_str_pos);
+  WriteLn('    mov x2, #1');
+  EmitLabel(rt_str_posex);
+  { x3 = substring Length, x4 = String Length }
+  WriteLn('    ldrb w3, [x0]');
+  WriteLn('    ldrb w4, [x1]');
+  EmitLabel(core_lbl);
+  WriteLn('    cmp x2, #1');
+  Write('    b.lt L'); WriteLn(not_found_lbl);
+  Write('    cbz x3, L'); WriteLn(empty_lbl);
+  { x5 = last position where the substring still fits }
+  WriteLn('    sub x5, x4, x3');
+  WriteLn('    add x5, x5, #1');
+  WriteLn('    cmp x2, x5');
+  Write('    b.gt L'); WriteLn(not_found_lbl);
+  WriteLn('    cmp x3, #8');
+  Write('    b.hi L'); WriteLn(horspool_lbl);
+
+  { x6 = first char, x8 = it In every byte, x7 = 0x01.., x9 = 0x80.. }
+  WriteLn('    ldrb w6, [x0, #1]');
+  WriteLn('    mov x7, #0x0101010101010101');
+  WriteLn('    mov x9, #0x8080808080808080');
+  WriteLn('    mul x8, x6, x7');
+  EmitLabel(scan_lbl);
+  { Only whole words Of candidate positions, so no load passes the End }
+  WriteLn('    add x10, x2, #7');
+  WriteLn('    cmp x10, x5');
+  Write('    b.gt L'); WriteLn(bytes_lbl);
+  WriteLn('    ldr x10, [x1, x2]');
+  WriteLn('    eor x10, x10, x8');
+  WriteLn('    sub x11, x10, x7');
+  WriteLn('    bic x11, x11, x10');
+  WriteLn('    and x11, x11, x9');
+  Write('    cbnz x11, L'); WriteLn(hit_lbl);
+  WriteLn('    add x2, x2, #8');
+  EmitBranchLabel(scan_lbl);
+  { The lowest flagged byte is the first match In the word }
+  EmitLabel(hit_lbl);
+  WriteLn('    rbit x11, x11');
+  WriteLn('    clz x11, x11');
+  WriteLn('    add x2, x2, x11, lsr #3');
+  EmitLabel(verify_lbl);
+  EmitPosVerify(found_lbl, next_lbl);
+  EmitLabel(next_lbl);
+  WriteLn('    add x2, x2, #1');
+  EmitBranchLabel(scan_lbl);
+  { Fewer than 8 positions left: one byte at a time }
+  EmitLabel(bytes_lbl);
+  WriteLn('    cmp x2, x5');
+  Write('    b.gt L'); WriteLn(not_found_lbl);
+  WriteLn('    ldrb w10, [x1, x2]');
+  WriteLn('    cmp x10, x6');
+  Write('    b.eq L'); WriteLn(verify_lbl);
+  WriteLn('    add x2, x2, #1');
+  EmitBranchLabel(bytes_lbl);
 
+  { An empty substring matches at the start position, up To Length+1 }
+  EmitLabel(empty_lbl);
+  WriteLn('    add x5, x4, #1');
+  WriteLn('    cmp x2, x5');
+  Write('    b.gt L'); WriteLn(not_found_lbl);
   EmitLabel(found_lbl);
-  { Return outer_idx + 1 (1-based position) }
-  EmitLdurX0(-24);
-  WriteLn('    add x0, x0, #1');
-  EmitBranchLabel(done_lbl);
-
+  WriteLn('    mov x0, x2');
+  EmitRet;
   EmitLabel(not_found_lbl);
   EmitMovX0(0);
+  EmitRet;
 
-  EmitLabel(done_lbl);
-  EmitAddSP(48);
+  { Horspool: table[c] = how far the window may move when its last char }
+  { is c, the substring Length For chars Not In substring[1..m-1]. The }
+  { shifts are capped at 255 To fit a byte, which only shortens them For }
+  { AnsiString substrings over 255 chars }
+  EmitLabel(horspool_lbl);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(256);
+  WriteLn('    mov x13, #255');
+  WriteLn('    cmp x3, x13');
+  WriteLn('    csel x13, x3, x13, lo');
+  WriteLn('    mov x7, #0x0101010101010101');
+  WriteLn('    mul x10, x13, x7');
+  WriteLn('    mov x11, sp');
+  WriteLn('    mov x12, #16');
+  EmitLabel(fill_lbl);
+  WriteLn('    stp x10, x10, [x11], #16');
+  WriteLn('    subs x12, x12, #1');
+  Write('    b.ne L'); WriteLn(fill_lbl);
+  { Start at m - cap + 1, so later chars (smaller shifts) win }
+  WriteLn('    sub x12, x3, x13');
+  WriteLn('    add x12, x12, #1');
+  EmitLabel(table_lbl);
+  WriteLn('    cmp x12, x3');
+  Write('    b.hs L'); WriteLn(table_done_lbl);
+  WriteLn('    ldrb w10, [x0, x12]');
+  WriteLn('    sub x11, x3, x12');
+  WriteLn('    strb w11, [sp, x10]');
+  WriteLn('    add x12, x12, #1');
+  EmitBranchLabel(table_lbl);
+  EmitLabel(table_done_lbl);
+  { x6 = last char Of the substring }
+  WriteLn('    ldrb w6, [x0, x3]');
+
+  EmitLabel(search_lbl);
+  WriteLn('    cmp x2, x5');
+  Write('    b.gt L'); WriteLn(h_done_lbl);
+  WriteLn('    add x10, x2, x3');
+  WriteLn('    sub x10, x10, #1');
+  WriteLn('    ldrb w10, [x1, x10]');
+  WriteLn('    cmp x10, x6');
+  Write('    b.ne L'); WriteLn(shift_lbl);
+  EmitPosVerify(h_found_lbl, reload_lbl);
+  EmitLabel(reload_lbl);
+  WriteLn('    add x10, x2, x3');
+  WriteLn('    sub x10, x10, #1');
+  WriteLn('    ldrb w10, [x1, x10]');
+  EmitLabel(shift_lbl);
+  WriteLn('    ldrb w10, [sp, x10]');
+  WriteLn('    add x2, x2, x10');
+  EmitBranchLabel(search_lbl);
+
+  EmitLabel(h_found_lbl);
+  WriteLn('    mov x0, x2');
+  EmitAddSP(256);
+  EmitLdp;
+  EmitRet;
+  EmitLabel(h_done_lbl);
+  EmitMovX0(0);
+  EmitAddSP(256);
   EmitLdp;
   EmitRet
 End;
@@ -3649,163 +7835,453 @@ End;
 Procedure EmitStrDeleteRuntime;
 { Delete chars from String In place }
 { Input: x0 = String addr, x1 = start (1-based), x2 = count }
+{ Like Turbo Pascal, a start outside 1..Length Or a count below 1 }
+{ deletes nothing, And a count past the End deletes To the End. The }
+{ chars after the gap move down With one rt_move. Clobbers x0-x6 }
 Var
-  loop_lbl, done_lbl: Integer;
+  done_lbl: Integer;
 Begin
   EmitLabel(rt_str_delete);
-  EmitStp;
-  EmitMovFP;
-  EmitSubSP(48);
-  { [x29-8]=String, [x29-16]=start, [x29-24]=count, [x29-32]=len, [x29-40]=idx }
-  EmitSturX0(-8);
-  WriteLn('    stur x1, [x29, #-16]');
-  WriteLn('    stur x2, [x29, #-24]');
-
-  loop_lbl := NewLabel;
   done_lbl := NewLabel;
 
-  { Load String Length }
-  WriteLn('    ldrb w3, [x0]');
-  WriteLn('    stur x3, [x29, #-32]');
   { x3 = len }
-
-  { idx = start }
-  WriteLn('    ldur x0, [x29, #-16]');
-  EmitSturX0(-40);
-
-  EmitLabel(loop_lbl);
-  { If idx + count > len, done }
-  EmitLdurX0(-40);  { idx }
-  WriteLn('    ldur x2, [x29, #-24]');
-  WriteLn('    add x4, x0, x2');
-  WriteLn('    ldur x3, [x29, #-32]');
-  WriteLn('    cmp x4, x3');
+  WriteLn('    ldrb w3, [x0]');
+  WriteLn('    cmp x1, #1');
+  Write('    b.lt L'); WriteLn(done_lbl);
+  WriteLn('    cmp x1, x3');
   Write('    b.gt L'); WriteLn(done_lbl);
+  WriteLn('    cmp x2, #1');
+  Write('    b.lt L'); WriteLn(done_lbl);
 
-  { Copy Char from idx+count To idx }
-  EmitLdurX0(-8);  { String addr }
-  EmitLdurX0(-40);  { idx }
-  { RELOAD String addr since we overwrote x0 }
-  WriteLn('    ldur x1, [x29, #-8]');
-  WriteLn('    ldur x2, [x29, #-24]');
-  WriteLn('    add x3, x0, x2');
-  { x3 = idx + count (source position) }
-  { Load Char from String[idx+count] }
-  WriteLn('    ldrb w4, [x1, x3]');
-  { Store To String[idx] }
-  WriteLn('    strb w4, [x1, x0]');
+  { x4 = chars from start To the End, count = min(count, x4) }
+  WriteLn('    sub x4, x3, x1');
+  WriteLn('    add x4, x4, #1');
+  WriteLn('    cmp x2, x4');
+  WriteLn('    csel x2, x2, x4, lo');
+  { new_len = old_len - count }
+  WriteLn('    sub x3, x3, x2');
+  WriteLn('    strb w3, [x0]');
 
-  { idx++ }
-  EmitLdurX0(-40);
-  WriteLn('    add x0, x0, #1');
-  EmitSturX0(-40);
-  EmitBranchLabel(loop_lbl);
+  { Move String[start+count..len] down To String[start] }
+  WriteLn('    add x1, x0, x1');
+  WriteLn('    add x0, x1, x2');
+  WriteLn('    sub x2, x4, x2');
+  EmitBranchLabel(rt_move);
 
   EmitLabel(done_lbl);
-  { Update String Length: new_len = old_len - count }
-  WriteLn('    ldur x3, [x29, #-32]');
-  WriteLn('    ldur x2, [x29, #-24]');
-  WriteLn('    sub x0, x3, x2');
-  EmitLdurX0(-8);
-  { RELOAD x0 For store since we overwrote it }
-  WriteLn('    ldur x3, [x29, #-32]');
-  WriteLn('    ldur x2, [x29, #-24]');
-  WriteLn('    sub x4, x3, x2');
-  WriteLn('    ldur x1, [x29, #-8]');
-  WriteLn('    strb w4, [x1]');
-
-  EmitAddSP(48);
-  EmitLdp;
   EmitRet
 End;
 
 Procedure EmitStrInsertRuntime;
 { Insert String into another at position }
 { Input: x0 = source String, x1 = dest String, x2 = position (1-based) }
-Var
-  loop1_lbl, loop2_lbl, copy_lbl, done_lbl: Integer;
+{ Like Turbo Pascal, the position is clamped To 1..Length+1 And the }
+{ result is cut at 255 chars. The tail Of dest And the source each move }
+{ With one rt_move }
 Begin
   EmitLabel(rt_str_insert);
   EmitStp;
   EmitMovFP;
-  EmitSubSP(64);
-  { [x29-8]=source, [x29-16]=dest, [x29-24]=pos, [x29-32]=src_len, [x29-40]=dst_len, [x29-48]=idx }
+  EmitSubSP(32);
+
+  { Load lengths: x3 = src_len, x4 = dst_len }
+  WriteLn('    ldrb w3, [x0]');
+  WriteLn('    ldrb w4, [x1]');
+
+  { pos = max(pos, 1), pos = min(pos, dst_len + 1) }
+  WriteLn('    mov x5, #1');
+  WriteLn('    cmp x2, x5');
+  WriteLn('    csel x2, x2, x5, ge');
+  WriteLn('    add x5, x4, #1');
+  WriteLn('    cmp x2, x5');
+  WriteLn('    csel x2, x2, x5, le');
+
+  { new_len = min(dst_len + src_len, 255) }
+  WriteLn('    add x6, x4, x3');
+  WriteLn('    cmp x6, #255');
+  WriteLn('    mov x5, #255');
+  WriteLn('    csel x6, x6, x5, le');
+  WriteLn('    strb w6, [x1]');
+
+  { x5 = room from pos To char 255, x6 = source chars that fit }
+  WriteLn('    mov x5, #256');
+  WriteLn('    sub x5, x5, x2');
+  WriteLn('    cmp x3, x5');
+  WriteLn('    csel x6, x3, x5, lt');
+  { x4 = tail chars dest[pos..dst_len] that still fit after the source }
+  WriteLn('    sub x7, x5, x3');
+  WriteLn('    sub x4, x4, x2');
+  WriteLn('    add x4, x4, #1');
+  WriteLn('    cmp x4, x7');
+  WriteLn('    csel x4, x4, x7, lt');
+  WriteLn('    cmp x4, #0');
+  WriteLn('    csel x4, x4, xzr, gt');
+
+  { [x29-8]=source, [x29-16]=dest, [x29-24]=pos, [x29-32]=source chars }
   EmitSturX0(-8);
   WriteLn('    stur x1, [x29, #-16]');
   WriteLn('    stur x2, [x29, #-24]');
+  WriteLn('    stur x6, [x29, #-32]');
 
-  loop1_lbl := NewLabel;
-  loop2_lbl := NewLabel;
-  copy_lbl := NewLabel;
-  done_lbl := NewLabel;
+  { Shift the tail right by src_len }
+  WriteLn('    add x0, x1, x2');
+  WriteLn('    add x1, x0, x3');
+  WriteLn('    mov x2, x4');
+  EmitBL(rt_move);
 
-  { Load lengths }
-  WriteLn('    ldrb w3, [x0]');
-  WriteLn('    stur x3, [x29, #-32]');
-  WriteLn('    ldrb w4, [x1]');
-  WriteLn('    stur x4, [x29, #-40]');
+  { Copy source chars To dest[pos..] }
+  EmitLdurX0(-8);
+  WriteLn('    add x0, x0, #1');
+  WriteLn('    ldur x1, [x29, #-16]');
+  WriteLn('    ldur x2, [x29, #-24]');
+  WriteLn('    add x1, x1, x2');
+  WriteLn('    ldur x2, [x29, #-32]');
+  EmitBL(rt_move);
 
-  { Move existing chars from pos To End, shifting right by src_len }
-  { idx = dst_len }
-  WriteLn('    stur x4, [x29, #-48]');
+  EmitAddSP(32);
+  EmitLdp;
+  EmitRet
+End;
 
-  EmitLabel(loop1_lbl);
-  { If idx < pos, done moving }
-  EmitLdurX0(-48);  { idx }
-  WriteLn('    ldur x2, [x29, #-24]');
-  WriteLn('    cmp x0, x2');
-  Write('    b.lt L'); WriteLn(loop2_lbl);
+Procedure EmitAnsiRefRuntime;
+{ AnsiString records come from rt_alloc: [p] reference count, [p+8] }
+{ Length, the chars from p+16. Nil is the empty String. Each variable }
+{ owns one reference; a record With count 0 is a temp, And whatever }
+{ consumes it frees it With rt_ansi_drop }
+Var
+  add_done_lbl, rel_done_lbl, rel_free_lbl, unref_done_lbl: Integer;
+  drop_done_lbl, assign_lbl, unique_done_lbl: Integer;
+Begin
+  add_done_lbl := NewLabel;
+  rel_done_lbl := NewLabel;
+  rel_free_lbl := NewLabel;
+  unref_done_lbl := NewLabel;
+  drop_done_lbl := NewLabel;
+  assign_lbl := NewLabel;
+  unique_done_lbl := NewLabel;
+
+  { rt_ansi_new: x0 = Length -> x0 = temp record Of that Length }
+  EmitLabel(rt_ansi_new);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(16);
+  EmitSturX0(-8);
+  WriteLn('    add x0, x0, #16');
+  EmitBL(rt_alloc);
+  WriteLn('    ldur x1, [x29, #-8]');
+  WriteLn('    stp xzr, x1, [x0]');
+  EmitAddSP(16);
+  EmitLdp;
+  EmitRet;
+
+  { rt_ansi_addref: x0 = record Or Nil, kept. Clobbers x1 }
+  EmitLabel(rt_ansi_addref);
+  Write('    cbz x0, L'); WriteLn(add_done_lbl);
+  WriteLn('    ldr x1, [x0]');
+  WriteLn('    add x1, x1, #1');
+  WriteLn('    str x1, [x0]');
+  EmitLabel(add_done_lbl);
+  EmitRet;
+
+  { rt_ansi_release: x0 = record Or Nil, freed With its last reference }
+  EmitLabel(rt_ansi_release);
+  Write('    cbz x0, L'); WriteLn(rel_done_lbl);
+  WriteLn('    ldr x1, [x0]');
+  WriteLn('    subs x1, x1, #1');
+  Write('    b.le L'); WriteLn(rel_free_lbl);
+  WriteLn('    str x1, [x0]');
+  EmitLabel(rel_done_lbl);
+  EmitRet;
+  EmitLabel(rel_free_lbl);
+  EmitBranchLabel(rt_free);
+
+  { rt_ansi_unref: x0 = Function result, kept. Gives up the result }
+  { variable's reference without freeing, so an unshared result becomes }
+  { a temp For the caller }
+  EmitLabel(rt_ansi_unref);
+  Write('    cbz x0, L'); WriteLn(unref_done_lbl);
+  WriteLn('    ldr x1, [x0]');
+  WriteLn('    sub x1, x1, #1');
+  WriteLn('    str x1, [x0]');
+  EmitLabel(unref_done_lbl);
+  EmitRet;
+
+  { rt_ansi_drop: x1 = record Or Nil, freed If it is a temp. Keeps x0 }
+  EmitLabel(rt_ansi_drop);
+  Write('    cbz x1, L'); WriteLn(drop_done_lbl);
+  WriteLn('    ldr x2, [x1]');
+  Write('    cbnz x2, L'); WriteLn(drop_done_lbl);
+  EmitStp;
+  WriteLn('    str x0, [sp, #-16]!');
+  WriteLn('    mov x0, x1');
+  EmitBL(rt_free);
+  WriteLn('    ldr x0, [sp], #16');
+  EmitLdp;
+  EmitLabel(drop_done_lbl);
+  EmitRet;
 
-  { Copy dest[idx] To dest[idx+src_len] }
+  { rt_ansi_assign: x0 = New value, x1 = address Of the variable. Takes }
+  { a reference To the New value before releasing the old one, so }
+  { s := s is safe }
+  EmitLabel(rt_ansi_assign);
+  Write('    cbz x0, L'); WriteLn(assign_lbl);
+  WriteLn('    ldr x2, [x0]');
+  WriteLn('    add x2, x2, #1');
+  WriteLn('    str x2, [x0]');
+  EmitLabel(assign_lbl);
+  WriteLn('    ldr x2, [x1]');
+  WriteLn('    str x0, [x1]');
+  WriteLn('    mov x0, x2');
+  EmitBranchLabel(rt_ansi_release);
+
+  { rt_ansi_unique: x0 = address Of the variable -> x0 = its record, }
+  { copied first If another variable shares it (copy-on-write) }
+  EmitLabel(rt_ansi_unique);
+  WriteLn('    mov x2, x0');
+  WriteLn('    ldr x0, [x2]');
+  Write('    cbz x0, L'); WriteLn(unique_done_lbl);
+  WriteLn('    ldr x1, [x0]');
+  WriteLn('    cmp x1, #1');
+  Write('    b.ls L'); WriteLn(unique_done_lbl);
+  { Shared: the others keep the old record, this variable gets a copy }
+  WriteLn('    sub x1, x1, #1');
+  WriteLn('    str x1, [x0]');
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(16);
+  EmitSturX0(-8);
+  WriteLn('    stur x2, [x29, #-16]');
+  WriteLn('    ldr x0, [x0, #8]');
+  EmitBL(rt_ansi_new);
+  WriteLn('    mov x1, #1');
+  WriteLn('    str x1, [x0]');
   WriteLn('    ldur x1, [x29, #-16]');
-  WriteLn('    ldrb w5, [x1, x0]');
-  WriteLn('    ldur x3, [x29, #-32]');
-  WriteLn('    add x6, x0, x3');
-  WriteLn('    strb w5, [x1, x6]');
+  WriteLn('    str x0, [x1]');
+  WriteLn('    stur x0, [x29, #-16]');
+  WriteLn('    ldr x2, [x0, #8]');
+  WriteLn('    add x1, x0, #16');
+  EmitLdurX0(-8);
+  WriteLn('    add x0, x0, #16');
+  EmitBL(rt_move);
+  EmitLdurX0(-16);
+  EmitAddSP(16);
+  EmitLdp;
+  EmitLabel(unique_done_lbl);
+  EmitRet
+End;
 
-  { idx-- }
-  EmitLdurX0(-48);
-  WriteLn('    sub x0, x0, #1');
-  EmitSturX0(-48);
-  EmitBranchLabel(loop1_lbl);
+Procedure EmitAnsiConvRuntime;
+{ Conversions between AnsiString And String Or Char, And Write For }
+{ AnsiStrings }
+Var
+  from_lbl, empty_lbl, cut_lbl, print_done_lbl: Integer;
+Begin
+  from_lbl := NewLabel;
+  empty_lbl := NewLabel;
+  cut_lbl := NewLabel;
+  print_done_lbl := NewLabel;
 
-  EmitLabel(loop2_lbl);
-  { Now copy source chars To position pos...pos+src_len-1 }
-  { idx = 0 }
+  { rt_ansi_from_short: x0 = String addr -> x0 = temp record Or Nil. }
+  { Keeps x1 }
+  EmitLabel(rt_ansi_from_short);
+  WriteLn('    ldrb w2, [x0]');
+  Write('    cbnz x2, L'); WriteLn(from_lbl);
   EmitMovX0(0);
-  EmitSturX0(-48);
-
-  EmitLabel(copy_lbl);
-  { If idx >= src_len, done }
-  EmitLdurX0(-48);
-  WriteLn('    ldur x3, [x29, #-32]');
-  WriteLn('    cmp x0, x3');
-  Write('    b.ge L'); WriteLn(done_lbl);
+  EmitRet;
+  EmitLabel(from_lbl);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(16);
+  EmitSturX0(-8);
+  WriteLn('    stur x1, [x29, #-16]');
+  WriteLn('    mov x0, x2');
+  EmitBL(rt_ansi_new);
+  WriteLn('    ldur x1, [x29, #-8]');
+  EmitSturX0(-8);
+  WriteLn('    ldr x2, [x0, #8]');
+  WriteLn('    add x3, x0, #16');
+  WriteLn('    add x0, x1, #1');
+  WriteLn('    mov x1, x3');
+  EmitBL(rt_move);
+  EmitLdurX0(-8);
+  WriteLn('    ldur x1, [x29, #-16]');
+  EmitAddSP(16);
+  EmitLdp;
+  EmitRet;
 
-  { Copy source[idx+1] To dest[pos+idx] }
-  WriteLn('    ldur x5, [x29, #-8]');
-  WriteLn('    add x6, x0, #1');
-  WriteLn('    ldrb w7, [x5, x6]');
+  { rt_ansi_from_char: x0 = Char -> x0 = temp record. Keeps x1 }
+  EmitLabel(rt_ansi_from_char);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(16);
+  EmitSturX0(-8);
+  WriteLn('    stur x1, [x29, #-16]');
+  EmitMovX0(1);
+  EmitBL(rt_ansi_new);
+  WriteLn('    ldur x1, [x29, #-8]');
+  WriteLn('    strb w1, [x0, #16]');
   WriteLn('    ldur x1, [x29, #-16]');
-  WriteLn('    ldur x2, [x29, #-24]');
-  WriteLn('    add x6, x2, x0');
-  WriteLn('    strb w7, [x1, x6]');
+  EmitAddSP(16);
+  EmitLdp;
+  EmitRet;
 
-  { idx++ }
-  EmitLdurX0(-48);
-  WriteLn('    add x0, x0, #1');
-  EmitSturX0(-48);
-  EmitBranchLabel(copy_lbl);
+  { rt_ansi_to_short: x0 = record Or Nil -> x0 = temp String, cut at }
+  { 255 chars. Drops the record }
+  EmitLabel(rt_ansi_to_short);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(16);
+  EmitSturX0(-8);
+  WriteLn('    mov x1, x21');
+  WriteLn('    add x21, x21, #256');
+  WriteLn('    stur x1, [x29, #-16]');
+  EmitMovX0(0);
+  WriteLn('    mov x2, #0');
+  WriteLn('    ldur x3, [x29, #-8]');
+  Write('    cbz x3, L'); WriteLn(cut_lbl);
+  WriteLn('    ldr x2, [x3, #8]');
+  WriteLn('    mov x4, #255');
+  WriteLn('    cmp x2, x4');
+  WriteLn('    csel x2, x2, x4, ls');
+  WriteLn('    add x0, x3, #16');
+  EmitLabel(cut_lbl);
+  WriteLn('    strb w2, [x1], #1');
+  EmitBL(rt_move);
+  WriteLn('    ldur x1, [x29, #-8]');
+  EmitLdurX0(-16);
+  EmitBL(rt_ansi_drop);
+  EmitAddSP(16);
+  EmitLdp;
+  EmitRet;
+
+  { rt_print_ansi: x0 = record Or Nil, written out In one go. Drops it }
+  EmitLabel(rt_print_ansi);
+  Write('    cbz x0, L'); WriteLn(print_done_lbl);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(16);
+  EmitSturX0(-8);
+  WriteLn('    ldr x2, [x0, #8]');
+  WriteLn('    add x1, x0, #16');
+  EmitBL(rt_write_buf);
+  WriteLn('    ldur x1, [x29, #-8]');
+  EmitBL(rt_ansi_drop);
+  EmitAddSP(16);
+  EmitLdp;
+  EmitLabel(print_done_lbl);
+  EmitRet
+End;
+
+Procedure EmitAnsiConcatRuntime;
+{ AnsiString concatenation: x0 = left, x1 = right -> x0 = result }
+{ An empty side gives back the other side without copying. Drops both }
+Var
+  left_empty_lbl, done_lbl: Integer;
+Begin
+  left_empty_lbl := NewLabel;
+  done_lbl := NewLabel;
+  EmitLabel(rt_ansi_concat);
+  Write('    cbz x0, L'); WriteLn(left_empty_lbl);
+  Write('    cbz x1, L'); WriteLn(done_lbl);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(32);
+  { [x29-8] = left, [x29-16] = right, [x29-24] = result }
+  EmitSturX0(-8);
+  WriteLn('    stur x1, [x29, #-16]');
+  WriteLn('    ldr x2, [x0, #8]');
+  WriteLn('    ldr x3, [x1, #8]');
+  WriteLn('    add x0, x2, x3');
+  EmitBL(rt_ansi_new);
+  WriteLn('    stur x0, [x29, #-24]');
+  { Left chars To the start }
+  WriteLn('    ldur x3, [x29, #-8]');
+  WriteLn('    ldr x2, [x3, #8]');
+  WriteLn('    add x1, x0, #16');
+  WriteLn('    add x0, x3, #16');
+  EmitBL(rt_move);
+  { Right chars after them }
+  WriteLn('    ldur x3, [x29, #-8]');
+  WriteLn('    ldr x4, [x3, #8]');
+  WriteLn('    ldur x1, [x29, #-24]');
+  WriteLn('    add x1, x1, #16');
+  WriteLn('    add x1, x1, x4');
+  WriteLn('    ldur x3, [x29, #-16]');
+  WriteLn('    ldr x2, [x3, #8]');
+  WriteLn('    add x0, x3, #16');
+  EmitBL(rt_move);
+  EmitLdurX0(-24);
+  WriteLn('    ldur x1, [x29, #-8]');
+  EmitBL(rt_ansi_drop);
+  WriteLn('    ldur x1, [x29, #-16]');
+  EmitBL(rt_ansi_drop);
+  EmitAddSP(32);
+  EmitLdp;
+  EmitRet;
+  EmitLabel(left_empty_lbl);
+  WriteLn('    mov x0, x1');
+  EmitLabel(done_lbl);
+  EmitRet
+End;
 
+Procedure EmitAnsiCopyRuntime;
+{ Copy For AnsiStrings: x0 = record, x1 = index, x2 = count -> x0 = }
+{ result. An index below 1 counts from 1 And the count is cut at the }
+{ End; a copy Of the whole String shares the record. Drops the source }
+Var
+  len_lbl, empty_lbl, whole_lbl, done_lbl: Integer;
+Begin
+  len_lbl := NewLabel;
+  empty_lbl := NewLabel;
+  whole_lbl := NewLabel;
+  done_lbl := NewLabel;
+  EmitLabel(rt_ansi_copy);
+  EmitStp;
+  EmitMovFP;
+  EmitSubSP(32);
+  { [x29-8] = source, [x29-16] = index, [x29-24] = count, [x29-32] = result }
+  EmitSturX0(-8);
+  WriteLn('    mov x3, #0');
+  Write('    cbz x0, L'); WriteLn(len_lbl);
+  WriteLn('    ldr x3, [x0, #8]');
+  EmitLabel(len_lbl);
+  { index = max(index, 1), count = min(count, len - index + 1) }
+  WriteLn('    mov x4, #1');
+  WriteLn('    cmp x1, x4');
+  WriteLn('    csel x1, x1, x4, ge');
+  WriteLn('    sub x4, x3, x1');
+  WriteLn('    add x4, x4, #1');
+  WriteLn('    cmp x2, x4');
+  WriteLn('    csel x2, x2, x4, lt');
+  WriteLn('    cmp x2, #0');
+  Write('    b.le L'); WriteLn(empty_lbl);
+  WriteLn('    cmp x2, x3');
+  Write('    b.eq L'); WriteLn(whole_lbl);
+  WriteLn('    stur x1, [x29, #-16]');
+  WriteLn('    stur x2, [x29, #-24]');
+  WriteLn('    mov x0, x2');
+  EmitBL(rt_ansi_new);
+  WriteLn('    stur x0, [x29, #-32]');
+  WriteLn('    add x1, x0, #16');
+  WriteLn('    ldur x2, [x29, #-24]');
+  EmitLdurX0(-8);
+  WriteLn('    ldur x3, [x29, #-16]');
+  WriteLn('    add x0, x0, x3');
+  WriteLn('    add x0, x0, #15');
+  EmitBL(rt_move);
+  EmitLdurX0(-32);
+  WriteLn('    ldur x1, [x29, #-8]');
+  EmitBL(rt_ansi_drop);
+  EmitBranchLabel(done_lbl);
+  EmitLabel(empty_lbl);
+  EmitMovX0(0);
+  WriteLn('    ldur x1, [x29, #-8]');
+  EmitBL(rt_ansi_drop);
+  EmitBranchLabel(done_lbl);
+  EmitLabel(whole_lbl);
+  EmitLdurX0(-8);
   EmitLabel(done_lbl);
-  { Update dest Length: new_len = dst_len + src_len }
-  WriteLn('    ldur x3, [x29, #-32]');
-  WriteLn('    ldur x4, [x29, #-40]');
-  WriteLn('    add x0, x3, x4');
-  WriteLn('    ldur x1, [x29, #-16]');
-  WriteLn('    strb w0, [x1]');
-
-  EmitAddSP(64);
+  EmitAddSP(32);
   EmitLdp;
   EmitRet
 End;
@@ -3814,197 +8290,88 @@ End;
 { x0 = Integer value, x1 = destination String address }
 Procedure EmitIntToStrRuntime;
 Var
-  done_lbl, neg_lbl, pos_lbl, loop_lbl, rev_lbl, rev_done_lbl: Integer;
+  loop_lbl, done_lbl: Integer;
 Begin
   EmitLabel(rt_int_to_str);
   EmitStp;
   EmitMovFP;
   EmitSubSP(48);
 
-  done_lbl := NewLabel;
-  neg_lbl := NewLabel;
-  pos_lbl := NewLabel;
   loop_lbl := NewLabel;
-  rev_lbl := NewLabel;
-  rev_done_lbl := NewLabel;
-
-  { Save dest String address }
-  WriteLn('    stur x1, [x29, #-16]');
-
-  { x2 = digit count, x3 = is_negative }
-  WriteLn('    mov x2, #0');
-  WriteLn('    mov x3, #0');
-
-  { Check If value is negative }
-  WriteLn('    cmp x0, #0');
-  Write('    b.lt L'); WriteLn(neg_lbl);
-  Write('    b L'); WriteLn(pos_lbl);
+  done_lbl := NewLabel;
 
-  { Handle negative }
-  EmitLabel(neg_lbl);
-  WriteLn('    neg x0, x0');
-  WriteLn('    mov x3, #1');
+  { Save dest String address, format below it }
+  WriteLn('    stur x1, [x29, #-8]');
+  WriteLn('    sub x1, x29, #8');
+  EmitBL(rt_fmt_int);
 
-  { Loop To extract digits (stored In reverse on stack) }
-  EmitLabel(pos_lbl);
+  { Store Length, Then copy x2 chars from x1 To dest + 1 }
+  WriteLn('    ldur x4, [x29, #-8]');
+  WriteLn('    strb w2, [x4], #1');
   EmitLabel(loop_lbl);
-  { x4 = x0 / 10, x5 = x0 Mod 10 }
-  WriteLn('    mov x6, #10');
-  WriteLn('    udiv x4, x0, x6');
-  WriteLn('    msub x5, x4, x6, x0');
-
-  { Convert digit To ASCII And store on stack }
-  WriteLn('    add x5, x5, #48');
-
-  { Store digit at sp + x2 }
-  WriteLn('    strb w5, [sp, x2]');
-
-  { Increment digit count }
-  WriteLn('    add x2, x2, #1');
-
-  { x0 = x4 (quotient), Continue If x0 > 0 }
-  WriteLn('    mov x0, x4');
-  WriteLn('    cmp x0, #0');
-  Write('    b.ne L'); WriteLn(loop_lbl);
-
-  { Now reverse digits into destination String }
-  { x1 = dest String, x4 = Write position (starts at 1 If no sign, 2 If negative) }
-  WriteLn('    ldur x1, [x29, #-16]');
-
-  { If negative, store '-' at position 1, start digits at 2 }
-  WriteLn('    cmp x3, #0');
-  Write('    b.eq L'); WriteLn(rev_lbl);
-
-  { Store '-' sign }
-  WriteLn('    mov w5, #45');
-  WriteLn('    strb w5, [x1, #1]');
-
-  { x4 = Write position (1 For positive, 2 For negative start) }
-  EmitLabel(rev_lbl);
-  WriteLn('    add x4, x3, #1');
-
-  { x5 = Read position (digit count - 1, reading backwards) }
-  WriteLn('    sub x5, x2, #1');
-
-  { Reverse copy loop }
-  EmitLabel(rev_done_lbl);
-  WriteLn('    cmp x5, #0');
-  Write('    b.lt L'); WriteLn(done_lbl);
-
-  { Load digit from stack at position x5 }
-  WriteLn('    ldrb w6, [sp, x5]');
-
-  { Store at dest position x4 }
-  WriteLn('    strb w6, [x1, x4]');
-
-  WriteLn('    add x4, x4, #1');
-  WriteLn('    sub x5, x5, #1');
-  Write('    b L'); WriteLn(rev_done_lbl);
-
-  { Store Length (x2 + x3 = digit count + sign) }
+  Write('    cbz x2, L'); WriteLn(done_lbl);
+  WriteLn('    ldrb w3, [x1], #1');
+  WriteLn('    strb w3, [x4], #1');
+  WriteLn('    sub x2, x2, #1');
+  EmitBranchLabel(loop_lbl);
   EmitLabel(done_lbl);
-  WriteLn('    add x0, x2, x3');
-  WriteLn('    strb w0, [x1]');
 
   EmitAddSP(48);
   EmitLdp;
   EmitRet
 End;
 
-{ EmitStrToIntRuntime - Convert String To Integer }
-{ x0 = source String address }
-{ Returns: x0 = Integer value, x1 = error code (0 = success, position Of error otherwise) }
-Procedure EmitStrToIntRuntime;
+Procedure EmitStrToNumber(parse_rt: Integer);
 Var
-  done_lbl, error_lbl, loop_lbl, neg_lbl, pos_lbl, skip_sign_lbl, exit_lbl: Integer;
+  error_lbl, done_lbl: Integer;
 Begin
-  EmitLabel(rt_str_to_int);
+  { Body Of rt_str_to_int / rt_str_to_real: the whole String must be the }
+  { number. Error code = position Of the first byte that is Not part Of it }
+  error_lbl := NewLabel;
+  done_lbl := NewLabel;
   EmitStp;
   EmitMovFP;
-  EmitSubSP(32);
-
-  done_lbl := NewLabel;
-  error_lbl := NewLabel;
-  loop_lbl := NewLabel;
-  neg_lbl := NewLabel;
-  pos_lbl := NewLabel;
-  skip_sign_lbl := NewLabel;
-  exit_lbl := NewLabel;
-
-  { x1 = Length, x2 = index (starts at 1), x3 = result, x4 = is_negative }
-  WriteLn('    ldrb w1, [x0]');
-  WriteLn('    mov x2, #1');
-  WriteLn('    mov x3, #0');
-  WriteLn('    mov x4, #0');
-
-  { Check If empty String }
-  WriteLn('    cmp x1, #0');
-  Write('    b.eq L'); WriteLn(error_lbl);
-
-  { Check first Char For sign }
-  WriteLn('    ldrb w5, [x0, #1]');
-
-  { Check For '-' (45) }
-  WriteLn('    cmp x5, #45');
-  Write('    b.eq L'); WriteLn(neg_lbl);
-
-  { Check For '+' (43) }
-  WriteLn('    cmp x5, #43');
-  Write('    b.eq L'); WriteLn(pos_lbl);
-  Write('    b L'); WriteLn(loop_lbl);
-
-  EmitLabel(neg_lbl);
-  WriteLn('    mov x4, #1');
-  EmitLabel(pos_lbl);
-  WriteLn('    add x2, x2, #1');
-
-  { Main loop }
-  EmitLabel(loop_lbl);
-  WriteLn('    cmp x2, x1');
-  Write('    b.gt L'); WriteLn(done_lbl);
-
-  { Load Char at position x2 }
-  WriteLn('    ldrb w5, [x0, x2]');
-
-  { Check If digit (48-57) }
-  WriteLn('    cmp x5, #48');
-  Write('    b.lt L'); WriteLn(error_lbl);
-  WriteLn('    cmp x5, #57');
-  Write('    b.gt L'); WriteLn(error_lbl);
-
-  { result = result * 10 + digit }
-  WriteLn('    mov x6, #10');
-  WriteLn('    mul x3, x3, x6');
-  WriteLn('    sub x5, x5, #48');
-  WriteLn('    add x3, x3, x5');
-
-  { x2 := x2 + 1 }
-  WriteLn('    add x2, x2, #1');
-  Write('    b L'); WriteLn(loop_lbl);
-
-  { Success }
-  EmitLabel(done_lbl);
-  { Apply sign If negative }
-  WriteLn('    cmp x4, #0');
-  Write('    b.eq L'); WriteLn(skip_sign_lbl);
-  WriteLn('    neg x3, x3');
-
-  EmitLabel(skip_sign_lbl);
-  WriteLn('    mov x0, x3');
+  EmitSubSP(16);
+  WriteLn('    stur x0, [x29, #-8]');
+  WriteLn('    ldrb w1, [x0], #1');
+  WriteLn('    add x1, x0, x1');
+  WriteLn('    stur x1, [x29, #-16]');
+  EmitBL(parse_rt);
+  Write('    cbz x3, L'); WriteLn(error_lbl);
+  WriteLn('    ldur x1, [x29, #-16]');
+  WriteLn('    cmp x0, x1');
+  Write('    b.ne L'); WriteLn(error_lbl);
+  WriteLn('    mov x0, x2');
   WriteLn('    mov x1, #0');
-  Write('    b L'); WriteLn(exit_lbl);
-
-  { Error - return position In x1 }
+  EmitBranchLabel(done_lbl);
   EmitLabel(error_lbl);
+  WriteLn('    ldur x1, [x29, #-8]');
+  WriteLn('    sub x1, x0, x1');
   WriteLn('    mov x0, #0');
-  WriteLn('    mov x1, x2');
-
-  EmitLabel(exit_lbl);
-  EmitAddSP(32);
+  WriteLn('    fmov d0, xzr');
+  EmitLabel(done_lbl);
+  EmitAddSP(16);
   EmitLdp;
   EmitRet
 End;
 
+{ EmitStrToIntRuntime - Convert String To Integer }
+{ x0 = source String address }
+{ Returns: x0 = Integer value, x1 = error code (0 = success, position Of error otherwise) }
+Procedure EmitStrToIntRuntime;
+Begin
+  EmitLabel(rt_str_to_int);
+  EmitStrToNumber(rt_parse_int)
+End;
+
+{ EmitStrToRealRuntime - Convert String To Real }
+{ x0 = source String address }
+{ Returns: d0 = value, x1 = error code As For rt_str_to_int }
+Procedure EmitStrToRealRuntime;
+Begin
+  EmitLabel(rt_str_to_real);
+  EmitStrToNumber(rt_parse_real)
+End;
 { EmitStrLtrimRuntime - Remove leading whitespace from String }
 { Input: x0 = source String addr }
 { Output: x0 = New trimmed String addr (allocated from heap) }
@@ -4237,14 +8604,12 @@ Begin
   EmitStrbAtOffset(-10);
   EmitMovX0(72);       { H }
   EmitStrbAtOffset(-9);
-  { Write syscall: x0=fd, x1=buf, x2=count }
-  EmitMovX16(33554436);  { 0x2000004 = Write }
-  EmitMovX0X20;          { fd from x20 }
+  { Write To output buffer: x1=buf, x2=count }
   { sub x1, x29, #15 }
   WriteLn('    sub x1, x29, #15');
   { mov x2, #7 }
   WriteLn('    mov x2, #7');
-  EmitSvc;
+  EmitBL(rt_write_buf);
   EmitAddSP(16);
   EmitLdp;
   EmitRet
@@ -4328,12 +8693,10 @@ Begin
   WriteLn('    sub x2, x8, x29');
   { add x2, x2, #20 }
   WriteLn('    add x2, x2, #20');
-  { Write syscall }
-  EmitMovX16(33554436);  { 0x2000004 = Write }
-  EmitMovX0X20;          { fd from x20 }
+  { Write To output buffer: x1=buf, x2=count }
   { sub x1, x29, #20 }
   WriteLn('    sub x1, x29, #20');
-  EmitSvc;
+  EmitBL(rt_write_buf);
   EmitAddSP(48);
   EmitLdp;
   EmitRet
@@ -4353,14 +8716,12 @@ Begin
   EmitStrbAtOffset(-10);
   EmitMovX0(75);  { K }
   EmitStrbAtOffset(-9);
-  { Write syscall }
-  EmitMovX16(33554436);  { 0x2000004 = Write }
-  EmitMovX0X20;          { fd from x20 }
+  { Write To output buffer: x1=buf, x2=count }
   { sub x1, x29, #11 }
   WriteLn('    sub x1, x29, #11');
   { mov x2, #3 }
   WriteLn('    mov x2, #3');
-  EmitSvc;
+  EmitBL(rt_write_buf);
   EmitAddSP(16);
   EmitLdp;
   EmitRet
@@ -4388,14 +8749,12 @@ Begin
   { Store 'm' }
   EmitMovX0(109);  { m }
   EmitStrbAtOffset(-9);
-  { Write syscall }
-  EmitMovX16(33554436);  { 0x2000004 = Write }
-  EmitMovX0X20;          { fd from x20 }
+  { Write To output buffer: x1=buf, x2=count }
   { sub x1, x29, #13 }
   WriteLn('    sub x1, x29, #13');
   { mov x2, #5 }
   WriteLn('    mov x2, #5');
-  EmitSvc;
+  EmitBL(rt_write_buf);
   EmitAddSP(16);
   EmitLdp;
   EmitRet
@@ -4423,14 +8782,12 @@ Begin
   { Store 'm' }
   EmitMovX0(109);  { m }
   EmitStrbAtOffset(-9);
-  { Write syscall }
-  EmitMovX16(33554436);  { 0x2000004 = Write }
-  EmitMovX0X20;          { fd from x20 }
+  { Write To output buffer: x1=buf, x2=count }
   { sub x1, x29, #13 }
   WriteLn('    sub x1, x29, #13');
   { mov x2, #5 }
   WriteLn('    mov x2, #5');
-  EmitSvc;
+  EmitBL(rt_write_buf);
   EmitAddSP(16);
   EmitLdp;
   EmitRet
@@ -4452,14 +8809,12 @@ Begin
   EmitStrbAtOffset(-10);
   EmitMovX0(109); { m }
   EmitStrbAtOffset(-9);
-  { Write syscall }
-  EmitMovX16(33554436);  { 0x2000004 = Write }
-  EmitMovX0X20;          { fd from x20 }
+  { Write To output buffer: x1=buf, x2=count }
   { sub x1, x29, #12 }
   WriteLn('    sub x1, x29, #12');
   { mov x2, #4 }
   WriteLn('    mov x2, #4');
-  EmitSvc;
+  EmitBL(rt_write_buf);
   EmitAddSP(16);
   EmitLdp;
   EmitRet
@@ -4481,14 +8836,12 @@ Begin
   EmitStrbAtOffset(-10);
   EmitMovX0(109); { m }
   EmitStrbAtOffset(-9);
-  { Write syscall }
-  EmitMovX16(33554436);  { 0x2000004 = Write }
-  EmitMovX0X20;          { fd from x20 }
+  { Write To output buffer: x1=buf, x2=count }
   { sub x1, x29, #12 }
   WriteLn('    sub x1, x29, #12');
   { mov x2, #4 }
   WriteLn('    mov x2, #4');
-  EmitSvc;
+  EmitBL(rt_write_buf);
   EmitAddSP(16);
   EmitLdp;
   EmitRet
@@ -4510,14 +8863,12 @@ Begin
   EmitStrbAtOffset(-10);
   EmitMovX0(109); { m }
   EmitStrbAtOffset(-9);
-  { Write syscall }
-  EmitMovX16(33554436);  { 0x2000004 = Write }
-  EmitMovX0X20;          { fd from x20 }
+  { Write To output buffer: x1=buf, x2=count }
   { sub x1, x29, #12 }
   WriteLn('    sub x1, x29, #12');
   { mov x2, #4 }
   WriteLn('    mov x2, #4');
-  EmitSvc;
+  EmitBL(rt_write_buf);
   EmitAddSP(16);
   EmitLdp;
   EmitRet
@@ -4543,14 +8894,12 @@ Begin
   EmitStrbAtOffset(-10);
   EmitMovX0(108); { l }
   EmitStrbAtOffset(-9);
-  { Write syscall }
-  EmitMovX16(33554436);  { 0x2000004 = Write }
-  EmitMovX0X20;          { fd from x20 }
+  { Write To output buffer: x1=buf, x2=count }
   { sub x1, x29, #14 }
   WriteLn('    sub x1, x29, #14');
   { mov x2, #6 }
   WriteLn('    mov x2, #6');
-  EmitSvc;
+  EmitBL(rt_write_buf);
   EmitAddSP(16);
   EmitLdp;
   EmitRet
@@ -4576,14 +8925,12 @@ Begin
   EmitStrbAtOffset(-10);
   EmitMovX0(104); { h }
   EmitStrbAtOffset(-9);
-  { Write syscall }
-  EmitMovX16(33554436);  { 0x2000004 = Write }
-  EmitMovX0X20;          { fd from x20 }
+  { Write To output buffer: x1=buf, x2=count }
   { sub x1, x29, #14 }
   WriteLn('    sub x1, x29, #14');
   { mov x2, #6 }
   WriteLn('    mov x2, #6');
-  EmitSvc;
+  EmitBL(rt_write_buf);
   EmitAddSP(16);
   EmitLdp;
   EmitRet
@@ -4600,6 +8947,11 @@ Begin
   EmitMovFP;
   EmitSubSP(32);  { 16 bytes For timeval + alignment }
 
+  { Show everything drawn so far before pausing }
+  EmitPushX0;
+  EmitBL(rt_flush_output);
+  EmitPopX0;
+
   { x10 = ms (save original) }
   WriteLn('    mov x10, x0');
 
@@ -4653,6 +9005,7 @@ Begin
   EmitStp;
   EmitMovFP;
   EmitSubSP(48);  { 8 bytes For fd_set + 16 bytes For timeval + padding }
+  EmitBL(rt_flush_output);
 
   { Clear the fd_set at sp }
   WriteLn('    mov x0, #0');
@@ -5791,28 +10144,341 @@ Begin
   EmitRet
 End;
 
-
-{ ----- Parser ----- }
-
-Procedure ParseExpression; Forward;
-Procedure ParseStatement; Forward;
-
-Procedure Expect(t: Integer);
+{ ----- Parser ----- }
+
+Procedure ParseExpression; Forward;
+Procedure ParseFoldedExpr; Forward;
+Procedure ParseStatement; Forward;
+
+Procedure SetExprConst(val: Integer);
+Begin
+  { The expression is the constant val; its code is emitted later, If }
+  { at all }
+  expr_const := 1;
+  expr_const_val := val
+End;
+
+Procedure EmitConstFlush;
+Begin
+  { Materialize a pending constant In x0 }
+  If expr_const = 1 Then
+  Begin
+    EmitMovX0(expr_const_val);
+    expr_const := 0
+  End
+End;
+
+Procedure Expect(t: Integer);
+Begin
+  If tok_type <> t Then
+    Error(2);
+  NextToken
+End;
+
+Function Match(t: Integer): Integer;
+Begin
+  If tok_type = t Then
+  Begin
+    NextToken;
+    Match := 1
+  End
+  Else
+    Match := 0
+End;
+
+Function ParseFieldAddr(rec_type: Integer): Integer;
+Var
+  fld: Integer;
+Begin
+  { At '.' after a Record Of Type rec_type whose address is In x0: }
+  { follow .field.subfield, leave the field's address In x0 And return }
+  { its field index }
+  NextToken;  { consume '.' }
+  If tok_type <> TOK_IDENT Then
+    Error(11);
+  fld := FindField(rec_type);
+  If fld < 0 Then
+    Error(15);
+  If field_offset[fld] > 0 Then
+    EmitAddrOffset(0, 0, field_offset[fld]);
+  NextToken;
+  While (field_type[fld] = TYPE_RECORD) And (tok_type = TOK_DOT) Do
+  Begin
+    NextToken;  { consume '.' }
+    If tok_type <> TOK_IDENT Then
+      Error(11);
+    fld := FindField(field_rec_type[fld]);
+    If fld < 0 Then
+      Error(15);
+    If field_offset[fld] > 0 Then
+      EmitAddrOffset(0, 0, field_offset[fld]);
+    NextToken
+  End;
+  ParseFieldAddr := fld
+End;
+
+Procedure EmitPtrArrIndex(pa: Integer);
+Begin
+  { x0 = index into pointer-To-Array Type pa, stack = Array base; }
+  { pops the base And leaves the element's address In x0 }
+  EmitAddrOffset(0, 0, 0 - ptr_arr_lo[pa]);
+  If ptr_arr_elem[pa] = TYPE_RECORD Then
+  Begin
+    WriteLn('    mov x1, x0');
+    EmitMovX0(sym_label[ptr_arr_rec[pa]]);
+    WriteLn('    mul x0, x1, x0')
+  End
+  Else
+    WriteLn('    lsl x0, x0, #3');
+  EmitPopX1;
+  WriteLn('    add x0, x1, x0')
+End;
+
+Procedure EmitToAnsi;
+Begin
+  { Turn the String Or Char value In x0 into an AnsiString, keeping x1 }
+  If expr_type = TYPE_STRING Then
+    EmitBL(rt_ansi_from_short)
+  Else If expr_type = TYPE_CHAR Then
+    EmitBL(rt_ansi_from_char)
+  Else If expr_type <> TYPE_ANSISTRING Then
+    Error(12);
+  expr_type := TYPE_ANSISTRING
+End;
+
+Procedure EmitAnsiOperands(left_type: Integer);
+Begin
+  { Left operand In an operand slot, right one In x0: make both AnsiStrings, left }
+  { In x0 And right In x1 }
+  EmitToAnsi;
+  WriteLn('    mov x1, x0');
+  EmitPopOperandTo(0);
+  expr_type := left_type;
+  EmitToAnsi
+End;
+
+Procedure EmitAnsiVarAddr(idx: Integer);
+Begin
+  { x0 = address Of the pointer held by AnsiString variable idx }
+  EmitVarAddr(idx, scope_level);
+  If sym_is_var_param[idx] = 1 Then
+    WriteLn('    ldr x0, [x0]')
+End;
+
+Procedure EmitStrLength;
+Var
+  lbl: Integer;
+Begin
+  { Length Of the String expression In x0 }
+  If expr_type = TYPE_ANSISTRING Then
+  Begin
+    lbl := NewLabel;
+    WriteLn('    mov x1, x0');
+    EmitBranchLabelZ(lbl);
+    WriteLn('    ldr x0, [x0, #8]');
+    EmitLabel(lbl);
+    EmitBL(rt_ansi_drop)
+  End
+  Else If expr_type = TYPE_STRING Then
+    WriteLn('    ldrb w0, [x0]')
+  Else If expr_type = TYPE_CHAR Then
+    EmitMovX0(1)
+  Else
+    Error(12)
+End;
+
+Procedure EmitStrConcat(left_type: Integer);
+Begin
+  { Left String operand In an operand slot, right one In x0: x0 = the two joined. }
+  { With an AnsiString on either side the result is an AnsiString, }
+  { Else a temp String cut at 255 chars }
+  If (left_type = TYPE_ANSISTRING) Or (expr_type = TYPE_ANSISTRING) Then
+  Begin
+    EmitAnsiOperands(left_type);
+    EmitBL(rt_ansi_concat)
+  End
+  Else
+  Begin
+    If (left_type = TYPE_CHAR) And (expr_type = TYPE_CHAR) Then
+    Begin
+      { Concat Of two chars: make the right one a String first }
+      WriteLn('    mov x3, x0');
+      WriteLn('    mov x0, x21');
+      WriteLn('    mov x4, #1');
+      WriteLn('    strb w4, [x0]');
+      WriteLn('    strb w3, [x0, #1]');
+      WriteLn('    add x21, x21, #256');
+      expr_type := TYPE_STRING
+    End;
+    If (left_type = TYPE_STRING) And (expr_type = TYPE_STRING) Then
+    Begin
+      { String concatenation: str1 + str2 }
+      { x0 = string2 addr, top slot = string1 addr }
+      WriteLn('    mov x2, x0');
+      EmitPopOperandTo(1);  { string1 addr }
+      { Allocate temp String from heap }
+      WriteLn('    mov x0, x21');
+      WriteLn('    add x21, x21, #256');
+      { Call rt_str_concat(x0=dest, x1=str1, x2=str2) }
+      EmitBL(rt_str_concat)
+    End
+    Else If (left_type = TYPE_STRING) And (expr_type = TYPE_CHAR) Then
+    Begin
+      { String + Char: x0 = Char, top slot = String addr }
+      { Create single-Char String from x0 on heap }
+      WriteLn('    mov x3, x0');
+      WriteLn('    mov x2, x21');
+      EmitMovX0(1);  { Length = 1 }
+      WriteLn('    strb w0, [x2]');
+      WriteLn('    strb w3, [x2, #1]');
+      WriteLn('    add x21, x21, #256');
+      EmitPopOperandTo(1);  { string1 addr }
+      { x2 = Char String, x1 = string1, allocate result on heap }
+      WriteLn('    mov x0, x21');
+      WriteLn('    add x21, x21, #256');
+      EmitBL(rt_str_concat)
+    End
+    Else If (left_type = TYPE_CHAR) And (expr_type = TYPE_STRING) Then
+    Begin
+      { Char + String: x0 = String addr, top slot = Char }
+      WriteLn('    mov x2, x0');
+      EmitPopOperandTo(0);  { x0 = Char }
+      { Create single-Char String from x0 on heap }
+      WriteLn('    mov x1, x21');
+      WriteLn('    mov x3, x0');
+      EmitMovX0(1);  { Length = 1 }
+      WriteLn('    strb w0, [x1]');
+      WriteLn('    strb w3, [x1, #1]');
+      WriteLn('    add x21, x21, #256');
+      { x1 = Char String, x2 = string2, allocate result on heap }
+      WriteLn('    mov x0, x21');
+      WriteLn('    add x21, x21, #256');
+      EmitBL(rt_str_concat)
+    End
+    Else
+      Error(12);
+    expr_type := TYPE_STRING
+  End
+End;
+
+Function ParseArrayIndex(idx: Integer): Integer;
+Var
+  dim_idx, dim_count, dim_size, lin, folded: Integer;
 Begin
-  If tok_type <> t Then
-    Error(2);
-  NextToken
+  { Parse the indices Of Array symbol idx up To And including ']'. When }
+  { every index is constant, returns the element's byte offset from the }
+  { Array base And emits nothing; Else returns -1 With the offset In x0 }
+  ParseFoldedExpr;  { first index }
+  folded := expr_const;
+  lin := expr_const_val - arr_info[idx * 8];
+  expr_const := 0;
+  If folded = 0 Then
+  Begin
+    { Subtract low bound for first dimension }
+    EmitAddX0Const(0 - arr_info[idx * 8])  { x0 = index - lo_bound }
+  End;
+  { Handle multi-dimensional arrays }
+  dim_count := arr_dims[idx];
+  If dim_count < 1 Then dim_count := 1;  { default to 1D }
+  dim_idx := 1;
+  While (dim_idx < dim_count) And (tok_type = TOK_COMMA) Do
+  Begin
+    NextToken;  { consume ',' }
+    dim_size := arr_info[idx * 8 + dim_idx * 2 + 1];
+    If folded = 1 Then
+    Begin
+      lin := lin * dim_size;
+      ParseFoldedExpr;
+      If expr_const = 1 Then
+      Begin
+        lin := lin + expr_const_val - arr_info[idx * 8 + dim_idx * 2];
+        expr_const := 0
+      End
+      Else
+      Begin
+        { Constant so far: x0 = index - lo_bound + lin }
+        EmitAddX0Const(lin - arr_info[idx * 8 + dim_idx * 2]);
+        folded := 0
+      End
+    End
+    Else
+    Begin
+      { Multiply current linear index by this dimension's size }
+      EmitPushX0;  { save current linear index }
+      EmitMovX0(dim_size);
+      EmitPopX1;
+      WriteLn('    mul x0, x1, x0');  { x0 = linear_index * dim_size }
+      EmitPushX0;  { save multiplied result }
+      ParseExpression;  { new index in x0 }
+      { Subtract low bound for this dimension }
+      EmitAddX0Const(0 - arr_info[idx * 8 + dim_idx * 2]);  { x0 = index - lo_bound }
+      EmitPopX1;  { restore multiplied linear index }
+      WriteLn('    add x0, x1, x0')  { x0 = linear_index + new_index }
+    End;
+    dim_idx := dim_idx + 1
+  End;
+  Expect(TOK_RBRACKET);
+  If folded = 1 Then
+  Begin
+    { Below the low bound: leave it To the usual address arithmetic }
+    If lin < 0 Then
+    Begin
+      EmitMovX0(lin);
+      folded := 0
+    End
+  End;
+  { Multiply linear index by element size }
+  ParseArrayIndex := -1;
+  If sym_var_param_flags[idx] > 0 Then
+  Begin
+    { Array Of records - multiply by Record size }
+    dim_size := sym_label[sym_var_param_flags[idx] - 1];
+    If folded = 1 Then
+      ParseArrayIndex := lin * dim_size
+    Else
+    Begin
+      EmitPushX0;
+      EmitMovX0(dim_size);
+      EmitPopX1;
+      WriteLn('    mul x0, x1, x0')
+    End
+  End
+  Else If sym_var_param_flags[idx] = -1 Then
+  Begin
+    { Array Of strings - multiply by 256 using lsl #8 }
+    If folded = 1 Then
+      ParseArrayIndex := lin * 256
+    Else
+      WriteLn('    lsl x0, x0, #8')
+  End
+  Else If folded = 1 Then
+    ParseArrayIndex := lin * 8
+  Else
+    { Basic Type - multiply by 8 using lsl #3 }
+    WriteLn('    lsl x0, x0, #3')
 End;
 
-Function Match(t: Integer): Integer;
+Procedure EmitArrayElemAddr(idx, dest, elem_off: Integer);
 Begin
-  If tok_type = t Then
+  { x<dest> = address Of the element Of Array symbol idx at byte offset }
+  { elem_off, Or at the offset In x0 If elem_off < 0 }
+  If sym_level[idx] < scope_level Then
   Begin
-    NextToken;
-    Match := 1
+    EmitFollowChain(sym_level[idx], scope_level);
+    If elem_off >= 0 Then
+      EmitSubLargeOffset(dest, 8, elem_off - sym_offset[idx])
+    Else
+      EmitSubLargeOffset(1, 8, 0 - sym_offset[idx])
   End
+  Else If elem_off >= 0 Then
+    EmitSubLargeOffset(dest, 29, elem_off - sym_offset[idx])
   Else
-    Match := 0
+    EmitSubLargeOffset(1, 29, 0 - sym_offset[idx]);
+  If elem_off < 0 Then
+  Begin
+    { Arrays grow downward: element = base - offset }
+    Write('    sub x'); Write(dest); WriteLn(', x1, x0')
+  End
 End;
 
 Procedure ParseFactor;
@@ -5823,7 +10489,7 @@ Var
 Begin
   If tok_type = TOK_INTEGER Then
   Begin
-    EmitMovX0(tok_int);
+    SetExprConst(tok_int);
     expr_type := TYPE_INTEGER;
     NextToken
   End
@@ -5851,28 +10517,36 @@ Begin
   End
   Else If tok_type = TOK_TRUE Then
   Begin
-    EmitMovX0(1);
+    SetExprConst(1);
     expr_type := TYPE_INTEGER;
     NextToken
   End
   Else If tok_type = TOK_FALSE Then
   Begin
-    EmitMovX0(0);
+    SetExprConst(0);
     expr_type := TYPE_INTEGER;
     NextToken
   End
   Else If tok_type = TOK_LPAREN Then
   Begin
     NextToken;
-    ParseExpression;
+    ParseFoldedExpr;
     Expect(TOK_RPAREN)
-    { expr_type is already Set by ParseExpression }
+    { expr_type is already Set by ParseFoldedExpr }
   End
   Else If tok_type = TOK_NOT Then
   Begin
     NextToken;
     ParseFactor;
-    EmitEorX0(1);
+    If expr_const = 1 Then
+    Begin
+      If expr_const_val Mod 2 = 0 Then
+        expr_const_val := expr_const_val + 1
+      Else
+        expr_const_val := expr_const_val - 1
+    End
+    Else
+      EmitEorX0(1);
     expr_type := TYPE_INTEGER  { Not always returns Boolean/int }
   End
   Else If tok_type = TOK_LBRACKET Then
@@ -5945,7 +10619,7 @@ Begin
     If tok_len = 1 Then
     Begin
       { Single character - treat as Char/Integer }
-      EmitMovX0(tok_str[0]);
+      SetExprConst(tok_str[0]);
       expr_type := TYPE_CHAR
     End
     Else
@@ -5983,60 +10657,7 @@ Begin
     Begin
       { Address Of Array element: @arr[index] Or @arr[i,j,...] }
       NextToken;  { consume '[' }
-      ParseExpression;  { first index In x0 }
-      { Subtract low bound for first dimension }
-      dim_lo := arr_info[idx * 8];
-      EmitPushX0;
-      EmitMovX0(dim_lo);
-      EmitPopX1;
-      WriteLn('    sub x0, x1, x0');
-      { Handle multi-dimensional arrays }
-      dim_count := arr_dims[idx];
-      If dim_count < 1 Then dim_count := 1;
-      dim_idx := 1;
-      While (dim_idx < dim_count) And (tok_type = TOK_COMMA) Do
-      Begin
-        NextToken;  { consume ',' }
-        dim_size := arr_info[idx * 8 + dim_idx * 2 + 1];
-        EmitPushX0;
-        EmitMovX0(dim_size);
-        EmitPopX1;
-        WriteLn('    mul x0, x1, x0');
-        EmitPushX0;
-        ParseExpression;
-        dim_lo := arr_info[idx * 8 + dim_idx * 2];
-        EmitPushX0;
-        EmitMovX0(dim_lo);
-        EmitPopX1;
-        WriteLn('    sub x0, x1, x0');
-        EmitPopX1;
-        WriteLn('    add x0, x1, x0');
-        dim_idx := dim_idx + 1
-      End;
-      Expect(TOK_RBRACKET);
-      { Multiply by element size }
-      If sym_var_param_flags[idx] > 0 Then
-      Begin
-        lbl1 := sym_label[sym_var_param_flags[idx] - 1];
-        EmitPushX0;
-        EmitMovX0(lbl1);
-        EmitPopX1;
-        WriteLn('    mul x0, x1, x0');
-      End
-      Else If sym_var_param_flags[idx] = -1 Then
-        WriteLn('    lsl x0, x0, #8')
-      Else
-        WriteLn('    lsl x0, x0, #3');
-      { Get base address }
-      If sym_level[idx] < scope_level Then
-      Begin
-        EmitFollowChain(sym_level[idx], scope_level);
-        EmitSubLargeOffset(1, 8, 0 - sym_offset[idx])
-      End
-      Else
-        EmitSubLargeOffset(1, 29, 0 - sym_offset[idx]);
-      { Address = base - element_offset }
-      WriteLn('    sub x0, x1, x0');
+      EmitArrayElemAddr(idx, 0, ParseArrayIndex(idx));
     End
     Else
       EmitVarAddr(idx, scope_level);
@@ -6088,7 +10709,7 @@ Begin
       NextToken;
       If sym_kind[idx] = SYM_CONST Then
       Begin
-        EmitMovX0(sym_const_val[idx]);
+        SetExprConst(sym_const_val[idx]);
         expr_type := TYPE_INTEGER
       End
       Else If (sym_kind[idx] = SYM_VAR) Or (sym_kind[idx] = SYM_PARAM) Then
@@ -6097,71 +10718,7 @@ Begin
         Begin
           { Array element access: arr[index] Or arr[i,j,...] }
           NextToken;  { consume '[' }
-          ParseExpression;  { first index In x0 }
-          { Subtract low bound for first dimension }
-          dim_lo := arr_info[idx * 8];  { lo bound for dim 0 }
-          EmitPushX0;
-          EmitMovX0(dim_lo);
-          EmitPopX1;
-          WriteLn('    sub x0, x1, x0');  { x0 = index - lo_bound }
-          { Handle multi-dimensional arrays }
-          dim_count := arr_dims[idx];
-          If dim_count < 1 Then dim_count := 1;  { default to 1D }
-          dim_idx := 1;
-          While (dim_idx < dim_count) And (tok_type = TOK_COMMA) Do
-          Begin
-            NextToken;  { consume ',' }
-            { Multiply current linear index by this dimension's size }
-            dim_size := arr_info[idx * 8 + dim_idx * 2 + 1];
-            EmitPushX0;  { save current linear index }
-            EmitMovX0(dim_size);
-            EmitPopX1;
-            WriteLn('    mul x0, x1, x0');  { x0 = linear_index * dim_size }
-            EmitPushX0;  { save multiplied result }
-            { Parse next index }
-            ParseExpression;  { new index in x0 }
-            { Subtract low bound for this dimension }
-            dim_lo := arr_info[idx * 8 + dim_idx * 2];
-            EmitPushX0;
-            EmitMovX0(dim_lo);
-            EmitPopX1;
-            WriteLn('    sub x0, x1, x0');  { x0 = index - lo_bound }
-            { Add to previous linear index }
-            EmitPopX1;  { restore multiplied linear index }
-            WriteLn('    add x0, x1, x0');  { x0 = linear_index + new_index }
-            dim_idx := dim_idx + 1
-          End;
-          Expect(TOK_RBRACKET);
-          { Multiply linear index by element size }
-          If sym_var_param_flags[idx] > 0 Then
-          Begin
-            { Array Of records - multiply by Record size }
-            lbl1 := sym_label[sym_var_param_flags[idx] - 1];  { Record size }
-            EmitPushX0;
-            EmitMovX0(lbl1);
-            EmitPopX1;
-            WriteLn('    mul x0, x1, x0');
-          End
-          Else If sym_var_param_flags[idx] = -1 Then
-          Begin
-            { Array Of strings - multiply by 256 using lsl #8 }
-            WriteLn('    lsl x0, x0, #8');
-          End
-          Else
-          Begin
-            { Basic Type - multiply by 8 using lsl #3 }
-            WriteLn('    lsl x0, x0, #3');
-          End;
-          { Get base address: frame + offset (offset is negative) }
-          If sym_level[idx] < scope_level Then
-          Begin
-            EmitFollowChain(sym_level[idx], scope_level);
-            EmitSubLargeOffset(1, 8, 0 - sym_offset[idx])
-          End
-          Else
-            EmitSubLargeOffset(1, 29, 0 - sym_offset[idx]);
-          { Compute element address: x1 - x0 }
-          WriteLn('    sub x1, x1, x0');
+          EmitArrayElemAddr(idx, 1, ParseArrayIndex(idx));
           { Check For field access on Array Of records }
           If (sym_var_param_flags[idx] > 0) And (tok_type = TOK_DOT) Then
           Begin
@@ -6289,6 +10846,25 @@ Begin
               expr_type := TYPE_CHAR
             End
           End
+          Else If sym_type[idx] = TYPE_ANSISTRING Then
+          Begin
+            { AnsiString variable - load its record pointer }
+            EmitAnsiVarAddr(idx);
+            WriteLn('    ldr x0, [x0]');
+            expr_type := TYPE_ANSISTRING;
+            { s[i] is the byte at p+15+i }
+            If tok_type = TOK_LBRACKET Then
+            Begin
+              NextToken;  { consume '[' }
+              EmitPushX0;  { save record address }
+              ParseExpression;  { index In x0 }
+              Expect(TOK_RBRACKET);
+              EmitPopX1;
+              WriteLn('    add x0, x1, x0');
+              WriteLn('    ldrb w0, [x0, #15]');
+              expr_type := TYPE_CHAR
+            End
+          End
           Else If sym_type[idx] = TYPE_POINTER Then
           Begin
             { Pointer variable }
@@ -6303,53 +10879,62 @@ Begin
             If tok_type = TOK_CARET Then
             Begin
               NextToken;
+              { pp^^: follow the extra links; lbl2 = levels still To go }
+              lbl2 := ptr_depth[idx] - 1;
+              While tok_type = TOK_CARET Do
+              Begin
+                WriteLn('    ldr x0, [x0]');
+                lbl2 := lbl2 - 1;
+                NextToken
+              End;
               { Check For Array dereference With index: pa^[i] }
               If (ptr_ultimate_type[idx] = TYPE_ARRAY) And (tok_type = TOK_LBRACKET) Then
               Begin
                 NextToken;
+                EmitPushX0;  { save Array base address }
                 ParseExpression;
                 Expect(TOK_RBRACKET);
-                { x0 = index, stack has base address }
-                EmitPushX0;
-                If sym_level[idx] < scope_level Then
-                  EmitLdurX0Outer(sym_offset[idx], sym_level[idx], scope_level)
-                Else
-                  EmitLdurX0(sym_offset[idx]);
-                If sym_is_var_param[idx] = 1 Then
-                  WriteLn('    ldr x0, [x0]');
-                EmitPushX0;
-                EmitPopX1;
-                EmitPopX0;
-                { Subtract low bound }
                 arg_count := sym_label[idx];  { ptr_arr index }
-                EmitPushX0;
-                EmitMovX0(ptr_arr_lo[arg_count]);
-                EmitPopX1;
-                { x0 = x1 - x0 = index - low_bound }
-                WriteLn('    sub x0, x1, x0');
-                { Multiply by 8 using lsl #3 }
-                WriteLn('    lsl x0, x0, #3');
-                { Add To base: x1 = base + offset }
-                EmitPopX1;  { x1 = base address }
-                WriteLn('    add x0, x1, x0');
-                { Load element value }
-                If ptr_arr_elem[arg_count] = TYPE_REAL Then
-                Begin
-                  WriteLn('    ldr d0, [x0]');
-                  expr_type := TYPE_REAL
-                End
-                Else
-                Begin
+                EmitPtrArrIndex(arg_count);
+                { Load element value, Or a field Of a Record element }
+                lbl1 := ptr_arr_elem[arg_count];
+                If (lbl1 = TYPE_RECORD) And (tok_type = TOK_DOT) Then
+                  lbl1 := field_type[ParseFieldAddr(ptr_arr_rec[arg_count])];
+                If lbl1 = TYPE_REAL Then
+                  WriteLn('    ldr d0, [x0]')
+                Else If lbl1 <> TYPE_RECORD Then
                   WriteLn('    ldr x0, [x0]');
-                  expr_type := ptr_arr_elem[arg_count]
-                End
+                expr_type := lbl1
+              End
+              Else If lbl2 > 0 Then
+              Begin
+                { Still a pointer }
+                WriteLn('    ldr x0, [x0]');
+                expr_type := TYPE_POINTER
+              End
+              Else If (ptr_ultimate_type[idx] = TYPE_RECORD) And (tok_type = TOK_DOT) Then
+              Begin
+                { p^.field }
+                lbl1 := field_type[ParseFieldAddr(ptr_ultimate_rec[idx])];
+                If lbl1 = TYPE_REAL Then
+                  WriteLn('    ldr d0, [x0]')
+                Else If lbl1 <> TYPE_RECORD Then
+                  WriteLn('    ldr x0, [x0]');
+                expr_type := lbl1
               End
               Else If ptr_ultimate_type[idx] = TYPE_REAL Then
               Begin
+                WriteLn('    ldr d0, [x0]');
                 expr_type := TYPE_REAL
               End
+              Else If (ptr_ultimate_type[idx] = TYPE_RECORD) Or (ptr_ultimate_type[idx] = TYPE_ARRAY) Then
+              Begin
+                { A whole Record Or Array stays an address }
+                expr_type := ptr_ultimate_type[idx]
+              End
               Else
               Begin
+                WriteLn('    ldr x0, [x0]');
                 expr_type := ptr_ultimate_type[idx]
               End
             End
@@ -6384,10 +10969,7 @@ Begin
                       ParseExpression;  { first index In x0 }
                       { Subtract low bound for first dimension }
                       dim_lo := arr_info[var_arg_idx * 8];
-                      EmitPushX0;
-                      EmitMovX0(dim_lo);
-                      EmitPopX1;
-                      WriteLn('    sub x0, x1, x0');
+                      EmitAddX0Const(0 - dim_lo);
                       { Handle multi-dimensional arrays }
                       dim_count := arr_dims[var_arg_idx];
                       If dim_count < 1 Then dim_count := 1;
@@ -6403,10 +10985,7 @@ Begin
                         EmitPushX0;
                         ParseExpression;
                         dim_lo := arr_info[var_arg_idx * 8 + dim_idx * 2];
-                        EmitPushX0;
-                        EmitMovX0(dim_lo);
-                        EmitPopX1;
-                        WriteLn('    sub x0, x1, x0');
+                        EmitAddX0Const(0 - dim_lo);
                         EmitPopX1;
                         WriteLn('    add x0, x1, x0');
                         dim_idx := dim_idx + 1
@@ -6443,7 +11022,9 @@ Begin
                   Else
                   Begin
                     { Value param - evaluate expression }
-                    ParseExpression
+                    ParseExpression;
+                    If IsVarParam(var_flags Div 256, arg_count) = 1 Then
+                      EmitToAnsi
                   End;
                   EmitPushX0;
                   arg_count := arg_count + 1
@@ -6511,10 +11092,7 @@ Begin
                   ParseExpression;  { first index In x0 }
                   { Subtract low bound for first dimension }
                   dim_lo := arr_info[var_arg_idx * 8];
-                  EmitPushX0;
-                  EmitMovX0(dim_lo);
-                  EmitPopX1;
-                  WriteLn('    sub x0, x1, x0');
+                  EmitAddX0Const(0 - dim_lo);
                   { Handle multi-dimensional arrays }
                   dim_count := arr_dims[var_arg_idx];
                   If dim_count < 1 Then dim_count := 1;
@@ -6530,10 +11108,7 @@ Begin
                     EmitPushX0;
                     ParseExpression;
                     dim_lo := arr_info[var_arg_idx * 8 + dim_idx * 2];
-                    EmitPushX0;
-                    EmitMovX0(dim_lo);
-                    EmitPopX1;
-                    WriteLn('    sub x0, x1, x0');
+                    EmitAddX0Const(0 - dim_lo);
                     EmitPopX1;
                     WriteLn('    add x0, x1, x0');
                     dim_idx := dim_idx + 1
@@ -6570,7 +11145,9 @@ Begin
               Else
               Begin
                 { Value param - evaluate expression }
-                ParseExpression
+                ParseExpression;
+                If IsVarParam(var_flags Div 256, arg_count) = 1 Then
+                  EmitToAnsi
               End;
               EmitPushX0;
               arg_count := arg_count + 1
@@ -6657,31 +11234,8 @@ Begin
       Expect(TOK_LPAREN);
       ParseExpression;
       Expect(TOK_RPAREN);
-      { x0 = fd, save it Then Do Read syscall }
-      { sub sp, sp, #16; str x0, [sp] - allocate buffer And save fd }
-      WriteLn('    sub sp, sp, #16');
-      { mov x1, sp - buffer on stack }
-      WriteLn('    mov x1, sp');
-      { mov x2, #1 - Read 1 byte }
-      WriteLn('    mov x2, #1');
-      { Read syscall: x16 = 0x2000003 }
-      WriteLn('    movz x16, #3');
-      WriteLn('    movk x16, #0x200, lsl #16');
-      EmitSvc;
-      { Check If Read returned >= 1 }
-      { cmp x0, #1; b.ge got_char; mov x0, #-1; b done; got_char: ldrb w0, [sp]; done: }
-      WriteLn('    cmp x0, #1');
-      Write('    b.ge L'); WriteLn(label_count);
-      EmitMovX0(-1);
-      EmitBranchLabel(label_count + 1);
-      EmitLabel(label_count);
-      label_count := label_count + 1;
-      { ldrb w0, [sp] }
-      WriteLn('    ldrb w0, [sp]');
-      EmitLabel(label_count);
-      label_count := label_count + 1;
-      { add sp, sp, #16 - restore stack }
-      WriteLn('    add sp, sp, #16');
+      { x0 = fd; buffered input For fd is served first }
+      EmitBL(rt_read_fd);
       expr_type := TYPE_INTEGER
     End
     { openfile = 111,112,101,110,102,105,108,101 (8 chars) }
@@ -6760,7 +11314,7 @@ Begin
     Begin
       NextToken;
       Expect(TOK_LPAREN);
-      ParseExpression;
+      ParseFoldedExpr;
       Expect(TOK_RPAREN);
       { Ord() is identity For integers/chars }
       expr_type := TYPE_INTEGER
@@ -6822,7 +11376,7 @@ Begin
     Begin
       NextToken;
       Expect(TOK_LPAREN);
-      ParseExpression;
+      ParseFoldedExpr;
       Expect(TOK_RPAREN);
       { Chr() is identity For integers/chars }
       expr_type := TYPE_INTEGER
@@ -7221,27 +11775,32 @@ Begin
       { Check For Type name Or variable }
       If tok_type = TOK_INTEGER_TYPE Then
       Begin
-        EmitMovX0(8);
+        SetExprConst(8);
         NextToken
       End
       Else If tok_type = TOK_CHAR_TYPE Then
       Begin
-        EmitMovX0(1);
+        SetExprConst(1);
         NextToken
       End
       Else If tok_type = TOK_BOOLEAN_TYPE Then
       Begin
-        EmitMovX0(1);
+        SetExprConst(1);
         NextToken
       End
       Else If tok_type = TOK_REAL_TYPE Then
       Begin
-        EmitMovX0(8);
+        SetExprConst(8);
         NextToken
       End
       Else If tok_type = TOK_STRING_TYPE Then
       Begin
-        EmitMovX0(256);
+        SetExprConst(256);
+        NextToken
+      End
+      Else If tok_type = TOK_ANSISTRING_TYPE Then
+      Begin
+        SetExprConst(8);
         NextToken
       End
       Else If tok_type = TOK_IDENT Then
@@ -7253,32 +11812,32 @@ Begin
         If sym_kind[idx] = SYM_TYPEDEF Then
         Begin
           { Type definition - get size from sym_label (Record size) }
-          EmitMovX0(sym_label[idx])
+          SetExprConst(sym_label[idx])
         End
         Else If sym_type[idx] = TYPE_INTEGER Then
-          EmitMovX0(8)
+          SetExprConst(8)
         Else If sym_type[idx] = TYPE_CHAR Then
-          EmitMovX0(1)  { Logical size, Not storage size }
+          SetExprConst(1)  { Logical size, Not storage size }
         Else If sym_type[idx] = TYPE_BOOLEAN Then
-          EmitMovX0(1)  { Logical size, Not storage size }
+          SetExprConst(1)  { Logical size, Not storage size }
         Else If sym_type[idx] = TYPE_REAL Then
-          EmitMovX0(8)
+          SetExprConst(8)
         Else If sym_type[idx] = TYPE_STRING Then
-          EmitMovX0(256)
+          SetExprConst(256)
         Else If sym_type[idx] = TYPE_POINTER Then
-          EmitMovX0(8)
+          SetExprConst(8)
         Else If sym_type[idx] = TYPE_ARRAY Then
         Begin
           { Array: sym_label already contains total size In bytes }
-          EmitMovX0(sym_label[idx])
+          SetExprConst(sym_label[idx])
         End
         Else If sym_type[idx] = TYPE_RECORD Then
         Begin
           { Record: sym_const_val has typedef index, get size from typedef's sym_label }
-          EmitMovX0(sym_label[sym_const_val[idx]])
+          SetExprConst(sym_label[sym_const_val[idx]])
         End
         Else
-          EmitMovX0(8);  { Default To 8 bytes }
+          SetExprConst(8);  { Default To 8 bytes }
         NextToken
       End
       Else
@@ -7362,10 +11921,7 @@ Begin
           ParseExpression;  { index In x0 }
           Expect(TOK_RBRACKET);
           { Subtract low bound }
-          EmitPushX0;
-          EmitMovX0(sym_const_val[idx]);
-          EmitPopX1;
-          WriteLn('    sub x0, x1, x0');
+          EmitAddX0Const(0 - sym_const_val[idx]);
           { Multiply by 256 }
           WriteLn('    lsl x0, x0, #8');
           { Get base address }
@@ -7382,10 +11938,17 @@ Begin
           WriteLn('    ldrb w0, [x0]');
         End
         Else
-          Error(9);
+        Begin
+          { Any other String expression, e.g. an AnsiString }
+          ParseExpression;
+          EmitStrLength
+        End
       End
       Else
-        Error(9);
+      Begin
+        ParseExpression;
+        EmitStrLength
+      End;
       Expect(TOK_RPAREN);
       expr_type := TYPE_INTEGER
     End
@@ -7394,7 +11957,7 @@ Begin
             (ToLower(tok_str[2]) = 102) Then
     Begin
       { eof(f) - check If at End Of file }
-      { Uses lseek To compare current position With file size }
+      { Looks at the file's buffer; reads ahead only when it is empty }
       NextToken;
       Expect(TOK_LPAREN);
       If tok_type <> TOK_IDENT Then
@@ -7406,42 +11969,10 @@ Begin
         Error(9);
       NextToken;
       Expect(TOK_RPAREN);
-      { Get file fd And save For later }
       EmitVarAddr(idx, scope_level);
       { ldr x0, [x0] - load fd }
       WriteLn('    ldr x0, [x0]');
-      { Save fd To x23 (callee-saved) }
-      WriteLn('    mov x23, x0');
-      { lseek(fd, 0, SEEK_CUR=1) To get current position }
-      WriteLn('    mov x1, #0');
-      WriteLn('    mov x2, #1');
-      { lseek syscall: 0x20000C7 }
-      WriteLn('    movz x16, #0xC7');
-      WriteLn('    movk x16, #0x200, lsl #16');
-      EmitSvc;
-      { x0 = current position, save To x24 }
-      WriteLn('    mov x24, x0');
-      { lseek(fd, 0, SEEK_END=2) To get file size }
-      WriteLn('    mov x0, x23');
-      WriteLn('    mov x1, #0');
-      WriteLn('    mov x2, #2');
-      WriteLn('    movz x16, #0xC7');
-      WriteLn('    movk x16, #0x200, lsl #16');
-      EmitSvc;
-      { x0 = file size, x24 = current position }
-      { Restore file position: lseek(fd, current_pos, SEEK_SET=0) }
-      WriteLn('    mov x25, x0');
-      WriteLn('    mov x0, x23');
-      WriteLn('    mov x1, x24');
-      WriteLn('    mov x2, #0');
-      WriteLn('    movz x16, #0xC7');
-      WriteLn('    movk x16, #0x200, lsl #16');
-      EmitSvc;
-      { Compare: x24 = current_pos, x25 = file_size }
-      { cmp x24, x25 }
-      WriteLn('    cmp x24, x25');
-      { cset x0, ge - x0 = 1 If current_pos >= file_size }
-      WriteLn('    cset x0, ge');
+      EmitBL(rt_eof);
       expr_type := TYPE_BOOLEAN
     End
     { filepos = 102,105,108,101,112,111,115 }
@@ -7465,14 +11996,14 @@ Begin
       EmitVarAddr(idx, scope_level);
       { ldr x0, [x0] - load fd }
       WriteLn('    ldr x0, [x0]');
-      { lseek(fd, 0, SEEK_CUR=1) To get current position }
-      WriteLn('    mov x1, #0');
-      WriteLn('    mov x2, #1');
-      { lseek syscall: 0x20000C7 }
-      WriteLn('    movz x16, #0xC7');
-      WriteLn('    movk x16, #0x200, lsl #16');
-      EmitSvc;
-      { x0 = current position }
+      EmitBL(rt_io_pos);
+      { Typed files count In elements }
+      If (sym_type[idx] = TYPE_FILE) And (sym_label[idx] > 1) Then
+      Begin
+        WriteLn('    mov x1, x0');
+        EmitMovX0(sym_label[idx]);
+        WriteLn('    sdiv x0, x1, x0')
+      End;
       expr_type := TYPE_INTEGER
     End
     { filesize = 102,105,108,101,115,105,122,101 }
@@ -7492,39 +12023,18 @@ Begin
         Error(9);
       NextToken;
       Expect(TOK_RPAREN);
-      { Get file fd And save For later }
+      { Get file fd }
       EmitVarAddr(idx, scope_level);
       { ldr x0, [x0] - load fd }
       WriteLn('    ldr x0, [x0]');
-      { Save fd To x23 }
-      WriteLn('    mov x23, x0');
-      { lseek(fd, 0, SEEK_CUR=1) To get current position (To restore later) }
-      WriteLn('    mov x1, #0');
-      WriteLn('    mov x2, #1');
-      { lseek syscall: 0x20000C7 }
-      WriteLn('    movz x16, #0xC7');
-      WriteLn('    movk x16, #0x200, lsl #16');
-      EmitSvc;
-      { x0 = current position, save To x24 }
-      WriteLn('    mov x24, x0');
-      { lseek(fd, 0, SEEK_END=2) To get file size }
-      WriteLn('    mov x0, x23');
-      WriteLn('    mov x1, #0');
-      WriteLn('    mov x2, #2');
-      WriteLn('    movz x16, #0xC7');
-      WriteLn('    movk x16, #0x200, lsl #16');
-      EmitSvc;
-      { x0 = file size, save To x25 }
-      WriteLn('    mov x25, x0');
-      { Restore file position: lseek(fd, current_pos, SEEK_SET=0) }
-      WriteLn('    mov x0, x23');
-      WriteLn('    mov x1, x24');
-      WriteLn('    mov x2, #0');
-      WriteLn('    movz x16, #0xC7');
-      WriteLn('    movk x16, #0x200, lsl #16');
-      EmitSvc;
-      { Move file size To x0 as return value }
-      WriteLn('    mov x0, x25');
+      EmitBL(rt_io_size);
+      { Typed files count In elements }
+      If (sym_type[idx] = TYPE_FILE) And (sym_label[idx] > 1) Then
+      Begin
+        WriteLn('    mov x1, x0');
+        EmitMovX0(sym_label[idx]);
+        WriteLn('    sdiv x0, x1, x0')
+      End;
       expr_type := TYPE_INTEGER
     End
     { copy = 99,111,112,121 }
@@ -7534,19 +12044,27 @@ Begin
       NextToken;
       Expect(TOK_LPAREN);
       { First arg: source String }
+      lbl2 := -1;
       If tok_type = TOK_IDENT Then
       Begin
         idx := SymLookup;
         If idx < 0 Then
           Error(3);
-        If sym_type[idx] <> TYPE_STRING Then
-          Error(9);
-        NextToken;
-        EmitVarAddr(idx, scope_level);  { source addr In x0 }
-        EmitPushX0
-      End
-      Else
-        Error(9);
+        If sym_type[idx] = TYPE_STRING Then
+        Begin
+          NextToken;
+          EmitVarAddr(idx, scope_level);  { source addr In x0 }
+          lbl2 := TYPE_STRING
+        End
+      End;
+      If lbl2 < 0 Then
+      Begin
+        ParseExpression;
+        lbl2 := expr_type;
+        If (lbl2 <> TYPE_STRING) And (lbl2 <> TYPE_ANSISTRING) Then
+          Error(9)
+      End;
+      EmitPushX0;
       Expect(TOK_COMMA);
       { Second arg: start index }
       ParseExpression;
@@ -7554,91 +12072,75 @@ Begin
       Expect(TOK_COMMA);
       { Third arg: count }
       ParseExpression;  { count In x0 }
-      { x0 = count, x1 = start, x2 = source addr }
-      WriteLn('    mov x3, x0');
-      EmitPopX1;  { start }
-      EmitPopX0;  { source addr -> x2 }
-      WriteLn('    mov x2, x0');
-      { Allocate temp String from heap: x0 = x21, x21 += 256 }
-      WriteLn('    mov x0, x21');
-      WriteLn('    add x21, x21, #256');
-      { Save dest addr }
-      EmitPushX0;
-      { Inline copy logic: copy from source[start] To dest, count bytes }
-      { x0 = dest, x1 = start, x2 = source, x3 = count }
-      { Store count as Length at dest[0] }
-      WriteLn('    strb w3, [x0]');
-      { Loop: copy count bytes from source[start+i] To dest[1+i] }
-      lbl1 := NewLabel;
-      WriteLn('    mov x4, #0');
-      EmitLabel(lbl1);
-      { cmp x4, x3 }
-      WriteLn('    cmp x4, x3');
-      { b.ge done }
-      Write('    b.ge L'); WriteLn(label_count);
-      { x5 = start + x4 (source index) }
-      WriteLn('    add x5, x1, x4');
-      { ldrb w6, [x2, x5] }
-      WriteLn('    ldrb w6, [x2, x5]');
-      { x5 = x4 + 1 (dest index) }
-      WriteLn('    add x5, x4, #1');
-      { strb w6, [x0, x5] }
-      WriteLn('    strb w6, [x0, x5]');
-      { x4 = x4 + 1 }
-      WriteLn('    add x4, x4, #1');
-      EmitBranchLabel(lbl1);
-      EmitLabel(label_count);
-      label_count := label_count + 1;
-      { Restore dest addr To x0 }
-      EmitPopX0;
+      If lbl2 = TYPE_ANSISTRING Then
+      Begin
+        { rt_ansi_copy(x0=source, x1=start, x2=count) }
+        WriteLn('    mov x2, x0');
+        EmitPopX1;
+        EmitPopX0;
+        EmitBL(rt_ansi_copy)
+      End
+      Else
+      Begin
+        { x0 = count, x1 = start, x2 = source addr }
+        WriteLn('    mov x3, x0');
+        EmitPopX1;  { start }
+        EmitPopX0;  { source addr -> x2 }
+        WriteLn('    mov x2, x0');
+        { Allocate temp String from heap: x0 = x21, x21 += 256 }
+        WriteLn('    mov x0, x21');
+        WriteLn('    add x21, x21, #256');
+        { Save dest addr }
+        EmitPushX0;
+        { Inline copy logic: copy from source[start] To dest, count bytes }
+        { x0 = dest, x1 = start, x2 = source, x3 = count }
+        { Store count as Length at dest[0] }
+        WriteLn('    strb w3, [x0]');
+        { Loop: copy count bytes from source[start+i] To dest[1+i] }
+        lbl1 := NewLabel;
+        WriteLn('    mov x4, #0');
+        EmitLabel(lbl1);
+        { cmp x4, x3 }
+        WriteLn('    cmp x4, x3');
+        { b.ge done }
+        Write('    b.ge L'); WriteLn(label_count);
+        { x5 = start + x4 (source index) }
+        WriteLn('    add x5, x1, x4');
+        { ldrb w6, [x2, x5] }
+        WriteLn('    ldrb w6, [x2, x5]');
+        { x5 = x4 + 1 (dest index) }
+        WriteLn('    add x5, x4, #1');
+        { strb w6, [x0, x5] }
+        WriteLn('    strb w6, [x0, x5]');
+        { x4 = x4 + 1 }
+        WriteLn('    add x4, x4, #1');
+        EmitBranchLabel(lbl1);
+        EmitLabel(label_count);
+        label_count := label_count + 1;
+        { Restore dest addr To x0 }
+        EmitPopX0;
+      End;
       Expect(TOK_RPAREN);
-      expr_type := TYPE_STRING
+      expr_type := lbl2
     End
     { concat = 99,111,110,99,97,116 }
     Else If (tok_len = 6) And (ToLower(tok_str[0]) = 99) And (ToLower(tok_str[1]) = 111) And
             (ToLower(tok_str[2]) = 110) And (ToLower(tok_str[3]) = 99) And (ToLower(tok_str[4]) = 97) And
             (ToLower(tok_str[5]) = 116) Then
     Begin
+      { Concat(s1, s2, ...) joins like s1 + s2 + ... }
       NextToken;
       Expect(TOK_LPAREN);
-      { First String }
-      If tok_type = TOK_IDENT Then
-      Begin
-        idx := SymLookup;
-        If idx < 0 Then
-          Error(3);
-        If sym_type[idx] <> TYPE_STRING Then
-          Error(9);
-        NextToken;
-        EmitVarAddr(idx, scope_level);  { string1 addr In x0 }
-        EmitPushX0
-      End
-      Else
-        Error(9);
-      Expect(TOK_COMMA);
-      { Second String }
-      If tok_type = TOK_IDENT Then
+      ParseExpression;
+      While tok_type = TOK_COMMA Do
       Begin
-        idx := SymLookup;
-        If idx < 0 Then
-          Error(3);
-        If sym_type[idx] <> TYPE_STRING Then
-          Error(9);
         NextToken;
-        EmitVarAddr(idx, scope_level);  { string2 addr In x0 }
-        { x0 = string2, stack top = string1 }
-        WriteLn('    mov x2, x0');
-        EmitPopX1;  { string1 }
-      End
-      Else
-        Error(9);
-      { Allocate temp String from heap: x0 = x21, x21 += 256 }
-      WriteLn('    mov x0, x21');
-      WriteLn('    add x21, x21, #256');
-      { Call rt_str_concat(x0=dest, x1=str1, x2=str2) }
-      EmitBL(rt_str_concat);
-      Expect(TOK_RPAREN);
-      expr_type := TYPE_STRING
+        lbl2 := expr_type;
+        EmitPushOperand;
+        ParseExpression;
+        EmitStrConcat(lbl2)
+      End;
+      Expect(TOK_RPAREN)
     End
     { trim = 116,114,105,109 }
     Else If (tok_len = 4) And (ToLower(tok_str[0]) = 116) And (ToLower(tok_str[1]) = 114) And
@@ -7706,23 +12208,29 @@ Begin
       EmitBL(rt_str_rtrim);
       expr_type := TYPE_STRING
     End
-    { pos = 112,111,115 }
-    Else If (tok_len = 3) And (ToLower(tok_str[0]) = 112) And (ToLower(tok_str[1]) = 111) And
-            (ToLower(tok_str[2]) = 115) Then
+    { pos = 112,111,115, posex = 112,111,115,101,120 }
+    Else If (TokIs8(112, 111, 115, 0, 0, 0, 0, 0) = 1) Or
+            (TokIs8(112, 111, 115, 101, 120, 0, 0, 0) = 1) Then
     Begin
+      { PosEx(substr, s, start) takes a third argument }
+      arg_count := 2;
+      If tok_len = 5 Then
+        arg_count := 3;
       NextToken;
       Expect(TOK_LPAREN);
       { First arg: substring }
+      lbl2 := -1;
       If tok_type = TOK_IDENT Then
       Begin
         idx := SymLookup;
         If idx < 0 Then
           Error(3);
-        If sym_type[idx] <> TYPE_STRING Then
-          Error(9);
-        NextToken;
-        EmitVarAddr(idx, scope_level);
-        EmitPushX0
+        If sym_type[idx] = TYPE_STRING Then
+        Begin
+          NextToken;
+          EmitVarAddr(idx, scope_level);
+          lbl2 := TYPE_STRING
+        End
       End
       Else If tok_type = TOK_STRING Then
       Begin
@@ -7737,33 +12245,94 @@ Begin
         End;
         WriteLn('    mov x0, x21');
         WriteLn('    add x21, x21, #256');
-        EmitPushX0;
+        lbl2 := TYPE_STRING;
         NextToken
-      End
-      Else
-        Error(9);
+      End;
+      If lbl2 < 0 Then
+      Begin
+        ParseExpression;
+        lbl2 := expr_type
+      End;
+      EmitPushOperand;
       Expect(TOK_COMMA);
       { Second arg: String To search In }
+      lbl1 := -1;
       If tok_type = TOK_IDENT Then
       Begin
         idx := SymLookup;
         If idx < 0 Then
           Error(3);
-        If sym_type[idx] <> TYPE_STRING Then
-          Error(9);
-        NextToken;
-        EmitVarAddr(idx, scope_level);  { String addr In x0 }
-        { mov x1, x0; pop x0 }
-        WriteLn('    mov x1, x0');
-        EmitPopX0  { substr In x0 }
+        If sym_type[idx] = TYPE_STRING Then
+        Begin
+          NextToken;
+          EmitVarAddr(idx, scope_level);  { String addr In x0 }
+          expr_type := TYPE_STRING;
+          lbl1 := 0
+        End
+      End;
+      If lbl1 < 0 Then
+        ParseExpression;
+      If (lbl2 = TYPE_ANSISTRING) Or (expr_type = TYPE_ANSISTRING) Then
+      Begin
+        { Either side an AnsiString: rt_ansi_posex(x0=substr, x1=String, }
+        { x2=start) }
+        EmitAnsiOperands(lbl2);
+        If arg_count = 3 Then
+        Begin
+          EmitPushX0;
+          WriteLn('    str x1, [sp, #-16]!');
+          Expect(TOK_COMMA);
+          ParseExpression;
+          WriteLn('    mov x2, x0');
+          EmitPopX1;
+          EmitPopX0
+        End
+        Else
+          WriteLn('    mov x2, #1');
+        EmitBL(rt_ansi_posex)
       End
       Else
-        Error(9);
-      { Call rt_str_pos(x0=substr, x1=String) }
-      EmitBL(rt_str_pos);
+      Begin
+        If (lbl2 <> TYPE_STRING) Or (expr_type <> TYPE_STRING) Then
+          Error(9);
+        If arg_count = 3 Then
+        Begin
+          { Third arg: start position }
+          EmitPushX0;
+          Expect(TOK_COMMA);
+          ParseExpression;
+          WriteLn('    mov x2, x0');
+          EmitPopX1;  { String }
+          EmitPopOperandTo(0);  { substr }
+          { Call rt_str_posex(x0=substr, x1=String, x2=start) }
+          EmitBL(rt_str_posex)
+        End
+        Else
+        Begin
+          WriteLn('    mov x1, x0');
+          EmitPopOperandTo(0);  { substr In x0 }
+          { Call rt_str_pos(x0=substr, x1=String) }
+          EmitBL(rt_str_pos)
+        End
+      End;
       Expect(TOK_RPAREN);
       expr_type := TYPE_INTEGER
     End
+    Else If TokIs8(109, 101, 109, 97, 118, 97, 105, 108) = 1 Then
+    Begin
+      { MemAvail - free bytes In the heap mapped so far }
+      NextToken;
+      EmitBL(rt_heap_avail);
+      expr_type := TYPE_INTEGER
+    End
+    Else If TokIs8(109, 97, 120, 97, 118, 97, 105, 108) = 1 Then
+    Begin
+      { MaxAvail - largest block New Or GetMem can get without growing }
+      NextToken;
+      EmitBL(rt_heap_avail);
+      WriteLn('    mov x0, x1');
+      expr_type := TYPE_INTEGER
+    End
     { paramcount = 112,97,114,97,109,99,111,117,110,116 }
     Else If (tok_len = 10) And (ToLower(tok_str[0]) = 112) And (ToLower(tok_str[1]) = 97) And
             (ToLower(tok_str[2]) = 114) And (ToLower(tok_str[3]) = 97) And (ToLower(tok_str[4]) = 109) And
@@ -7803,7 +12372,9 @@ Begin
   Begin
     NextToken;
     ParseFactor;
-    If expr_type = TYPE_REAL Then
+    If expr_const = 1 Then
+      expr_const_val := 0 - expr_const_val
+    Else If expr_type = TYPE_REAL Then
       EmitFNeg
     Else
       EmitNeg
@@ -7817,9 +12388,195 @@ Begin
     ParseFactor
 End;
 
+Function EmitPopRealOperand(left_type: Integer): Integer;
+Var
+  r: Integer;
+Begin
+  { Pop the left operand Of a float op And Return the d register }
+  { holding it, converting an Integer one To float In d1 }
+  If left_type = TYPE_REAL Then
+    EmitPopRealOperand := EmitPopOperandD(1)
+  Else
+  Begin
+    r := EmitPopOperand(1);
+    Write('    scvtf d1, x'); WriteLn(r);
+    EmitPopRealOperand := 1
+  End
+End;
+
+Function FoldsConst(op, lc, left_type: Integer): Integer;
+Begin
+  { 1 If a constant left operand (lc = 1) And the constant right one just }
+  { parsed combine at compile time under op. Char operands count as their }
+  { codes: Char + Char is an Integer add here, As In EmitIntOp }
+  FoldsConst := 0;
+  If (lc = 1) And (expr_const = 1) Then
+    If ((left_type = TYPE_INTEGER) Or (left_type = TYPE_CHAR)) And
+       ((expr_type = TYPE_INTEGER) Or (expr_type = TYPE_CHAR)) Then
+    Begin
+      If (op = TOK_DIV) Or (op = TOK_MOD) Then
+      Begin
+        { Leave division by zero To run time }
+        If expr_const_val <> 0 Then
+          FoldsConst := 1
+      End
+      Else If op <> TOK_SLASH Then
+        FoldsConst := 1
+    End
+End;
+
+Function FoldIntOp(op, a, b: Integer): Integer;
+Begin
+  { a op b For an arithmetic Or comparison operator; comparisons give 0/1 }
+  FoldIntOp := 0;
+  If op = TOK_PLUS Then FoldIntOp := a + b
+  Else If op = TOK_MINUS Then FoldIntOp := a - b
+  Else If op = TOK_STAR Then FoldIntOp := a * b
+  Else If op = TOK_DIV Then FoldIntOp := a Div b
+  Else If op = TOK_MOD Then FoldIntOp := a Mod b
+  Else If op = TOK_EQ Then
+  Begin
+    If a = b Then FoldIntOp := 1
+  End
+  Else If op = TOK_NEQ Then
+  Begin
+    If a <> b Then FoldIntOp := 1
+  End
+  Else If op = TOK_LT Then
+  Begin
+    If a < b Then FoldIntOp := 1
+  End
+  Else If op = TOK_LE Then
+  Begin
+    If a <= b Then FoldIntOp := 1
+  End
+  Else If op = TOK_GT Then
+  Begin
+    If a > b Then FoldIntOp := 1
+  End
+  Else If op = TOK_GE Then
+  Begin
+    If a >= b Then FoldIntOp := 1
+  End
+End;
+
+Function IntOperands(left_type: Integer): Integer;
+Begin
+  { 1 If neither operand takes the Real, Set Or String code paths }
+  IntOperands := 0;
+  If (left_type <> TYPE_REAL) And (left_type <> TYPE_SET) And
+     (left_type <> TYPE_STRING) And (left_type <> TYPE_ANSISTRING) And
+     (expr_type <> TYPE_REAL) And (expr_type <> TYPE_SET) And
+     (expr_type <> TYPE_STRING) And (expr_type <> TYPE_ANSISTRING) Then
+    IntOperands := 1
+End;
+
+Function EmitConstIntOp(op, lc, lval, left_type: Integer): Integer;
+Var
+  c: Integer;
+Begin
+  { *, Div, Mod, + Or - Of integers With exactly one constant side: emit }
+  { the strength-reduced Or immediate form And Return 1, Else Return 0 }
+  EmitConstIntOp := 0;
+  If ((op = TOK_STAR) Or (op = TOK_DIV) Or (op = TOK_MOD)) And
+     (left_type <> TYPE_REAL) And (left_type <> TYPE_SET) And
+     (expr_type <> TYPE_REAL) And (expr_type <> TYPE_SET) Then
+  Begin
+    If (lc = 0) And (expr_const = 1) Then
+    Begin
+      c := expr_const_val;
+      expr_const := 0;
+      If op = TOK_STAR Then
+        EmitMulConst(EmitPopOperand(1), c)
+      Else If op = TOK_DIV Then
+        EmitDivConst(EmitPopOperand(1), c)
+      Else
+        EmitModConst(EmitPopOperand(1), c);
+      EmitConstIntOp := 1
+    End
+    Else If (lc = 1) And (expr_const = 0) And (op = TOK_STAR) Then
+    Begin
+      { Constant * x: the right operand is already In x0 }
+      EmitMulConst(0, lval);
+      EmitConstIntOp := 1
+    End
+  End
+  Else If ((op = TOK_PLUS) Or (op = TOK_MINUS)) And (IntOperands(left_type) = 1) And
+          (left_type <> TYPE_POINTER) And
+          ((left_type <> TYPE_CHAR) Or (expr_type <> TYPE_CHAR)) Then
+  Begin
+    If (lc = 0) And (expr_const = 1) Then
+    Begin
+      c := expr_const_val;
+      If op = TOK_MINUS Then
+        c := 0 - c;
+      If ArithImmFits(c) = 1 Then
+      Begin
+        expr_const := 0;
+        EmitAddImm(0, EmitPopOperand(1), c);
+        EmitConstIntOp := 1
+      End
+    End
+    Else If (lc = 1) And (expr_const = 0) And (op = TOK_PLUS) Then
+    Begin
+      { Constant + x: add it To the right operand In x0 }
+      If ArithImmFits(lval) = 1 Then
+      Begin
+        EmitAddImm(0, 0, lval);
+        EmitConstIntOp := 1
+      End
+    End
+  End
+End;
+
+Function CmpCond(op: Integer): Integer;
+Begin
+  { EmitCset condition For a comparison operator }
+  If op = TOK_EQ Then CmpCond := 0
+  Else If op = TOK_NEQ Then CmpCond := 1
+  Else If op = TOK_LT Then CmpCond := 2
+  Else If op = TOK_LE Then CmpCond := 3
+  Else If op = TOK_GT Then CmpCond := 4
+  Else CmpCond := 5
+End;
+
+Function EmitConstCmp(op, lc, lval, left_type: Integer): Integer;
+Var
+  cond: Integer;
+Begin
+  { Integer comparison With exactly one constant side that fits an }
+  { immediate: emit cmp/cmn And cset, Return 1, Else Return 0 }
+  EmitConstCmp := 0;
+  If IntOperands(left_type) = 1 Then
+  Begin
+    cond := CmpCond(op);
+    If (lc = 0) And (expr_const = 1) Then
+    Begin
+      If ArithImmFits(expr_const_val) = 1 Then
+      Begin
+        expr_const := 0;
+        EmitCmpImm(EmitPopOperand(1), expr_const_val);
+        EmitCset(cond);
+        EmitConstCmp := 1
+      End
+    End
+    Else If (lc = 1) And (expr_const = 0) And (ArithImmFits(lval) = 1) Then
+    Begin
+      { Constant op x is tested As x op' constant, With op' mirrored }
+      If cond = 2 Then cond := 4
+      Else If cond = 3 Then cond := 5
+      Else If cond = 4 Then cond := 2
+      Else If cond = 5 Then cond := 3;
+      EmitCmpImm(0, lval);
+      EmitCset(cond);
+      EmitConstCmp := 1
+    End
+  End
+End;
+
 Procedure ParseTerm;
 Var
-  op, left_type, and_skip_label, had_and: Integer;
+  op, left_type, and_skip_label, had_and, lc, lval, done: Integer;
 Begin
   ParseUnary;
   had_and := 0;
@@ -7840,87 +12597,73 @@ Begin
         had_and := 1
       End;
       { cbz x0, .Lskip - branch If zero }
+      EmitConstFlush;
       EmitBranchLabelZ(and_skip_label);
       ParseUnary;
+      EmitConstFlush;
       expr_type := TYPE_INTEGER
     End
     Else
     Begin
-      { Regular operators - push left, eval right, pop, compute }
-      If left_type = TYPE_REAL Then
-        EmitPushD0
-      Else
-        EmitPushX0;
+      { Regular operators - hold left In an operand slot, eval right, compute. }
+      { A constant left operand is only materialized If the op does Not fold }
+      lc := expr_const;
+      lval := expr_const_val;
+      expr_const := 0;
+      If lc = 0 Then
+      Begin
+        If left_type = TYPE_REAL Then
+          EmitPushOperandD0
+        Else
+          EmitPushOperand
+      End;
       ParseUnary;
       { right operand is now In x0 Or d0 depending on expr_type }
+      done := 0;
+      If FoldsConst(op, lc, left_type) = 0 Then
+      Begin
+        done := EmitConstIntOp(op, lc, lval, left_type);
+        EmitConstFlush;
+        If (lc = 1) And (done = 0) Then
+          EmitPushConstOperand(lval)
+      End;
 
-      If op = TOK_SLASH Then
+      If done = 1 Then
+        expr_type := TYPE_INTEGER
+      Else If expr_const = 1 Then
       Begin
-        { / always produces Real - convert both operands To float }
-        If expr_type <> TYPE_REAL Then
-          EmitScvtfD0X0;  { convert right To float }
-        If left_type = TYPE_REAL Then
-          EmitPopD1
-        Else
-        Begin
-          EmitPopX1;
-          EmitScvtfD1X1  { convert left To float }
-        End;
-        EmitFDiv;
-        expr_type := TYPE_REAL
+        { Both sides constant }
+        expr_const_val := FoldIntOp(op, lval, expr_const_val);
+        expr_type := TYPE_INTEGER
       End
-      Else If (left_type = TYPE_REAL) Or (expr_type = TYPE_REAL) Then
+      Else If (op = TOK_SLASH) Or (left_type = TYPE_REAL) Or (expr_type = TYPE_REAL) Then
       Begin
-        { Mixed Or both Real - use float ops }
+        { / always produces Real; Mixed Or both Real - use float ops }
         If expr_type <> TYPE_REAL Then
           EmitScvtfD0X0;  { convert right To float }
-        If left_type = TYPE_REAL Then
-          EmitPopD1
-        Else
-        Begin
-          EmitPopX1;
-          EmitScvtfD1X1  { convert left To float }
-        End;
-        If op = TOK_STAR Then
-          EmitFMul
-        Else If op = TOK_DIV Then
+        If op = TOK_MOD Then
+          Error(13);  { Mod Not supported For reals }
+        EmitFloatOp(op, EmitPopRealOperand(left_type));
+        If op = TOK_DIV Then
         Begin
           { Div on floats - truncate result To Integer }
-          EmitFDiv;
           EmitFcvtzsX0D0;
           expr_type := TYPE_INTEGER
         End
-        Else If op = TOK_MOD Then
-          Error(13);  { Mod Not supported For reals }
-        If (op = TOK_STAR) Then
+        Else
           expr_type := TYPE_REAL
       End
       Else If (left_type = TYPE_SET) Or (expr_type = TYPE_SET) Then
       Begin
         { Set intersection: x0 = x1 And x0 }
-        EmitPopX1;
+        EmitPopOperandTo(1);
         WriteLn('    And x0, x1, x0');
         expr_type := TYPE_SET
       End
       Else
       Begin
         { Both integers - use Integer ops }
-        EmitPopX1;
-        If op = TOK_STAR Then
-          EmitMul
-        Else If op = TOK_DIV Then
-          EmitSDiv
-        Else If op = TOK_MOD Then
-        Begin
-          { x1 Mod x0: x1 - (x1 / x0) * x0 }
-          EmitPushX0;
-          EmitPushX1;
-          EmitSDiv;
-          EmitMovX2X0;
-          EmitPopX1;
-          EmitPopX0;
-          EmitMsub
-        End;
+        EmitIntOp(op, EmitPopOperand(1));
         expr_type := TYPE_INTEGER
       End
     End
@@ -7933,7 +12676,7 @@ End;
 
 Procedure ParseSimpleExpr;
 Var
-  op, left_type, left_ptr_base, or_true_label, or_end_label, had_or: Integer;
+  op, left_type, left_ptr_base, or_true_label, or_end_label, had_or, lc, lval, done: Integer;
 Begin
   ParseTerm;
   had_or := 0;
@@ -7956,23 +12699,47 @@ Begin
         had_or := 1
       End;
       { cbnz x0, .Ltrue - branch If Not zero }
+      EmitConstFlush;
       EmitBranchLabelNZ(or_true_label);
       ParseTerm;
+      EmitConstFlush;
       expr_type := TYPE_INTEGER
     End
     Else
     Begin
-      { Regular operators (+, -) - push left, eval right, pop, compute }
-      If left_type = TYPE_REAL Then
-        EmitPushD0
-      Else
-        EmitPushX0;
+      { Regular operators (+, -) - hold left In an operand slot, eval right, compute }
+      lc := expr_const;
+      lval := expr_const_val;
+      expr_const := 0;
+      If lc = 0 Then
+      Begin
+        If left_type = TYPE_REAL Then
+          EmitPushOperandD0
+        Else
+          EmitPushOperand
+      End;
       ParseTerm;
+      done := 0;
+      If FoldsConst(op, lc, left_type) = 0 Then
+      Begin
+        done := EmitConstIntOp(op, lc, lval, left_type);
+        EmitConstFlush;
+        If (lc = 1) And (done = 0) Then
+          EmitPushConstOperand(lval)
+      End;
 
-      If (left_type = TYPE_POINTER) And (op = TOK_PLUS) Then
+      If done = 1 Then
+        expr_type := TYPE_INTEGER
+      Else If expr_const = 1 Then
+      Begin
+        { Both sides constant }
+        expr_const_val := FoldIntOp(op, lval, expr_const_val);
+        expr_type := TYPE_INTEGER
+      End
+      Else If (left_type = TYPE_POINTER) And (op = TOK_PLUS) Then
     Begin
       { pointer + Integer: scale Integer by 8 And SUBTRACT (arrays grow downward) }
-      EmitPopX1;  { pointer In x1 }
+      EmitPopOperandTo(1);  { pointer In x1 }
       { x0 has Integer offset, multiply by 8 using lsl #3 }
       WriteLn('    lsl x0, x0, #3');
       EmitSub;  { x0 = x1 - x0 (subtract because arrays grow downward) }
@@ -7984,7 +12751,7 @@ Begin
       If expr_type = TYPE_POINTER Then
       Begin
         { pointer - pointer: returns Integer count (negated For downward growth) }
-        EmitPopX1;  { left pointer In x1 }
+        EmitPopOperandTo(1);  { left pointer In x1 }
         EmitSub;  { x0 = x1 - x0 }
         { Negate And divide by 8 For correct count }
         EmitNeg;  { x0 = -(x1 - x0) = x0 - x1 }
@@ -7995,7 +12762,7 @@ Begin
       Else
       Begin
         { pointer - Integer: scale Integer by 8 And ADD (arrays grow downward) }
-        EmitPopX1;  { pointer In x1 }
+        EmitPopOperandTo(1);  { pointer In x1 }
         { x0 has Integer offset, multiply by 8 using lsl #3 }
         WriteLn('    lsl x0, x0, #3');
         EmitAdd;  { x0 = x1 + x0 (add because arrays grow downward) }
@@ -8003,63 +12770,14 @@ Begin
         ptr_base_type := left_ptr_base
       End
     End
-    Else If (left_type = TYPE_STRING) And (expr_type = TYPE_STRING) And (op = TOK_PLUS) Then
-    Begin
-      { String concatenation: str1 + str2 }
-      { x0 = string2 addr, stack top = string1 addr }
-      WriteLn('    mov x2, x0');
-      EmitPopX1;  { string1 addr }
-      { Allocate temp String from heap }
-      WriteLn('    mov x0, x21');
-      WriteLn('    add x21, x21, #256');
-      { Call rt_str_concat(x0=dest, x1=str1, x2=str2) }
-      EmitBL(rt_str_concat);
-      expr_type := TYPE_STRING
-    End
-    Else If (((left_type = TYPE_STRING) And (expr_type = TYPE_CHAR)) Or
-             ((left_type = TYPE_CHAR) And (expr_type = TYPE_STRING))) And (op = TOK_PLUS) Then
-    Begin
-      { String + Char Or Char + String concatenation }
-      { Need To convert Char To a single-character String, Then concatenate }
-      If left_type = TYPE_STRING Then
-      Begin
-        { String + Char: x0 = Char, stack top = String addr }
-        { Create single-Char String from x0 on heap }
-        WriteLn('    mov x3, x0');
-        WriteLn('    mov x2, x21');
-        EmitMovX0(1);  { Length = 1 }
-        WriteLn('    strb w0, [x2]');
-        WriteLn('    strb w3, [x2, #1]');
-        WriteLn('    add x21, x21, #256');
-        EmitPopX1;  { string1 addr }
-        { x2 = Char String, x1 = string1, allocate result on heap }
-        WriteLn('    mov x0, x21');
-        WriteLn('    add x21, x21, #256');
-        EmitBL(rt_str_concat)
-      End
-      Else
-      Begin
-        { Char + String: x0 = String addr, stack top = Char }
-        WriteLn('    mov x2, x0');
-        EmitPopX0;  { x0 = Char }
-        { Create single-Char String from x0 on heap }
-        WriteLn('    mov x1, x21');
-        WriteLn('    mov x3, x0');
-        EmitMovX0(1);  { Length = 1 }
-        WriteLn('    strb w0, [x1]');
-        WriteLn('    strb w3, [x1, #1]');
-        WriteLn('    add x21, x21, #256');
-        { x1 = Char String, x2 = string2, allocate result on heap }
-        WriteLn('    mov x0, x21');
-        WriteLn('    add x21, x21, #256');
-        EmitBL(rt_str_concat)
-      End;
-      expr_type := TYPE_STRING
-    End
+    Else If ((left_type = TYPE_STRING) Or (expr_type = TYPE_STRING) Or
+             (left_type = TYPE_ANSISTRING) Or (expr_type = TYPE_ANSISTRING)) And (op = TOK_PLUS) Then
+      { String concatenation, With a Char On either side made a String }
+      EmitStrConcat(left_type)
     Else If (left_type = TYPE_SET) Or (expr_type = TYPE_SET) Then
     Begin
       { Set operations: + is union, - is difference }
-      EmitPopX1;  { left Set In x1 }
+      EmitPopOperandTo(1);  { left Set In x1 }
       If op = TOK_PLUS Then
       Begin
         { Union: x0 = x1 Or x0 }
@@ -8080,29 +12798,13 @@ Begin
       { Mixed Or both Real - use float ops }
       If expr_type <> TYPE_REAL Then
         EmitScvtfD0X0;  { convert right To float }
-      If left_type = TYPE_REAL Then
-        EmitPopD1
-      Else
-      Begin
-        EmitPopX1;
-        EmitScvtfD1X1  { convert left To float }
-      End;
-      If op = TOK_PLUS Then
-        EmitFAdd
-      Else If op = TOK_MINUS Then
-        EmitFSub
-      Else { TOK_OR }
-        Error(13);  { Or Not supported For reals }
+      EmitFloatOp(op, EmitPopRealOperand(left_type));
       expr_type := TYPE_REAL
     End
     Else
     Begin
       { Both integers (only + And - reach here) }
-      EmitPopX1;
-      If op = TOK_PLUS Then
-        EmitAdd
-      Else
-        EmitSub;
+      EmitIntOp(op, EmitPopOperand(1));
       expr_type := TYPE_INTEGER
     End
     End  { End Of Else For non-Or operators }
@@ -8119,10 +12821,12 @@ Begin
   End
 End;
 
-Procedure ParseExpression;
+Procedure ParseFoldedExpr;
 Var
-  op, cond, left_type: Integer;
+  op, cond, left_type, lc, lval, done: Integer;
 Begin
+  { Like ParseExpression, but a constant result is left pending In }
+  { expr_const_val instead Of being loaded into x0 }
   ParseSimpleExpr;
   If (tok_type = TOK_EQ) Or (tok_type = TOK_NEQ) Or (tok_type = TOK_LT) Or
      (tok_type = TOK_LE) Or (tok_type = TOK_GT) Or (tok_type = TOK_GE) Then
@@ -8130,19 +12834,56 @@ Begin
     op := tok_type;
     left_type := expr_type;
     NextToken;
-    { Push left operand appropriately }
-    If left_type = TYPE_REAL Then
-      EmitPushD0
-    Else
-      EmitPushX0;
+    { Hold left operand In an operand slot unless it is a constant }
+    lc := expr_const;
+    lval := expr_const_val;
+    expr_const := 0;
+    If lc = 0 Then
+    Begin
+      If left_type = TYPE_REAL Then
+        EmitPushOperandD0
+      Else
+        EmitPushOperand
+    End;
     ParseSimpleExpr;
+    done := 0;
+    If FoldsConst(op, lc, left_type) = 0 Then
+    Begin
+      done := EmitConstCmp(op, lc, lval, left_type);
+      EmitConstFlush;
+      If (lc = 1) And (done = 0) Then
+        EmitPushConstOperand(lval)
+    End;
 
-    If (left_type = TYPE_STRING) And (expr_type = TYPE_STRING) Then
+    If done = 1 Then
+      expr_type := TYPE_INTEGER
+    Else If expr_const = 1 Then
+    Begin
+      { Both sides constant }
+      expr_const_val := FoldIntOp(op, lval, expr_const_val);
+      expr_type := TYPE_INTEGER
+    End
+    Else If (left_type = TYPE_ANSISTRING) Or (expr_type = TYPE_ANSISTRING) Then
+    Begin
+      { AnsiString comparison: rt_ansi_cmp returns -1/0/1 }
+      EmitAnsiOperands(left_type);
+      EmitBL(rt_ansi_cmp);
+      WriteLn('    cmp x0, #0');
+      If op = TOK_EQ Then cond := 0
+      Else If op = TOK_NEQ Then cond := 1
+      Else If op = TOK_LT Then cond := 2
+      Else If op = TOK_LE Then cond := 3
+      Else If op = TOK_GT Then cond := 4
+      Else cond := 5;
+      EmitCset(cond);
+      expr_type := TYPE_INTEGER
+    End
+    Else If (left_type = TYPE_STRING) And (expr_type = TYPE_STRING) Then
     Begin
       { String comparison }
-      { x0 = string2 addr, stack top = string1 addr }
+      { x0 = string2 addr, top slot = string1 addr }
       WriteLn('    mov x1, x0');
-      EmitPopX0;  { string1 addr In x0 }
+      EmitPopOperandTo(0);  { string1 addr In x0 }
       If (op = TOK_EQ) Or (op = TOK_NEQ) Then
       Begin
         { Call rt_str_compare(x0=str1, x1=str2) - returns 1 If equal, 0 If Not }
@@ -8183,18 +12924,11 @@ Begin
       expr_type := TYPE_INTEGER
     End
     Else If (left_type = TYPE_REAL) Or (expr_type = TYPE_REAL) Then
-    Begin
-      { Float comparison }
-      If expr_type <> TYPE_REAL Then
-        EmitScvtfD0X0;  { convert right To float }
-      If left_type = TYPE_REAL Then
-        EmitPopD1
-      Else
-      Begin
-        EmitPopX1;
-        EmitScvtfD1X1  { convert left To float }
-      End;
-      EmitFCmp;
+    Begin
+      { Float comparison }
+      If expr_type <> TYPE_REAL Then
+        EmitScvtfD0X0;  { convert right To float }
+      EmitFCmpReg(EmitPopRealOperand(left_type));
       If op = TOK_EQ Then cond := 0
       Else If op = TOK_NEQ Then cond := 1
       Else If op = TOK_LT Then cond := 2
@@ -8207,15 +12941,8 @@ Begin
     Else
     Begin
       { Integer comparison }
-      EmitPopX1;
-      EmitCmpX0X1;
-      If op = TOK_EQ Then cond := 0
-      Else If op = TOK_NEQ Then cond := 1
-      Else If op = TOK_LT Then cond := 2
-      Else If op = TOK_LE Then cond := 3
-      Else If op = TOK_GT Then cond := 4
-      Else cond := 5;
-      EmitCset(cond);
+      EmitCmpReg(EmitPopOperand(1));
+      EmitCset(CmpCond(op));
       expr_type := TYPE_INTEGER
     End
   End
@@ -8223,20 +12950,263 @@ Begin
   Begin
     { Set membership: value In Set }
     { x0 = value, need To check If bit is Set In the Set }
-    EmitPushX0;  { push value }
+    EmitConstFlush;
+    EmitPushOperand;  { hold value }
     NextToken;
     ParseSimpleExpr;  { Set In x0 }
-    { x0 = Set, stack = value }
+    EmitConstFlush;
     { Result: (Set >> value) & 1 }
-    EmitPopX1;  { value In x1 }
-    { lsr x0, x0, x1 }
-    WriteLn('    lsr x0, x0, x1');
+    Write('    lsr x0, x0, x'); WriteLn(EmitPopOperand(1));
     { And x0, x0, #1 }
     EmitAndImm(1);
     expr_type := TYPE_BOOLEAN
   End
 End;
 
+Procedure ParseExpression;
+Begin
+  ParseFoldedExpr;
+  EmitConstFlush
+End;
+
+Procedure EmitWriteValue;
+Begin
+  { Print the expression just parsed by Write/WriteLn, With an optional }
+  { field width (x:w) And, For reals, decimals (x:w:d) }
+  If expr_type = TYPE_REAL Then
+  Begin
+    If tok_type = TOK_COLON Then
+    Begin
+      EmitPushD0;
+      NextToken;
+      ParseExpression;
+      If tok_type = TOK_COLON Then
+      Begin
+        EmitPushX0;
+        NextToken;
+        ParseExpression;
+        WriteLn('    mov x1, x0');
+        EmitPopX0
+      End
+      Else
+        WriteLn('    movn x1, #0');
+      EmitPopD0
+    End
+    Else
+    Begin
+      EmitMovX0(0);
+      WriteLn('    movn x1, #0')
+    End;
+    EmitBL(rt_print_real)
+  End
+  Else If expr_type = TYPE_STRING Then
+    EmitBL(rt_print_string)
+  Else If expr_type = TYPE_ANSISTRING Then
+    EmitBL(rt_print_ansi)
+  Else If tok_type = TOK_COLON Then
+  Begin
+    EmitPushX0;
+    NextToken;
+    ParseExpression;
+    WriteLn('    mov x1, x0');
+    EmitPopX0;
+    EmitBL(rt_print_int_w)
+  End
+  Else
+    EmitBL(rt_print_int)
+End;
+
+Procedure EmitFileCall(rt, f_idx, elem_size, stride, slot: Integer);
+Begin
+  { Call rt_file_read Or rt_file_write For file variable f_idx. The }
+  { stack holds the first slot's address under the element count }
+  EmitMovX0(stride);
+  WriteLn('    mov x4, x0');
+  EmitMovX0(slot);
+  WriteLn('    mov x5, x0');
+  EmitMovX0(elem_size);
+  WriteLn('    mov x2, x0');
+  EmitVarAddr(f_idx, scope_level);
+  WriteLn('    ldr x0, [x0]');
+  WriteLn('    ldr x3, [sp], #16');
+  WriteLn('    ldr x1, [sp], #16');
+  EmitBL(rt)
+End;
+
+Procedure ParseFileVarAddr(f_idx: Integer);
+Var
+  idx, fi: Integer;
+Begin
+  { Address Of a variable matching the element Type Of typed file f_idx }
+  fi := sym_const_val[f_idx];
+  If tok_type <> TOK_IDENT Then
+    Error(6);
+  idx := SymLookup;
+  If idx < 0 Then
+    Error(3);
+  If file_elem_type[fi] = TYPE_RECORD Then
+  Begin
+    If (sym_type[idx] <> TYPE_RECORD) Or (sym_const_val[idx] <> file_rec_idx[fi]) Then
+      Error(19)
+  End
+  Else If sym_type[idx] <> file_elem_type[fi] Then
+    Error(19);
+  NextToken;
+  EmitVarAddr(idx, scope_level);
+  If sym_is_var_param[idx] = 1 Then
+    WriteLn('    ldr x0, [x0]')
+End;
+
+Procedure ParseFileRead(f_idx: Integer);
+Var
+  size, slot: Integer;
+Begin
+  { Read(f, v1, v2, ...) On a typed file - one element into each variable }
+  size := sym_label[f_idx];
+  slot := 8;
+  If file_elem_type[sym_const_val[f_idx]] = TYPE_RECORD Then
+    slot := size;
+  ParseFileVarAddr(f_idx);
+  EmitPushX0;
+  EmitMovX0(1);
+  EmitPushX0;
+  EmitFileCall(rt_file_read, f_idx, size, slot, slot);
+  While tok_type = TOK_COMMA Do
+  Begin
+    NextToken;
+    ParseFileVarAddr(f_idx);
+    EmitPushX0;
+    EmitMovX0(1);
+    EmitPushX0;
+    EmitFileCall(rt_file_read, f_idx, size, slot, slot)
+  End
+End;
+
+Procedure ParseFileWrite(f_idx: Integer);
+Var
+  size, elem: Integer;
+Begin
+  { Write(f, e1, e2, ...) On a typed file - one element per argument. }
+  { Records come from a variable, other values go through a stack slot }
+  size := sym_label[f_idx];
+  elem := file_elem_type[sym_const_val[f_idx]];
+  While tok_type <> TOK_RPAREN Do
+  Begin
+    If elem = TYPE_RECORD Then
+      ParseFileVarAddr(f_idx)
+    Else
+    Begin
+      ParseExpression;
+      If elem = TYPE_REAL Then
+      Begin
+        If expr_type <> TYPE_REAL Then
+          EmitScvtfD0X0;
+        EmitFmovX0D0
+      End
+      Else If (expr_type = TYPE_REAL) Or (expr_type = TYPE_STRING) Then
+        Error(19);
+      EmitPushX0;
+      WriteLn('    mov x0, sp')
+    End;
+    EmitPushX0;
+    EmitMovX0(1);
+    EmitPushX0;
+    EmitFileCall(rt_file_write, f_idx, size, size, size);
+    If elem <> TYPE_RECORD Then
+      EmitAddSP(16);
+    If tok_type = TOK_COMMA Then
+      NextToken
+    Else If tok_type <> TOK_RPAREN Then
+      Error(9)
+  End
+End;
+
+Procedure ParseBlockTransfer(rt: Integer);
+Var
+  f_idx, idx, size, slot, stride: Integer;
+Begin
+  { BlockRead/BlockWrite(f, buf, count [, result]) - count elements Of }
+  { the file (bytes For a Text file) To Or from buf. An Array transfers }
+  { from its first element on, p^ from the memory p points To }
+  NextToken;
+  Expect(TOK_LPAREN);
+  If tok_type <> TOK_IDENT Then
+    Error(6);
+  f_idx := SymLookup;
+  If f_idx < 0 Then
+    Error(3);
+  If sym_type[f_idx] = TYPE_FILE Then
+    size := sym_label[f_idx]
+  Else If sym_type[f_idx] = TYPE_TEXT Then
+    size := 1
+  Else
+    Error(9);
+  NextToken;
+  Expect(TOK_COMMA);
+  If tok_type <> TOK_IDENT Then
+    Error(6);
+  idx := SymLookup;
+  If idx < 0 Then
+    Error(3);
+  NextToken;
+  slot := size;
+  stride := size;
+  If sym_type[idx] = TYPE_ARRAY Then
+  Begin
+    { Elements are stored downward from the first one }
+    If sym_var_param_flags[idx] > 0 Then
+      slot := sym_label[sym_var_param_flags[idx] - 1]
+    Else If sym_var_param_flags[idx] = -1 Then
+      slot := 256
+    Else
+      slot := 8;
+    If slot < size Then
+      Error(19);
+    stride := 0 - slot;
+    EmitVarAddr(idx, scope_level)
+  End
+  Else If (sym_type[idx] = TYPE_POINTER) And (tok_type = TOK_CARET) Then
+  Begin
+    NextToken;
+    If sym_level[idx] < scope_level Then
+      EmitLdurX0Outer(sym_offset[idx], sym_level[idx], scope_level)
+    Else
+      EmitLdurX0(sym_offset[idx]);
+    If sym_is_var_param[idx] = 1 Then
+      WriteLn('    ldr x0, [x0]')
+  End
+  Else
+  Begin
+    EmitVarAddr(idx, scope_level);
+    If sym_is_var_param[idx] = 1 Then
+      WriteLn('    ldr x0, [x0]')
+  End;
+  EmitPushX0;
+  Expect(TOK_COMMA);
+  ParseExpression;
+  EmitPushX0;
+  EmitFileCall(rt, f_idx, size, stride, slot);
+  If tok_type = TOK_COMMA Then
+  Begin
+    { Optional result: elements actually transferred }
+    NextToken;
+    If tok_type <> TOK_IDENT Then
+      Error(6);
+    idx := SymLookup;
+    If idx < 0 Then
+      Error(3);
+    NextToken;
+    EmitPushX0;
+    EmitVarAddr(idx, scope_level);
+    If sym_is_var_param[idx] = 1 Then
+      WriteLn('    ldr x0, [x0]');
+    WriteLn('    mov x1, x0');
+    EmitPopX0;
+    WriteLn('    str x0, [x1]')
+  End;
+  Expect(TOK_RPAREN)
+End;
+
 Procedure ParseStatement;
 Var
   idx, lbl1, lbl2, lbl3, arg_count, i: Integer;
@@ -8517,49 +13487,68 @@ Begin
     idx := SymLookup;
     If idx < 0 Then
       Error(3);
-    { Check If first arg is a file variable }
-    If (sym_type[idx] = TYPE_FILE) Or (sym_type[idx] = TYPE_TEXT) Then
+    If sym_type[idx] = TYPE_FILE Then
     Begin
-      { File variable - save x19 And load file's fd }
-      lbl1 := 1;
+      { Typed file - one binary element per variable }
       NextToken;
-      { Push x19 To save it }
-      WriteLn('    str x19, [sp, #-16]!');
-      { Load file's fd into x19 }
-      EmitVarAddr(idx, scope_level);
-      WriteLn('    ldr x19, [x0]');
       Expect(TOK_COMMA);
-      If tok_type <> TOK_IDENT Then
-        Error(6);
-      idx := SymLookup;
-      If idx < 0 Then
-        Error(3)
-    End;
-    NextToken;
-    If sym_type[idx] = TYPE_REAL Then
-    Begin
-      { Call read_real runtime - result In d0 }
-      EmitBL(rt_read_real);
-      { Store result In variable }
-      If sym_level[idx] = scope_level Then
-        EmitSturD0(sym_offset[idx])
-      Else
-        EmitSturD0Outer(sym_offset[idx], sym_level[idx], scope_level)
+      ParseFileRead(idx)
     End
     Else
     Begin
-      { Call read_int runtime }
-      EmitBL(rt_read_int);
-      { Store result In variable }
-      If sym_level[idx] = scope_level Then
-        EmitSturX0(sym_offset[idx])
+      { Check If first arg is a file variable }
+      If sym_type[idx] = TYPE_TEXT Then
+      Begin
+        { File variable - save x19 And load file's fd }
+        lbl1 := 1;
+        NextToken;
+        { Push x19 To save it }
+        WriteLn('    str x19, [sp, #-16]!');
+        { Load file's fd into x19 }
+        EmitVarAddr(idx, scope_level);
+        WriteLn('    ldr x19, [x0]');
+        Expect(TOK_COMMA);
+        If tok_type <> TOK_IDENT Then
+          Error(6);
+        idx := SymLookup;
+        If idx < 0 Then
+          Error(3)
+      End;
+      NextToken;
+      If sym_type[idx] = TYPE_REAL Then
+      Begin
+        { Call read_real runtime - result In d0 }
+        EmitBL(rt_read_real);
+        { Store result In variable }
+        If sym_level[idx] = scope_level Then
+          EmitSturD0(sym_offset[idx])
+        Else
+          EmitSturD0Outer(sym_offset[idx], sym_level[idx], scope_level)
+      End
+      Else If sym_type[idx] = TYPE_CHAR Then
+      Begin
+        { Read a single character }
+        EmitBL(rt_readchar);
+        If sym_level[idx] = scope_level Then
+          EmitSturX0(sym_offset[idx])
+        Else
+          EmitSturX0Outer(sym_offset[idx], sym_level[idx], scope_level)
+      End
       Else
-        EmitSturX0Outer(sym_offset[idx], sym_level[idx], scope_level)
-    End;
-    { Restore x19 If we saved it }
-    If lbl1 = 1 Then
-    Begin
-      WriteLn('    ldr x19, [sp], #16');
+      Begin
+        { Call read_int runtime }
+        EmitBL(rt_read_int);
+        { Store result In variable }
+        If sym_level[idx] = scope_level Then
+          EmitSturX0(sym_offset[idx])
+        Else
+          EmitSturX0Outer(sym_offset[idx], sym_level[idx], scope_level)
+      End;
+      { Restore x19 If we saved it }
+      If lbl1 = 1 Then
+      Begin
+        WriteLn('    ldr x19, [sp], #16');
+      End
     End;
     Expect(TOK_RPAREN)
   End
@@ -8634,6 +13623,30 @@ Begin
             { Call read_string runtime - already consumes newline }
             EmitBL(rt_read_string)
           End
+          Else If sym_type[idx] = TYPE_ANSISTRING Then
+          Begin
+            { Read the line into a temp String, Then store it }
+            WriteLn('    mov x0, x21');
+            WriteLn('    add x21, x21, #256');
+            EmitPushX0;
+            EmitBL(rt_read_string);
+            EmitPopX0;
+            EmitBL(rt_ansi_from_short);
+            EmitPushX0;
+            EmitAnsiVarAddr(idx);
+            WriteLn('    mov x1, x0');
+            EmitPopX0;
+            EmitBL(rt_ansi_assign)
+          End
+          Else If sym_type[idx] = TYPE_CHAR Then
+          Begin
+            { Read a single character }
+            EmitBL(rt_readchar);
+            If sym_level[idx] = scope_level Then
+              EmitSturX0(sym_offset[idx])
+            Else
+              EmitSturX0Outer(sym_offset[idx], sym_level[idx], scope_level)
+          End
           Else
           Begin
             { Call read_int runtime }
@@ -8646,7 +13659,7 @@ Begin
           End;
           Expect(TOK_RPAREN);
           { Skip To End Of line only For Integer/Real (read_string already consumed newline) }
-          If lbl2 <> TYPE_STRING Then
+          If (lbl2 <> TYPE_STRING) And (lbl2 <> TYPE_ANSISTRING) Then
             EmitBL(rt_skip_line);
           { Restore x19 If we saved it }
           If lbl1 = 1 Then
@@ -8723,6 +13736,9 @@ Begin
       If exit_label = 0 Then
       Begin
         { In main Program - just call Halt With Exit code 0 }
+        If heap_stats_out = 1 Then
+          EmitBL(rt_heap_stats);
+        EmitBL(rt_flush_all);
         EmitMovX0(0);
         { mov x16, #1 }
         WriteLn('    mov x16, #1');
@@ -8751,7 +13767,9 @@ Begin
           If tok_type = TOK_IDENT Then
           Begin
             idx := SymLookup;
-            If (idx >= 0) And ((sym_type[idx] = TYPE_FILE) Or (sym_type[idx] = TYPE_TEXT)) Then
+            If (idx >= 0) And (sym_type[idx] = TYPE_FILE) Then
+              Error(19);
+            If (idx >= 0) And (sym_type[idx] = TYPE_TEXT) Then
             Begin
               { File variable - save x20 And load file's fd }
               lbl1 := 1;
@@ -8771,18 +13789,18 @@ Begin
             Begin
               If tok_type = TOK_STRING Then
               Begin
-                { Print String literal character by character }
+                { Queue String literal; adjacent literals are written together }
                 idx := 0;
                 While idx < tok_len Do
                 Begin
-                  EmitMovX0(tok_str[idx]);
-                  EmitBL(rt_print_char);
+                  EmitLitChar(tok_str[idx]);
                   idx := idx + 1
                 End;
                 NextToken
               End
               Else If tok_type = TOK_IDENT Then
               Begin
+                EmitLitFlush;
                 { Check If it's a String variable }
                 idx := SymLookup;
                 If (idx >= 0) And (sym_type[idx] = TYPE_STRING) Then
@@ -8796,23 +13814,14 @@ Begin
                 Begin
                   { Not a String - parse as expression And print based on Type }
                   ParseExpression;
-                  If expr_type = TYPE_REAL Then
-                    EmitBL(rt_print_real)
-                  Else If expr_type = TYPE_STRING Then
-                    EmitBL(rt_print_string)
-                  Else
-                    EmitBL(rt_print_int)
+                  EmitWriteValue
                 End
               End
               Else
               Begin
+                EmitLitFlush;
                 ParseExpression;
-                If expr_type = TYPE_REAL Then
-                  EmitBL(rt_print_real)
-                Else If expr_type = TYPE_STRING Then
-                  EmitBL(rt_print_string)
-                Else
-                  EmitBL(rt_print_int)
+                EmitWriteValue
               End;
               If tok_type = TOK_COMMA Then NextToken
             End
@@ -8820,7 +13829,14 @@ Begin
         End;
         Expect(TOK_RPAREN)
       End;
-      EmitBL(rt_newline);
+      { The newline joins a trailing literal In one Write }
+      If lit_len > 0 Then
+      Begin
+        EmitLitChar(10);
+        EmitLitFlush
+      End
+      Else
+        EmitBL(rt_newline);
       { Restore x20 If we saved it }
       If lbl1 = 1 Then
       Begin
@@ -8831,7 +13847,7 @@ Begin
     Begin
       { Write }
       NextToken;
-      lbl1 := 0;  { flag: 1 If writing To file }
+      lbl1 := 0;  { flag: 1 If writing To a Text file, 2 a typed file }
       If tok_type = TOK_LPAREN Then
       Begin
         NextToken;
@@ -8841,7 +13857,15 @@ Begin
           If tok_type = TOK_IDENT Then
           Begin
             idx := SymLookup;
-            If (idx >= 0) And ((sym_type[idx] = TYPE_FILE) Or (sym_type[idx] = TYPE_TEXT)) Then
+            If (idx >= 0) And (sym_type[idx] = TYPE_FILE) Then
+            Begin
+              { Typed file - one binary element per argument }
+              lbl1 := 2;
+              NextToken;
+              Expect(TOK_COMMA);
+              ParseFileWrite(idx)
+            End
+            Else If (idx >= 0) And (sym_type[idx] = TYPE_TEXT) Then
             Begin
               { File variable - save x20 And load file's fd }
               lbl1 := 1;
@@ -8861,18 +13885,18 @@ Begin
             Begin
               If tok_type = TOK_STRING Then
               Begin
-                { Print String literal character by character }
+                { Queue String literal; adjacent literals are written together }
                 idx := 0;
                 While idx < tok_len Do
                 Begin
-                  EmitMovX0(tok_str[idx]);
-                  EmitBL(rt_print_char);
+                  EmitLitChar(tok_str[idx]);
                   idx := idx + 1
                 End;
                 NextToken
               End
               Else If tok_type = TOK_IDENT Then
               Begin
+                EmitLitFlush;
                 { Check If it's a String variable }
                 idx := SymLookup;
                 If (idx >= 0) And (sym_type[idx] = TYPE_STRING) Then
@@ -8886,23 +13910,14 @@ Begin
                 Begin
                   { Not a String - parse as expression And print based on Type }
                   ParseExpression;
-                  If expr_type = TYPE_REAL Then
-                    EmitBL(rt_print_real)
-                  Else If expr_type = TYPE_STRING Then
-                    EmitBL(rt_print_string)
-                  Else
-                    EmitBL(rt_print_int)
+                  EmitWriteValue
                 End
               End
               Else
               Begin
+                EmitLitFlush;
                 ParseExpression;
-                If expr_type = TYPE_REAL Then
-                  EmitBL(rt_print_real)
-                Else If expr_type = TYPE_STRING Then
-                  EmitBL(rt_print_string)
-                Else
-                  EmitBL(rt_print_int)
+                EmitWriteValue
               End;
               If tok_type = TOK_COMMA Then NextToken
             End
@@ -8910,6 +13925,7 @@ Begin
         End;
         Expect(TOK_RPAREN)
       End;
+      EmitLitFlush;
       { Restore x20 If we saved it }
       If lbl1 = 1 Then
       Begin
@@ -8931,9 +13947,48 @@ Begin
       End
       Else
         EmitMovX0(0);
+      { Flush buffered output before exiting }
+      EmitPushX0;
+      If heap_stats_out = 1 Then
+        EmitBL(rt_heap_stats);
+      EmitBL(rt_flush_all);
+      EmitPopX0;
       EmitMovX16(33554433);  { 0x2000001 = Exit }
       EmitSvc
     End
+    { Flush = 102,108,117,115,104 }
+    Else If TokIs8(102, 108, 117, 115, 104, 0, 0, 0) = 1 Then
+    Begin
+      { Flush, Flush(Output) Or Flush(f) - Write out buffered output }
+      NextToken;
+      idx := -1;
+      If tok_type = TOK_LPAREN Then
+      Begin
+        NextToken;
+        If tok_type <> TOK_IDENT Then
+          Error(6);
+        idx := SymLookup;
+        If idx >= 0 Then
+        Begin
+          If (sym_type[idx] <> TYPE_FILE) And (sym_type[idx] <> TYPE_TEXT) Then
+            Error(9)
+        End
+        { output = 111,117,116,112,117,116 }
+        Else If TokIs8(111, 117, 116, 112, 117, 116, 0, 0) = 0 Then
+          Error(3);
+        NextToken;
+        Expect(TOK_RPAREN)
+      End;
+      If idx >= 0 Then
+      Begin
+        { Flush(f) - Write out the file's own buffer }
+        EmitVarAddr(idx, scope_level);
+        WriteLn('    ldr x0, [x0]');
+        EmitBL(rt_io_sync)
+      End
+      Else
+        EmitBL(rt_flush_output)
+    End
     { randomize = 114,97,110,100,111,109,105,122,101 }
     Else If (tok_len = 9) And (ToLower(tok_str[0]) = 114) And (ToLower(tok_str[1]) = 97) And
             (ToLower(tok_str[2]) = 110) And (ToLower(tok_str[3]) = 100) And (ToLower(tok_str[4]) = 111) And
@@ -9083,7 +14138,11 @@ Begin
       Begin
         { Pointer To Array: calculate size from bounds }
         arg_count := sym_label[idx];  { ptr_arr index }
-        lbl1 := (ptr_arr_hi[arg_count] - ptr_arr_lo[arg_count] + 1) * 8
+        lbl1 := ptr_arr_hi[arg_count] - ptr_arr_lo[arg_count] + 1;
+        If ptr_arr_elem[arg_count] = TYPE_RECORD Then
+          lbl1 := lbl1 * sym_label[ptr_arr_rec[arg_count]]
+        Else
+          lbl1 := lbl1 * 8
       End
       Else
         lbl1 := 8;  { basic types are 8 bytes }
@@ -9159,11 +14218,59 @@ Begin
       Else
         EmitSturX0(sym_offset[idx])
     End
-    Else If (tok_len = 7) And (ToLower(tok_str[0]) = 100) And (ToLower(tok_str[1]) = 105) And
-            (ToLower(tok_str[2]) = 115) And (ToLower(tok_str[3]) = 112) And (ToLower(tok_str[4]) = 111) And
-            (ToLower(tok_str[5]) = 115) And (ToLower(tok_str[6]) = 101) Then
+    Else If (tok_len = 7) And (ToLower(tok_str[0]) = 100) And (ToLower(tok_str[1]) = 105) And
+            (ToLower(tok_str[2]) = 115) And (ToLower(tok_str[3]) = 112) And (ToLower(tok_str[4]) = 111) And
+            (ToLower(tok_str[5]) = 115) And (ToLower(tok_str[6]) = 101) Then
+    Begin
+      { Dispose(p) - free memory via free list allocator }
+      NextToken;
+      Expect(TOK_LPAREN);
+      If tok_type <> TOK_IDENT Then
+        Error(6);  { expected identifier }
+      idx := SymLookup;
+      If idx < 0 Then
+        Error(3);  { undefined identifier }
+      If sym_type[idx] <> TYPE_POINTER Then
+        Error(14);  { expected pointer Type }
+      NextToken;
+      Expect(TOK_RPAREN);
+      { Load pointer value into x0 }
+      If sym_level[idx] < scope_level Then
+        EmitLdurX0Outer(sym_offset[idx], sym_level[idx], scope_level)
+      Else
+        EmitLdurX0(sym_offset[idx]);
+      { Call rt_free To return memory To free list }
+      EmitBL(rt_free);
+      { Set pointer To Nil For safety }
+      EmitMovX0(0);
+      If sym_level[idx] < scope_level Then
+        EmitSturX0Outer(sym_offset[idx], sym_level[idx], scope_level)
+      Else
+        EmitSturX0(sym_offset[idx])
+    End
+    Else If TokIs8(109, 97, 114, 107, 0, 0, 0, 0) = 1 Then
+    Begin
+      { Mark(p) - note the arena position In p, starting the arena }
+      NextToken;
+      Expect(TOK_LPAREN);
+      If tok_type <> TOK_IDENT Then
+        Error(6);  { expected identifier }
+      idx := SymLookup;
+      If idx < 0 Then
+        Error(3);  { undefined identifier }
+      If sym_type[idx] <> TYPE_POINTER Then
+        Error(14);  { expected pointer Type }
+      NextToken;
+      Expect(TOK_RPAREN);
+      EmitBL(rt_mark);
+      If sym_level[idx] < scope_level Then
+        EmitSturX0Outer(sym_offset[idx], sym_level[idx], scope_level)
+      Else
+        EmitSturX0(sym_offset[idx])
+    End
+    Else If TokIs8(114, 101, 108, 101, 97, 115, 101, 0) = 1 Then
     Begin
-      { Dispose(p) - free memory via free list allocator }
+      { Release(p) - free everything allocated since Mark(p) }
       NextToken;
       Expect(TOK_LPAREN);
       If tok_type <> TOK_IDENT Then
@@ -9175,19 +14282,11 @@ Begin
         Error(14);  { expected pointer Type }
       NextToken;
       Expect(TOK_RPAREN);
-      { Load pointer value into x0 }
       If sym_level[idx] < scope_level Then
         EmitLdurX0Outer(sym_offset[idx], sym_level[idx], scope_level)
       Else
         EmitLdurX0(sym_offset[idx]);
-      { Call rt_free To return memory To free list }
-      EmitBL(rt_free);
-      { Set pointer To Nil For safety }
-      EmitMovX0(0);
-      If sym_level[idx] < scope_level Then
-        EmitSturX0Outer(sym_offset[idx], sym_level[idx], scope_level)
-      Else
-        EmitSturX0(sym_offset[idx])
+      EmitBL(rt_release)
     End
     { FillChar = 102,105,108,108,99,104,97,114 - fill memory with byte }
     Else If TokIs8(102, 105, 108, 108, 99, 104, 97, 114) = 1 Then
@@ -9432,12 +14531,34 @@ Begin
       { Convert Pascal String To C String: skip Length byte }
       WriteLn('    add x0, x0, #1');
       { open syscall: x0=path, x1=O_RDONLY(0), x2=mode(0) }
-      WriteLn('    mov x1, #0');
+      { Typed files open O_RDWR(2) so records can be updated In place }
+      If sym_type[idx] = TYPE_FILE Then
+        WriteLn('    mov x1, #2')
+      Else
+        WriteLn('    mov x1, #0');
       WriteLn('    mov x2, #0');
       { movz x16, #5; movk x16, #0x200, lsl #16 = 0x2000005 }
       WriteLn('    movz x16, #5');
       WriteLn('    movk x16, #0x200, lsl #16');
       EmitSvc;
+      If sym_type[idx] = TYPE_FILE Then
+      Begin
+        { A file we may Not Write is still opened For reading }
+        lbl1 := NewLabel;
+        Write('    b.cc L'); WriteLn(lbl1);
+        WriteLn('    ldr x0, [sp]');
+        WriteLn('    add x0, x0, #17');
+        WriteLn('    mov x1, #0');
+        WriteLn('    mov x2, #0');
+        WriteLn('    movz x16, #5');
+        WriteLn('    movk x16, #0x200, lsl #16');
+        EmitSvc;
+        EmitLabel(lbl1)
+      End;
+      { Failed open returns errno With carry set: make it fd -1 }
+      WriteLn('    csinv x0, x0, xzr, cc');
+      { Give the file its own buffer }
+      EmitBL(rt_io_open);
       { Store fd In file variable (offset 0) }
       EmitPopX1;  { x1 = file Var base }
       { str x0, [x1] }
@@ -9472,14 +14593,21 @@ Begin
       { Convert Pascal String To C String: skip Length byte }
       WriteLn('    add x0, x0, #1');
       { open syscall: x0=path, x1=O_WRONLY|O_CREAT|O_TRUNC(1537), x2=mode(420) }
-      { mov x1, #1537 }
-      WriteLn('    mov x1, #1537');
+      { Typed files use O_RDWR(1538) so they can be Read back after Seek }
+      If sym_type[idx] = TYPE_FILE Then
+        WriteLn('    mov x1, #1538')
+      Else
+        WriteLn('    mov x1, #1537');
       { mov x2, #420 }
       WriteLn('    mov x2, #420');
       { movz x16, #5; movk x16, #0x200, lsl #16 = 0x2000005 }
       WriteLn('    movz x16, #5');
       WriteLn('    movk x16, #0x200, lsl #16');
       EmitSvc;
+      { Failed open returns errno With carry set: make it fd -1 }
+      WriteLn('    csinv x0, x0, xzr, cc');
+      { Give the file its own buffer }
+      EmitBL(rt_io_open);
       { Store fd In file variable (offset 0) }
       EmitPopX1;  { x1 = file Var base }
       { str x0, [x1] }
@@ -9509,6 +14637,8 @@ Begin
       EmitVarAddr(idx, scope_level);
       { ldr x0, [x0] - load fd }
       WriteLn('    ldr x0, [x0]');
+      { Write out And release its buffer }
+      EmitBL(rt_io_close);
       { close syscall: x0=fd }
       { movz x16, #6; movk x16, #0x200, lsl #16 = 0x2000006 }
       WriteLn('    movz x16, #6');
@@ -9609,6 +14739,8 @@ Begin
       Expect(TOK_LPAREN);
       ParseExpression;
       Expect(TOK_RPAREN);
+      { Write out And release its buffer }
+      EmitBL(rt_io_close);
       { x0 = fd To close }
       { close syscall: x16 = 0x2000006 }
       WriteLn('    movz x16, #6');
@@ -9628,29 +14760,108 @@ Begin
       Expect(TOK_COMMA);
       ParseExpression;  { Char }
       { x0 = Char, stack top = fd }
-      { sub sp, sp, #16; strb w0, [sp] - store Char In buffer }
-      WriteLn('    sub sp, sp, #16');
-      { strb w0, [sp] }
-      WriteLn('    strb w0, [sp]');
-      { ldr x0, [sp, #16] - load fd from saved position }
-      WriteLn('    ldr x0, [sp, #16]');
-      { mov x1, sp - buffer address }
-      WriteLn('    mov x1, sp');
-      { mov x2, #1 - Write 1 byte }
-      WriteLn('    mov x2, #1');
-      { Write syscall: x16 = 0x2000004 }
-      WriteLn('    movz x16, #4');
-      WriteLn('    movk x16, #0x200, lsl #16');
-      EmitSvc;
-      { add sp, sp, #32 - restore stack (16 For buffer + 16 For saved fd) }
-      WriteLn('    add sp, sp, #32');
+      WriteLn('    mov x1, x0');
+      WriteLn('    ldr x0, [sp], #16');
+      { Call Write Char To fd runtime: x0=fd, x1=Char }
+      EmitBL(rt_write_char_fd);
       Expect(TOK_RPAREN)
     End
+    { mapfile = 109,97,112,102,105,108,101 }
+    Else If (tok_len = 7) And (ToLower(tok_str[0]) = 109) And (ToLower(tok_str[1]) = 97) And
+            (ToLower(tok_str[2]) = 112) And (ToLower(tok_str[3]) = 102) And (ToLower(tok_str[4]) = 105) And
+            (ToLower(tok_str[5]) = 108) And (ToLower(tok_str[6]) = 101) Then
+    Begin
+      { mapfile(f, p [, sync]) - point p at the whole typed file mapped }
+      { shared, Or Nil; With sync the mapping is written To disk before }
+      { UnmapFile Or Close release it }
+      NextToken;
+      Expect(TOK_LPAREN);
+      If tok_type <> TOK_IDENT Then
+        Error(6);
+      idx := SymLookup;
+      If idx < 0 Then
+        Error(3);
+      If sym_type[idx] <> TYPE_FILE Then
+        Error(9);
+      NextToken;
+      Expect(TOK_COMMA);
+      If tok_type <> TOK_IDENT Then
+        Error(6);
+      lbl2 := SymLookup;
+      If lbl2 < 0 Then
+        Error(3);
+      If (sym_type[lbl2] <> TYPE_POINTER) Or (ptr_ultimate_type[lbl2] <> TYPE_ARRAY) Or
+         (ptr_depth[lbl2] <> 1) Then
+        Error(19);
+      { Elements must have the file's layout }
+      lbl1 := sym_label[lbl2];  { ptr_arr index }
+      lbl3 := sym_const_val[idx];  { file index }
+      If file_elem_type[lbl3] = TYPE_RECORD Then
+      Begin
+        If (ptr_arr_elem[lbl1] <> TYPE_RECORD) Or (ptr_arr_rec[lbl1] <> file_rec_idx[lbl3]) Then
+          Error(19)
+      End
+      Else If (file_elem_size[lbl3] <> 8) Or (ptr_arr_elem[lbl1] <> file_elem_type[lbl3]) Then
+        Error(19);
+      NextToken;
+      If tok_type = TOK_COMMA Then
+      Begin
+        NextToken;
+        ParseExpression
+      End
+      Else
+        EmitMovX0(0);
+      Expect(TOK_RPAREN);
+      EmitPushX0;
+      EmitVarAddr(idx, scope_level);
+      WriteLn('    ldr x0, [x0]');
+      EmitPopX1;
+      EmitBL(rt_map_file);
+      If sym_level[lbl2] < scope_level Then
+        EmitSturX0Outer(sym_offset[lbl2], sym_level[lbl2], scope_level)
+      Else
+        EmitSturX0(sym_offset[lbl2])
+    End
+    { unmapfile = 117,110,109,97,112,102,105,108,101 }
+    Else If (tok_len = 9) And (ToLower(tok_str[0]) = 117) And (ToLower(tok_str[1]) = 110) And
+            (ToLower(tok_str[2]) = 109) And (ToLower(tok_str[3]) = 97) And (ToLower(tok_str[4]) = 112) And
+            (ToLower(tok_str[5]) = 102) And (ToLower(tok_str[6]) = 105) And (ToLower(tok_str[7]) = 108) And
+            (ToLower(tok_str[8]) = 101) Then
+    Begin
+      { unmapfile(f) - release the mapping made by MapFile }
+      NextToken;
+      Expect(TOK_LPAREN);
+      If tok_type <> TOK_IDENT Then
+        Error(6);
+      idx := SymLookup;
+      If idx < 0 Then
+        Error(3);
+      If sym_type[idx] <> TYPE_FILE Then
+        Error(9);
+      NextToken;
+      Expect(TOK_RPAREN);
+      EmitVarAddr(idx, scope_level);
+      WriteLn('    ldr x0, [x0]');
+      EmitBL(rt_io_unmap)
+    End
+    { blockread = 98,108,111,99,107,114,101,97,100 }
+    Else If (tok_len = 9) And (ToLower(tok_str[0]) = 98) And (ToLower(tok_str[1]) = 108) And
+            (ToLower(tok_str[2]) = 111) And (ToLower(tok_str[3]) = 99) And (ToLower(tok_str[4]) = 107) And
+            (ToLower(tok_str[5]) = 114) And (ToLower(tok_str[6]) = 101) And (ToLower(tok_str[7]) = 97) And
+            (ToLower(tok_str[8]) = 100) Then
+      ParseBlockTransfer(rt_file_read)
+    { blockwrite = 98,108,111,99,107,119,114,105,116,101 }
+    Else If (tok_len = 10) And (ToLower(tok_str[0]) = 98) And (ToLower(tok_str[1]) = 108) And
+            (ToLower(tok_str[2]) = 111) And (ToLower(tok_str[3]) = 99) And (ToLower(tok_str[4]) = 107) And
+            (ToLower(tok_str[5]) = 119) And (ToLower(tok_str[6]) = 114) And (ToLower(tok_str[7]) = 105) And
+            (ToLower(tok_str[8]) = 116) And (ToLower(tok_str[9]) = 101) Then
+      ParseBlockTransfer(rt_file_write)
     { seek = 115,101,101,107 }
     Else If (tok_len = 4) And (ToLower(tok_str[0]) = 115) And (ToLower(tok_str[1]) = 101) And
             (ToLower(tok_str[2]) = 101) And (ToLower(tok_str[3]) = 107) Then
     Begin
       { seek(f, pos) - move To position In file }
+      { Typed files count In elements, Text files In bytes }
       NextToken;
       Expect(TOK_LPAREN);
       If tok_type <> TOK_IDENT Then
@@ -9662,25 +14873,23 @@ Begin
         Error(9);
       NextToken;
       Expect(TOK_COMMA);
-      { Get file fd And save To x23 }
+      { Parse position expression }
+      ParseExpression;
+      If (sym_type[idx] = TYPE_FILE) And (sym_label[idx] > 1) Then
+      Begin
+        EmitPushX0;
+        EmitMovX0(sym_label[idx]);
+        EmitPopX1;
+        WriteLn('    mul x0, x1, x0')
+      End;
+      EmitPushX0;
+      { Get file fd }
       EmitVarAddr(idx, scope_level);
       { ldr x0, [x0] - load fd }
       WriteLn('    ldr x0, [x0]');
-      { Save fd To x23 }
-      WriteLn('    mov x23, x0');
-      { Parse position expression }
-      ParseExpression;
-      { x0 = position, x23 = fd }
-      { mov x1, x0 (position To x1) }
-      WriteLn('    mov x1, x0');
-      { mov x0, x23 (fd To x0) }
-      WriteLn('    mov x0, x23');
-      { mov x2, #0 (SEEK_SET) }
-      WriteLn('    mov x2, #0');
-      { lseek syscall: 0x20000C7 }
-      WriteLn('    movz x16, #0xC7');
-      WriteLn('    movk x16, #0x200, lsl #16');
-      EmitSvc;
+      EmitPopX1;
+      { x0 = fd, x1 = byte position }
+      EmitBL(rt_io_seek);
       Expect(TOK_RPAREN)
     End
     { delete = 100,101,108,101,116,101 }
@@ -9808,7 +15017,7 @@ Begin
     Else If (tok_len = 3) And (ToLower(tok_str[0]) = 118) And (ToLower(tok_str[1]) = 97) And
             (ToLower(tok_str[2]) = 108) And (SymLookup < 0) Then
     Begin
-      { val(s, v, code) - convert String s To Integer v, error In code }
+      { val(s, v, code) - convert String s To Integer Or Real v, error In code }
       NextToken;
       Expect(TOK_LPAREN);
       { First arg: String }
@@ -9839,25 +15048,41 @@ Begin
       End
       Else
         Error(9);
-      { Call rt_str_to_int: x0=String addr -> x0=value, x1=error }
-      EmitBL(rt_str_to_int);
-      { Save both results: push error first (x1), Then value (x0) }
-      EmitPushX1;
+      { Keep the String address Until the target type Is known }
       EmitPushX0;
       Expect(TOK_COMMA);
-      { Second arg: Integer variable To receive value }
+      { Second arg: Integer Or Real variable To receive value }
       If tok_type <> TOK_IDENT Then
         Error(6);
       idx := SymLookup;
       If idx < 0 Then
         Error(3);
       NextToken;
-      { Get address Of v into x0, move To x1, pop value, store }
-      EmitVarAddr(idx, scope_level);
-      WriteLn('    mov x1, x0');
-      EmitPopX0;  { value }
-      { str x0, [x1] }
-      WriteLn('    str x0, [x1]');
+      EmitPopX0;
+      If sym_type[idx] = TYPE_REAL Then
+      Begin
+        { Call rt_str_to_real: x0=String addr -> d0=value, x1=error }
+        EmitBL(rt_str_to_real);
+        EmitPushX1;
+        EmitPushD0;
+        EmitVarAddr(idx, scope_level);
+        WriteLn('    mov x1, x0');
+        EmitPopD0;  { value }
+        WriteLn('    str d0, [x1]')
+      End
+      Else
+      Begin
+        { Call rt_str_to_int: x0=String addr -> x0=value, x1=error }
+        EmitBL(rt_str_to_int);
+        { Save both results: push error first (x1), Then value (x0) }
+        EmitPushX1;
+        EmitPushX0;
+        { Get address Of v into x0, move To x1, pop value, store }
+        EmitVarAddr(idx, scope_level);
+        WriteLn('    mov x1, x0');
+        EmitPopX0;  { value }
+        WriteLn('    str x0, [x1]')
+      End;
       Expect(TOK_COMMA);
       { Third arg: Integer variable To receive error code }
       If tok_type <> TOK_IDENT Then
@@ -10090,10 +15315,7 @@ Begin
                   ParseExpression;  { first index In x0 }
                   { Subtract low bound for first dimension }
                   dim_lo := arr_info[var_arg_idx * 8];
-                  EmitPushX0;
-                  EmitMovX0(dim_lo);
-                  EmitPopX1;
-                  WriteLn('    sub x0, x1, x0');
+                  EmitAddX0Const(0 - dim_lo);
                   { Handle multi-dimensional arrays }
                   dim_count := arr_dims[var_arg_idx];
                   If dim_count < 1 Then dim_count := 1;
@@ -10109,10 +15331,7 @@ Begin
                     EmitPushX0;
                     ParseExpression;
                     dim_lo := arr_info[var_arg_idx * 8 + dim_idx * 2];
-                    EmitPushX0;
-                    EmitMovX0(dim_lo);
-                    EmitPopX1;
-                    WriteLn('    sub x0, x1, x0');
+                    EmitAddX0Const(0 - dim_lo);
                     EmitPopX1;
                     WriteLn('    add x0, x1, x0');
                     dim_idx := dim_idx + 1
@@ -10149,7 +15368,9 @@ Begin
               Else
               Begin
                 { Value param - evaluate expression }
-                ParseExpression
+                ParseExpression;
+                If IsVarParam(var_flags Div 256, arg_count) = 1 Then
+                  EmitToAnsi
               End;
               EmitPushX0;
               arg_count := arg_count + 1
@@ -10170,7 +15391,13 @@ Begin
         Else If sym_is_external[idx] = 1 Then
           EmitBLExternal(idx)
         Else
-          EmitBL(sym_label[idx])
+          EmitBL(sym_label[idx]);
+        { A discarded AnsiString result is a temp To free }
+        If (sym_kind[idx] = SYM_FUNCTION) And (sym_type[idx] = TYPE_ANSISTRING) Then
+        Begin
+          WriteLn('    mov x1, x0');
+          EmitBL(rt_ansi_drop)
+        End
       End
       Else If (sym_kind[idx] = SYM_VAR) Or (sym_kind[idx] = SYM_PARAM) Then
       Begin
@@ -10178,66 +15405,7 @@ Begin
         Begin
           { Array element assignment: arr[i] := expr Or arr[i,j,...] := expr }
           NextToken;  { consume '[' }
-          ParseExpression;  { first index In x0 }
-          { Subtract low bound for first dimension }
-          dim_lo := arr_info[idx * 8];
-          EmitPushX0;
-          EmitMovX0(dim_lo);
-          EmitPopX1;
-          WriteLn('    sub x0, x1, x0');
-          { Handle multi-dimensional arrays }
-          dim_count := arr_dims[idx];
-          If dim_count < 1 Then dim_count := 1;
-          dim_idx := 1;
-          While (dim_idx < dim_count) And (tok_type = TOK_COMMA) Do
-          Begin
-            NextToken;
-            dim_size := arr_info[idx * 8 + dim_idx * 2 + 1];
-            EmitPushX0;
-            EmitMovX0(dim_size);
-            EmitPopX1;
-            WriteLn('    mul x0, x1, x0');
-            EmitPushX0;
-            ParseExpression;
-            dim_lo := arr_info[idx * 8 + dim_idx * 2];
-            EmitPushX0;
-            EmitMovX0(dim_lo);
-            EmitPopX1;
-            WriteLn('    sub x0, x1, x0');
-            EmitPopX1;
-            WriteLn('    add x0, x1, x0');
-            dim_idx := dim_idx + 1
-          End;
-          Expect(TOK_RBRACKET);
-          { Multiply by element size }
-          If sym_var_param_flags[idx] > 0 Then
-          Begin
-            { Array Of records }
-            lbl1 := sym_label[sym_var_param_flags[idx] - 1];
-            EmitPushX0;
-            EmitMovX0(lbl1);
-            EmitPopX1;
-            WriteLn('    mul x0, x1, x0');
-          End
-          Else If sym_var_param_flags[idx] = -1 Then
-          Begin
-            { Array Of strings - multiply by 256 }
-            WriteLn('    lsl x0, x0, #8');
-          End
-          Else
-          Begin
-            WriteLn('    lsl x0, x0, #3');
-          End;
-          { Get base address }
-          If sym_level[idx] < scope_level Then
-          Begin
-            EmitFollowChain(sym_level[idx], scope_level);
-            EmitSubLargeOffset(1, 8, 0 - sym_offset[idx])
-          End
-          Else
-            EmitSubLargeOffset(1, 29, 0 - sym_offset[idx]);
-          { x1 = base, x0 = offset, compute element address In x1 }
-          WriteLn('    sub x1, x1, x0');
+          EmitArrayElemAddr(idx, 1, ParseArrayIndex(idx));
           { Check For field access }
           If (sym_var_param_flags[idx] > 0) And (tok_type = TOK_DOT) Then
           Begin
@@ -10290,11 +15458,10 @@ Begin
           Else
           Begin
             { Basic Array assignment }
-            EmitPushX1;  { save element address }
+            EmitPushOperandX(1);  { hold element address }
             Expect(TOK_ASSIGN);
             ParseExpression;
-            EmitPopX1;
-            WriteLn('    str x0, [x1]');
+            Write('    str x0, [x'); Write(EmitPopOperand(1)); WriteLn(']')
           End
         End
         Else If (sym_type[idx] = TYPE_RECORD) And (tok_type = TOK_DOT) Then
@@ -10432,37 +15599,32 @@ Begin
           Else If (lbl2 = 0) And (ptr_ultimate_type[idx] = TYPE_ARRAY) And (tok_type = TOK_LBRACKET) Then
           Begin
             { Pointer To Array element assignment: pa^[i] := value }
+            { Or pa^[i].field := value For an Array Of records }
             NextToken;  { consume '[' }
             EmitPushX0;  { save Array base address }
             ParseExpression;  { index In x0 }
             Expect(TOK_RBRACKET);
-            { x0 = index, stack has base address }
-            { Subtract low bound }
             arg_count := sym_label[idx];  { ptr_arr index }
-            EmitPushX0;
-            EmitMovX0(ptr_arr_lo[arg_count]);
-            EmitPopX1;
-            { x0 = x1 - x0 = index - low_bound }
-            WriteLn('    sub x0, x1, x0');
-            { Multiply by 8 using lsl #3 }
-            WriteLn('    lsl x0, x0, #3');
-            { Add To base: x0 = base + offset }
-            EmitPopX1;  { x1 = base address }
-            WriteLn('    add x8, x1, x0');
-            { x8 now has element address }
+            EmitPtrArrIndex(arg_count);
+            lbl1 := ptr_arr_elem[arg_count];
+            If lbl1 = TYPE_RECORD Then
+            Begin
+              If tok_type <> TOK_DOT Then
+                Error(9);
+              lbl1 := field_type[ParseFieldAddr(ptr_arr_rec[arg_count])]
+            End;
+            EmitPushX0;  { save element address }
             Expect(TOK_ASSIGN);
             ParseExpression;  { value To store }
-            { Store value }
-            If ptr_arr_elem[arg_count] = TYPE_REAL Then
+            EmitPopX1;
+            If lbl1 = TYPE_REAL Then
             Begin
               If expr_type <> TYPE_REAL Then
                 EmitScvtfD0X0;
-              WriteLn('    str d0, [x8]');
+              WriteLn('    str d0, [x1]')
             End
             Else
-            Begin
-              WriteLn('    str x0, [x8]');
-            End
+              WriteLn('    str x0, [x1]')
           End
           Else
           Begin
@@ -10525,6 +15687,12 @@ Begin
             WriteLn('    strb w3, [x0, #1]');  { store char }
             WriteLn('    add x21, x21, #256');  { advance heap }
             expr_type := TYPE_STRING
+          End
+          Else If expr_type = TYPE_ANSISTRING Then
+          Begin
+            { AnsiString - cut To a temp String }
+            EmitBL(rt_ansi_to_short);
+            expr_type := TYPE_STRING
           End;
           If expr_type <> TYPE_STRING Then
             Error(12);  { expected String }
@@ -10536,6 +15704,39 @@ Begin
           EmitBL(rt_str_copy)
           End  { End Of Else For String whole assignment }
         End
+        Else If sym_type[idx] = TYPE_ANSISTRING Then
+        Begin
+          If tok_type = TOK_LBRACKET Then
+          Begin
+            { s[i] := Char writes into a record no other variable shares }
+            NextToken;  { consume '[' }
+            EmitAnsiVarAddr(idx);
+            EmitBL(rt_ansi_unique);
+            EmitPushX0;  { save record address }
+            ParseExpression;  { index In x0 }
+            Expect(TOK_RBRACKET);
+            EmitPopX1;
+            WriteLn('    add x0, x1, x0');
+            WriteLn('    add x0, x0, #15');
+            EmitPushX0;  { save Char address }
+            Expect(TOK_ASSIGN);
+            ParseExpression;
+            EmitPopX1;
+            WriteLn('    strb w0, [x1]')
+          End
+          Else
+          Begin
+            { AnsiString assignment stores the pointer And shares the record }
+            Expect(TOK_ASSIGN);
+            ParseExpression;
+            EmitToAnsi;
+            EmitPushX0;
+            EmitAnsiVarAddr(idx);
+            WriteLn('    mov x1, x0');
+            EmitPopX0;
+            EmitBL(rt_ansi_assign)
+          End
+        End
         Else If sym_type[idx] = TYPE_REAL Then
         Begin
           { Real variable assignment }
@@ -10608,8 +15809,17 @@ Begin
             EmitScvtfD0X0;
           EmitSturD0(-16)
         End
+        Else If sym_type[idx] = TYPE_ANSISTRING Then
+        Begin
+          { The result variable holds a reference like any AnsiString }
+          EmitToAnsi;
+          WriteLn('    sub x1, x29, #16');
+          EmitBL(rt_ansi_assign)
+        End
         Else If sym_type[idx] = TYPE_STRING Then
         Begin
+          If expr_type = TYPE_ANSISTRING Then
+            EmitBL(rt_ansi_to_short);
           { String Function - x0 has source String addr, copy To heap For return }
           { x0 = source, x1 = dest (heap), call str_copy }
           WriteLn('    mov x8, x0');
@@ -10854,6 +16064,13 @@ Begin
         End
       End
     End
+    Else If tok_type = TOK_ANSISTRING_TYPE Then
+    Begin
+      { AnsiString: 8-byte pointer To a heap record, Nil when empty }
+      For j := first_idx To idx Do
+        sym_type[j] := TYPE_ANSISTRING;
+      NextToken
+    End
     Else If tok_type = TOK_TEXT Then
     Begin
       { Text file Type: 272 bytes (fd + mode + filename) }
@@ -11055,10 +16272,20 @@ Begin
         { Store In ptr_arr arrays }
         If ptr_arr_count >= 100 Then
           Error(23);
+        ptr_arr_rec[ptr_arr_count] := 0;
+        If tok_type = TOK_IDENT Then
+        Begin
+          { Array Of Record: elements are Record size apart }
+          j := SymLookup;
+          If (j >= 0) And (sym_kind[j] = SYM_TYPEDEF) And (sym_type[j] = TYPE_RECORD) Then
+          Begin
+            base_idx := TYPE_RECORD;
+            ptr_arr_rec[ptr_arr_count] := j
+          End
+        End;
         ptr_arr_lo[ptr_arr_count] := hi_bound;
         ptr_arr_hi[ptr_arr_count] := arr_size;
         ptr_arr_elem[ptr_arr_count] := base_idx;
-        ptr_arr_rec[ptr_arr_count] := 0;
         For j := first_idx To idx Do
         Begin
           sym_type[j] := TYPE_POINTER;
@@ -11168,12 +16395,17 @@ Begin
         Begin
           { Allocate space For Record }
           lo_bound := sym_label[arr_size];  { reuse lo_bound For Record size }
-          { Adjust local_offset: we already allocated 8 bytes, need rest }
-          local_offset := local_offset - (lo_bound - 8);
+          { Fields sit at positive offsets, so the base is the bottom Of }
+          { the area: the first var grows its 8 bytes, the rest get their own }
           For j := first_idx To idx Do
           Begin
             sym_type[j] := TYPE_RECORD;
-            sym_const_val[j] := arr_size  { link To Type definition }
+            sym_const_val[j] := arr_size;  { link To Type definition }
+            If j = first_idx Then
+              local_offset := local_offset - (lo_bound - 8)
+            Else
+              local_offset := local_offset - lo_bound;
+            sym_offset[j] := local_offset
           End
         End
         Else If sym_type[arr_size] = TYPE_ENUM Then
@@ -11686,11 +16918,34 @@ End;
 Procedure ParseProcedureDeclaration; Forward;
 Procedure ParseFunctionDeclaration; Forward;
 
+Procedure EmitAnsiCleanup(level: Integer);
+Var
+  i, n: Integer;
+Begin
+  { Release the AnsiString locals And value params Of the routine at }
+  { level. sp goes below them first, so the calls leave them intact }
+  n := 0;
+  For i := 0 To sym_count - 1 Do
+    If (sym_level[i] = level) And (sym_type[i] = TYPE_ANSISTRING) And
+       (sym_is_var_param[i] = 0) And ((sym_kind[i] = SYM_VAR) Or (sym_kind[i] = SYM_PARAM)) Then
+    Begin
+      If n = 0 Then
+      Begin
+        EmitSubLargeOffset(9, 29, ((15 - local_offset) Div 16) * 16);
+        WriteLn('    mov sp, x9')
+      End;
+      n := n + 1;
+      EmitLdurX0(sym_offset[i]);
+      EmitBL(rt_ansi_release)
+    End
+End;
+
 Procedure ParseBlock;
 Var
   saved_offset: Integer;
   alloc_size: Integer;
   body_label: Integer;
+  i, n: Integer;
 Begin
   saved_offset := local_offset;
   body_label := 0;
@@ -11732,6 +16987,18 @@ Begin
     EmitSubSP(alloc_size)
   End;
 
+  { AnsiString variables start out empty }
+  n := 0;
+  For i := 0 To sym_count - 1 Do
+    If (sym_level[i] = scope_level) And (sym_kind[i] = SYM_VAR) And
+       (sym_type[i] = TYPE_ANSISTRING) And (sym_unit_idx[i] < 0) Then
+    Begin
+      If n = 0 Then
+        EmitMovX0(0);
+      n := n + 1;
+      EmitSturX0(sym_offset[i])
+    End;
+
   Expect(TOK_BEGIN);
   ParseStatement;
   While tok_type = TOK_SEMICOLON Do
@@ -11856,6 +17123,12 @@ Begin
             End;
             NextToken
           End
+          Else If tok_type = TOK_ANSISTRING_TYPE Then
+          Begin
+            For j := first_param_in_group To param_count - 1 Do
+              sym_type[param_indices[j]] := TYPE_ANSISTRING;
+            NextToken
+          End
           Else If tok_type = TOK_INTEGER_TYPE Then
             NextToken  { Already TYPE_INTEGER from SymAdd }
         End
@@ -11878,6 +17151,15 @@ Begin
       If i = 6 Then sym_var_param_flags[idx] := sym_var_param_flags[idx] + 64;
       If i = 7 Then sym_var_param_flags[idx] := sym_var_param_flags[idx] + 128
     End;
+  { Bits 8-15 mark AnsiString value params, which callers convert To }
+  j := 256;
+  For i := 0 To param_count - 1 Do
+    If i < 8 Then
+    Begin
+      If (sym_type[param_indices[i]] = TYPE_ANSISTRING) And (sym_is_var_param[param_indices[i]] = 0) Then
+        sym_var_param_flags[idx] := sym_var_param_flags[idx] + j;
+      j := j * 2
+    End;
 
   Expect(TOK_SEMICOLON);
 
@@ -11968,7 +17250,15 @@ Begin
           EmitNL
         End
       End
-    End
+    End;
+    { AnsiString value params hold a reference For the call }
+    For i := 0 To param_count - 1 Do
+      If i < 8 Then
+        If (sym_type[param_indices[i]] = TYPE_ANSISTRING) And (sym_is_var_param[param_indices[i]] = 0) Then
+        Begin
+          EmitLdurX0(sym_offset[param_indices[i]]);
+          EmitBL(rt_ansi_addref)
+        End
   End;
 
   { Set up Exit label For this Procedure }
@@ -11979,15 +17269,16 @@ Begin
   { Parse Procedure body }
   ParseBlock;
 
+  { Emit Exit label For Exit statements }
+  EmitLabel(proc_exit_label);
+  exit_label := saved_exit_label;
+  EmitAnsiCleanup(scope_level);
+
   { Pop local symbols And restore scope }
   PopScope(scope_level);
   scope_level := saved_level;
   local_offset := saved_offset;
 
-  { Emit Exit label For Exit statements }
-  EmitLabel(proc_exit_label);
-  exit_label := saved_exit_label;
-
   { Restore sp To frame pointer (undoes static link + params + local allocations) }
   EmitIndent;
   WriteChar(109); WriteChar(111); WriteChar(118); WriteChar(32);  { mov }
@@ -12112,6 +17403,12 @@ Begin
             End;
             NextToken
           End
+          Else If tok_type = TOK_ANSISTRING_TYPE Then
+          Begin
+            For j := first_param_in_group To param_count - 1 Do
+              sym_type[param_indices[j]] := TYPE_ANSISTRING;
+            NextToken
+          End
           Else If tok_type = TOK_INTEGER_TYPE Then
             NextToken  { Already TYPE_INTEGER from SymAdd }
         End
@@ -12134,6 +17431,15 @@ Begin
       If i = 6 Then sym_var_param_flags[idx] := sym_var_param_flags[idx] + 64;
       If i = 7 Then sym_var_param_flags[idx] := sym_var_param_flags[idx] + 128
     End;
+  { Bits 8-15 mark AnsiString value params, which callers convert To }
+  j := 256;
+  For i := 0 To param_count - 1 Do
+    If i < 8 Then
+    Begin
+      If (sym_type[param_indices[i]] = TYPE_ANSISTRING) And (sym_is_var_param[param_indices[i]] = 0) Then
+        sym_var_param_flags[idx] := sym_var_param_flags[idx] + j;
+      j := j * 2
+    End;
 
   { Parse return Type }
   Expect(TOK_COLON);
@@ -12150,6 +17456,11 @@ Begin
     sym_type[idx] := TYPE_STRING;
     NextToken
   End
+  Else If tok_type = TOK_ANSISTRING_TYPE Then
+  Begin
+    sym_type[idx] := TYPE_ANSISTRING;
+    NextToken
+  End
   Else
     Error(9);
 
@@ -12190,6 +17501,8 @@ Begin
   EmitMovFP;
   EmitSubSP(16);  { Allocate space For static link }
   EmitStoreStaticLink;
+  If sym_type[idx] = TYPE_ANSISTRING Then
+    WriteLn('    stur xzr, [x29, #-16]');  { result starts out empty }
 
   { Allocate space For parameters And copy from registers }
   If param_count > 0 Then
@@ -12242,7 +17555,15 @@ Begin
           EmitNL
         End
       End
-    End
+    End;
+    { AnsiString value params hold a reference For the call }
+    For i := 0 To param_count - 1 Do
+      If i < 8 Then
+        If (sym_type[param_indices[i]] = TYPE_ANSISTRING) And (sym_is_var_param[param_indices[i]] = 0) Then
+        Begin
+          EmitLdurX0(sym_offset[param_indices[i]]);
+          EmitBL(rt_ansi_addref)
+        End
   End;
 
   { Set up Exit label For this Function }
@@ -12253,20 +17574,24 @@ Begin
   { Parse Function body }
   ParseBlock;
 
+  { Emit Exit label For Exit statements }
+  EmitLabel(func_exit_label);
+  exit_label := saved_exit_label;
+  EmitAnsiCleanup(scope_level);
+
   { Pop local symbols And restore scope }
   PopScope(scope_level);
   scope_level := saved_level;
   local_offset := saved_offset;
 
-  { Emit Exit label For Exit statements }
-  EmitLabel(func_exit_label);
-  exit_label := saved_exit_label;
-
   { Load result from local variable into x0 Or d0 }
   If sym_type[idx] = TYPE_REAL Then
     EmitLdurD0(-16)
   Else
     EmitLdurX0(-16);
+  { An AnsiString result goes To the caller as a temp }
+  If sym_type[idx] = TYPE_ANSISTRING Then
+    EmitBL(rt_ansi_unref);
 
   { Restore sp To frame pointer (undoes static link + params + local allocations) }
   EmitIndent;
@@ -12355,6 +17680,8 @@ Begin
     Write(tpu_file, 'Boolean')
   Else If t = TYPE_STRING Then
     Write(tpu_file, 'String')
+  Else If t = TYPE_ANSISTRING Then
+    Write(tpu_file, 'ANSISTRING')
   Else If t = TYPE_REAL Then
     Write(tpu_file, 'Real')
   Else If t = TYPE_VOID Then
@@ -12560,6 +17887,8 @@ Begin
     TPUParseType := TYPE_RECORD
   Else If (tok_str[0] = 65) And (tok_str[1] = 82) And (tok_str[2] = 82) Then  { ARR }
     TPUParseType := TYPE_ARRAY
+  Else If (tok_str[0] = 65) And (tok_str[1] = 78) And (tok_str[2] = 83) Then  { ANS }
+    TPUParseType := TYPE_ANSISTRING
   Else
     TPUParseType := TYPE_INTEGER
 End;
@@ -12756,17 +18085,61 @@ Begin
 
   { Emit runtime routines needed by Unit code }
   rt_print_int := NewLabel;
+  rt_fmt_int := NewLabel;
   rt_newline := NewLabel;
   rt_readchar := NewLabel;
   rt_print_char := NewLabel;
   rt_write_char_fd := NewLabel;
+  rt_flush_output := NewLabel;
+  rt_flush_all := NewLabel;
+  rt_flush_desc := NewLabel;
+  rt_write_buf := NewLabel;
+  rt_out_switch := NewLabel;
+  rt_fill_input := NewLabel;
+  rt_io_find := NewLabel;
+  rt_io_desc := NewLabel;
+  rt_io_open := NewLabel;
+  rt_io_close := NewLabel;
+  rt_io_sync := NewLabel;
+  rt_io_drop := NewLabel;
+  rt_io_seek := NewLabel;
+  rt_io_pos := NewLabel;
+  rt_io_size := NewLabel;
+  rt_io_unmap := NewLabel;
+  rt_map_file := NewLabel;
+  rt_block_read := NewLabel;
+  rt_block_write := NewLabel;
+  rt_file_read := NewLabel;
+  rt_file_write := NewLabel;
+  rt_read_fd := NewLabel;
+  rt_eof := NewLabel;
   rt_read_int := NewLabel;
   rt_skip_line := NewLabel;
   rt_print_string := NewLabel;
   rt_print_real := NewLabel;
+  rt_print_int_w := NewLabel;
+  rt_write_spaces := NewLabel;
+  rt_real_scale := NewLabel;
+  rt_real_digits := NewLabel;
+  rt_real_shortest := NewLabel;
+  rt_real_fixed := NewLabel;
+  rt_pow10_dbl := NewLabel;
+  rt_pow10_int := NewLabel;
   rt_read_real := NewLabel;
+  rt_scan_digits := NewLabel;
+  rt_parse_int := NewLabel;
+  rt_parse_real := NewLabel;
+  rt_real_exact := NewLabel;
+  rt_num_cut := NewLabel;
+  rt_fill_more := NewLabel;
   rt_read_string := NewLabel;
   rt_heap_init := NewLabel;
+  rt_heap_grow := NewLabel;
+  rt_arena_grow := NewLabel;
+  rt_mark := NewLabel;
+  rt_release := NewLabel;
+  rt_heap_avail := NewLabel;
+  rt_heap_stats := NewLabel;
   rt_alloc := NewLabel;
   rt_free := NewLabel;
   rt_fillchar := NewLabel;
@@ -12776,13 +18149,30 @@ Begin
   rt_str_concat := NewLabel;
   rt_str_cmp := NewLabel;
   rt_str_pos := NewLabel;
+  rt_str_posex := NewLabel;
   rt_str_delete := NewLabel;
   rt_str_insert := NewLabel;
   rt_int_to_str := NewLabel;
   rt_str_to_int := NewLabel;
+  rt_str_to_real := NewLabel;
   rt_str_ltrim := NewLabel;
   rt_str_rtrim := NewLabel;
   rt_str_trim := NewLabel;
+  rt_ansi_new := NewLabel;
+  rt_ansi_addref := NewLabel;
+  rt_ansi_release := NewLabel;
+  rt_ansi_unref := NewLabel;
+  rt_ansi_drop := NewLabel;
+  rt_ansi_assign := NewLabel;
+  rt_ansi_unique := NewLabel;
+  rt_ansi_from_short := NewLabel;
+  rt_ansi_from_char := NewLabel;
+  rt_ansi_to_short := NewLabel;
+  rt_ansi_concat := NewLabel;
+  rt_ansi_cmp := NewLabel;
+  rt_ansi_posex := NewLabel;
+  rt_ansi_copy := NewLabel;
+  rt_print_ansi := NewLabel;
   rt_clrscr := NewLabel;
   rt_gotoxy := NewLabel;
   rt_clreol := NewLabel;
@@ -12808,20 +18198,68 @@ Begin
   rt_arccos := NewLabel;
   rt_paramstr := NewLabel;
 
+  runtime_out := 1;
+  EmitFmtIntRuntime;
   EmitPrintIntRuntime;
   EmitNewlineRuntime;
   EmitReadcharRuntime;
   EmitPrintCharRuntime;
   EmitWriteCharFdRuntime;
+  EmitFlushOutputRuntime;
+  EmitFlushAllRuntime;
+  EmitFlushDescRuntime;
+  EmitWriteBufRuntime;
+  EmitOutSwitchRuntime;
+  EmitFillInputRuntime;
+  EmitIoFindRuntime;
+  EmitIoDescRuntime;
+  EmitIoOpenRuntime;
+  EmitIoCloseRuntime;
+  EmitIoSyncRuntime;
+  EmitIoDropRuntime;
+  EmitIoSeekRuntime;
+  EmitIoPosRuntime;
+  EmitIoSizeRuntime;
+  EmitIoUnmapRuntime;
+  EmitMapFileRuntime;
+  EmitBlockReadRuntime;
+  EmitBlockWriteRuntime;
+  EmitFileReadRuntime;
+  EmitFileWriteRuntime;
+  EmitReadFdRuntime;
+  EmitEofRuntime;
+  EmitScanDigitsRuntime;
+  EmitParseIntRuntime;
+  EmitRealExactRuntime;
+  EmitParseRealRuntime;
+  EmitNumCutRuntime;
+  EmitFillMoreRuntime;
   EmitReadIntRuntime;
   EmitSkipLineRuntime;
   EmitPrintStringRuntime;
+  EmitRealTablesRuntime;
+  EmitRealScaleRuntime;
+  EmitRealDigitsRuntime;
+  EmitRealShortestRuntime;
+  EmitRealFixedRuntime;
+  EmitWriteSpacesRuntime;
   EmitPrintRealRuntime;
+  EmitPrintIntWidthRuntime;
   EmitReadRealRuntime;
   EmitReadStringRuntime;
   EmitHeapInitRuntime;
+  EmitHeapGrowRuntime;
   EmitAllocRuntime;
   EmitFreeRuntime;
+  EmitArenaGrowRuntime;
+  EmitMarkRuntime;
+  EmitReleaseRuntime;
+  EmitHeapAvailRuntime;
+  If heap_stats = 1 Then
+  Begin
+    EmitHeapStatsRuntime;
+    heap_stats_out := 1
+  End;
   EmitFillCharRuntime;
   EmitMoveRuntime;
   EmitStrCopyRuntime;
@@ -12831,8 +18269,13 @@ Begin
   EmitStrPosRuntime;
   EmitStrDeleteRuntime;
   EmitStrInsertRuntime;
+  EmitAnsiRefRuntime;
+  EmitAnsiConvRuntime;
+  EmitAnsiConcatRuntime;
+  EmitAnsiCopyRuntime;
   EmitIntToStrRuntime;
   EmitStrToIntRuntime;
+  EmitStrToRealRuntime;
   EmitStrLtrimRuntime;
   EmitStrRtrimRuntime;
   EmitStrTrimRuntime;
@@ -12976,17 +18419,61 @@ Begin
 
   { Emit runtime routines }
   rt_print_int := NewLabel;
+  rt_fmt_int := NewLabel;
   rt_newline := NewLabel;
   rt_readchar := NewLabel;
   rt_print_char := NewLabel;
   rt_write_char_fd := NewLabel;
+  rt_flush_output := NewLabel;
+  rt_flush_all := NewLabel;
+  rt_flush_desc := NewLabel;
+  rt_write_buf := NewLabel;
+  rt_out_switch := NewLabel;
+  rt_fill_input := NewLabel;
+  rt_io_find := NewLabel;
+  rt_io_desc := NewLabel;
+  rt_io_open := NewLabel;
+  rt_io_close := NewLabel;
+  rt_io_sync := NewLabel;
+  rt_io_drop := NewLabel;
+  rt_io_seek := NewLabel;
+  rt_io_pos := NewLabel;
+  rt_io_size := NewLabel;
+  rt_io_unmap := NewLabel;
+  rt_map_file := NewLabel;
+  rt_block_read := NewLabel;
+  rt_block_write := NewLabel;
+  rt_file_read := NewLabel;
+  rt_file_write := NewLabel;
+  rt_read_fd := NewLabel;
+  rt_eof := NewLabel;
   rt_read_int := NewLabel;
   rt_skip_line := NewLabel;
   rt_print_string := NewLabel;
   rt_print_real := NewLabel;
+  rt_print_int_w := NewLabel;
+  rt_write_spaces := NewLabel;
+  rt_real_scale := NewLabel;
+  rt_real_digits := NewLabel;
+  rt_real_shortest := NewLabel;
+  rt_real_fixed := NewLabel;
+  rt_pow10_dbl := NewLabel;
+  rt_pow10_int := NewLabel;
   rt_read_real := NewLabel;
+  rt_scan_digits := NewLabel;
+  rt_parse_int := NewLabel;
+  rt_parse_real := NewLabel;
+  rt_real_exact := NewLabel;
+  rt_num_cut := NewLabel;
+  rt_fill_more := NewLabel;
   rt_read_string := NewLabel;
   rt_heap_init := NewLabel;
+  rt_heap_grow := NewLabel;
+  rt_arena_grow := NewLabel;
+  rt_mark := NewLabel;
+  rt_release := NewLabel;
+  rt_heap_avail := NewLabel;
+  rt_heap_stats := NewLabel;
   rt_alloc := NewLabel;
   rt_free := NewLabel;
   rt_fillchar := NewLabel;
@@ -12996,13 +18483,30 @@ Begin
   rt_str_concat := NewLabel;
   rt_str_cmp := NewLabel;
   rt_str_pos := NewLabel;
+  rt_str_posex := NewLabel;
   rt_str_delete := NewLabel;
   rt_str_insert := NewLabel;
   rt_int_to_str := NewLabel;
   rt_str_to_int := NewLabel;
+  rt_str_to_real := NewLabel;
   rt_str_ltrim := NewLabel;
   rt_str_rtrim := NewLabel;
   rt_str_trim := NewLabel;
+  rt_ansi_new := NewLabel;
+  rt_ansi_addref := NewLabel;
+  rt_ansi_release := NewLabel;
+  rt_ansi_unref := NewLabel;
+  rt_ansi_drop := NewLabel;
+  rt_ansi_assign := NewLabel;
+  rt_ansi_unique := NewLabel;
+  rt_ansi_from_short := NewLabel;
+  rt_ansi_from_char := NewLabel;
+  rt_ansi_to_short := NewLabel;
+  rt_ansi_concat := NewLabel;
+  rt_ansi_cmp := NewLabel;
+  rt_ansi_posex := NewLabel;
+  rt_ansi_copy := NewLabel;
+  rt_print_ansi := NewLabel;
   rt_clrscr := NewLabel;
   rt_gotoxy := NewLabel;
   rt_clreol := NewLabel;
@@ -13028,20 +18532,68 @@ Begin
   rt_arccos := NewLabel;
   rt_paramstr := NewLabel;
 
+  runtime_out := 1;
+  EmitFmtIntRuntime;
   EmitPrintIntRuntime;
   EmitNewlineRuntime;
   EmitReadcharRuntime;
   EmitPrintCharRuntime;
   EmitWriteCharFdRuntime;
+  EmitFlushOutputRuntime;
+  EmitFlushAllRuntime;
+  EmitFlushDescRuntime;
+  EmitWriteBufRuntime;
+  EmitOutSwitchRuntime;
+  EmitFillInputRuntime;
+  EmitIoFindRuntime;
+  EmitIoDescRuntime;
+  EmitIoOpenRuntime;
+  EmitIoCloseRuntime;
+  EmitIoSyncRuntime;
+  EmitIoDropRuntime;
+  EmitIoSeekRuntime;
+  EmitIoPosRuntime;
+  EmitIoSizeRuntime;
+  EmitIoUnmapRuntime;
+  EmitMapFileRuntime;
+  EmitBlockReadRuntime;
+  EmitBlockWriteRuntime;
+  EmitFileReadRuntime;
+  EmitFileWriteRuntime;
+  EmitReadFdRuntime;
+  EmitEofRuntime;
+  EmitScanDigitsRuntime;
+  EmitParseIntRuntime;
+  EmitRealExactRuntime;
+  EmitParseRealRuntime;
+  EmitNumCutRuntime;
+  EmitFillMoreRuntime;
   EmitReadIntRuntime;
   EmitSkipLineRuntime;
   EmitPrintStringRuntime;
+  EmitRealTablesRuntime;
+  EmitRealScaleRuntime;
+  EmitRealDigitsRuntime;
+  EmitRealShortestRuntime;
+  EmitRealFixedRuntime;
+  EmitWriteSpacesRuntime;
   EmitPrintRealRuntime;
+  EmitPrintIntWidthRuntime;
   EmitReadRealRuntime;
   EmitReadStringRuntime;
   EmitHeapInitRuntime;
+  EmitHeapGrowRuntime;
   EmitAllocRuntime;
   EmitFreeRuntime;
+  EmitArenaGrowRuntime;
+  EmitMarkRuntime;
+  EmitReleaseRuntime;
+  EmitHeapAvailRuntime;
+  If heap_stats = 1 Then
+  Begin
+    EmitHeapStatsRuntime;
+    heap_stats_out := 1
+  End;
   EmitFillCharRuntime;
   EmitMoveRuntime;
   EmitStrCopyRuntime;
@@ -13051,8 +18603,13 @@ Begin
   EmitStrPosRuntime;
   EmitStrDeleteRuntime;
   EmitStrInsertRuntime;
+  EmitAnsiRefRuntime;
+  EmitAnsiConvRuntime;
+  EmitAnsiConcatRuntime;
+  EmitAnsiCopyRuntime;
   EmitIntToStrRuntime;
   EmitStrToIntRuntime;
+  EmitStrToRealRuntime;
   EmitStrLtrimRuntime;
   EmitStrRtrimRuntime;
   EmitStrTrimRuntime;
@@ -13111,7 +18668,10 @@ Begin
 
   Expect(TOK_DOT);
 
-  { Exit syscall }
+  { Flush buffered output, Then Exit syscall }
+  If heap_stats_out = 1 Then
+    EmitBL(rt_heap_stats);
+  EmitBL(rt_flush_all);
   EmitMovX0(0);
   EmitMovX16(33554433);  { 0x2000001 }
   EmitSvc
@@ -13128,6 +18688,7 @@ Begin
   local_offset := 0;
   label_count := 0;
   string_count := 0;
+  lit_len := 0;
   had_error := 0;
   rt_print_int := 0;
   rt_newline := 0;
@@ -13140,6 +18701,11 @@ Begin
   rt_read_real := 0;
   rt_read_string := 0;
   rt_heap_init := 0;
+  heap_min_size := 1048576;
+  heap_max_size := 0;
+  heap_stats := 0;
+  heap_stats_out := 0;
+  runtime_out := 0;
   rt_str_copy := 0;
   rt_str_compare := 0;
   rt_str_concat := 0;
@@ -13148,6 +18714,9 @@ Begin
   pushback_ch := -1;
   expr_type := TYPE_INTEGER;
   ptr_base_type := TYPE_INTEGER;
+  opnd_depth := 0;
+  expr_const := 0;
+  expr_const_val := 0;
   field_count := 0;
   with_rec_idx := -1;
   with_rec_type := 0;
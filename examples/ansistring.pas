@@ -0,0 +1,40 @@
+program AnsiStringDemo;
+{ AnsiString: heap text of any length, shared on assignment and copied
+  on the first write through a shared reference }
+var
+  a, b, c: ansistring;
+  s: string;
+  i: integer;
+
+function Twice(x: ansistring): ansistring;
+begin
+  Twice := x + x
+end;
+
+begin
+  a := 'abc';
+  b := a;
+  b[1] := 'x';
+  writeln(a, ' ', b);
+
+  { No 255 character limit }
+  c := '0123456789';
+  for i := 1 to 6 do
+    c := Twice(c);
+  writeln(length(c), ' ', copy(c, 631, 10));
+
+  { String converts both ways; a long one is cut at 255 on the way back }
+  s := c;
+  writeln(length(s));
+  c := s;
+  c := c + '!';
+  write(length(c), ' ');
+  writechar(c[256]);
+  writeln;
+
+  writeln(pos('789', a + c));
+  if a < b then
+    writeln(a, ' < ', b);
+  a := '';
+  writeln('empty ', length(a))
+end.
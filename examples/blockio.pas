@@ -0,0 +1,38 @@
+program BlockIO;
+{ BlockRead and BlockWrite move whole runs of records between a typed
+  file and an array or heap buffer in one call }
+var
+  f: file of integer;
+  a: array[1..1000] of integer;
+  p: ^integer;
+  i, got, sum, total: integer;
+begin
+  for i := 1 to 1000 do
+    a[i] := i;
+  assign(f, 'blockio.dat');
+  rewrite(f);
+  for i := 1 to 5 do
+    blockwrite(f, a, 1000);
+  writeln('written: ', filesize(f));
+  close(f);
+
+  { Read back in chunks; the last call reports how many it got }
+  reset(f);
+  total := 0;
+  sum := 0;
+  repeat
+    blockread(f, a, 700, got);
+    for i := 1 to got do
+      sum := sum + a[i];
+    total := total + got
+  until got < 700;
+  writeln('read: ', total, ' sum: ', sum);
+
+  { The whole file into a heap buffer at once }
+  getmem(p, 8 * 5000);
+  seek(f, 0);
+  blockread(f, p^, 5000, got);
+  writeln('bulk: ', got);
+  close(f);
+  freemem(p)
+end.
@@ -0,0 +1,43 @@
+program ConstFold;
+{ Constant expressions are worked out by the compiler. The results must
+  be the same as computing them at run time }
+const
+  N = 10;
+type
+  Point = record
+    x, y: integer
+  end;
+var
+  grid: array[5..7, 2..4] of integer;
+  r, c, v, k: integer;
+  ch: char;
+  p: Point;
+begin
+  writeln(N * 4 + 1, ' ', (N * 4 + 1 - 1) div 8, ' ', (N * 4) mod 7, ' ', -(N * 4 + 1) + 2 * N);
+  writeln(1 + 2 * 3 - 4, ' ', (1 + 2) * (3 - 4), ' ', 100 div 7 * 7 + 100 mod 7);
+  v := 'a' + 'b';
+  writeln(Ord('A'), ' ', Ord('A') + 1, ' ', v, ' ', Ord(Chr(65)) * 2);
+  ch := Chr(65 + 2);
+  writechar(ch);
+  writechar(Chr(Ord('a') + 25));
+  writeln;
+  writeln(SizeOf(Point), ' ', SizeOf(grid), ' ', SizeOf(integer) * N, ' ', SizeOf(p) div 8);
+  writeln(ord(N > 5), ' ', ord(N * 4 + 1 = 41), ' ', ord(N * 2 < 15), ' ', (N - 3) * (N + 3));
+
+  { The same values with a variable in the mix }
+  k := N;
+  writeln(k * 4 + 1, ' ', (k * 4 + 1 - 1) div 8, ' ', -k * 4 - 1 + 2 * k);
+
+  { Constant indexes into an array with non-zero low bounds }
+  for r := 5 to 7 do
+    for c := 2 to 4 do
+      grid[r, c] := r * 10 + c;
+  writeln(grid[5, 2], ' ', grid[5, 4], ' ', grid[6, 3], ' ', grid[7, 2], ' ', grid[7, 4]);
+  grid[6, 2 + 1] := 0;
+  grid[2 + 5, N - 6] := grid[5, 2] + 1;
+  v := 0;
+  for r := 5 to 7 do
+    for c := 2 to 4 do
+      v := v + grid[r, c];
+  writeln(grid[6, 3], ' ', grid[7, 4], ' ', v)
+end.
@@ -0,0 +1,86 @@
+program DivMod;
+{ Div and Mod by a constant compile to shifts and a multiply by a magic
+  number instead of a divide. Every result here is checked against Div
+  and Mod by the same value held in a variable, which use the hardware
+  divide. Mod takes the sign of the dividend }
+var
+  xs: array[1..40] of integer;
+  n, i, k, x, seed, checked, bad, mx, mn: integer;
+
+procedure Check(x, d, q, r: integer);
+begin
+  checked := checked + 1;
+  if (q <> x div d) or (r <> x mod d) then
+  begin
+    writeln('wrong: ', x, ' div/mod ', d, ' gave ', q, ' ', r);
+    bad := bad + 1
+  end
+end;
+
+procedure Add(v: integer);
+begin
+  n := n + 1;
+  xs[n] := v
+end;
+
+procedure CheckAll(x: integer);
+begin
+  { x div -1 overflows for the smallest integer }
+  if x <> mn then
+    Check(x, -1, x div -1, x mod -1);
+  Check(x, 1, x div 1, x mod 1);
+  Check(x, 2, x div 2, x mod 2);
+  Check(x, -2, x div -2, x mod -2);
+  Check(x, 3, x div 3, x mod 3);
+  Check(x, -3, x div -3, x mod -3);
+  Check(x, 5, x div 5, x mod 5);
+  Check(x, 7, x div 7, x mod 7);
+  Check(x, -7, x div -7, x mod -7);
+  Check(x, 10, x div 10, x mod 10);
+  Check(x, -10, x div -10, x mod -10);
+  Check(x, 16, x div 16, x mod 16);
+  Check(x, -16, x div -16, x mod -16);
+  Check(x, 641, x div 641, x mod 641);
+  Check(x, 1024, x div 1024, x mod 1024);
+  Check(x, 1000000007, x div 1000000007, x mod 1000000007);
+  Check(x, -1000000007, x div -1000000007, x mod -1000000007);
+  Check(x, 4294967296, x div 4294967296, x mod 4294967296);
+  Check(x, 4611686018427387903, x div 4611686018427387903, x mod 4611686018427387903);
+  Check(x, 4611686018427387904, x div 4611686018427387904, x mod 4611686018427387904);
+  Check(x, -4611686018427387904, x div -4611686018427387904, x mod -4611686018427387904);
+  Check(x, 4611686018427387905, x div 4611686018427387905, x mod 4611686018427387905);
+  Check(x, 6148914691236517205, x div 6148914691236517205, x mod 6148914691236517205);
+  Check(x, 9223372036854775807, x div 9223372036854775807, x mod 9223372036854775807);
+  Check(x, -9223372036854775807, x div -9223372036854775807, x mod -9223372036854775807)
+end;
+
+begin
+  mx := 9223372036854775807;
+  mn := -mx - 1;
+  n := 0;
+  Add(0); Add(1); Add(-1); Add(2); Add(-2); Add(6); Add(-6); Add(7); Add(-7);
+  Add(15); Add(-15); Add(16); Add(-17); Add(640); Add(-641); Add(1000000007);
+  Add(-2000000014); Add(4294967295); Add(-4294967296);
+  Add(4611686018427387903); Add(4611686018427387904); Add(-4611686018427387904);
+  Add(-4611686018427387905); Add(mx); Add(-mx); Add(mn); Add(mn + 1); Add(mx - 1);
+
+  checked := 0;
+  bad := 0;
+  for i := 1 to n do
+    CheckAll(xs[i]);
+  { Pseudo-random values over the whole range; the multiply wraps }
+  seed := 88172645463325252;
+  for k := 1 to 2000 do
+  begin
+    seed := seed * 6364136223846793005 + 1442695040888963407;
+    CheckAll(seed);
+    CheckAll(seed div 4294967296)
+  end;
+  writeln('checked ', checked, ', wrong ', bad);
+
+  { The signs of Div and Mod }
+  x := 7;
+  writeln(x div 2, ' ', x mod 2, ' ', -x div 2, ' ', -x mod 2, ' ', x div -2, ' ', x mod -2, ' ', -x div -2, ' ', -x mod -2);
+  writeln(mn div 16, ' ', mn mod 16, ' ', mn div -7, ' ', mn mod -7, ' ', mx div 3, ' ', mx mod -3);
+  writeln(mn div 4611686018427387904, ' ', mn div 9223372036854775807, ' ', mn mod 9223372036854775807, ' ', mx div -9223372036854775807)
+end.
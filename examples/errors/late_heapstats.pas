@@ -0,0 +1,10 @@
+program LateHeapStats;
+{ The heap report is part of the runtime, so $HEAPSTATS has to come
+  before the declarations }
+var
+  p: ^integer;
+{$HEAPSTATS ON}
+begin
+  new(p);
+  halt
+end.
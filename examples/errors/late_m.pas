@@ -0,0 +1,8 @@
+program LateM;
+{ $M sets up the heap, so it has to come before the declarations }
+var
+  i: integer;
+{$M 16384, 65536, 1048576}
+begin
+  i := 0
+end.
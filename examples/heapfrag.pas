@@ -0,0 +1,43 @@
+program HeapFrag;
+{ Heap fragmentation benchmark. Under a 4MB heap limit, allocate 10000
+  small blocks of mixed sizes, free them in interleaved order, and repeat.
+  Then report MaxAvail, the largest free block, and check that GetMem can
+  return a block that big. A heap that merges freed neighbours gets its
+  chunks back whole; one that does not is left with small free blocks
+  that no large request can use. }
+{$M 16384, 1048576, 4194304}
+var
+  i, round, largest: integer;
+  p: ^integer;
+  ptrs: array[0..9999] of integer;
+begin
+  for round := 1 to 4 do
+  begin
+    for i := 0 to 9999 do
+    begin
+      getmem(p, 16 + (i mod 24) * 16);
+      ptrs[i] := p
+    end;
+    for i := 0 to 4999 do
+    begin
+      p := ptrs[i * 2];
+      freemem(p)
+    end;
+    for i := 0 to 4999 do
+    begin
+      p := ptrs[i * 2 + 1];
+      freemem(p)
+    end
+  end;
+
+  largest := maxavail;
+  writeln('largest block after churn: ', largest);
+  getmem(p, largest);
+  if p <> nil then
+  begin
+    writeln('getmem(maxavail): ok');
+    freemem(p)
+  end
+  else
+    writeln('getmem(maxavail): failed')
+end.
@@ -0,0 +1,26 @@
+{$HEAPSTATS ON}
+program HeapStats;
+{ With $HEAPSTATS the program prints a heap report to stderr when it
+  exits, through Halt as well. The one block still in use here shows up
+  as an allocation without a matching free }
+type
+  TSmall = record
+    a, b: integer
+  end;
+var
+  p: ^TSmall;
+  buf: ^integer;
+  i: integer;
+begin
+  for i := 1 to 10 do
+  begin
+    new(p);
+    dispose(p)
+  end;
+  getmem(buf, 1000);
+  freemem(buf);
+  new(p);
+  writeln('done');
+  halt;
+  writeln('not reached')
+end.
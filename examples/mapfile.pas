@@ -0,0 +1,42 @@
+program MapFileDemo;
+{ MapFile maps a typed file into memory and points p at its records.
+  Changes made through p reach the file when it is unmapped or closed.
+  An empty file maps to nil }
+type
+  TRec = record
+    id: integer;
+    value: integer
+  end;
+var
+  f: file of TRec;
+  r: TRec;
+  p: ^array[0..0] of TRec;
+  i, sum: integer;
+begin
+  assign(f, 'mapfile.dat');
+  rewrite(f);
+  for i := 0 to 999 do
+  begin
+    r.id := i;
+    r.value := i * 3;
+    write(f, r)
+  end;
+
+  mapfile(f, p);
+  sum := 0;
+  for i := 0 to filesize(f) - 1 do
+    sum := sum + p^[i].value;
+  writeln('sum: ', sum, ' record 500: ', p^[500].id);
+  p^[10].value := -1;
+  unmapfile(f);
+
+  seek(f, 10);
+  read(f, r);
+  writeln('record 10 after mapped write: ', r.value);
+
+  rewrite(f);
+  mapfile(f, p);
+  if p = nil then
+    writeln('empty file maps to nil');
+  close(f)
+end.
@@ -0,0 +1,43 @@
+program MarkRelease;
+{ Mark saves the heap position and Release frees every block allocated
+  after it at once, so the next New reuses the same memory. Marks nest;
+  blocks from before the first Mark stay }
+var
+  m, inner: ^integer;
+  keep: ^integer;
+  p, first, again: ^array[1..100] of integer;
+  round, i, k, sum: integer;
+begin
+  new(keep);
+  keep^ := 42;
+  for round := 1 to 200 do
+  begin
+    mark(m);
+    sum := 0;
+    for i := 1 to 500 do
+    begin
+      new(p);
+      if i = 1 then
+        first := p;
+      for k := 1 to 100 do
+        p^[k] := k;
+      sum := sum + p^[100]
+    end;
+    { A nested phase released on its own }
+    mark(inner);
+    for i := 1 to 2000 do
+      new(p);
+    release(inner);
+    release(m)
+  end;
+  writeln('last sum: ', sum, ' kept: ', keep^);
+
+  mark(m);
+  new(again);
+  if again = first then
+    writeln('released memory is reused')
+  else
+    writeln('released memory is not reused');
+  release(m);
+  dispose(keep)
+end.
@@ -0,0 +1,39 @@
+program PosExDemo;
+{ Pos finds the first occurrence of a substring, PosEx the first one at
+  or after a given index. Both return 0 when there is none. Substrings
+  of up to 8 characters and longer ones are searched differently, so
+  both kinds are tried, along with matches at the very end }
+var
+  s, t: string;
+  a: ansistring;
+  i, n: integer;
+begin
+  s := 'the cat sat on the mat with the hat';
+  writeln(pos('the', s), ' ', pos('dog', s));
+  writeln(posex('the', s, 2), ' ', posex('at', s, 30), ' ', posex('at', s, 40));
+
+  { Count every occurrence }
+  n := 0;
+  i := posex('at', s, 1);
+  while i > 0 do
+  begin
+    n := n + 1;
+    i := posex('at', s, i + 1)
+  end;
+  writeln('at occurs ', n, ' times');
+
+  { 200 characters ending in 'z'; 'aaaaaaab' is 8 long, 'aaaaaaaab' is 9 }
+  t := '';
+  for i := 1 to 199 do
+    t := t + 'a';
+  t := t + 'z';
+  writeln(pos('z', t), ' ', pos('az', t), ' ', pos('aaaaaaaz', t), ' ', pos('aaaaaaaaz', t));
+  writeln(pos('aaaaaaaaaaaaaaaaaaaaz', t), ' ', posex('aaaaaaaaa', t, 150), ' ', posex('aaaaaaaaa', t, 192));
+  writeln(pos('b', t), ' ', pos('aaaaaaab', t), ' ', pos('aaaaaaaaab', t));
+  writeln(pos('cat sat on the mat with the hat!', s), ' ', pos(s, s), ' ', pos('hat', s));
+
+  { AnsiString text past 255 characters }
+  a := t;
+  a := a + t + 'needle in a haystack';
+  writeln(length(a), ' ', pos('needle', a), ' ', pos('in a haystack', a), ' ', posex('z', a, 201))
+end.
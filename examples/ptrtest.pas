@@ -1,9 +1,16 @@
 program PtrTest;
+type
+  Item = record
+    count: integer;
+    price: real
+  end;
 var
   x, y: integer;
   p: ^integer;
-  r: real;
+  pp: ^^integer;
+  r, s: real;
   pr: ^real;
+  pi: ^Item;
 begin
   x := 42;
   p := @x;
@@ -25,5 +32,20 @@ begin
   write('Real via pointer: '); writeln(pr^);
 
   pr^ := 2.71;
-  write('After pr^ := 2.71, r = '); writeln(r)
+  write('After pr^ := 2.71, r = '); writeln(r);
+
+  { Reads through pointers inside expressions }
+  s := 0.5;
+  write('pr^ * 2 + s = '); writeln(pr^ * 2.0 + s);
+  pp := @p;
+  write('pp^^ + 1 = '); writeln(pp^^ + 1);
+  if pp^ = p then
+    writeln('pp^ = p');
+  new(pi);
+  pi^.count := 3;
+  pi^.price := 1.25;
+  write('pi^.count * pi^.price = '); writeln(pi^.count * pi^.price);
+  x := pi^.count + p^;
+  write('pi^.count + p^ = '); writeln(x);
+  dispose(pi)
 end.
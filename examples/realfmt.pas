@@ -0,0 +1,18 @@
+program RealFmt;
+{ Real output. Without decimals a real prints the fewest digits that
+  read back as the same value. x:w:d prints d decimals, rounded from
+  the exact binary value, right-aligned in w columns }
+var
+  x: real;
+begin
+  writeln(0.1, ' ', 2.0 / 3.0, ' ', -2.5, ' ', 100.0 * 1000000.0);
+  x := 3.14159;
+  writeln('[', x:10:2, '] [', x:0:4, '] [', -x:8:1, ']');
+  { 0.15 is stored as 0.1499999..., 0.125 is an exact half }
+  writeln(0.15:0:1, ' ', 0.125:0:2, ' ', 2.5:0:0, ' ', 0.3:0:18);
+  writeln(0.0:0:3, ' ', 123.456:0:0, ' ', 99.995:0:2, ' ', -0.005:0:2);
+  { Up to 40 decimals, all exact }
+  writeln(1.0 / 3.0:0:40);
+  writeln(0.1:0:30, ' ', 1024.0 * 1024.0 * 1024.0 * 1024.0:0:1);
+  writeln(42:6, '|', -7:4, '|')
+end.
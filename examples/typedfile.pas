@@ -0,0 +1,53 @@
+program TypedFile;
+{ Typed files hold fixed-size records. Seek moves to a record number,
+  FilePos reports the current one and FileSize the record count }
+type
+  TItem = record
+    id: integer;
+    price: real;
+    code: char
+  end;
+var
+  f: file of TItem;
+  r, saved: TItem;
+  i: integer;
+begin
+  assign(f, 'typedfile.dat');
+  rewrite(f);
+  for i := 1 to 5 do
+  begin
+    r.id := i;
+    r.price := i * 2.5;
+    r.code := chr(64 + i);
+    write(f, r)
+  end;
+  writeln('records: ', filesize(f), ' pos: ', filepos(f));
+  close(f);
+
+  reset(f);
+  while not eof(f) do
+  begin
+    read(f, r);
+    write(r.id, ' ', r.price:0:2, ' ');
+    writechar(r.code);
+    writeln
+  end;
+
+  { Update record 2 in place, then append a sixth }
+  seek(f, 2);
+  read(f, r);
+  saved.price := r.price;
+  r.price := 99.5;
+  seek(f, 2);
+  write(f, r);
+  writeln('pos after update: ', filepos(f));
+  seek(f, filesize(f));
+  r.id := 6;
+  write(f, r);
+  writeln('records: ', filesize(f));
+
+  seek(f, 2);
+  read(f, r);
+  writeln('record 2: ', r.id, ' ', r.price:0:2, ' was ', saved.price:0:2);
+  close(f)
+end.
@@ -1,6 +1,6 @@
 #!/bin/bash
 # TuxPascal wrapper - provides user-friendly CLI around the compiler
-# Usage: tpc <input.pas> [-o <output>] [-S] [-c] [-I<path>] [-ltuxgraph] [-ltuxnet]
+# Usage: tpc <input.pas> [-o <output>] [-S] [-c] [-O] [-gh] [-I<path>] [-ltuxgraph] [-ltuxnet]
 
 set -e
 
@@ -14,13 +14,16 @@ if [ ! -f "$COMPILER" ]; then
     LIB_DIR="$(dirname "$0")/../lib"
 fi
 
+# The peephole optimizer is installed next to the raw compiler
+PEEPHOLE="$(dirname "$COMPILER")/tuxpascal-peephole"
+
 # If lib dir doesn't exist, try relative to script
 if [ ! -d "$LIB_DIR" ]; then
     LIB_DIR="$SCRIPT_DIR/../../lib"
 fi
 
 usage() {
-    echo "Usage: tpc <input.pas> [-o <output>] [-S] [-c] [-ltuxgraph] [-ltuxnet]"
+    echo "Usage: tpc <input.pas> [-o <output>] [-S] [-c] [-O] [-gh] [-ltuxgraph] [-ltuxnet]"
     echo ""
     echo "TuxPascal - A Pascal compiler for ARM64 macOS"
     echo ""
@@ -28,6 +31,8 @@ usage() {
     echo "  -o <file>    Output file name (default: input name without .pas)"
     echo "  -S           Output assembly only (don't assemble/link)"
     echo "  -c           Compile only, produce object file (.o)"
+    echo "  -O           Run the peephole optimizer over the generated assembly"
+    echo "  -gh          Print heap statistics to stderr when the program exits"
     echo "  -I<path>     Add directory to unit search path"
     echo "  -ltuxgraph   Link with TuxGraph library (graphics and sound)"
     echo "  -ltuxnet     Link with TuxNet library (networking)"
@@ -43,6 +48,8 @@ INPUT=""
 OUTPUT=""
 ASM_ONLY=0
 OBJ_ONLY=0
+OPTIMIZE=0
+HEAP_STATS=0
 LINK_TUXGRAPH=0
 LINK_TUXNET=0
 INCLUDE_PATHS=()
@@ -61,6 +68,14 @@ while [ $# -gt 0 ]; do
             OBJ_ONLY=1
             shift
             ;;
+        -O)
+            OPTIMIZE=1
+            shift
+            ;;
+        -gh)
+            HEAP_STATS=1
+            shift
+            ;;
         -ltuxgraph)
             LINK_TUXGRAPH=1
             shift
@@ -108,11 +123,28 @@ fi
 TMPASM=$(mktemp /tmp/tpc_XXXXXX.s)
 trap "rm -f $TMPASM" EXIT
 
-if ! cat "$INPUT" | "$COMPILER" > "$TMPASM"; then
+# -gh prepends the directive on the first line so error line numbers
+# still match the source
+if ! { [ $HEAP_STATS -eq 1 ] && printf '{$HEAPSTATS ON}'; cat "$INPUT"; } | "$COMPILER" > "$TMPASM"; then
     echo "Compilation failed"
     exit 1
 fi
 
+# -O rewrites the assembly through the peephole optimizer
+if [ $OPTIMIZE -eq 1 ]; then
+    if [ ! -f "$PEEPHOLE" ]; then
+        echo "Error: tuxpascal-peephole not found next to $COMPILER"
+        exit 1
+    fi
+    TMPOPT=$(mktemp /tmp/tpc_XXXXXX.s)
+    trap "rm -f $TMPASM $TMPOPT" EXIT
+    if ! "$PEEPHOLE" < "$TMPASM" > "$TMPOPT"; then
+        echo "Optimization failed"
+        exit 1
+    fi
+    mv "$TMPOPT" "$TMPASM"
+fi
+
 if [ $ASM_ONLY -eq 1 ]; then
     mv "$TMPASM" "$OUTPUT"
     echo "Compiled $INPUT -> $OUTPUT"